@@ -3,6 +3,8 @@
 #include "AnimNodes/PaperZDAnimNode_Base.h"
 #include "PaperZDAnimBPGeneratedClass.h"
 #include "PaperZDAnimInstance.h"
+#include "PaperZDTrace.h"
+#include "PaperZDProfiler.h"
 
 //////////////////////////////////////////////////////////////////////////
 // Animation Context
@@ -49,6 +51,73 @@ void FPaperZDAnimDataLink::Evaluate(FPaperZDAnimationPlaybackData& OutputData)
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Exposed value copy record
+//////////////////////////////////////////////////////////////////////////
+bool FPaperZDExposedValueCopyRecord::Initialize(UClass* InClass, const FStructProperty* NodeProperty)
+{
+	SourceProperty = FindFProperty<FProperty>(InClass, SourcePropertyName);
+	FProperty* DestProperty = NodeProperty ? FindFProperty<FProperty>(NodeProperty->Struct, DestPropertyName) : nullptr;
+	if (!SourceProperty || !DestProperty)
+	{
+		return false;
+	}
+
+	DestArrayProperty = DestArrayIndex != INDEX_NONE ? CastField<FArrayProperty>(DestProperty) : nullptr;
+	DestValueProperty = DestArrayProperty ? DestArrayProperty->Inner : DestProperty;
+
+	//The types could have changed since the class was compiled, make sure we still agree on the conversion
+	EPaperZDExposedValueCopyType ResolvedCopyType;
+	if (!GetCopyType(SourceProperty, DestValueProperty, ResolvedCopyType) || ResolvedCopyType != CopyType || (DestArrayIndex != INDEX_NONE && !DestArrayProperty))
+	{
+		return false;
+	}
+
+	SourceOffset = SourceProperty->GetOffset_ForInternal();
+	DestOffset = NodeProperty->GetOffset_ForInternal() + DestProperty->GetOffset_ForInternal();
+	Size = DestValueProperty->ElementSize;
+	return true;
+}
+
+bool FPaperZDExposedValueCopyRecord::GetCopyType(const FProperty* InSourceProperty, const FProperty* InDestProperty, EPaperZDExposedValueCopyType& OutCopyType)
+{
+	if (!InSourceProperty || !InDestProperty || InSourceProperty->ArrayDim != 1 || InDestProperty->ArrayDim != 1)
+	{
+		return false;
+	}
+
+	//Blueprint floats are doubles, while most of the native nodes store floats
+	if (InSourceProperty->IsA<FDoubleProperty>() && InDestProperty->IsA<FFloatProperty>())
+	{
+		OutCopyType = EPaperZDExposedValueCopyType::DoubleToFloat;
+		return true;
+	}
+	else if (InSourceProperty->IsA<FFloatProperty>() && InDestProperty->IsA<FDoubleProperty>())
+	{
+		OutCopyType = EPaperZDExposedValueCopyType::FloatToDouble;
+		return true;
+	}
+	else if (!InSourceProperty->SameType(InDestProperty))
+	{
+		return false;
+	}
+
+	if (InSourceProperty->IsA<FBoolProperty>())
+	{
+		OutCopyType = EPaperZDExposedValueCopyType::BoolCopy;
+	}
+	else if (InSourceProperty->HasAnyPropertyFlags(CPF_IsPlainOldData) && InDestProperty->HasAnyPropertyFlags(CPF_IsPlainOldData))
+	{
+		OutCopyType = EPaperZDExposedValueCopyType::MemCopy;
+	}
+	else
+	{
+		OutCopyType = EPaperZDExposedValueCopyType::ComplexCopy;
+	}
+
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Exposed value handler
 //////////////////////////////////////////////////////////////////////////
@@ -73,6 +142,17 @@ void FPaperZDExposedValueHandler::Initialize(UClass* InClass)
 			}
 		}
 
+		//Resolve the fast-path copies, any record that cannot be resolved is dropped as it would write into the wrong memory
+		const FStructProperty* NodeProperty = ValueHandlerNodeProperty.Get();
+		for (int32 i = CopyRecords.Num() - 1; i >= 0; i--)
+		{
+			if (!CopyRecords[i].Initialize(InClass, NodeProperty))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Cannot resolve fast-path copy from '%s' to '%s' on class '%s', recompile the AnimBP."), *CopyRecords[i].SourcePropertyName.ToString(), *CopyRecords[i].DestPropertyName.ToString(), *InClass->GetName());
+				CopyRecords.RemoveAtSwap(i);
+			}
+		}
+
 		//Initialization complete
 		bInitialized = true;
 	}
@@ -80,8 +160,15 @@ void FPaperZDExposedValueHandler::Initialize(UClass* InClass)
 
 void FPaperZDExposedValueHandler::Update(FPaperZDAnimationBaseContext& Context)
 {
+	//Fast-path copies first, these never touch the blueprint VM
+	for (const FPaperZDExposedValueCopyRecord& Record : CopyRecords)
+	{
+		Record.Copy(Context.AnimInstance);
+	}
+
 	if (Function)
 	{
+		FPaperZDProfiler::CountBlueprintCall(Context.AnimInstance);
 		Context.AnimInstance->ProcessEvent(Function, nullptr);
 	}
 }
@@ -101,28 +188,38 @@ void FPaperZDExposedValueHandler::InitClass(TArray<FPaperZDExposedValueHandler>&
 //////////////////////////////////////////////////////////////////////////
 FPaperZDAnimNode_Base::FPaperZDAnimNode_Base()
 	: ExposedValueHandler(nullptr)
+	, NodeStruct(nullptr)
+#if PAPERZD_NODE_COST_ENABLED
+	, NodeLinkID(INDEX_NONE)
+#endif
 {}
 
-void FPaperZDAnimNode_Base::Initialize(const FPaperZDAnimationInitContext& Context)
+void FPaperZDAnimNode_Base::UpdateExposedValues(const FPaperZDAnimationBaseContext& Context)
 {
-	//Run evaluation handlers first, if they exist
 	if (ExposedValueHandler != nullptr)
 	{
+		//Classes with bound functions never update in parallel, only the fast-path copies can reach here from a worker thread
+		checkSlow(ExposedValueHandler->Function == nullptr || IsInGameThread());
 		FPaperZDAnimationBaseContext BaseContext = Context;
 		ExposedValueHandler->Update(BaseContext);
 	}
+}
+
+void FPaperZDAnimNode_Base::Initialize(const FPaperZDAnimationInitContext& Context)
+{
+	//Run evaluation handlers first, if they exist
+	UpdateExposedValues(Context);
 
 	OnInitialize(Context);
 }
 
 void FPaperZDAnimNode_Base::Update(const FPaperZDAnimationUpdateContext& Context)
 {
+	PAPERZD_TRACE_SCOPE(NodeStruct ? NodeStruct->GetFName() : NAME_None);
+	PAPERZD_COST_SCOPE(Context.AnimInstance, Node, true, true, NodeLinkID);
+
 	//Run evaluation handlers first, if they exist
-	if (ExposedValueHandler != nullptr)
-	{
-		FPaperZDAnimationBaseContext BaseContext = Context;
-		ExposedValueHandler->Update(BaseContext);
-	}
+	UpdateExposedValues(Context);
 
 	//Pass down to child classes
 	OnUpdate(Context);
@@ -31,7 +31,7 @@ void FPaperZDAnimNode_LayerAnimations::OnEvaluate(FPaperZDAnimationPlaybackData&
 	for (int32 i = 0; i < AnimationLayer.Num(); i++)
 	{
 		FPaperZDAnimDataLink& Anim = AnimationLayer[i];
-		FPaperZDAnimationPlaybackData LayerData;
+		LayerData.Reset();
 		Anim.Evaluate(LayerData);
 
 		//If this is the base layer, copy the data from there
@@ -26,8 +26,8 @@ void FPaperZDAnimNode_PlaySequence::OnUpdate(const FPaperZDAnimationUpdateContex
 	if (AnimSequence)
 	{
 		//Independent of the weight we have, we should update the playback, to avoid losing sync
-		UPaperZDAnimPlayer* Player = UpdateContext.AnimInstance->GetPlayer();
-		Player->TickPlayback(AnimSequence, PlaybackTime, UpdateContext.DeltaTime * PlayRate, bLoopAnimation, UpdateContext.AnimInstance, UpdateContext.Weight);		
+		FPaperZDAnimPlayerState& Player = UpdateContext.AnimInstance->GetPlayerState();
+		Player.TickPlayback(AnimSequence, PlaybackTime, UpdateContext.DeltaTime * PlayRate, bLoopAnimation, UpdateContext.AnimInstance, UpdateContext.Weight);		
 	}
 }
 
@@ -2,35 +2,74 @@
 
 #include "AnimNodes/PaperZDAnimNode_RandomPlayer.h"
 #include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "PaperZDAnimBPGeneratedClass.h"
 
+//////////////////////////////////////////////////////////////////////////
+// Random player data
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDRandomPlayerData::Init(const TArray<FPaperZDRandomPlayerEntry>& InEntries, bool bInShuffleMode)
+{
+	Entries = InEntries;
+	bShuffleMode = bInShuffleMode;
+
+	//First build the indices
+	AggregatedChance = 0.0f;
+	ChanceOrder.Empty(Entries.Num());
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		ChanceOrder.Add(i);
+		AggregatedChance += Entries[i].ChanceToPlay;
+	}
+
+	//Sorted once, as the chances are the same for every instance
+	ChanceOrder.Sort([this](const int32& LH, const int32& RH) -> bool
+	{
+		return Entries[LH].ChanceToPlay > Entries[RH].ChanceToPlay;
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Random player node
+//////////////////////////////////////////////////////////////////////////
 FPaperZDAnimNode_RandomPlayer::FPaperZDAnimNode_RandomPlayer()
-	: bShuffleMode(false)
+	: RandomPlayerIndex(INDEX_NONE)
+	, PlayerData(nullptr)
 	, PlaybackTime(0.0f)
 	, CurrentEntryIdx(INDEX_NONE)
 	, RemainingLoops(0)
 	, PlayRate(1.0f)
 	, ShuffleIndex(INDEX_NONE)
-	, AggregatedChance(0.0f)
-{}
+{
+#if WITH_EDITORONLY_DATA
+	bShuffleMode = false;
+#endif
+}
 
 void FPaperZDAnimNode_RandomPlayer::OnInitialize(const FPaperZDAnimationInitContext& InitContext)
 {
-	if (Entries.Num() > 0)
+	const UPaperZDAnimBPGeneratedClass* AnimClass = InitContext.GetAnimBPClass();
+	PlayerData = AnimClass && AnimClass->GetRandomPlayers().IsValidIndex(RandomPlayerIndex) ? &AnimClass->GetRandomPlayers()[RandomPlayerIndex] : nullptr;
+
+	if (PlayerData && PlayerData->Entries.Num() > 0)
 	{
 		//Select the first animation to play
-		GenerateOrderedList();
+		if (PlayerData->bShuffleMode)
+		{
+			GenerateShuffleList();
+		}
+
 		PickNextEntry();
 	}
 }
 
 void FPaperZDAnimNode_RandomPlayer::OnUpdate(const FPaperZDAnimationUpdateContext& UpdateContext)
 {
-	if (Entries.IsValidIndex(CurrentEntryIdx) && PlayRate != 0.0f)
+	if (PlayerData && PlayerData->Entries.IsValidIndex(CurrentEntryIdx) && PlayRate != 0.0f)
 	{
 		//Independent of the weight we have, we should update the playback, to avoid losing sync
 		const float PreviousTime = PlaybackTime;
- 		UPaperZDAnimPlayer* Player = UpdateContext.AnimInstance->GetPlayer();
-		Player->TickPlayback(Entries[CurrentEntryIdx].AnimSequence, PlaybackTime, UpdateContext.DeltaTime * PlayRate, true, UpdateContext.AnimInstance, UpdateContext.Weight);
+ 		FPaperZDAnimPlayerState& Player = UpdateContext.AnimInstance->GetPlayerState();
+		Player.TickPlayback(PlayerData->Entries[CurrentEntryIdx].AnimSequence, PlaybackTime, UpdateContext.DeltaTime * PlayRate, true, UpdateContext.AnimInstance, UpdateContext.Weight);
 
 		//Check if we have looped yet
 		const bool bLoopComplete = PlayRate > 0.0f ? PreviousTime > PlaybackTime : PreviousTime < PlaybackTime;
@@ -45,66 +84,60 @@ void FPaperZDAnimNode_RandomPlayer::OnUpdate(const FPaperZDAnimationUpdateContex
 
 void FPaperZDAnimNode_RandomPlayer::OnEvaluate(FPaperZDAnimationPlaybackData& OutData)
 {
-	if (Entries.IsValidIndex(CurrentEntryIdx))
+	if (PlayerData && PlayerData->Entries.IsValidIndex(CurrentEntryIdx))
 	{
 		//Forcefully add the animation as the only present
-		OutData.SetAnimation(Entries[CurrentEntryIdx].AnimSequence, PlaybackTime);
+		OutData.SetAnimation(PlayerData->Entries[CurrentEntryIdx].AnimSequence, PlaybackTime);
 	}
 }
 
-void FPaperZDAnimNode_RandomPlayer::GenerateOrderedList()
+bool FPaperZDAnimNode_RandomPlayer::CanUpdateInWorkerThread(const UPaperZDAnimBPGeneratedClass* AnimClass) const
+{
+	//Picking entries relies on the global random stream, which isn't safe to use from multiple threads
+	return false;
+}
+
+void FPaperZDAnimNode_RandomPlayer::GenerateShuffleList()
 {
 	//First build the indices
-	AggregatedChance = 0.0f;
-	OrderedList.Empty(Entries.Num());
-	for (int32 i = 0; i < Entries.Num(); i++)
+	const int32 NumEntries = PlayerData->Entries.Num();
+	ShuffleList.Empty(NumEntries);
+	for (int32 i = 0; i < NumEntries; i++)
 	{
-		OrderedList.Add(i);
-		AggregatedChance += Entries[i].ChanceToPlay;
+		ShuffleList.Add(i);
 	}
 
-	//What type of order is inside the list depends on the play mode
-	if (bShuffleMode)
+	//Each instance plays the entries on its own order
+	const int32 LastIndex = ShuffleList.Num() - 1;
+	for (int32 i = 0; i <= LastIndex; i++)
 	{
-		//Simply shuffle the indices
-		const int32 LastIndex = OrderedList.Num() - 1;
-		for (int32 i = 0; i <= LastIndex; i++)
+		const int32 Index = FMath::RandRange(i, LastIndex);
+		if (i != Index)
 		{
-			const int32 Index = FMath::RandRange(i, LastIndex);
-			if (i != Index)
-			{
-				OrderedList.Swap(i, Index);
-			}
+			ShuffleList.Swap(i, Index);
 		}
 	}
-	else
-	{
-		//We actually need to sort the array depending on the entries chance to play
-		OrderedList.Sort([this](const int32& LH, const int32& RH) -> bool
-		{
-			return Entries[LH].ChanceToPlay > Entries[RH].ChanceToPlay;
-		});
-	}
 }
 
 void FPaperZDAnimNode_RandomPlayer::PickNextEntry()
 {
 	//First choose the entry itself, how to choose it depends if we're on shuffle mode or not
-	if (bShuffleMode)
+	const TArray<FPaperZDRandomPlayerEntry>& Entries = PlayerData->Entries;
+	if (PlayerData->bShuffleMode)
 	{
-		ShuffleIndex = (ShuffleIndex + 1) % OrderedList.Num();
-		CurrentEntryIdx = OrderedList[ShuffleIndex];
+		ShuffleIndex = (ShuffleIndex + 1) % ShuffleList.Num();
+		CurrentEntryIdx = ShuffleList[ShuffleIndex];
 	}
 	else
 	{
 		//Select a random number that falls in between the universe of "chance" we have
-		float RandResult = FMath::RandRange(0.0f, AggregatedChance);
+		float RandResult = FMath::RandRange(0.0f, PlayerData->AggregatedChance);
 
 		//Then search which sample got the big price
 		float CurrentChance = 0.0f;
-		for (int32 i = 0; i < OrderedList.Num(); i++)
+		for (const int32 EntryIdx : PlayerData->ChanceOrder)
 		{
-			CurrentEntryIdx = OrderedList[i];
+			CurrentEntryIdx = EntryIdx;
 			CurrentChance += Entries[CurrentEntryIdx].ChanceToPlay;
 
 			//Done if we surpassed the picked value
@@ -15,10 +15,7 @@ void FPaperZDAnimNode_SetDirectionality::OnInitialize(const FPaperZDAnimationIni
 void FPaperZDAnimNode_SetDirectionality::OnUpdate(const FPaperZDAnimationUpdateContext& UpdateContext)
 {
 	//Cache the directional angle
-	static const FVector2D TopPosition(0.0f, 1.0f);
-	const float Sign = Input.X != 0.0f ? FMath::Sign(Input.X) : 1.0f;
-	const float AngleRad = FMath::Acos(Input.GetSafeNormal() | TopPosition) * Sign;
-	CachedDirectionalAngle = FMath::RadiansToDegrees(AngleRad);
+	UpdateDirectionalAngle();
 
 	//Update the relevant animation
 	Animation.Update(UpdateContext);
@@ -30,3 +27,11 @@ void FPaperZDAnimNode_SetDirectionality::OnEvaluate(FPaperZDAnimationPlaybackDat
 	Animation.Evaluate(OutData);
 	OutData.DirectionalAngle = CachedDirectionalAngle;
 }
+
+void FPaperZDAnimNode_SetDirectionality::UpdateDirectionalAngle()
+{
+	static const FVector2D TopPosition(0.0f, 1.0f);
+	const float Sign = Input.X != 0.0f ? FMath::Sign(Input.X) : 1.0f;
+	const float AngleRad = FMath::Acos(Input.GetSafeNormal() | TopPosition) * Sign;
+	CachedDirectionalAngle = FMath::RadiansToDegrees(AngleRad);
+}
@@ -1,9 +1,11 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "AnimNodes/PaperZDAnimNode_Sink.h"
+#include "AnimNodes/PaperZDAnimProgram.h"
 
 FPaperZDAnimNode_Sink::FPaperZDAnimNode_Sink()
 	: Name(NAME_None)
+	, Program(nullptr)
 {}
 
 bool FPaperZDAnimNode_Sink::IsMainSinkNode() const
@@ -25,10 +27,24 @@ void FPaperZDAnimNode_Sink::OnInitialize(const FPaperZDAnimationInitContext& Ini
 
 void FPaperZDAnimNode_Sink::OnUpdate(const FPaperZDAnimationUpdateContext& UpdateContext)
 {
-	Result.Update(UpdateContext);
+	if (Program)
+	{
+		Program->Update(this, UpdateContext);
+	}
+	else
+	{
+		Result.Update(UpdateContext);
+	}
 }
 
 void FPaperZDAnimNode_Sink::OnEvaluate(FPaperZDAnimationPlaybackData& OutData)
 {
-	Result.Evaluate(OutData);
+	if (Program)
+	{
+		Program->Evaluate(this, OutData);
+	}
+	else
+	{
+		Result.Evaluate(OutData);
+	}
 }
@@ -6,18 +6,29 @@
 #include "AnimSequences/Players/PaperZDAnimPlayer.h"
 #include "PaperZDAnimInstance.h"
 #include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimCounters.h"
+#include "PaperZDProfiler.h"
+#include "PaperZDTrace.h"
+#include "PaperZDAnimRecorder.h"
+#include "PaperZDNodeCost.h"
 
 FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::FScopedAnimationUpdate(FPaperZDAnimNode_StateMachine* InStateMachine, const FPaperZDAnimationUpdateContext& InUpdateContext)
 	: StateMachine(InStateMachine)
 	, UpdateContext(InUpdateContext)
 {
 	check(InStateMachine);
-	SequenceCompleteHandle = UpdateContext.AnimInstance->GetPlayer()->OnPlaybackSequenceComplete_Native.AddRaw(this, &FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::OnTransitionalAnimationComplete);
+
+	//Binding to the native delegate would allocate every update, comparing the completion count is enough to know if any sequence completed
+	StartSequenceCompleteCount = UpdateContext.AnimInstance->GetPlayerState().GetSequenceCompleteCount();
 }
 
 FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::~FScopedAnimationUpdate()
 {
-	UpdateContext.AnimInstance->GetPlayer()->OnPlaybackSequenceComplete_Native.Remove(SequenceCompleteHandle);
+	//Need to delay the removal of the transitional AnimNode, as at this point it hasn't been evaluated
+	if (UpdateContext.AnimInstance->GetPlayerState().GetSequenceCompleteCount() != StartSequenceCompleteCount)
+	{
+		StateMachine->bPopTransitionalAnimNode = true;
+	}
 }
 
 void FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::Update()
@@ -29,12 +40,6 @@ void FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::Update()
 	}
 }
 
-void FPaperZDAnimNode_StateMachine::FScopedAnimationUpdate::OnTransitionalAnimationComplete(const UPaperZDAnimSequence* AnimSequence)
-{
-	//Need to delay the removal of the transitional AnimNode, as at this point it hasn't been evaluated
-	StateMachine->bPopTransitionalAnimNode = true;
-}
-
 //////////////////////////////////////////////////////////////////////////
 //
 //////////////////////////////////////////////////////////////////////////
@@ -45,7 +50,8 @@ FPaperZDAnimNode_StateMachine::FPaperZDAnimNode_StateMachine()
 	, CurrentStateTime(0.0f)
 	, CurrentStateAnimNode(nullptr)
 	, CurrentTransitionalAnimNode(nullptr)
-	,bPopTransitionalAnimNode(false)
+	, bPopTransitionalAnimNode(false)
+	, LastGraphUpdate(0)
 {}
 
 void FPaperZDAnimNode_StateMachine::OnInitialize(const FPaperZDAnimationInitContext& InitContext)
@@ -72,61 +78,86 @@ void FPaperZDAnimNode_StateMachine::OnUpdate(const FPaperZDAnimationUpdateContex
 {
 	if (CachedStateMachine && CurrentStateIndex != INDEX_NONE)
 	{
-		//Transitional nodes need to be removed in a deferred way, because they complete their "AnimationComplete" callback while updating
-		//but by this point they haven't been evaluated and rendered.
-		//We proceed to pop the pending transitional anim node now, when its "Evaluate" method has already been called.
-		if (bPopTransitionalAnimNode)
+		LastGraphUpdate = UpdateContext.AnimInstance->GetGraphUpdateCount();
+		UpdateTransitions(UpdateContext);
+
+		//Increment time spent on this state
+		CurrentStateTime += UpdateContext.DeltaTime;
+		PAPERZD_RECORD(UpdateContext.AnimInstance, State, StateMachineIndex, CurrentStateIndex, CurrentStateTime);
+
+#if PAPERZD_NODE_COST_ENABLED
+		if (FPaperZDNodeCostData* NodeCosts = UpdateContext.AnimInstance->GetNodeCosts())
 		{
-			CurrentTransitionalAnimNode = nullptr;
-			bPopTransitionalAnimNode = false;
+			NodeCosts->MarkStateActive(StateMachineIndex, CurrentStateIndex);
 		}
+#endif
 
-		//Check for any pending state change
-		FNodeEvaluationContext Context(UpdateContext.AnimInstance);
-		Context.VisitedNodes.Add(CurrentStateIndex);
-		while (const FPaperZDAnimStateMachineLink* NextTransition = CheckValidTransition(CurrentStateIndex, Context))
+		//Pass through the OnUpdate call to the AnimNode, the state measures its whole graph
 		{
-			SetState(NextTransition->TargetNodeIndex, UpdateContext);
-			Context.VisitedNodes.Add(CurrentStateIndex);
-			
-			//Check for transitional graphs
-			if (NextTransition->HasTransitionalAnimations())
-			{
-				//Anim node could have been ignored when compiled (empty result node), in which case it exists but has no animations that could trigger the EndLoop callback
-				//we need to make sure that the result LinkID is at least linked to something, otherwise we could potentially end up with an AnimGraph without players
-				//in which case they won't be able to ever "end" by reaching the end of their animations.
- 				FPaperZDAnimNode_Sink* TransitionalAnimNode = UpdateContext.GetAnimBPClass()->GetAnimNodeByPropertyIndex<FPaperZDAnimNode_Sink>(Context.AnimInstance, NextTransition->TransitionalAnimNodeIndex);
- 				if (TransitionalAnimNode && TransitionalAnimNode->HasAnimationData())
- 				{
-					CurrentTransitionalAnimNode = TransitionalAnimNode;
- 				}
-			}
-
-			//New AnimNode needs to be initialized on entry
-			FPaperZDAnimationInitContext InitContext(UpdateContext.AnimInstance);
-			CurrentStateAnimNode->Initialize(InitContext);
+			PAPERZD_COST_SCOPE(UpdateContext.AnimInstance, State, false, true, StateMachineIndex, CurrentStateIndex);
+			FScopedAnimationUpdate AnimationScope(this, UpdateContext);
+			AnimationScope.Update();
+		}
+	}
+}
 
-			//Initialize optional TransitionalNode
-			if (CurrentTransitionalAnimNode)
-			{
-				CurrentTransitionalAnimNode->Initialize(InitContext);
-			}
+void FPaperZDAnimNode_StateMachine::UpdateTransitions(const FPaperZDAnimationUpdateContext& UpdateContext)
+{
+	//Transitional nodes need to be removed in a deferred way, because they complete their "AnimationComplete" callback while updating
+	//but by this point they haven't been evaluated and rendered.
+	//We proceed to pop the pending transitional anim node now, when its "Evaluate" method has already been called.
+	if (bPopTransitionalAnimNode)
+	{
+		CurrentTransitionalAnimNode = nullptr;
+		bPopTransitionalAnimNode = false;
+	}
 
-			//We continue transitioning unless the AnimInstance doesn't allow for it
-			if (!UpdateContext.AnimInstance->AllowsTransitionalStates())
+	//Check for any pending state change
+	FNodeEvaluationContext Context(UpdateContext.AnimInstance, CachedStateMachine->Nodes.Num());
+	Context.VisitedNodes[CurrentStateIndex] = true;
+	while (const FPaperZDAnimStateMachineLink* NextTransition = CheckValidTransition(CurrentStateIndex, Context))
+	{
+		PAPERZD_TRACE_EVENT(Transition, UpdateContext.AnimInstance, CachedStateMachine->MachineName, CachedStateMachine->Nodes[CurrentStateIndex].StateName, CachedStateMachine->Nodes[NextTransition->TargetNodeIndex].StateName);
+		PAPERZD_RECORD(UpdateContext.AnimInstance, Transition, StateMachineIndex, CurrentStateIndex, NextTransition->TargetNodeIndex, NextTransition->TransitionRuleIndex);
+		PAPERZD_COST_COUNT(UpdateContext.AnimInstance, Rule, NumTaken++, StateMachineIndex, NextTransition->TransitionRuleIndex);
+		SetState(NextTransition->TargetNodeIndex, UpdateContext);
+		FPaperZDAnimCounters::CountStateTransition();
+		Context.VisitedNodes[CurrentStateIndex] = true;
+		
+		//Check for transitional graphs
+		if (NextTransition->HasTransitionalAnimations())
+		{
+			//Anim node could have been ignored when compiled (empty result node), in which case it exists but has no animations that could trigger the EndLoop callback
+			//we need to make sure that the result LinkID is at least linked to something, otherwise we could potentially end up with an AnimGraph without players
+			//in which case they won't be able to ever "end" by reaching the end of their animations.
+			FPaperZDAnimNode_Sink* TransitionalAnimNode = UpdateContext.GetAnimBPClass()->GetAnimNodeByPropertyIndex<FPaperZDAnimNode_Sink>(Context.AnimInstance, NextTransition->TransitionalAnimNodeIndex);
+			if (TransitionalAnimNode && TransitionalAnimNode->HasAnimationData())
 			{
-				break;
+				CurrentTransitionalAnimNode = TransitionalAnimNode;
 			}
 		}
 
-		//Increment time spent on this state
-		CurrentStateTime += UpdateContext.DeltaTime;
+		//New AnimNode needs to be initialized on entry
+		FPaperZDAnimationInitContext InitContext(UpdateContext.AnimInstance);
+		CurrentStateAnimNode->Initialize(InitContext);
 
-		//Pass through the OnUpdate call to the AnimNode
+		//Initialize optional TransitionalNode
+		if (CurrentTransitionalAnimNode)
 		{
-			FScopedAnimationUpdate AnimationScope(this, UpdateContext);
-			AnimationScope.Update();
+			CurrentTransitionalAnimNode->Initialize(InitContext);
 		}
+
+		//We continue transitioning unless the AnimInstance doesn't allow for it
+		if (!UpdateContext.AnimInstance->AllowsTransitionalStates())
+		{
+			break;
+		}
+	}
+
+	if (Context.NumRuleEvaluations > 0)
+	{
+		PAPERZD_TRACE_EVENT(RuleEvaluations, UpdateContext.AnimInstance, CachedStateMachine->MachineName, Context.NumRuleEvaluations);
+		FPaperZDProfiler::CountRuleEvaluations(UpdateContext.AnimInstance, Context.NumRuleEvaluations);
 	}
 }
 
@@ -139,11 +170,51 @@ void FPaperZDAnimNode_StateMachine::OnEvaluate(FPaperZDAnimationPlaybackData& Ou
 	}
 }
 
+bool FPaperZDAnimNode_StateMachine::CanUpdateInWorkerThread(const UPaperZDAnimBPGeneratedClass* AnimClass) const
+{
+	//Enter/Exit events get deferred to the game thread, but the transition rules need to be evaluated in place
+	if (AnimClass && AnimClass->GetStateMachines().IsValidIndex(StateMachineIndex))
+	{
+		const FPaperZDAnimStateMachine& StateMachine = AnimClass->GetStateMachines()[StateMachineIndex];
+		for (const FPaperZDAnimStateMachineTransitionRule& Rule : StateMachine.TransitionRules)
+		{
+			if (!Rule.CanEvaluateInWorkerThread())
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 FName FPaperZDAnimNode_StateMachine::GetMachineName() const
 {
 	return CachedStateMachine ? CachedStateMachine->MachineName : NAME_None;
 }
 
+bool FPaperZDAnimNode_StateMachine::WasUpdatedOnLastGraphUpdate(const UPaperZDAnimInstance* AnimInstance) const
+{
+	return AnimInstance && LastGraphUpdate != 0 && LastGraphUpdate == AnimInstance->GetGraphUpdateCount();
+}
+
+void FPaperZDAnimNode_StateMachine::UpdateSharedState(const FPaperZDAnimationUpdateContext& UpdateContext, const FPaperZDAnimNode_StateMachine& SharedMachine)
+{
+	if (CachedStateMachine && CurrentStateIndex != INDEX_NONE)
+	{
+		//The transitional animation is only played by the shared instance, so it completes when that one pops it
+		if (CurrentTransitionalAnimNode && CurrentStateIndex == SharedMachine.CurrentStateIndex && !SharedMachine.CurrentTransitionalAnimNode)
+		{
+			bPopTransitionalAnimNode = true;
+		}
+
+		LastGraphUpdate = UpdateContext.AnimInstance->GetGraphUpdateCount();
+		UpdateTransitions(UpdateContext);
+		CurrentStateTime += UpdateContext.DeltaTime;
+		PAPERZD_RECORD(UpdateContext.AnimInstance, State, StateMachineIndex, CurrentStateIndex, CurrentStateTime);
+	}
+}
+
 void FPaperZDAnimNode_StateMachine::JumpToNode(FName Name, const FPaperZDAnimationBaseContext& Context)
 {
 	if (CachedStateMachine)
@@ -151,6 +222,8 @@ void FPaperZDAnimNode_StateMachine::JumpToNode(FName Name, const FPaperZDAnimati
 		const int32* pTargetNodeIdx = CachedStateMachine->JumpLinks.Find(Name);
 		if (pTargetNodeIdx)
 		{
+			//Jumps aren't driven by any transition rule
+			PAPERZD_RECORD(Context.AnimInstance, Transition, StateMachineIndex, CurrentStateIndex, *pTargetNodeIdx, INDEX_NONE);
 			SetState(*pTargetNodeIdx, Context);
 
 			//Initialize the state
@@ -163,9 +236,13 @@ void FPaperZDAnimNode_StateMachine::JumpToNode(FName Name, const FPaperZDAnimati
 void FPaperZDAnimNode_StateMachine::SetState(int32 NewState, const FPaperZDAnimationBaseContext& Context)
 {
 	//Call the Exit State delegate if it exists
-	if (CachedStateMachine->Nodes.IsValidIndex(CurrentStateIndex) && !CachedStateMachine->Nodes[CurrentStateIndex].OnStateExitEventName.IsNone())
+	if (CachedStateMachine->Nodes.IsValidIndex(CurrentStateIndex))
 	{
-		CallEvent(CachedStateMachine->Nodes[CurrentStateIndex].OnStateExitEventName, Context);
+		PAPERZD_TRACE_EVENT(StateExited, Context.AnimInstance, CachedStateMachine->MachineName, CachedStateMachine->Nodes[CurrentStateIndex].StateName);
+		if (!CachedStateMachine->Nodes[CurrentStateIndex].OnStateExitEventName.IsNone())
+		{
+			CallEvent(CachedStateMachine->Nodes[CurrentStateIndex].OnStateExitEventName, Context);
+		}
 	}
 
 	CurrentStateIndex = NewState;
@@ -174,15 +251,19 @@ void FPaperZDAnimNode_StateMachine::SetState(int32 NewState, const FPaperZDAnima
 	CurrentTransitionalAnimNode = nullptr;
 
 	//Call the Enter State delegate if it exists
-	if (CachedStateMachine->Nodes.IsValidIndex(CurrentStateIndex) && !CachedStateMachine->Nodes[CurrentStateIndex].OnStateEnterEventName.IsNone())
+	if (CachedStateMachine->Nodes.IsValidIndex(CurrentStateIndex))
 	{
-		CallEvent(CachedStateMachine->Nodes[CurrentStateIndex].OnStateEnterEventName, Context);
+		PAPERZD_TRACE_EVENT(StateEntered, Context.AnimInstance, CachedStateMachine->MachineName, CachedStateMachine->Nodes[CurrentStateIndex].StateName);
+		if (!CachedStateMachine->Nodes[CurrentStateIndex].OnStateEnterEventName.IsNone())
+		{
+			CallEvent(CachedStateMachine->Nodes[CurrentStateIndex].OnStateEnterEventName, Context);
+		}
 	}
 }
 
 bool FPaperZDAnimNode_StateMachine::CanEnterNode(int32 NodeIndex, const FNodeEvaluationContext& EvaluationContext) const
 {
-	if (!EvaluationContext.VisitedNodes.Contains(NodeIndex))
+	if (!EvaluationContext.VisitedNodes[NodeIndex])
 	{
 		//By default any node can be entered, unless its a conduit, in which case we need to evaluate its rule
 		bool bCanEnter = true;
@@ -190,8 +271,7 @@ bool FPaperZDAnimNode_StateMachine::CanEnterNode(int32 NodeIndex, const FNodeEva
 		if (Node.bConduit)
 		{
 			check(CachedStateMachine->TransitionRules.IsValidIndex(Node.ConduitRuleIndex));
-			const FPaperZDAnimStateMachineTransitionRule& ConduitRule = CachedStateMachine->TransitionRules[Node.ConduitRuleIndex];
-			bCanEnter = ConduitRule.EvaluateRule(EvaluationContext.AnimInstance);
+			bCanEnter = EvaluateTransitionRule(Node.ConduitRuleIndex, EvaluationContext);
 		}
 
 		return bCanEnter;
@@ -200,6 +280,19 @@ bool FPaperZDAnimNode_StateMachine::CanEnterNode(int32 NodeIndex, const FNodeEva
 	return false;
 }
 
+bool FPaperZDAnimNode_StateMachine::EvaluateTransitionRule(int32 RuleIndex, const FNodeEvaluationContext& EvaluationContext) const
+{
+	EvaluationContext.NumRuleEvaluations++;
+	PAPERZD_COST_SCOPE(EvaluationContext.AnimInstance, Rule, false, true, StateMachineIndex, RuleIndex);
+	const bool bPassed = CachedStateMachine->EvaluateTransitionRule(RuleIndex, EvaluationContext.AnimInstance);
+	if (bPassed)
+	{
+		PAPERZD_COST_COUNT(EvaluationContext.AnimInstance, Rule, NumPassed++, StateMachineIndex, RuleIndex);
+	}
+
+	return bPassed;
+}
+
 const FPaperZDAnimStateMachineLink* FPaperZDAnimNode_StateMachine::CheckValidTransition(int32 NodeIndex, FNodeEvaluationContext& EvaluationContext) const
 {
 	const FPaperZDAnimStateMachineNode& Node = CachedStateMachine->Nodes[NodeIndex];
@@ -207,8 +300,7 @@ const FPaperZDAnimStateMachineLink* FPaperZDAnimNode_StateMachine::CheckValidTra
 	{
 		if (CachedStateMachine->TransitionRules.IsValidIndex(LinkTransition.TransitionRuleIndex))
 		{
-			const FPaperZDAnimStateMachineTransitionRule& Rule = CachedStateMachine->TransitionRules[LinkTransition.TransitionRuleIndex];
-			if (Rule.EvaluateRule(EvaluationContext.AnimInstance) && CanEnterNode(LinkTransition.TargetNodeIndex, EvaluationContext))
+			if (EvaluateTransitionRule(LinkTransition.TransitionRuleIndex, EvaluationContext) && CanEnterNode(LinkTransition.TargetNodeIndex, EvaluationContext))
 			{
 				//We cannot allow taking any transition that leads to a conduit not connected to a state
 				//If the target is a conduit, we should recursively check if it ends up in a valid state
@@ -216,13 +308,18 @@ const FPaperZDAnimStateMachineLink* FPaperZDAnimNode_StateMachine::CheckValidTra
 				if (TargetNode.bConduit)
 				{
 					FNodeEvaluationContext ConduitEvalContext = EvaluationContext;
-					ConduitEvalContext.VisitedNodes.Add(LinkTransition.TargetNodeIndex);
+					ConduitEvalContext.VisitedNodes[LinkTransition.TargetNodeIndex] = true;
 					const FPaperZDAnimStateMachineLink* ConduitLink = CheckValidTransition(LinkTransition.TargetNodeIndex, ConduitEvalContext);
 					if (ConduitLink)
 					{
+						//The link into the conduit is taken along with the one out of it
+						PAPERZD_COST_COUNT(EvaluationContext.AnimInstance, Rule, NumTaken++, StateMachineIndex, LinkTransition.TransitionRuleIndex);
 						EvaluationContext = MoveTemp(ConduitEvalContext);
 						return ConduitLink;
 					}
+
+					//The rules evaluated down a dead end still count
+					EvaluationContext.NumRuleEvaluations = ConduitEvalContext.NumRuleEvaluations;
 				}
 				else
 				{
@@ -238,12 +335,20 @@ const FPaperZDAnimStateMachineLink* FPaperZDAnimNode_StateMachine::CheckValidTra
 
 void FPaperZDAnimNode_StateMachine::CallEvent(FName Name, const FPaperZDAnimationBaseContext& Context)
 {
-	UFunction* FoundFunction = Context.AnimInstance->FindFunction(Name);
+	//Blueprint events cannot run outside of the game thread, let the AnimInstance call them after the parallel update
+	if (Context.AnimInstance->IsRunningParallelUpdate())
+	{
+		Context.AnimInstance->QueueDeferredEvent(Name);
+		return;
+	}
+
+	UFunction* FoundFunction = Context.AnimInstance->FindEventFunction(Name);
 	if (FoundFunction)
 	{
 		//Create a buffer just in case (if we send a null buffer, the system will crash if the event has parameters)
  		uint8* Buffer = (uint8*)FMemory_Alloca(FoundFunction->ParmsSize);
  		FMemory::Memzero(Buffer, FoundFunction->ParmsSize);
+		FPaperZDProfiler::CountBlueprintCall(Context.AnimInstance);
 		Context.AnimInstance->ProcessEvent(FoundFunction, Buffer);
 	}
 }
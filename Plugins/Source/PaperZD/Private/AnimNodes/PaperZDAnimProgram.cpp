@@ -0,0 +1,131 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "AnimNodes/PaperZDAnimProgram.h"
+#include "AnimNodes/PaperZDAnimNode_Sink.h"
+#include "AnimNodes/PaperZDAnimNode_SetDirectionality.h"
+#include "AnimNodes/PaperZDAnimNode_PlaySequence.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+
+namespace FPaperZDAnimProgramHelpers
+{
+	/* Checks that the node struct is the one the operation expects. */
+	bool IsValidOperation(EPaperZDAnimProgramOp Op, const UScriptStruct* NodeStruct)
+	{
+		switch (Op)
+		{
+			case EPaperZDAnimProgramOp::PassThrough:
+				return NodeStruct->IsChildOf(FPaperZDAnimNode_Sink::StaticStruct());
+			case EPaperZDAnimProgramOp::SetDirectionality:
+				return NodeStruct == FPaperZDAnimNode_SetDirectionality::StaticStruct();
+			case EPaperZDAnimProgramOp::PlaySequence:
+				return NodeStruct == FPaperZDAnimNode_PlaySequence::StaticStruct();
+			case EPaperZDAnimProgramOp::Fallback:
+				return NodeStruct->IsChildOf(FPaperZDAnimNode_Base::StaticStruct());
+			default:
+				return false;
+		}
+	}
+}
+
+bool FPaperZDAnimProgram::Initialize(UPaperZDAnimBPGeneratedClass* InClass, UObject* InClassDefaultObject)
+{
+	//A program needs at least the sink and the node it runs
+	if (Instructions.Num() < 2 || Instructions[0].Op != EPaperZDAnimProgramOp::PassThrough)
+	{
+		return false;
+	}
+
+	for (FPaperZDAnimProgramInstruction& Instruction : Instructions)
+	{
+		const FStructProperty* NodeProperty = InClass->AnimNodeProperties.IsValidIndex(Instruction.LinkID) ? InClass->AnimNodeProperties[Instruction.LinkID] : nullptr;
+		if (!NodeProperty || !FPaperZDAnimProgramHelpers::IsValidOperation(Instruction.Op, NodeProperty->Struct))
+		{
+			return false;
+		}
+
+		Instruction.NodeOffset = NodeProperty->GetOffset_ForInternal();
+	}
+
+	//Bind to the sink on the CDO, new instances will copy the pointer over
+	FPaperZDAnimNode_Sink* SinkNode = InClass->AnimNodeProperties[Instructions[0].LinkID]->ContainerPtrToValuePtr<FPaperZDAnimNode_Sink>(InClassDefaultObject);
+	SinkNode->Program = this;
+	return true;
+}
+
+void FPaperZDAnimProgram::Update(FPaperZDAnimNode_Base* SinkNode, const FPaperZDAnimationUpdateContext& Context) const
+{
+	//The sink already ran its own exposed values, start from the next node
+	for (int32 i = 1; i < Instructions.Num(); i++)
+	{
+		const FPaperZDAnimProgramInstruction& Instruction = Instructions[i];
+		FPaperZDAnimNode_Base* AnimNode = GetNode(SinkNode, Instruction);
+
+		//Fallback nodes go through the regular update, which opens their own trace and cost scopes
+		if (Instruction.Op == EPaperZDAnimProgramOp::Fallback)
+		{
+			AnimNode->Update(Context);
+			continue;
+		}
+
+		//Same scopes the recursive update opens, though they end up as siblings on the trace instead of nested under their output node
+		PAPERZD_TRACE_SCOPE(AnimNode->NodeStruct ? AnimNode->NodeStruct->GetFName() : NAME_None);
+		PAPERZD_COST_SCOPE(Context.AnimInstance, Node, true, true, AnimNode->NodeLinkID);
+		switch (Instruction.Op)
+		{
+			case EPaperZDAnimProgramOp::PassThrough:
+				AnimNode->UpdateExposedValues(Context);
+				break;
+			case EPaperZDAnimProgramOp::SetDirectionality:
+				AnimNode->UpdateExposedValues(Context);
+				static_cast<FPaperZDAnimNode_SetDirectionality*>(AnimNode)->UpdateDirectionalAngle();
+				break;
+			case EPaperZDAnimProgramOp::PlaySequence:
+			{
+				//Qualified call, avoids the virtual dispatch
+				FPaperZDAnimNode_PlaySequence* PlayNode = static_cast<FPaperZDAnimNode_PlaySequence*>(AnimNode);
+				PlayNode->UpdateExposedValues(Context);
+				PlayNode->FPaperZDAnimNode_PlaySequence::OnUpdate(Context);
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+void FPaperZDAnimProgram::Evaluate(FPaperZDAnimNode_Base* SinkNode, FPaperZDAnimationPlaybackData& OutData) const
+{
+	//Leaf first, so every node can overwrite the data its input produced
+	for (int32 i = Instructions.Num() - 1; i > 0; i--)
+	{
+		const FPaperZDAnimProgramInstruction& Instruction = Instructions[i];
+		FPaperZDAnimNode_Base* AnimNode = GetNode(SinkNode, Instruction);
+		switch (Instruction.Op)
+		{
+			case EPaperZDAnimProgramOp::PassThrough:
+				break;
+			case EPaperZDAnimProgramOp::SetDirectionality:
+				OutData.DirectionalAngle = static_cast<FPaperZDAnimNode_SetDirectionality*>(AnimNode)->GetDirectionalAngle();
+				break;
+			case EPaperZDAnimProgramOp::PlaySequence:
+				static_cast<FPaperZDAnimNode_PlaySequence*>(AnimNode)->FPaperZDAnimNode_PlaySequence::OnEvaluate(OutData);
+				break;
+			case EPaperZDAnimProgramOp::Fallback:
+				AnimNode->Evaluate(OutData);
+				break;
+		}
+	}
+}
+
+void FPaperZDAnimProgram::InitClass(TArray<FPaperZDAnimProgram>& Programs, UPaperZDAnimBPGeneratedClass* InClass, UObject* InClassDefaultObject)
+{
+	for (FPaperZDAnimProgram& Program : Programs)
+	{
+		//Sinks without a valid program keep running through their links
+		if (!Program.Initialize(InClass, InClassDefaultObject))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Cannot bind the linear animation program on class '%s', the graph will be updated recursively. Recompile the AnimBP."), *InClass->GetName());
+		}
+	}
+}
@@ -2,28 +2,111 @@
 
 #include "AnimNodes/PaperZDAnimStateMachine.h"
 #include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDProfiler.h"
 
-bool FPaperZDAnimStateMachineTransitionRule::EvaluateRule(UObject* AnimInstance) const
+namespace FPaperZDTransitionRuleHelpers
 {
-	if (bDynamicRule)
+	/* Reads the given property from the container as a double, booleans are read as 0/1. */
+	double ReadPropertyAsDouble(const FProperty* Property, const void* Container)
 	{
-		if (UFunction* Function = AnimInstance->FindFunction(RuleFunctionName))
+		const void* ValuePtr = Property->ContainerPtrToValuePtr<void>(Container);
+		if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			return BoolProperty->GetPropertyValue(ValuePtr) ? 1.0 : 0.0;
+		}
+		else if (const FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property))
+		{
+			return NumericProperty->IsFloatingPoint() ? NumericProperty->GetFloatingPointPropertyValue(ValuePtr) : (double)NumericProperty->GetSignedIntPropertyValue(ValuePtr);
+		}
+		else if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+		{
+			return (double)EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(ValuePtr);
+		}
+
+		return 0.0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Transition rule
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDAnimStateMachineTransitionRule::Initialize(UClass* InClass)
+{
+	CachedRuleFunction = nullptr;
+	ReturnValueOffset = INDEX_NONE;
+	bRuleFunctionResolved = false;
+
+	//FindFunction accesses a shared map in the class, so it can only run on the game thread. Classes initialized while async loading resolve it on the first evaluation
+	if (IsInGameThread())
+	{
+		ResolveRuleFunction(InClass);
+	}
+}
+
+void FPaperZDAnimStateMachineTransitionRule::ResolveRuleFunction(const UClass* InClass) const
+{
+	check(IsInGameThread());
+	bRuleFunctionResolved = true;
+
+	if (bDynamicRule && !bNativeRule)
+	{
+		CachedRuleFunction = InClass->FindFunctionByName(RuleFunctionName);
+		if (CachedRuleFunction)
+		{
+			//Precompute where the return value lives, so we don't need to iterate the parameters on every evaluation
+			for (TFieldIterator<FProperty> PropIt(CachedRuleFunction, EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
+			{
+				FProperty* Property = *PropIt;
+				if (Property->HasAnyPropertyFlags(CPF_OutParm) && Property->IsA<FBoolProperty>())
+				{
+					ReturnValueOffset = Property->GetOffset_ForUFunction();
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool FPaperZDAnimStateMachineTransitionRule::EvaluateRule(UObject* AnimInstance, const TArray<FPaperZDTransitionRuleInstruction>& RuleProgram) const
+{
+	if (bNativeRule)
+	{
+		return EvaluateNativeProgram(AnimInstance, RuleProgram);
+	}
+	else if (bDynamicRule)
+	{
+		//Rules that didn't go through the class initialization on the game thread still need to search for their function
+		if (!bRuleFunctionResolved)
+		{
+			ResolveRuleFunction(AnimInstance->GetClass());
+		}
+
+		UFunction* Function = CachedRuleFunction;
+		if (Function)
 		{
 			//Create Buffer and call function
 			uint8* Buffer = (uint8*)FMemory_Alloca(Function->ParmsSize);
 			FMemory::Memzero(Buffer, Function->ParmsSize);
+			FPaperZDProfiler::CountBlueprintCall(AnimInstance);
 			AnimInstance->ProcessEvent(Function, Buffer);
 
 			//Obtain the return value (Out Parameters)
 			bool bRuleValue = false;
-			for (TFieldIterator<FProperty> PropIt(Function, EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
+			if (ReturnValueOffset != INDEX_NONE)
 			{
-				FProperty* Property = *PropIt;
-				if (Property->HasAnyPropertyFlags(CPF_OutParm)) {
-					uint8* OutValueAddr = Property->ContainerPtrToValuePtr<uint8>(Buffer);
-					bool* pReturn = (bool*)OutValueAddr;
-					bRuleValue = *pReturn;
-					break;
+				bRuleValue = *(bool*)(Buffer + ReturnValueOffset);
+			}
+			else
+			{
+				for (TFieldIterator<FProperty> PropIt(Function, EFieldIteratorFlags::ExcludeSuper); PropIt; ++PropIt)
+				{
+					FProperty* Property = *PropIt;
+					if (Property->HasAnyPropertyFlags(CPF_OutParm)) {
+						uint8* OutValueAddr = Property->ContainerPtrToValuePtr<uint8>(Buffer);
+						bool* pReturn = (bool*)OutValueAddr;
+						bRuleValue = *pReturn;
+						break;
+					}
 				}
 			}
 
@@ -38,5 +121,84 @@ bool FPaperZDAnimStateMachineTransitionRule::EvaluateRule(UObject* AnimInstance)
 	else
 	{
 		return bConstantValue;
-	}	
-}
\ No newline at end of file
+	}
+}
+
+bool FPaperZDAnimStateMachineTransitionRule::EvaluateNativeProgram(UObject* AnimInstance, const TArray<FPaperZDTransitionRuleInstruction>& RuleProgram) const
+{
+	double Stack[FPaperZDTransitionRuleInstruction::MaxStackSize];
+	int32 StackSize = 0;
+
+	const int32 ProgramEnd = NativeProgramIndex + NativeProgramLength;
+	for (int32 i = NativeProgramIndex; i < ProgramEnd; i++)
+	{
+		const FPaperZDTransitionRuleInstruction& Instruction = RuleProgram[i];
+		switch (Instruction.Op)
+		{
+			case EPaperZDTransitionRuleOp::Constant:
+				Stack[StackSize++] = Instruction.ConstantValue;
+				break;
+			case EPaperZDTransitionRuleOp::ReadProperty:
+				Stack[StackSize++] = Instruction.CachedProperty ? FPaperZDTransitionRuleHelpers::ReadPropertyAsDouble(Instruction.CachedProperty, AnimInstance) : 0.0;
+				break;
+			case EPaperZDTransitionRuleOp::Not:
+				Stack[StackSize - 1] = Stack[StackSize - 1] != 0.0 ? 0.0 : 1.0;
+				break;
+			default:
+			{
+				//Every other operation is binary, pop both operands and push the result
+				const double B = Stack[--StackSize];
+				const double A = Stack[StackSize - 1];
+				bool bResult = false;
+				switch (Instruction.Op)
+				{
+					case EPaperZDTransitionRuleOp::And:				bResult = A != 0.0 && B != 0.0;		break;
+					case EPaperZDTransitionRuleOp::Or:				bResult = A != 0.0 || B != 0.0;		break;
+					case EPaperZDTransitionRuleOp::Xor:				bResult = (A != 0.0) != (B != 0.0);	break;
+					case EPaperZDTransitionRuleOp::Less:			bResult = A < B;					break;
+					case EPaperZDTransitionRuleOp::LessEqual:		bResult = A <= B;					break;
+					case EPaperZDTransitionRuleOp::Greater:			bResult = A > B;					break;
+					case EPaperZDTransitionRuleOp::GreaterEqual:	bResult = A >= B;					break;
+					case EPaperZDTransitionRuleOp::Equal:			bResult = A == B;					break;
+					case EPaperZDTransitionRuleOp::NotEqual:		bResult = A != B;					break;
+					default:										checkNoEntry();						break;
+				}
+				Stack[StackSize - 1] = bResult ? 1.0 : 0.0;
+				break;
+			}
+		}
+	}
+
+	return StackSize > 0 && Stack[StackSize - 1] != 0.0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// State machine
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDAnimStateMachine::Initialize(UClass* InClass)
+{
+	for (FPaperZDTransitionRuleInstruction& Instruction : RuleProgram)
+	{
+		if (Instruction.Op == EPaperZDTransitionRuleOp::ReadProperty)
+		{
+			Instruction.CachedProperty = FindFProperty<FProperty>(InClass, Instruction.PropertyName);
+			if (!Instruction.CachedProperty)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Cannot find property '%s' used by a transition rule on state machine '%s' of class '%s'"), *Instruction.PropertyName.ToString(), *MachineName.ToString(), *InClass->GetName());
+			}
+		}
+	}
+
+	for (FPaperZDAnimStateMachineTransitionRule& Rule : TransitionRules)
+	{
+		Rule.Initialize(InClass);
+	}
+}
+
+void FPaperZDAnimStateMachine::InitClass(TArray<FPaperZDAnimStateMachine>& StateMachines, UClass* InClass)
+{
+	for (FPaperZDAnimStateMachine& StateMachine : StateMachines)
+	{
+		StateMachine.Initialize(InClass);
+	}
+}
@@ -0,0 +1,234 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "AnimSequences/PaperZDAnimNotifyIndex.h"
+#include "Notifies/PaperZDAnimNotify.h"
+#include "Notifies/PaperZDAnimNotifyState.h"
+#include "Algo/StableSort.h"
+
+namespace FPaperZDAnimNotifyIndexHelpers
+{
+	/* Time in which the notify stops being active, point notifies end at the same time they trigger. */
+	float GetEndTime(const UPaperZDAnimNotify_Base* Notify)
+	{
+		const UPaperZDAnimNotifyState* StateNotify = Cast<const UPaperZDAnimNotifyState>(Notify);
+		return StateNotify ? Notify->Time + StateNotify->Duration : Notify->Time;
+	}
+
+	/* Hash of the notify array, in order. */
+	uint32 HashNotifies(const TArray<UPaperZDAnimNotify_Base*>& AnimNotifies)
+	{
+		uint32 Hash = 0;
+		for (const UPaperZDAnimNotify_Base* Notify : AnimNotifies)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Notify));
+		}
+		return Hash;
+	}
+
+	/* Checks that every entry still holds the times of its notify. */
+	bool AreEntriesUpToDate(const TArray<FPaperZDAnimNotifyIndex::FEntry>& Entries)
+	{
+		for (const FPaperZDAnimNotifyIndex::FEntry& Entry : Entries)
+		{
+			if (Entry.StartTime != Entry.Notify->Time || Entry.EndTime != GetEndTime(Entry.Notify))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/* Keeps the closest notify found while searching for the next one the playback reaches. */
+	struct FNextNotifySearch
+	{
+		float Time;
+		bool bLooping;
+		bool bReverse;
+		float BestReachTime;
+		bool bBestWrapped;
+		bool bFound;
+
+		FNextNotifySearch(float InTime, bool bInLooping, bool bInReverse)
+			: Time(InTime)
+			, bLooping(bInLooping)
+			, bReverse(bInReverse)
+			, BestReachTime(0.0f)
+			, bBestWrapped(false)
+			, bFound(false)
+		{}
+
+		/* Considers a notify reached at the given time, returns true if it's the closest one so far. */
+		bool Consider(float ReachTime)
+		{
+			//Notifies that need the playback to loop are always considered further away than the ones that don't
+			const bool bWrapped = bReverse ? ReachTime > Time : ReachTime < Time;
+			if (bWrapped && !bLooping)
+			{
+				return false;
+			}
+
+			const bool bCloser = !bFound || (bWrapped != bBestWrapped ? !bWrapped : (bReverse ? ReachTime > BestReachTime : ReachTime < BestReachTime));
+			if (bCloser)
+			{
+				BestReachTime = ReachTime;
+				bBestWrapped = bWrapped;
+				bFound = true;
+			}
+
+			return bCloser;
+		}
+	};
+}
+
+FPaperZDAnimNotifyIndex::FPaperZDAnimNotifyIndex()
+	: PackedNotifies(nullptr)
+	, MaxStateDuration(0.0f)
+	, NumSourceNotifies(0)
+	, SourceNotifiesHash(0)
+	, bBuilt(false)
+{}
+
+void FPaperZDAnimNotifyIndex::Build(const TArray<UPaperZDAnimNotify_Base*>& AnimNotifies, const TArray<FPaperZDPackedNotify>* InPackedNotifies /* = nullptr */)
+{
+	PointNotifies.Reset();
+	StateNotifies.Reset();
+	UnindexedNotifies.Reset();
+	PackedNotifies = InPackedNotifies;
+	MaxStateDuration = 0.0f;
+
+	for (UPaperZDAnimNotify_Base* Notify : AnimNotifies)
+	{
+		if (!Notify)
+		{
+			continue;
+		}
+
+		const FEntry Entry = { Notify, Notify->Time, FPaperZDAnimNotifyIndexHelpers::GetEndTime(Notify) };
+		if (Notify->IsA<UPaperZDAnimNotifyState>())
+		{
+			StateNotifies.Add(Entry);
+			MaxStateDuration = FMath::Max(MaxStateDuration, Entry.EndTime - Entry.StartTime);
+		}
+		else if (Notify->IsA<UPaperZDAnimNotify>())
+		{
+			PointNotifies.Add(Entry);
+		}
+		else
+		{
+			UnindexedNotifies.Add(Entry);
+		}
+	}
+
+	//Stable sort, notifies that share the same time keep triggering in the order they were added
+	auto SortByTime = [](const FEntry& A, const FEntry& B) { return A.StartTime < B.StartTime; };
+	Algo::StableSort(PointNotifies, SortByTime);
+	Algo::StableSort(StateNotifies, SortByTime);
+
+	NumSourceNotifies = AnimNotifies.Num();
+	SourceNotifiesHash = FPaperZDAnimNotifyIndexHelpers::HashNotifies(AnimNotifies);
+	bBuilt = true;
+}
+
+bool FPaperZDAnimNotifyIndex::IsUpToDate(const TArray<UPaperZDAnimNotify_Base*>& AnimNotifies) const
+{
+	return bBuilt
+		&& NumSourceNotifies == AnimNotifies.Num()
+		&& SourceNotifiesHash == FPaperZDAnimNotifyIndexHelpers::HashNotifies(AnimNotifies)
+		&& FPaperZDAnimNotifyIndexHelpers::AreEntriesUpToDate(PointNotifies)
+		&& FPaperZDAnimNotifyIndexHelpers::AreEntriesUpToDate(StateNotifies)
+		&& FPaperZDAnimNotifyIndexHelpers::AreEntriesUpToDate(UnindexedNotifies);
+}
+
+const FPaperZDAnimNotifyIndex::FEntry* FPaperZDAnimNotifyIndex::FindNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse) const
+{
+	const FEntry* BestEntry = nullptr;
+	FPaperZDAnimNotifyIndexHelpers::FNextNotifySearch Search(Time, bLooping, bReverse);
+	auto ConsiderEntries = [&](const TArray<FEntry>& Entries)
+	{
+		for (const FEntry& Entry : Entries)
+		{
+			if ((!NotifyClass || Entry.Notify->IsA(NotifyClass)) && Search.Consider(bReverse ? Entry.EndTime : Entry.StartTime))
+			{
+				BestEntry = &Entry;
+			}
+		}
+	};
+
+	ConsiderEntries(PointNotifies);
+	ConsiderEntries(StateNotifies);
+	ConsiderEntries(UnindexedNotifies);
+	return BestEntry;
+}
+
+bool FPaperZDAnimNotifyIndex::FindNextNotifyTime(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutTime) const
+{
+	FPaperZDAnimNotifyIndexHelpers::FNextNotifySearch Search(Time, bLooping, bReverse);
+	if (const FEntry* Entry = FindNextNotify(NotifyClass, Time, bLooping, bReverse))
+	{
+		Search.Consider(bReverse ? Entry->EndTime : Entry->StartTime);
+	}
+
+	if (PackedNotifies)
+	{
+		for (const FPaperZDPackedNotify& PackedNotify : *PackedNotifies)
+		{
+			if (!NotifyClass || PackedNotify.GetNotifyClass()->IsChildOf(NotifyClass))
+			{
+				Search.Consider(PackedNotify.Time);
+			}
+		}
+	}
+
+	OutTime = Search.BestReachTime;
+	return Search.bFound;
+}
+
+bool FPaperZDAnimNotifyIndex::NeedsTickAt(float Time) const
+{
+	if (UnindexedNotifies.Num())
+	{
+		return true;
+	}
+
+	for (int32 i = LowerBound(StateNotifies, Time - MaxStateDuration - KINDA_SMALL_NUMBER); i < StateNotifies.Num() && StateNotifies[i].StartTime < Time; i++)
+	{
+		if (StateNotifies[i].IsActiveAt(Time))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FPaperZDAnimNotifyIndex::GetNotifiesInRange(float StartTime, float EndTime, TArray<UPaperZDAnimNotify_Base*>& OutNotifies) const
+{
+	TArray<const FEntry*, TInlineAllocator<16>> FoundEntries;
+	for (int32 i = LowerBound(PointNotifies, StartTime); i < PointNotifies.Num() && PointNotifies[i].StartTime <= EndTime; i++)
+	{
+		FoundEntries.Add(&PointNotifies[i]);
+	}
+
+	for (int32 i = LowerBound(StateNotifies, StartTime - MaxStateDuration - KINDA_SMALL_NUMBER); i < StateNotifies.Num() && StateNotifies[i].StartTime <= EndTime; i++)
+	{
+		if (StateNotifies[i].EndTime >= StartTime)
+		{
+			FoundEntries.Add(&StateNotifies[i]);
+		}
+	}
+
+	for (const FEntry& Entry : UnindexedNotifies)
+	{
+		if (Entry.StartTime <= EndTime && Entry.EndTime >= StartTime)
+		{
+			FoundEntries.Add(&Entry);
+		}
+	}
+
+	Algo::StableSort(FoundEntries, [](const FEntry* A, const FEntry* B) { return A->StartTime < B->StartTime; });
+	OutNotifies.Reserve(OutNotifies.Num() + FoundEntries.Num());
+	for (const FEntry* Entry : FoundEntries)
+	{
+		OutNotifies.Add(Entry->Notify);
+	}
+}
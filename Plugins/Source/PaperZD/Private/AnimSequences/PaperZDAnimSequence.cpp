@@ -6,6 +6,9 @@
 #include "Components/PrimitiveComponent.h"
 #include "IPaperZDEditorProxy.h"
 #include "PaperZDCustomVersion.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectArray.h"
+#include "Algo/StableSort.h"
 
 //Setup static variables
 const FName UPaperZDAnimSequence::DefaultCategory(TEXT("Default"));
@@ -13,6 +16,19 @@ const FName UPaperZDAnimSequence::AnimSourceMemberName(TEXT("AnimSource"));
 
 #define MAX_NUM_TRACKS 10
 
+//Console variables
+static TAutoConsoleVariable<int32> CVarClusterAnimSequences(
+	TEXT("paperzd.ClusterAnimSequences"),
+	1,
+	TEXT("If non zero, cooked AnimSequences loaded from now on become garbage collection clusters along with their data sources and the notifies that weren't packed."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarPackBuiltInNotifies(
+	TEXT("paperzd.PackBuiltInNotifies"),
+	1,
+	TEXT("If non zero, the built-in notifies (play sound, particle effect and custom notifies) of the AnimSequences get cooked as packed records instead of notify objects. Packed notifies don't need to join the cluster of their sequence, as they aren't objects."),
+	ECVF_Default);
+
 //List of optional metadata specifiers
 namespace FPaperZDAnimSequenceDefaults
 {
@@ -22,6 +38,11 @@ namespace FPaperZDAnimSequenceDefaults
 UPaperZDAnimSequence::UPaperZDAnimSequence(const FObjectInitializer& ObjectInitializer)
 	: Super()
 	, CachedAnimDataSourceProperty(nullptr)
+	, CachedAnimDataSourceArray(nullptr)
+	, CachedAnimDataSourceElementSize(0)
+	, DirectionalLookupScale(0.0f)
+	, DirectionalLookupNum(0)
+	, DirectionalLookupOffset(0.0f)
 	, bDirectionalSequence(false)
 	, DirectionalAngleOffset(0.0f)
 	, DirectionalPreviewIndex(0)
@@ -32,6 +53,37 @@ UPaperZDAnimSequence::UPaperZDAnimSequence(const FObjectInitializer& ObjectIniti
 	Category = UPaperZDAnimSequence::DefaultCategory;
 }
 
+bool UPaperZDAnimSequence::CanBeClusterRoot() const
+{
+	return CanCreateClusters();
+}
+
+void UPaperZDAnimSequence::CreateCluster()
+{
+	//The animation source is shared by the whole library, absorbing it would make every other sequence keep this cluster alive
+	CreateDependencyCluster(AnimSource);
+	Super::CreateCluster();
+}
+
+bool UPaperZDAnimSequence::CanCreateClusters()
+{
+	//Queried while loading, which can happen outside of the game thread
+	return CVarClusterAnimSequences.GetValueOnAnyThread() != 0;
+}
+
+void UPaperZDAnimSequence::CreateDependencyCluster(UObject* Dependency)
+{
+	//Objects that are still loading don't know all of their references yet, the engine clusters them once they finish
+	if (Dependency && !Dependency->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad) && Dependency->CanBeClusterRoot())
+	{
+		const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(Dependency);
+		if (ObjectItem->GetOwnerIndex() == 0 && !ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot))
+		{
+			Dependency->CreateCluster();
+		}
+	}
+}
+
 void UPaperZDAnimSequence::PostLoad()
 {
 	Super::PostLoad();
@@ -45,6 +97,12 @@ void UPaperZDAnimSequence::PostLoad()
 		IPaperZDEditorProxy::Get()->UpdateVersionToAnimationSourceAdded(this);
 	}
 #endif
+
+	//Notifies are loaded at this point, index them so the playback doesn't need to go through all of them every tick
+	NotifyIndex.Build(AnimNotifies, &PackedNotifies);
+
+	//Same with the directional data, which is used on every render update
+	BuildDirectionalLookupTable();
 }
 
 void UPaperZDAnimSequence::Serialize(FArchive& Ar)
@@ -53,6 +111,72 @@ void UPaperZDAnimSequence::Serialize(FArchive& Ar)
 	Ar.UsingCustomVersion(FPaperZDCustomVersion::GUID);
 }
 
+#if WITH_EDITOR
+void UPaperZDAnimSequence::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	//The cooked data gets the packed records instead of the built-in notifies, the editor gets its notifies back once the package is saved
+	//A target platform is only given when cooking
+	if (TargetPlatform && CVarPackBuiltInNotifies.GetValueOnAnyThread() != 0 && CookSourceNotifies.Num() == 0)
+	{
+		CookSourceNotifies = AnimNotifies;
+		PackBuiltInNotifies();
+	}
+}
+
+void UPaperZDAnimSequence::PostSaveRoot(bool bCleanupIsRequired)
+{
+	Super::PostSaveRoot(bCleanupIsRequired);
+
+	if (CookSourceNotifies.Num())
+	{
+		for (UPaperZDAnimNotify_Base* Notify : CookSourceNotifies)
+		{
+			if (Notify)
+			{
+				Notify->ClearFlags(RF_Transient);
+			}
+		}
+
+		AnimNotifies = MoveTemp(CookSourceNotifies);
+		CookSourceNotifies.Reset();
+		PackedNotifies.Empty();
+		PackedNotifyTransforms.Empty();
+	}
+}
+
+void UPaperZDAnimSequence::PackBuiltInNotifies()
+{
+	PackedNotifies.Reset();
+	PackedNotifyTransforms.Reset();
+	for (int32 i = 0; i < AnimNotifies.Num(); i++)
+	{
+		FPaperZDPackedNotify PackedNotify;
+		UPaperZDAnimNotify_Base* Notify = AnimNotifies[i];
+		if (Notify && !Notify->HasAnyFlags(RF_Transient))
+		{
+			PackedNotify.Time = Notify->Time;
+			if (Notify->PackNotify(PackedNotify, PackedNotifyTransforms))
+			{
+				//Subobjects get exported even when nothing references them, transient ones are left out of the package
+				Notify->SetFlags(RF_Transient);
+				PackedNotifies.Add(PackedNotify);
+				AnimNotifies.RemoveAt(i--);
+			}
+		}
+	}
+
+	if (PackedNotifies.Num())
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("PaperZD: Packed %d of %d notifies of '%s' (%d bytes of records)."), PackedNotifies.Num(), CookSourceNotifies.Num(), *GetPathName(), PackedNotifies.GetAllocatedSize() + PackedNotifyTransforms.GetAllocatedSize());
+	}
+
+	//Stable sort, notifies that share the same time keep triggering in the order they were added
+	Algo::StableSort(PackedNotifies, [](const FPaperZDPackedNotify& A, const FPaperZDPackedNotify& B) { return A.Time < B.Time; });
+}
+#endif
+
 void UPaperZDAnimSequence::PostInitProperties()
 {
 	Super::PostInitProperties();
@@ -74,6 +198,44 @@ const TArray<UPaperZDAnimNotify_Base*>& UPaperZDAnimSequence::GetAnimNotifies()
 	return AnimNotifies;
 }
 
+const FPaperZDAnimNotifyIndex& UPaperZDAnimSequence::GetNotifyIndex() const
+{
+#if WITH_EDITOR
+	//Notifies can be added or moved at any time on the editor, rebuild if they don't match anymore
+	if (!NotifyIndex.IsUpToDate(AnimNotifies))
+#else
+	if (!NotifyIndex.IsBuilt())
+#endif
+	{
+		NotifyIndex.Build(AnimNotifies, &PackedNotifies);
+	}
+
+	return NotifyIndex;
+}
+
+UPaperZDAnimNotify_Base* UPaperZDAnimSequence::FindNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutNotifyTime) const
+{
+	const FPaperZDAnimNotifyIndex::FEntry* Entry = GetNotifyIndex().FindNextNotify(NotifyClass, Time, bLooping, bReverse);
+	if (Entry)
+	{
+		OutNotifyTime = bReverse ? Entry->EndTime : Entry->StartTime;
+		return Entry->Notify;
+	}
+
+	OutNotifyTime = 0.0f;
+	return nullptr;
+}
+
+bool UPaperZDAnimSequence::FindNextNotifyTime(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutNotifyTime) const
+{
+	return GetNotifyIndex().FindNextNotifyTime(NotifyClass, Time, bLooping, bReverse, OutNotifyTime);
+}
+
+void UPaperZDAnimSequence::GetNotifiesInRange(float StartTime, float EndTime, TArray<UPaperZDAnimNotify_Base*>& OutNotifies) const
+{
+	GetNotifyIndex().GetNotifiesInRange(StartTime, EndTime, OutNotifies);
+}
+
 FName UPaperZDAnimSequence::GetSequenceName() const
 {
 	return GetFName();
@@ -127,6 +289,10 @@ void UPaperZDAnimSequence::InitDataSource()
 	//If we do have a valid data source, we need to make sure its initial state is valid as well
 	if (CachedAnimDataSourceProperty)
 	{
+		//The array lives inside this object, so its address stays valid even if its contents get reallocated
+		CachedAnimDataSourceArray = CachedAnimDataSourceProperty->ContainerPtrToValuePtr<FScriptArray>(this);
+		CachedAnimDataSourceElementSize = CachedAnimDataSourceProperty->Inner->ElementSize;
+
 		FScriptArrayHelper ArrayHelper(CachedAnimDataSourceProperty, CachedAnimDataSourceProperty->ContainerPtrToValuePtr<uint8>(this));
 
 		//If we have no entries, this sequence was just created and we need to make sure its initial state is valid
@@ -138,10 +304,65 @@ void UPaperZDAnimSequence::InitDataSource()
 	}
 }
 
+void UPaperZDAnimSequence::BuildDirectionalLookupTable()
+{
+	checkSlow(IsInGameThread());
+
+	const int32 Num = CachedAnimDataSourceArray ? CachedAnimDataSourceArray->Num() : 0;
+	DirectionalLookupNum = Num;
+	DirectionalLookupOffset = DirectionalAngleOffset;
+	DirectionalLookupTable.Reset();
+
+	if (Num > 1)
+	{
+		//Each direction covers an area centered on its angle, so the boundaries are shifted by half a direction plus the offset
+		const int32 NumBins = Num * 2;
+		const float AngleSepparation = 360.0f / Num;
+		const float BinSize = 360.0f / NumBins;
+		const float AngleBias = DirectionalAngleOffset + AngleSepparation / 2.0f;
+		DirectionalLookupScale = NumBins / 360.0f;
+
+		DirectionalLookupTable.SetNumUninitialized(NumBins);
+		for (int32 i = 0; i < NumBins; i++)
+		{
+			const float BinStart = i * BinSize;
+			const int32 Area = FMath::FloorToInt((BinStart + AngleBias) / AngleSepparation);
+
+			FPaperZDDirectionalLookupBin& Bin = DirectionalLookupTable[i];
+			Bin.Index = ((Area % Num) + Num) % Num;
+			Bin.SplitIndex = (Bin.Index + 1) % Num;
+			Bin.SplitAngle = (Area + 1) * AngleSepparation - AngleBias;
+		}
+	}
+}
+
+int32 UPaperZDAnimSequence::ComputeDirectionalIndex(float DirectionalAngle, int32 NumDirections) const
+{
+	//Same areas the lookup table is built with
+	const float AngleSepparation = 360.0f / NumDirections;
+	const float AngleBias = DirectionalAngleOffset + AngleSepparation / 2.0f;
+	const int32 Area = FMath::FloorToInt((DirectionalAngle + AngleBias) / AngleSepparation);
+	return ((Area % NumDirections) + NumDirections) % NumDirections;
+}
+
+void UPaperZDAnimSequence::Prewarm(float TextureResidentTime) const
+{
+	//The directional lookup table is already built on load, nothing else to prepare on the base sequence
+}
+
 #if WITH_EDITOR
+void UPaperZDAnimSequence::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	//Directions or their offset could have changed
+	BuildDirectionalLookupTable();
+}
+
 void UPaperZDAnimSequence::PostEditUndo()
 {
 	Super::PostEditUndo();
+	BuildDirectionalLookupTable();
 
 	//@TODO: we can get away with removing this by adding a listener on the editor window instead
 	OnPostEditUndo.ExecuteIfBound();
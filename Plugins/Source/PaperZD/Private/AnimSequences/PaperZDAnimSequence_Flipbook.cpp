@@ -2,6 +2,8 @@
 
 #include "AnimSequences/PaperZDAnimSequence_Flipbook.h"
 #include "PaperZDCustomVersion.h"
+#include "PaperSprite.h"
+#include "Engine/Texture2D.h"
 
 void UPaperZDAnimSequence_Flipbook::PostLoad()
 {
@@ -43,3 +45,72 @@ bool UPaperZDAnimSequence_Flipbook::IsDataSourceEntrySet(int32 EntryIndex) const
 {
 	return AnimDataSource.IsValidIndex(EntryIndex) ? AnimDataSource[EntryIndex] != nullptr : false;
 }
+
+float UPaperZDAnimSequence_Flipbook::GetTimeToNextVisibleChange(float Time, bool bReverse) const
+{
+	//The direction can change at any time, so the closest change among every directional flipbook is used
+	float TimeToChange = MAX_flt;
+	for (const UPaperFlipbook* Flipbook : AnimDataSource)
+	{
+		const int32 NumKeyFrames = Flipbook ? Flipbook->GetNumKeyFrames() : 0;
+		const float FramesPerSecond = Flipbook ? Flipbook->GetFramesPerSecond() : 0.0f;
+		if (NumKeyFrames < 2 || FramesPerSecond <= 0.0f)
+		{
+			continue;
+		}
+
+		//Same accumulation as UPaperFlipbook::GetKeyFrameIndexAtTime, a keyframe is displayed up to its end time inclusive
+		float FrameStartTime = 0.0f;
+		for (int32 KeyFrameIndex = 0; KeyFrameIndex < NumKeyFrames; KeyFrameIndex++)
+		{
+			const float FrameEndTime = FrameStartTime + Flipbook->GetKeyFrameChecked(KeyFrameIndex).FrameRun / FramesPerSecond;
+			if (Time <= FrameEndTime || KeyFrameIndex == NumKeyFrames - 1)
+			{
+				//The first and last keyframes extend until the sequence loops or ends
+				if (bReverse && KeyFrameIndex > 0)
+				{
+					TimeToChange = FMath::Min(TimeToChange, Time - FrameStartTime);
+				}
+				else if (!bReverse && KeyFrameIndex < NumKeyFrames - 1)
+				{
+					TimeToChange = FMath::Min(TimeToChange, FrameEndTime - Time + KINDA_SMALL_NUMBER);
+				}
+				break;
+			}
+
+			FrameStartTime = FrameEndTime;
+		}
+	}
+
+	return FMath::Max(TimeToChange, 0.0f);
+}
+
+void UPaperZDAnimSequence_Flipbook::Prewarm(float TextureResidentTime) const
+{
+	Super::Prewarm(TextureResidentTime);
+
+	if (TextureResidentTime <= 0.0f)
+	{
+		return;
+	}
+
+	//Every direction could be displayed first, and keyframes usually share the same atlas
+	TSet<UTexture2D*> Textures;
+	for (const UPaperFlipbook* Flipbook : AnimDataSource)
+	{
+		const int32 NumKeyFrames = Flipbook ? Flipbook->GetNumKeyFrames() : 0;
+		for (int32 KeyFrameIndex = 0; KeyFrameIndex < NumKeyFrames; KeyFrameIndex++)
+		{
+			const UPaperSprite* Sprite = Flipbook->GetKeyFrameChecked(KeyFrameIndex).Sprite;
+			if (UTexture2D* Texture = Sprite ? Sprite->GetBakedTexture() : nullptr)
+			{
+				Textures.Add(Texture);
+			}
+		}
+	}
+
+	for (UTexture2D* Texture : Textures)
+	{
+		Texture->SetForceMipLevelsToBeResident(TextureResidentTime);
+	}
+}
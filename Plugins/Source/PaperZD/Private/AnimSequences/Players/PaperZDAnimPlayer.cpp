@@ -6,6 +6,7 @@
 #include "AnimSequences/PaperZDAnimSequence.h"
 #include "Components/PrimitiveComponent.h"
 #include "Notifies/PaperZDAnimNotify_Base.h"
+#include "PaperZDAnimInstance.h"
 #include "PaperZDStats.h"
 
 #define MIN_RELEVANT_WEIGHT 0.35f
@@ -13,56 +14,98 @@
 //Stats declarations
 DECLARE_CYCLE_STAT(TEXT("Execute AnimNotifies"), STAT_AnimNotifyTick, STATGROUP_PaperZD);
 
-UPaperZDAnimPlayer::UPaperZDAnimPlayer() : Super()
-{
-	bPlaying = true;
-	PlaybackMode = EAnimPlayerPlaybackMode::Forward;
-	bPreviewPlayer = false;
-	bFireSequenceChangedEvents = false;
-}
+FPaperZDAnimPlayerState::FPaperZDAnimPlayerState()
+	: PlaybackHandle(nullptr)
+	, PlayerObject(nullptr)
+	, EventInstance(nullptr)
+	, SequenceCompleteCount(0)
+	, NotifyPolicy(EPaperZDAnimLODNotifyPolicy::Fire)
+	, bHasPendingCatchUp(false)
+	, bTrackPlaybackEvents(false)
+	, PlaybackMode(EAnimPlayerPlaybackMode::Forward)
+	, bFireSequenceChangedEvents(false)
+	, bPlaying(true)
+	, bPreviewPlayer(false)
+	, bDeferGameThreadWork(false)
+{}
 
-float UPaperZDAnimPlayer::GetCurrentPlaybackTime() const
+float FPaperZDAnimPlayerState::GetCurrentPlaybackTime() const
 {
 	return LastWeightedAnimation.PlaybackTime;
 }
 
-float UPaperZDAnimPlayer::GetPlaybackProgress() const
+float FPaperZDAnimPlayerState::GetPlaybackProgress() const
 {	
 	const UPaperZDAnimSequence* PrimaryAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
 	return PrimaryAnimSequence && PrimaryAnimSequence->GetTotalDuration() > 0.0f ? LastWeightedAnimation.PlaybackTime / PrimaryAnimSequence->GetTotalDuration() : 0.0f;
 }
 
-const UPaperZDAnimSequence* UPaperZDAnimPlayer::GetCurrentAnimSequence() const
+const UPaperZDAnimSequence* FPaperZDAnimPlayerState::GetCurrentAnimSequence() const
 {
 	return LastWeightedAnimation.AnimSequencePtr.Get();
 }
 
-void UPaperZDAnimPlayer::ClearCachedAnimationData()
+EAnimPlayerPlaybackMode FPaperZDAnimPlayerState::GetPlaybackMode() const
 {
-	LastPlaybackData = FPaperZDAnimationPlaybackData();
+	return PlayerObject ? PlayerObject->PlaybackMode : PlaybackMode;
+}
+
+bool FPaperZDAnimPlayerState::ShouldFireSequenceChangedEvents() const
+{
+	return PlayerObject ? PlayerObject->bFireSequenceChangedEvents : bFireSequenceChangedEvents;
+}
+
+bool FPaperZDAnimPlayerState::GetTimeToNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, bool bLooping, float& OutTimeRemaining) const
+{
+	OutTimeRemaining = 0.0f;
+	const UPaperZDAnimSequence* PrimaryAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
+	if (PrimaryAnimSequence)
+	{
+		const bool bReverse = GetPlaybackMode() == EAnimPlayerPlaybackMode::Reversed;
+		const float PlaybackTime = LastWeightedAnimation.PlaybackTime;
+		float NotifyTime = 0.0f;
+		if (PrimaryAnimSequence->FindNextNotifyTime(NotifyClass, PlaybackTime, bLooping, bReverse, NotifyTime))
+		{
+			//Notifies found before the playback time (or after it, when reversed) are only reached after looping
+			const float TimeRemaining = bReverse ? PlaybackTime - NotifyTime : NotifyTime - PlaybackTime;
+			OutTimeRemaining = TimeRemaining < 0.0f ? TimeRemaining + PrimaryAnimSequence->GetTotalDuration() : TimeRemaining;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FPaperZDAnimPlayerState::ClearCachedAnimationData()
+{
+	LastPlaybackData.Reset();
 	LastWeightedAnimation = FPaperZDWeightedAnimation();
 }
 
-void UPaperZDAnimPlayer::ResumePlayback()
+void FPaperZDAnimPlayerState::ResumePlayback()
 {
 	bPlaying = true;
 }
 
-void UPaperZDAnimPlayer::PausePlayback()
+void FPaperZDAnimPlayerState::PausePlayback()
 {
 	bPlaying = false;
 }
 
-void UPaperZDAnimPlayer::Init(const UPaperZDAnimationSource* AnimationSource)
+void FPaperZDAnimPlayerState::Init(const UPaperZDAnimationSource* AnimationSource, UObject* Outer)
 {
 	if (AnimationSource && AnimationSource->GetPlaybackHandleClass())
 	{
 		//Create the playback handle  and initialize it via the animation source.
-		PlaybackHandle = NewObject<UPaperZDPlaybackHandle>(this, AnimationSource->GetPlaybackHandleClass());
+		PlaybackHandle = NewObject<UPaperZDPlaybackHandle>(Outer, AnimationSource->GetPlaybackHandleClass());
 		AnimationSource->InitPlaybackHandle(PlaybackHandle);
 
 		//By default allow the sequence changed events to trigger only on animation sources that do not blend, as those are the only ones that make sense to support.
 		bFireSequenceChangedEvents = !AnimationSource->SupportsBlending();
+		if (PlayerObject)
+		{
+			PlayerObject->bFireSequenceChangedEvents = bFireSequenceChangedEvents;
+		}
 
 		//Optionally configure the render component if it was setup before initializing
 		if (RegisteredRenderComponent.IsValid())
@@ -72,18 +115,61 @@ void UPaperZDAnimPlayer::Init(const UPaperZDAnimationSource* AnimationSource)
 	}
 }
 
-void UPaperZDAnimPlayer::SetIsPreviewPlayer(bool bInPreviewPlayer)
+void FPaperZDAnimPlayerState::ResetForReuse(const UPaperZDAnimationSource* AnimationSource)
+{
+	ClearCachedAnimationData();
+	DeferredNotifyTicks.Reset();
+	DeferredPlaybackEvents.Reset();
+	TrackedPlaybacks.Reset();
+	SequenceCompleteCount = 0;
+	NotifyPolicy = EPaperZDAnimLODNotifyPolicy::Fire;
+	bHasPendingCatchUp = false;
+	bTrackPlaybackEvents = false;
+	bDeferGameThreadWork = false;
+	bPlaying = true;
+	PlaybackMode = EAnimPlayerPlaybackMode::Forward;
+	if (AnimationSource && PlaybackHandle)
+	{
+		bFireSequenceChangedEvents = !AnimationSource->SupportsBlending();
+	}
+	OnPlaybackSequenceComplete_Native.Clear();
+
+	if (PlayerObject)
+	{
+		PlayerObject->PlaybackMode = PlaybackMode;
+		PlayerObject->bFireSequenceChangedEvents = bFireSequenceChangedEvents;
+
+		//Whoever used the instance before could have bound to our events
+		const UObject* OwningInstance = PlayerObject->GetOuter();
+		auto RemoveForeignBindings = [OwningInstance](auto& Delegate)
+		{
+			for (UObject* BoundObject : Delegate.GetAllObjects())
+			{
+				if (BoundObject != OwningInstance)
+				{
+					Delegate.RemoveAll(BoundObject);
+				}
+			}
+		};
+
+		RemoveForeignBindings(PlayerObject->OnPlaybackSequenceChanged);
+		RemoveForeignBindings(PlayerObject->OnPlaybackSequenceComplete);
+		RemoveForeignBindings(PlayerObject->OnPlaybackSequenceLooped);
+	}
+}
+
+void FPaperZDAnimPlayerState::SetIsPreviewPlayer(bool bInPreviewPlayer)
 {
 	bPreviewPlayer = bInPreviewPlayer;
 }
 
-bool UPaperZDAnimPlayer::IsRelevantWeight(float Weight) const
+bool FPaperZDAnimPlayerState::IsRelevantWeight(float Weight) const
 {
 	return Weight > MIN_RELEVANT_WEIGHT;
 }
 
 //Playback controls
-void UPaperZDAnimPlayer::TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance /* = nullptr */, float EffectiveWeight /* = 1.0f */, bool bSkipNotifies /* = false */)
+void FPaperZDAnimPlayerState::TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance /* = nullptr */, float EffectiveWeight /* = 1.0f */, bool bSkipNotifies /* = false */)
 {
 	if (AnimSequence && AnimSequence->GetTotalDuration() > 0.0f && bPlaying && DeltaTime != 0.0f)
 	{
@@ -92,17 +178,21 @@ void UPaperZDAnimPlayer::TickPlayback(const UPaperZDAnimSequence* AnimSequence,
 		UPrimitiveComponent* RenderComponent = nullptr;
 
 		//Find the render component for this class, if it exists
-		if (RegisteredRenderComponent.IsValid())
+		//Deferred work resolves it when flushing instead, as the weak pointer should only be checked on the game thread
+		if (!bDeferGameThreadWork)
 		{
-			RenderComponent = RegisteredRenderComponent.Get();
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Trying to tick AnimSequence '%s' without having registered a PrimitiveComponent as Renderer on AnimPlayer '%s'"), *AnimSequence->GetName(), *GetName());
+			if (RegisteredRenderComponent.IsValid())
+			{
+				RenderComponent = RegisteredRenderComponent.Get();
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Trying to tick AnimSequence '%s' without having registered a PrimitiveComponent as Renderer on AnimPlayer '%s'"), *AnimSequence->GetName(), *GetDebugName());
+			}
 		}
 		
 		//Adjust for forward/backwards
-		if (PlaybackMode == EAnimPlayerPlaybackMode::Reversed)
+		if (GetPlaybackMode() == EAnimPlayerPlaybackMode::Reversed)
 		{
 			DeltaTime *= -1.0f;
 		}
@@ -123,20 +213,26 @@ void UPaperZDAnimPlayer::TickPlayback(const UPaperZDAnimSequence* AnimSequence,
 		}
 		
 		//With the new playback marker set, we can go ahead and collect every AnimNotify object that should be triggered
+		//The notify policy set by the animation LOD can hold back or skip them
 		const bool bIsRelevant = IsRelevantWeight(EffectiveWeight);
-		if (bIsRelevant && !bSkipNotifies && RenderComponent)
+		const bool bProcessNotifies = bIsRelevant && !bSkipNotifies && NotifyPolicy != EPaperZDAnimLODNotifyPolicy::Skip;
+		if (bProcessNotifies && NotifyPolicy == EPaperZDAnimLODNotifyPolicy::CatchUp)
+		{
+			AccumulateCatchUpWindow({ AnimSequence, OwningInstance, DeltaTime, PlaybackMarker, PreviousTime });
+		}
+		else if (bProcessNotifies && bDeferGameThreadWork)
+		{
+			DeferredNotifyTicks.Add({ AnimSequence, OwningInstance, DeltaTime, PlaybackMarker, PreviousTime });
+		}
+		else if (bProcessNotifies && RenderComponent)
 		{
 			SCOPE_CYCLE_COUNTER(STAT_AnimNotifyTick);
-			for (UPaperZDAnimNotify_Base* Notify : AnimSequence->GetAnimNotifies())
-			{
-#if WITH_EDITOR
-				//Prevent from firing in editor if specifically requested
-				if (OwningInstance != nullptr || Notify->bShouldFireInEditor)
-#endif
-				{
-					Notify->TickNotify(DeltaTime, PlaybackMarker, PreviousTime, RenderComponent, OwningInstance);
-				}
-			}
+			TickNotifiesInWindow({ AnimSequence, OwningInstance, DeltaTime, PlaybackMarker, PreviousTime }, RenderComponent);
+		}
+
+		if (bTrackPlaybackEvents)
+		{
+			TrackedPlaybacks.Add({ AnimSequence, PlaybackMarker, DeltaTime, bLooping });
 		}
 
 		//Notify anyone who needs to know about looping or sequence playback completion
@@ -145,72 +241,327 @@ void UPaperZDAnimPlayer::TickPlayback(const UPaperZDAnimSequence* AnimSequence,
 			//We separate the delegates into two, one for looping, and one for playback completion
 			if (bLooping)
 			{
-				OnPlaybackSequenceLooped.Broadcast(AnimSequence);
+				if (bDeferGameThreadWork)
+				{
+					DeferredPlaybackEvents.Add({ AnimSequence, true });
+				}
+				else
+				{
+					BroadcastSequenceLooped(AnimSequence);
+				}
 			}
 			else if (PlaybackMarker != PreviousTime) //Make sure the animation actually just updated, instead of being stopped on the final frame of the animation due to a previous update
 			{
-				OnPlaybackSequenceComplete.Broadcast(AnimSequence);
+				if (bDeferGameThreadWork)
+				{
+					DeferredPlaybackEvents.Add({ AnimSequence, false });
+				}
+				else
+				{
+					BroadcastSequenceComplete(AnimSequence);
+				}
+
 				OnPlaybackSequenceComplete_Native.Broadcast(AnimSequence);
+				SequenceCompleteCount++;
 			}
 		}
 	}
 }
 
-void UPaperZDAnimPlayer::ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight /* = 1.0f */, UPaperZDAnimInstance* OwningInstance /* = nullptr */)
+void FPaperZDAnimPlayerState::BeginDeferredGameThreadWork()
+{
+	bDeferGameThreadWork = true;
+}
+
+void FPaperZDAnimPlayerState::FlushDeferredGameThreadWork()
+{
+	check(IsInGameThread());
+	bDeferGameThreadWork = false;
+
+	if (DeferredNotifyTicks.Num())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AnimNotifyTick);
+		UPrimitiveComponent* RenderComponent = RegisteredRenderComponent.Get();
+		if (RenderComponent)
+		{
+			for (const FPaperZDDeferredNotifyTick& NotifyTick : DeferredNotifyTicks)
+			{
+				TickNotifiesInWindow(NotifyTick, RenderComponent);
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Trying to tick AnimSequence '%s' without having registered a PrimitiveComponent as Renderer on AnimPlayer '%s'"), *DeferredNotifyTicks[0].AnimSequence->GetName(), *GetDebugName());
+		}
+
+		DeferredNotifyTicks.Reset();
+	}
+
+	for (const FPaperZDDeferredPlaybackEvent& PlaybackEvent : DeferredPlaybackEvents)
+	{
+		if (PlaybackEvent.bLooped)
+		{
+			BroadcastSequenceLooped(PlaybackEvent.AnimSequence);
+		}
+		else
+		{
+			BroadcastSequenceComplete(PlaybackEvent.AnimSequence);
+		}
+	}
+	DeferredPlaybackEvents.Reset();
+}
+
+void FPaperZDAnimPlayerState::SetNotifyPolicy(EPaperZDAnimLODNotifyPolicy InNotifyPolicy)
+{
+	check(IsInGameThread());
+	if (NotifyPolicy != InNotifyPolicy)
+	{
+		NotifyPolicy = InNotifyPolicy;
+
+		//Leaving the catch-up policy, the held back window needs to trigger once or be dropped
+		if (NotifyPolicy == EPaperZDAnimLODNotifyPolicy::Fire)
+		{
+			FlushCatchUpWindow();
+		}
+		else if (NotifyPolicy == EPaperZDAnimLODNotifyPolicy::Skip)
+		{
+			bHasPendingCatchUp = false;
+		}
+	}
+}
+
+void FPaperZDAnimPlayerState::FlushCatchUpWindow()
+{
+	if (bHasPendingCatchUp)
+	{
+		bHasPendingCatchUp = false;
+		if (bDeferGameThreadWork)
+		{
+			DeferredNotifyTicks.Add(PendingCatchUpTick);
+		}
+		else if (UPrimitiveComponent* RenderComponent = RegisteredRenderComponent.Get())
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AnimNotifyTick);
+			TickNotifiesInWindow(PendingCatchUpTick, RenderComponent);
+		}
+	}
+}
+
+void FPaperZDAnimPlayerState::BeginTrackingPlaybackEvents()
+{
+	TrackedPlaybacks.Reset();
+	bTrackPlaybackEvents = true;
+}
+
+float FPaperZDAnimPlayerState::EndTrackingPlaybackEvents()
+{
+	check(IsInGameThread());
+	bTrackPlaybackEvents = false;
+
+	float DeltaScale = MAX_flt;
+	for (const FPaperZDTrackedPlayback& Playback : TrackedPlaybacks)
+	{
+		const float TimeToEvent = UPaperZDAnimPlayer::GetTimeToNextPlaybackEvent(Playback.AnimSequence, Playback.PlaybackMarker, Playback.bLooping, Playback.DeltaTime < 0.0f);
+		if (TimeToEvent < MAX_flt)
+		{
+			DeltaScale = FMath::Min(DeltaScale, TimeToEvent / FMath::Abs(Playback.DeltaTime));
+		}
+	}
+	TrackedPlaybacks.Reset();
+
+	return DeltaScale;
+}
+
+float UPaperZDAnimPlayer::GetTimeToNextPlaybackEvent(const UPaperZDAnimSequence* AnimSequence, float PlaybackMarker, bool bLooping, bool bReverse)
+{
+	//Non-looping sequences that already completed stay on their last frame forever
+	const float Duration = AnimSequence->GetTotalDuration();
+	const float TimeToEnd = bReverse ? PlaybackMarker : Duration - PlaybackMarker;
+	if (!bLooping && TimeToEnd <= 0.0f)
+	{
+		return MAX_flt;
+	}
+
+	//Notify states need to tick while active
+	const FPaperZDAnimNotifyIndex& NotifyIndex = AnimSequence->GetNotifyIndex();
+	if (NotifyIndex.NeedsTickAt(PlaybackMarker))
+	{
+		return 0.0f;
+	}
+
+	float TimeToEvent = FMath::Min(TimeToEnd, AnimSequence->GetTimeToNextVisibleChange(PlaybackMarker, bReverse));
+	float NotifyTime = 0.0f;
+	if (NotifyIndex.FindNextNotifyTime(nullptr, PlaybackMarker, bLooping, bReverse, NotifyTime))
+	{
+		//Notifies found behind the playback marker are only reached after looping
+		const float TimeToNotify = bReverse ? PlaybackMarker - NotifyTime : NotifyTime - PlaybackMarker;
+		TimeToEvent = FMath::Min(TimeToEvent, TimeToNotify < 0.0f ? TimeToNotify + Duration : TimeToNotify);
+	}
+
+	return FMath::Max(TimeToEvent, 0.0f);
+}
+
+void FPaperZDAnimPlayerState::AccumulateCatchUpWindow(const FPaperZDDeferredNotifyTick& NotifyTick)
+{
+	//Keep the start of the window, unless the playback moved to another sequence or changed direction
+	const bool bSameDirection = (PendingCatchUpTick.DeltaTime > 0.0f) == (NotifyTick.DeltaTime > 0.0f);
+	if (bHasPendingCatchUp && PendingCatchUpTick.AnimSequence == NotifyTick.AnimSequence && bSameDirection)
+	{
+		//A window longer than the sequence would loop more than once, which the notifies don't support, so it gets clamped
+		const float Duration = NotifyTick.AnimSequence->GetTotalDuration();
+		PendingCatchUpTick.DeltaTime = FMath::Clamp(PendingCatchUpTick.DeltaTime + NotifyTick.DeltaTime, -Duration, Duration);
+		PendingCatchUpTick.PlaybackMarker = NotifyTick.PlaybackMarker;
+		PendingCatchUpTick.OwningInstance = NotifyTick.OwningInstance;
+	}
+	else
+	{
+		//The window held for the previous sequence triggers now, instead of being replaced
+		FlushCatchUpWindow();
+		PendingCatchUpTick = NotifyTick;
+		bHasPendingCatchUp = true;
+	}
+}
+
+void FPaperZDAnimPlayerState::TickNotifiesInWindow(const FPaperZDDeferredNotifyTick& NotifyTick, UPrimitiveComponent* RenderComponent)
+{
+	const FPaperZDAnimNotifyIndex& NotifyIndex = NotifyTick.AnimSequence->GetNotifyIndex();
+	NotifyIndex.ForEachNotifyInWindow(NotifyTick.PreviousTime, NotifyTick.PlaybackMarker, NotifyTick.DeltaTime, [&](UPaperZDAnimNotify_Base* Notify)
+	{
+#if WITH_EDITOR
+		//Prevent from firing in editor if specifically requested
+		if (NotifyTick.OwningInstance != nullptr || Notify->bShouldFireInEditor)
+#endif
+		{
+			Notify->ProcessNotifyTick(NotifyTick.DeltaTime, NotifyTick.PlaybackMarker, NotifyTick.PreviousTime, RenderComponent, NotifyTick.OwningInstance);
+		}
+	});
+
+	NotifyIndex.ForEachPackedNotifyInWindow(NotifyTick.PreviousTime, NotifyTick.PlaybackMarker, NotifyTick.DeltaTime, [&](const FPaperZDPackedNotify& PackedNotify)
+	{
+		PackedNotify.Fire(NotifyTick.AnimSequence, RenderComponent, NotifyTick.OwningInstance);
+	});
+}
+
+void FPaperZDAnimPlayerState::ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight /* = 1.0f */, UPaperZDAnimInstance* OwningInstance /* = nullptr */)
 {
 	SCOPE_CYCLE_COUNTER(STAT_AnimNotifyTick);
 
 	const bool bIsRelevant = IsRelevantWeight(Weight);
 	if (bIsRelevant && RegisteredRenderComponent.IsValid())
 	{
-		for (UPaperZDAnimNotify_Base* Notify : AnimSequence->GetAnimNotifies())
+		UPrimitiveComponent* RenderComponent = RegisteredRenderComponent.Get();
+		const FPaperZDAnimNotifyIndex& NotifyIndex = AnimSequence->GetNotifyIndex();
+		NotifyIndex.ForEachNotifyInWindow(FromTime, ToTime, ToTime - FromTime, [&](UPaperZDAnimNotify_Base* Notify)
 		{
-			Notify->TickNotify(ToTime - FromTime, ToTime, FromTime, RegisteredRenderComponent.Get(), OwningInstance);
-		}
+			Notify->ProcessNotifyTick(ToTime - FromTime, ToTime, FromTime, RenderComponent, OwningInstance);
+		});
+
+		NotifyIndex.ForEachPackedNotifyInWindow(FromTime, ToTime, ToTime - FromTime, [&](const FPaperZDPackedNotify& PackedNotify)
+		{
+			PackedNotify.Fire(AnimSequence, RenderComponent, OwningInstance);
+		});
 	}
 }
 
-void UPaperZDAnimPlayer::PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime)
+void FPaperZDAnimPlayerState::PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime)
 {
 	if (AnimSequence && PlaybackHandle && RegisteredRenderComponent.IsValid())
 	{
+		//A window held back for another sequence must trigger while its sequence is still the one rendered
+		if (bHasPendingCatchUp && PendingCatchUpTick.AnimSequence != AnimSequence)
+		{
+			FlushCatchUpWindow();
+		}
+
 		//Because we're not given a playback data struct, we must create one from the given data
 		const UPaperZDAnimSequence* PreviousAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
 		LastPlaybackData.SetAnimation(AnimSequence, Playtime);
 		LastWeightedAnimation = LastPlaybackData.WeightedAnimations[0];
 
 		//Potentially trigger the SequenceChanged events (backwards compatibility)
-		if (bFireSequenceChangedEvents && OnPlaybackSequenceChanged.IsBound() && LastWeightedAnimation.AnimSequencePtr.Get() != PreviousAnimSequence)
-		{
-			OnPlaybackSequenceChanged.Broadcast(PreviousAnimSequence, LastWeightedAnimation.AnimSequencePtr.Get(), GetPlaybackProgress());
-		}
+		NotifySequenceChanged(PreviousAnimSequence);
 
 		//Update the playback
 		PlaybackHandle->UpdateRenderPlayback(RegisteredRenderComponent.Get(), LastPlaybackData, bPreviewPlayer);
 	}
 }
 
-void UPaperZDAnimPlayer::Play(const FPaperZDAnimationPlaybackData& PlaybackData)
+void FPaperZDAnimPlayerState::Play(const FPaperZDAnimationPlaybackData& PlaybackData)
 {
 	if (PlaybackData.WeightedAnimations.Num() && PlaybackHandle && RegisteredRenderComponent.IsValid())
 	{
+		//A window held back for another sequence must trigger while its sequence is still the one rendered
+		if (bHasPendingCatchUp && PendingCatchUpTick.AnimSequence != PlaybackData.WeightedAnimations[0].AnimSequencePtr.Get())
+		{
+			FlushCatchUpWindow();
+		}
+
 		//Update playback
 		PlaybackHandle->UpdateRenderPlayback(RegisteredRenderComponent.Get(), PlaybackData, bPreviewPlayer);
 
-		//Store information for backwards support 
+		//Store information for backwards support, only the primary animation is needed so we avoid copying the whole playback data
 		const UPaperZDAnimSequence* PreviousAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
-		LastPlaybackData = PlaybackData;
-		LastWeightedAnimation = LastPlaybackData.WeightedAnimations[0];
+		LastWeightedAnimation = PlaybackData.WeightedAnimations[0];
 
 		//Potentially trigger the SequenceChanged events (backwards compatibility)
-		if (bFireSequenceChangedEvents && OnPlaybackSequenceChanged.IsBound() && LastWeightedAnimation.AnimSequencePtr.Get() != PreviousAnimSequence)
+		NotifySequenceChanged(PreviousAnimSequence);
+	}
+}
+
+void FPaperZDAnimPlayerState::PlayShared(const FPaperZDAnimationPlaybackData& PlaybackData, UPaperZDAnimInstance* OwningInstance, bool bRender /* = true */)
+{
+	if (PlaybackData.WeightedAnimations.Num() == 0)
+	{
+		return;
+	}
+
+	//The window goes from the last time played, sequences that just started playing are entered from their start
+	const FPaperZDWeightedAnimation& PrimaryAnimation = PlaybackData.WeightedAnimations[0];
+	const UPaperZDAnimSequence* AnimSequence = PrimaryAnimation.AnimSequencePtr.Get();
+	const float Duration = AnimSequence ? AnimSequence->GetTotalDuration() : 0.0f;
+	const bool bReversed = GetPlaybackMode() == EAnimPlayerPlaybackMode::Reversed;
+	if (Duration > 0.0f && bPlaying && RegisteredRenderComponent.IsValid())
+	{
+		const bool bSameSequence = LastWeightedAnimation.AnimSequencePtr.Get() == AnimSequence;
+		const float PreviousTime = bSameSequence ? LastWeightedAnimation.PlaybackTime : (bReversed ? Duration : 0.0f);
+		float DeltaTime = PrimaryAnimation.PlaybackTime - PreviousTime;
+
+		//Shared playback only moves in the direction of the player, going the other way means it looped
+		if (!bReversed && DeltaTime < 0.0f)
+		{
+			DeltaTime += Duration;
+		}
+		else if (bReversed && DeltaTime > 0.0f)
 		{
-			OnPlaybackSequenceChanged.Broadcast(PreviousAnimSequence, LastWeightedAnimation.AnimSequencePtr.Get(), GetPlaybackProgress());
+			DeltaTime -= Duration;
+		}
+
+		const bool bProcessNotifies = DeltaTime != 0.0f && IsRelevantWeight(PrimaryAnimation.Weight) && NotifyPolicy != EPaperZDAnimLODNotifyPolicy::Skip;
+		if (bProcessNotifies && NotifyPolicy == EPaperZDAnimLODNotifyPolicy::CatchUp)
+		{
+			AccumulateCatchUpWindow({ AnimSequence, OwningInstance, DeltaTime, PrimaryAnimation.PlaybackTime, PreviousTime });
+		}
+		else if (bProcessNotifies)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_AnimNotifyTick);
+			TickNotifiesInWindow({ AnimSequence, OwningInstance, DeltaTime, PrimaryAnimation.PlaybackTime, PreviousTime }, RegisteredRenderComponent.Get());
 		}
 	}
+
+	if (bRender)
+	{
+		Play(PlaybackData);
+	}
+	else
+	{
+		//Still needed as the start of the next window
+		const UPaperZDAnimSequence* PreviousAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
+		LastWeightedAnimation = PrimaryAnimation;
+		NotifySequenceChanged(PreviousAnimSequence);
+	}
 }
 
-void UPaperZDAnimPlayer::RegisterRenderComponent(UPrimitiveComponent* RenderComponent)
+void FPaperZDAnimPlayerState::RegisterRenderComponent(UPrimitiveComponent* RenderComponent)
 {
 	RegisteredRenderComponent = RenderComponent; 
 
@@ -219,4 +570,187 @@ void UPaperZDAnimPlayer::RegisterRenderComponent(UPrimitiveComponent* RenderComp
 	{
 		PlaybackHandle->ConfigureRenderComponent(RenderComponent, bPreviewPlayer);
 	}
-}
\ No newline at end of file
+}
+void FPaperZDAnimPlayerState::NotifySequenceChanged(const UPaperZDAnimSequence* PreviousAnimSequence)
+{
+	const UPaperZDAnimSequence* CurrentAnimSequence = LastWeightedAnimation.AnimSequencePtr.Get();
+	if (CurrentAnimSequence != PreviousAnimSequence && ShouldFireSequenceChangedEvents())
+	{
+		if (PlayerObject && PlayerObject->OnPlaybackSequenceChanged.IsBound())
+		{
+			PlayerObject->OnPlaybackSequenceChanged.Broadcast(PreviousAnimSequence, CurrentAnimSequence, GetPlaybackProgress());
+		}
+
+		if (EventInstance)
+		{
+			EventInstance->OnAnimSequenceUpdated(PreviousAnimSequence, CurrentAnimSequence, GetPlaybackProgress());
+		}
+	}
+}
+
+void FPaperZDAnimPlayerState::BroadcastSequenceComplete(const UPaperZDAnimSequence* AnimSequence)
+{
+	if (PlayerObject)
+	{
+		PlayerObject->OnPlaybackSequenceComplete.Broadcast(AnimSequence);
+	}
+
+	if (EventInstance)
+	{
+		EventInstance->OnAnimSequencePlaybackComplete(AnimSequence);
+	}
+}
+
+void FPaperZDAnimPlayerState::BroadcastSequenceLooped(const UPaperZDAnimSequence* AnimSequence)
+{
+	if (PlayerObject)
+	{
+		PlayerObject->OnPlaybackSequenceLooped.Broadcast(AnimSequence);
+	}
+}
+
+FString FPaperZDAnimPlayerState::GetDebugName() const
+{
+	if (PlayerObject)
+	{
+		return PlayerObject->GetName();
+	}
+
+	return EventInstance ? EventInstance->GetName() : FString(TEXT("None"));
+}
+
+//////////////////////////////////////////////////////////////////////////
+//// UPaperZDAnimPlayer
+//////////////////////////////////////////////////////////////////////////
+UPaperZDAnimPlayer::UPaperZDAnimPlayer() : Super()
+{
+	PlaybackMode = EAnimPlayerPlaybackMode::Forward;
+	bFireSequenceChangedEvents = false;
+	State = &OwnedState;
+	OwnedState.PlayerObject = this;
+}
+
+UPaperZDAnimPlayer* UPaperZDAnimPlayer::CreateProxy(UObject* Outer, FPaperZDAnimPlayerState& InState)
+{
+	check(InState.PlayerObject == nullptr);
+	UPaperZDAnimPlayer* Proxy = NewObject<UPaperZDAnimPlayer>(Outer);
+	Proxy->OwnedState.PlayerObject = nullptr;
+	Proxy->State = &InState;
+	Proxy->PlaybackMode = InState.PlaybackMode;
+	Proxy->bFireSequenceChangedEvents = InState.bFireSequenceChangedEvents;
+	InState.PlayerObject = Proxy;
+	return Proxy;
+}
+
+void UPaperZDAnimPlayer::BeginDestroy()
+{
+	//The state could outlive us if the owner keeps it after releasing the proxy
+	if (State && State->PlayerObject == this)
+	{
+		State->PlaybackMode = PlaybackMode;
+		State->bFireSequenceChangedEvents = bFireSequenceChangedEvents;
+		State->PlayerObject = nullptr;
+	}
+
+	Super::BeginDestroy();
+}
+
+float UPaperZDAnimPlayer::GetCurrentPlaybackTime() const
+{
+	return State->GetCurrentPlaybackTime();
+}
+
+float UPaperZDAnimPlayer::GetPlaybackProgress() const
+{
+	return State->GetPlaybackProgress();
+}
+
+const UPaperZDAnimSequence* UPaperZDAnimPlayer::GetCurrentAnimSequence() const
+{
+	return State->GetCurrentAnimSequence();
+}
+
+bool UPaperZDAnimPlayer::GetTimeToNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, bool bLooping, float& OutTimeRemaining) const
+{
+	return State->GetTimeToNextNotify(NotifyClass, bLooping, OutTimeRemaining);
+}
+
+void UPaperZDAnimPlayer::RegisterRenderComponent(UPrimitiveComponent* RenderComponent)
+{
+	State->RegisterRenderComponent(RenderComponent);
+}
+
+void UPaperZDAnimPlayer::ResumePlayback()
+{
+	State->ResumePlayback();
+}
+
+void UPaperZDAnimPlayer::PausePlayback()
+{
+	State->PausePlayback();
+}
+
+void UPaperZDAnimPlayer::ClearCachedAnimationData()
+{
+	State->ClearCachedAnimationData();
+}
+
+void UPaperZDAnimPlayer::Init(const UPaperZDAnimationSource* AnimationSource)
+{
+	State->Init(AnimationSource, this);
+}
+
+void UPaperZDAnimPlayer::ResetForReuse(const UPaperZDAnimationSource* AnimationSource)
+{
+	State->ResetForReuse(AnimationSource);
+}
+
+void UPaperZDAnimPlayer::SetIsPreviewPlayer(bool bInPreviewPlayer)
+{
+	State->SetIsPreviewPlayer(bInPreviewPlayer);
+}
+
+void UPaperZDAnimPlayer::TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance /* = nullptr */, float EffectiveWeight /* = 1.0f */, bool bSkipNotifies /* = false */)
+{
+	State->TickPlayback(AnimSequence, PlaybackMarker, DeltaTime, bLooping, OwningInstance, EffectiveWeight, bSkipNotifies);
+}
+
+void UPaperZDAnimPlayer::ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight /* = 1.0f */, UPaperZDAnimInstance* OwningInstance /* = nullptr */)
+{
+	State->ProcessAnimSequenceNotifies(AnimSequence, FromTime, ToTime, Weight, OwningInstance);
+}
+
+void UPaperZDAnimPlayer::PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime)
+{
+	State->PlaySingleAnimation(AnimSequence, Playtime);
+}
+
+void UPaperZDAnimPlayer::Play(const FPaperZDAnimationPlaybackData& PlaybackData)
+{
+	State->Play(PlaybackData);
+}
+
+void UPaperZDAnimPlayer::BeginDeferredGameThreadWork()
+{
+	State->BeginDeferredGameThreadWork();
+}
+
+void UPaperZDAnimPlayer::FlushDeferredGameThreadWork()
+{
+	State->FlushDeferredGameThreadWork();
+}
+
+void UPaperZDAnimPlayer::SetNotifyPolicy(EPaperZDAnimLODNotifyPolicy InNotifyPolicy)
+{
+	State->SetNotifyPolicy(InNotifyPolicy);
+}
+
+void UPaperZDAnimPlayer::BeginTrackingPlaybackEvents()
+{
+	State->BeginTrackingPlaybackEvents();
+}
+
+float UPaperZDAnimPlayer::EndTrackingPlaybackEvents()
+{
+	return State->EndTrackingPlaybackEvents();
+}
@@ -2,9 +2,15 @@
 
 #include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
 
+void FPaperZDAnimationPlaybackData::Reset()
+{
+	WeightedAnimations.Reset();
+	DirectionalAngle = 0.0f;
+}
+
 void FPaperZDAnimationPlaybackData::SetAnimation(const UPaperZDAnimSequence* Sequence, float PlaybackTime)
 {
-	WeightedAnimations.Empty(1);
+	WeightedAnimations.Reset();
 	FPaperZDWeightedAnimation& AnimWeight = WeightedAnimations.AddDefaulted_GetRef();
 	AnimWeight.AnimSequencePtr = Sequence;
 	AnimWeight.PlaybackTime = PlaybackTime;
@@ -4,6 +4,60 @@
 #include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
 #include "PaperFlipbookComponent.h"
 #include "PaperFlipbook.h"
+#include "PaperZDStats.h"
+#include "PaperZDTrace.h"
+#include "PaperZDProfiler.h"
+#include "PaperZDAnimInstance.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flipbook Updates Applied"), STAT_FlipbookUpdatesApplied, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flipbook Updates Skipped"), STAT_FlipbookUpdatesSkipped, STATGROUP_PaperZD);
+
+namespace FPaperZDFlipbookHandleHelpers
+{
+	/**
+	 * Finds the time range in which the flipbook displays the same keyframe as the given time.
+	 * Follows the same accumulation as UPaperFlipbook::GetKeyFrameIndexAtTime, so the range matches what the component renders.
+	 */
+	void FindKeyFrameRange(const UPaperFlipbook* Flipbook, float Time, float& OutStartTime, float& OutEndTime, float& OutSnapTime)
+	{
+		OutStartTime = -MAX_flt;
+		OutEndTime = MAX_flt;
+		OutSnapTime = 0.0f;
+
+		const int32 NumKeyFrames = Flipbook ? Flipbook->GetNumKeyFrames() : 0;
+		const float FramesPerSecond = Flipbook ? Flipbook->GetFramesPerSecond() : 0.0f;
+		if (NumKeyFrames == 0 || FramesPerSecond <= 0.0f)
+		{
+			//A single keyframe (or none) is displayed for any time
+			return;
+		}
+
+		float SumTime = 0.0f;
+		for (int32 KeyFrameIndex = 0; KeyFrameIndex < NumKeyFrames; KeyFrameIndex++)
+		{
+			const float FrameStartTime = SumTime;
+			SumTime += Flipbook->GetKeyFrameChecked(KeyFrameIndex).FrameRun / FramesPerSecond;
+			if (Time <= SumTime)
+			{
+				//The first keyframe covers every time before it, the last one every time after it
+				OutStartTime = KeyFrameIndex == 0 ? -MAX_flt : FrameStartTime;
+				OutEndTime = KeyFrameIndex == NumKeyFrames - 1 ? MAX_flt : SumTime;
+				OutSnapTime = SumTime;
+				return;
+			}
+		}
+
+		//Past the end of the flipbook, which displays the last keyframe
+		OutStartTime = SumTime;
+		OutSnapTime = SumTime;
+	}
+}
+
+UPaperZDPlaybackHandle_Flipbook::UPaperZDPlaybackHandle_Flipbook()
+	: bFrameQuantized(false)
+{
+	InvalidateRenderState();
+}
 
 void UPaperZDPlaybackHandle_Flipbook::UpdateRenderPlayback(UPrimitiveComponent* RenderComponent, const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback /* = false */)
 {
@@ -12,16 +66,41 @@ void UPaperZDPlaybackHandle_Flipbook::UpdateRenderPlayback(UPrimitiveComponent*
 	{
 		const FPaperZDWeightedAnimation& PrimaryAnimation = PlaybackData.WeightedAnimations[0];
 		UPaperFlipbook* Flipbook = PrimaryAnimation.AnimSequencePtr->GetAnimationData<UPaperFlipbook*>(PlaybackData.DirectionalAngle, bIsPreviewPlayback);
+		const float PlaybackTime = PrimaryAnimation.PlaybackTime;
+
+		//Skip the update if the component would keep rendering the same keyframe
+		//The component state is checked too, in case someone else modified it since our last update. Preview players always update, as they can be scrubbed
+		const bool bRenderStateUnchanged = !bIsPreviewPlayback
+			&& Sprite == LastRenderComponent
+			&& Flipbook == LastFlipbook
+			&& Sprite->GetFlipbook() == Flipbook
+			&& Sprite->GetPlaybackPosition() == LastPlaybackPosition
+			&& IsInsideRenderedKeyFrame(PlaybackTime);
+
+		if (bRenderStateUnchanged)
+		{
+			INC_DWORD_STAT(STAT_FlipbookUpdatesSkipped);
+			return;
+		}
 
 		//Check if the flipbook hasn't changed
 		if (Sprite->GetFlipbook() != Flipbook)
 		{
-			UPaperFlipbook* From = Sprite->GetFlipbook();
+			PAPERZD_TRACE_EVENT(FlipbookSwap, Sprite, Flipbook);
+			FPaperZDProfiler::CountFlipbookSwap(GetTypedOuter<UPaperZDAnimInstance>());
 			Sprite->SetFlipbook(Flipbook);
 		}
 
+		//Cache the range of the keyframe we're about to render, any time inside it can skip the update
+		FPaperZDFlipbookHandleHelpers::FindKeyFrameRange(Flipbook, PlaybackTime, KeyFrameStartTime, KeyFrameEndTime, KeyFrameSnapTime);
+
 		//We manage the time manually
-		Sprite->SetPlaybackPosition(PrimaryAnimation.PlaybackTime, false);
+		Sprite->SetPlaybackPosition(bFrameQuantized ? KeyFrameSnapTime : PlaybackTime, false);
+
+		LastRenderComponent = Sprite;
+		LastFlipbook = Flipbook;
+		LastPlaybackPosition = Sprite->GetPlaybackPosition();
+		INC_DWORD_STAT(STAT_FlipbookUpdatesApplied);
 	}
 }
 
@@ -34,4 +113,26 @@ void UPaperZDPlaybackHandle_Flipbook::ConfigureRenderComponent(UPrimitiveCompone
 		Sprite->Stop();
 		Sprite->SetLooping(false);
 	}
+
+	//New component, the next update needs to go through
+	InvalidateRenderState();
+}
+
+void UPaperZDPlaybackHandle_Flipbook::SetFrameQuantized(bool bInFrameQuantized)
+{
+	if (bFrameQuantized != bInFrameQuantized)
+	{
+		bFrameQuantized = bInFrameQuantized;
+		InvalidateRenderState();
+	}
+}
+
+void UPaperZDPlaybackHandle_Flipbook::InvalidateRenderState()
+{
+	LastRenderComponent = nullptr;
+	LastFlipbook = nullptr;
+	LastPlaybackPosition = 0.0f;
+	KeyFrameStartTime = 0.0f;
+	KeyFrameEndTime = -1.0f;
+	KeyFrameSnapTime = 0.0f;
 }
@@ -0,0 +1,88 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "AnimSequences/Players/PaperZDPlaybackHandle_InstancedSprite.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
+#include "PaperZDInstancedSpriteComponent.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDProfiler.h"
+#include "PaperFlipbook.h"
+#include "GameFramework/Actor.h"
+
+UPaperZDPlaybackHandle_InstancedSprite::UPaperZDPlaybackHandle_InstancedSprite()
+	: InstanceIndex(INDEX_NONE)
+{}
+
+void UPaperZDPlaybackHandle_InstancedSprite::BeginDestroy()
+{
+	ReleaseInstance();
+	Super::BeginDestroy();
+}
+
+void UPaperZDPlaybackHandle_InstancedSprite::UpdateRenderPlayback(UPrimitiveComponent* RenderComponent, const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback /* = false */)
+{
+	UPaperZDInstancedSpriteComponent* InstancedSprite = Cast<UPaperZDInstancedSpriteComponent>(RenderComponent);
+	if (!InstancedSprite)
+	{
+		Super::UpdateRenderPlayback(RenderComponent, PlaybackData, bIsPreviewPlayback);
+		return;
+	}
+
+	//The instance could have been pruned by the component, in which case we need a new one
+	if (InstancedSprite != InstancedComponent.Get() || !InstancedSprite->IsAnimatedInstanceValid(InstanceIndex))
+	{
+		ConfigureRenderComponent(RenderComponent, bIsPreviewPlayback);
+	}
+
+	//The component already skips any update that keeps the same keyframe
+	const FPaperZDWeightedAnimation& PrimaryAnimation = PlaybackData.WeightedAnimations[0];
+	const UPaperFlipbook* Flipbook = ResolveFlipbook(PlaybackData, bIsPreviewPlayback);
+	if (FPaperZDProfiler::IsActive())
+	{
+		const UPaperFlipbook* CurrentFlipbook = nullptr;
+		int32 CurrentKeyFrameIndex = INDEX_NONE;
+		InstancedSprite->GetInstanceKeyFrame(InstanceIndex, CurrentFlipbook, CurrentKeyFrameIndex);
+		if (CurrentFlipbook != Flipbook)
+		{
+			FPaperZDProfiler::CountFlipbookSwap(GetTypedOuter<UPaperZDAnimInstance>());
+		}
+	}
+
+	InstancedSprite->SetInstancePlayback(InstanceIndex, Flipbook, PrimaryAnimation.PlaybackTime);
+}
+
+void UPaperZDPlaybackHandle_InstancedSprite::ConfigureRenderComponent(UPrimitiveComponent* RenderComponent, bool bIsPreviewPlayback /* = false */)
+{
+	Super::ConfigureRenderComponent(RenderComponent, bIsPreviewPlayback);
+	ReleaseInstance();
+
+	UPaperZDInstancedSpriteComponent* InstancedSprite = Cast<UPaperZDInstancedSpriteComponent>(RenderComponent);
+	if (InstancedSprite)
+	{
+		//Follow the actor that owns the AnimInstance, preview players have no owner and render at the origin of the component
+		const UPaperZDAnimInstance* OwningInstance = GetTypedOuter<UPaperZDAnimInstance>();
+		const AActor* OwningActor = OwningInstance ? OwningInstance->GetOwningActor() : nullptr;
+		USceneComponent* FollowComponent = OwningActor && OwningActor != InstancedSprite->GetOwner() ? OwningActor->GetRootComponent() : nullptr;
+		const FTransform InstanceTransform = FollowComponent ? FTransform::Identity : InstancedSprite->GetComponentTransform();
+
+		InstancedComponent = InstancedSprite;
+		InstanceIndex = InstancedSprite->RegisterAnimatedInstance(FollowComponent, InstanceTransform, OwningInstance);
+	}
+}
+
+const UPaperFlipbook* UPaperZDPlaybackHandle_InstancedSprite::ResolveFlipbook(const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback /* = false */)
+{
+	const UPaperZDAnimSequence* AnimSequence = PlaybackData.WeightedAnimations.Num() ? PlaybackData.WeightedAnimations[0].AnimSequencePtr.Get() : nullptr;
+	return AnimSequence ? AnimSequence->GetAnimationData<UPaperFlipbook*>(PlaybackData.DirectionalAngle, bIsPreviewPlayback) : nullptr;
+}
+
+void UPaperZDPlaybackHandle_InstancedSprite::ReleaseInstance()
+{
+	if (UPaperZDInstancedSpriteComponent* InstancedSprite = InstancedComponent.Get())
+	{
+		InstancedSprite->ReleaseAnimatedInstance(InstanceIndex);
+	}
+
+	InstancedComponent = nullptr;
+	InstanceIndex = INDEX_NONE;
+}
@@ -1,6 +1,7 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "AnimSequences/Sources/PaperZDAnimationSource.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
 #include "IPaperZDEditorProxy.h"
 
 UPaperZDAnimationSource::UPaperZDAnimationSource()
@@ -8,6 +9,12 @@ UPaperZDAnimationSource::UPaperZDAnimationSource()
 	, bSupportsAnimationLayers(false)
 {}
 
+bool UPaperZDAnimationSource::CanBeClusterRoot() const
+{
+	//Every sequence of the source references it, on its own cluster it doesn't tie them to whichever sequence loaded first
+	return UPaperZDAnimSequence::CanCreateClusters();
+}
+
 #if WITH_EDITOR
 void UPaperZDAnimationSource::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
 {
@@ -2,6 +2,7 @@
 
 #include "AnimSequences/Sources/PaperZDAnimationSource_Flipbook.h"
 #include "AnimSequences/Players/PaperZDPlaybackHandle_Flipbook.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle_InstancedSprite.h"
 #include "AnimSequences/PaperZDAnimSequence_Flipbook.h"
 #include "PaperFlipbookComponent.h"
 
@@ -10,11 +11,21 @@ UPaperZDAnimationSource_Flipbook::UPaperZDAnimationSource_Flipbook()
 	SupportedAnimSequenceClass = UPaperZDAnimSequence_Flipbook::StaticClass();
 	bSupportsBlending = false;
 	bSupportsAnimationLayers = false;
+	bFrameQuantizedPlayback = false;
+	bSupportsInstancedRendering = false;
 }
 
 TSubclassOf<UPaperZDPlaybackHandle> UPaperZDAnimationSource_Flipbook::GetPlaybackHandleClass() const
 {
-	return UPaperZDPlaybackHandle_Flipbook::StaticClass();
+	return bSupportsInstancedRendering ? UPaperZDPlaybackHandle_InstancedSprite::StaticClass() : UPaperZDPlaybackHandle_Flipbook::StaticClass();
+}
+
+void UPaperZDAnimationSource_Flipbook::InitPlaybackHandle(UPaperZDPlaybackHandle* Handle) const
+{
+	if (UPaperZDPlaybackHandle_Flipbook* FlipbookHandle = Cast<UPaperZDPlaybackHandle_Flipbook>(Handle))
+	{
+		FlipbookHandle->SetFrameQuantized(bFrameQuantizedPlayback);
+	}
 }
 
 TSubclassOf<UPrimitiveComponent> UPaperZDAnimationSource_Flipbook::GetRenderComponentClass() const
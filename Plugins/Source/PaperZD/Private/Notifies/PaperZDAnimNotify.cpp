@@ -1,6 +1,8 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "Notifies/PaperZDAnimNotify.h"
+#include "Notifies/PaperZDNotifyInstrumentation.h"
+#include "PaperZDAnimInstance.h"
 
 UPaperZDAnimNotify::UPaperZDAnimNotify(const FObjectInitializer& ObjectInitializer)
 	: Super()
@@ -18,10 +20,12 @@ void UPaperZDAnimNotify::TickNotify(float DeltaTime, float Playtime, float LastP
 		const bool bLooped = Playtime < LastPlaybackTime;
 		if (bLooped && (Playtime >= Time || LastPlaybackTime <= Time))
 		{
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnReceiveNotify(OwningInstance);
 		}
 		else if (Playtime > Time && LastPlaybackTime <= Time)
 		{
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnReceiveNotify(OwningInstance);
 		}
 	}
@@ -30,10 +34,12 @@ void UPaperZDAnimNotify::TickNotify(float DeltaTime, float Playtime, float LastP
 		const bool bLooped = Playtime > LastPlaybackTime;
 		if (bLooped && (Playtime <= Time || LastPlaybackTime >= Time))
 		{
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnReceiveNotify(OwningInstance);
 		}
 		else if (Playtime < Time && LastPlaybackTime >= Time)
 		{
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnReceiveNotify(OwningInstance);
 		}
 	}
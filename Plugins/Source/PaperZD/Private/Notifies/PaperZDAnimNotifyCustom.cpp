@@ -1,8 +1,10 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "Notifies/PaperZDAnimNotifyCustom.h"
+#include "Notifies/PaperZDPackedNotify.h"
 #include "PaperZDAnimInstance.h"
 #include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDProfiler.h"
 
 UPaperZDAnimNotifyCustom::UPaperZDAnimNotifyCustom(const FObjectInitializer& ObjectInitializer)
 	: Super()
@@ -14,14 +16,34 @@ void UPaperZDAnimNotifyCustom::OnReceiveNotify_Implementation(UPaperZDAnimInstan
 	//Owning instance can be null on editor
 	if (OwningInstance)
 	{
-		//Ask the instance for the function implementation
-		UFunction* BoundFunction = OwningInstance->FindAnimNotifyFunction(Name);
-		if (ensure(BoundFunction)) 
-		{
-			//Create Buffer and call function
-			uint8 *Buffer = (uint8*)FMemory_Alloca(BoundFunction->ParmsSize);
-			FMemory::Memzero(Buffer, BoundFunction->ParmsSize);
-			OwningInstance->ProcessEvent(BoundFunction, Buffer);
-		}
+		CallNotifyFunction(OwningInstance, Name);
 	}
 }
+
+void UPaperZDAnimNotifyCustom::CallNotifyFunction(UPaperZDAnimInstance* OwningInstance, FName NotifyName)
+{
+	//Ask the instance for the function implementation
+	UFunction* BoundFunction = OwningInstance->FindAnimNotifyFunction(NotifyName);
+	if (ensure(BoundFunction)) 
+	{
+		//Create Buffer and call function
+		uint8 *Buffer = (uint8*)FMemory_Alloca(BoundFunction->ParmsSize);
+		FMemory::Memzero(Buffer, BoundFunction->ParmsSize);
+		FPaperZDProfiler::CountBlueprintCall(OwningInstance);
+		OwningInstance->ProcessEvent(BoundFunction, Buffer);
+	}
+}
+
+#if WITH_EDITOR
+bool UPaperZDAnimNotifyCustom::PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const
+{
+	if (GetClass() != UPaperZDAnimNotifyCustom::StaticClass())
+	{
+		return false;
+	}
+
+	OutNotify.Type = EPaperZDPackedNotifyType::Custom;
+	OutNotify.Name = Name;
+	return true;
+}
+#endif
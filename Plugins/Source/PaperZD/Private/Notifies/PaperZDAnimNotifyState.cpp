@@ -1,6 +1,8 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "Notifies/PaperZDAnimNotifyState.h"
+#include "Notifies/PaperZDNotifyInstrumentation.h"
+#include "PaperZDAnimInstance.h"
 
 //static defines
 const float UPaperZDAnimNotifyState::MinimumStateDuration = (1.0f / 30.0f);
@@ -54,6 +56,7 @@ void UPaperZDAnimNotifyState::TickNotify(float DeltaTime, float Playtime, float
 		{
 			//The previous step handled notifies that were already active, so if we got to this point
 			//this meant that the notify got activated in this frame
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnNotifyBegin(OwningInstance);
 
 			//Then just tick any remainder time
@@ -104,6 +107,7 @@ void UPaperZDAnimNotifyState::TickNotify(float DeltaTime, float Playtime, float
 		{
 			//The previous step handled notifies that were already active, so if we got to this point
 			//this meant that the notify got activated in this frame
+			FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, this, Time);
 			OnNotifyBegin(OwningInstance);
 
 			//Then just tick any remainder time
@@ -19,6 +19,12 @@ UWorld* UPaperZDAnimNotify_Base::GetWorld() const
 	return SequenceRenderComponent ? SequenceRenderComponent->GetWorld() : NULL;
 }
 
+bool UPaperZDAnimNotify_Base::CanBeInCluster() const
+{
+	//Blueprint notifies can hold on to anything between ticks, from variables to latent actions
+	return SupportsClustering() && !GetClass()->HasAnyClassFlags(CLASS_CompiledFromBlueprint) && Super::CanBeInCluster();
+}
+
 FName UPaperZDAnimNotify_Base::GetDisplayName_Implementation() const
 {
 	return Name;
@@ -29,6 +35,17 @@ void UPaperZDAnimNotify_Base::TickNotify(float DeltaTime, float Playtime, float
 	SequenceRenderComponent = AnimRenderComponent;
 }
 
+void UPaperZDAnimNotify_Base::ProcessNotifyTick(float DeltaTime, float Playtime, float LastPlaybackTime, UPrimitiveComponent* AnimRenderComponent, UPaperZDAnimInstance* OwningInstance)
+{
+	TickNotify(DeltaTime, Playtime, LastPlaybackTime, AnimRenderComponent, OwningInstance);
+
+	//A clustered notify is shared by every instance and would keep the last component alive without the collector knowing
+	if (SupportsClustering())
+	{
+		SequenceRenderComponent = nullptr;
+	}
+}
+
 UObject* UPaperZDAnimNotify_Base::GetContainingAsset() const
 {
 	UObject* ContainingAsset = GetTypedOuter<UPaperZDAnimSequence>();
@@ -1,6 +1,7 @@
 // Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
 
 #include "PaperZDAnimNotify_ParticleEffect.h"
+#include "Notifies/PaperZDPackedNotify.h"
 #include "Particles/ParticleSystem.h"
 #include "Kismet/GameplayStatics.h"
 #include "Particles/ParticleSystem.h"
@@ -10,6 +11,7 @@ UPaperZDAnimNotify_ParticleEffect::UPaperZDAnimNotify_ParticleEffect()
 {
 	bAttached = true;
 	Scale = FVector(1.f);
+	RotationOffsetQuat = FQuat::Identity;
 
 #if WITH_EDITORONLY_DATA
 	Color = FColor(192, 255, 99, 255);
@@ -51,26 +53,7 @@ void UPaperZDAnimNotify_ParticleEffect::OnReceiveNotify_Implementation(UPaperZDA
 {
 	if (PSTemplate && SequenceRenderComponent)
 	{
-		if (PSTemplate->IsLooping())
-		{
-			UObject* AnimSequencePkg = GetContainingAsset();
-			UE_LOG(LogTemp, Warning, TEXT("Particle Notify: Particle Notify : Anim '%s' tried to spawn infinitely looping particle system '%s'. Spawning suppressed."), *GetNameSafe(AnimSequencePkg), *GetNameSafe(PSTemplate));
-			return;
-		}
-
-		if (bAttached)
-		{
-			UGameplayStatics::SpawnEmitterAttached(PSTemplate, SequenceRenderComponent, SocketName, LocationOffset, RotationOffset, Scale);
-		}
-		else
-		{
-			const FTransform Transform = SequenceRenderComponent->GetSocketTransform(SocketName);
-			FTransform SpawnTransform;
-			SpawnTransform.SetLocation(Transform.TransformPosition(LocationOffset));
-			SpawnTransform.SetRotation(Transform.GetRotation() * RotationOffsetQuat);
-			SpawnTransform.SetScale3D(Scale);
-			UParticleSystemComponent* System = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), PSTemplate, SpawnTransform);
-		}
+		SpawnEffectForComponent(PSTemplate, SequenceRenderComponent, FTransform(RotationOffsetQuat, LocationOffset, Scale), bAttached, SocketName, GetContainingAsset());
 	}
 	else
 	{
@@ -79,3 +62,43 @@ void UPaperZDAnimNotify_ParticleEffect::OnReceiveNotify_Implementation(UPaperZDA
 	}
 }
 
+void UPaperZDAnimNotify_ParticleEffect::SpawnEffectForComponent(UParticleSystem* PSTemplate, UPrimitiveComponent* RenderComponent, const FTransform& Offset, bool bAttached, FName SocketName, const UObject* Source)
+{
+	if (PSTemplate->IsLooping())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Particle Notify: Particle Notify : Anim '%s' tried to spawn infinitely looping particle system '%s'. Spawning suppressed."), *GetNameSafe(Source), *GetNameSafe(PSTemplate));
+		return;
+	}
+
+	if (bAttached)
+	{
+		UGameplayStatics::SpawnEmitterAttached(PSTemplate, RenderComponent, SocketName, Offset.GetLocation(), Offset.Rotator(), Offset.GetScale3D());
+	}
+	else
+	{
+		const FTransform Transform = RenderComponent->GetSocketTransform(SocketName);
+		FTransform SpawnTransform;
+		SpawnTransform.SetLocation(Transform.TransformPosition(Offset.GetLocation()));
+		SpawnTransform.SetRotation(Transform.GetRotation() * Offset.GetRotation());
+		SpawnTransform.SetScale3D(Offset.GetScale3D());
+		UGameplayStatics::SpawnEmitterAtLocation(RenderComponent->GetWorld(), PSTemplate, SpawnTransform);
+	}
+}
+
+#if WITH_EDITOR
+bool UPaperZDAnimNotify_ParticleEffect::PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const
+{
+	//Child classes can change how the notify behaves, and notifies without a system only report the missing system
+	if (GetClass() != UPaperZDAnimNotify_ParticleEffect::StaticClass() || !PSTemplate)
+	{
+		return false;
+	}
+
+	OutNotify.Type = EPaperZDPackedNotifyType::ParticleEffect;
+	OutNotify.Asset = PSTemplate;
+	OutNotify.bAttached = bAttached;
+	OutNotify.Name = SocketName;
+	OutNotify.TransformIndex = OutTransforms.Add(FTransform(FQuat(RotationOffset), LocationOffset, Scale));
+	return true;
+}
+#endif
@@ -3,6 +3,7 @@
 #include "Notifies/PaperZDAnimNotify_PlaySound.h"
 #include "PaperZD.h"
 #include "PaperZDAnimInstance.h"
+#include "Notifies/PaperZDPackedNotify.h"
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundBase.h"
 #include "Engine/World.h"
@@ -24,34 +25,56 @@ void UPaperZDAnimNotify_PlaySound::OnReceiveNotify_Implementation(UPaperZDAnimIn
 	// We use the SequenceRenderComponent associated to the AnimSequence to know where and how to spawn the sound.
 	if (SequenceRenderComponent && Sound)
 	{
-		if (Sound->IsLooping())
-		{
-			UObject* AnimSequencePkg = GetContainingAsset();
-			UE_LOG(LogAudio, Warning, TEXT("PlaySound notify: Anim %s tried to spawn infinitely looping sound asset %s. Spawning suppressed."), *GetNameSafe(AnimSequencePkg), *GetNameSafe(Sound));
-			return;
-		}
-
 #if WITH_EDITORONLY_DATA
 		UWorld* World = GetWorld();
-		if (bPreviewIgnoreAttenuation && World && World->WorldType == EWorldType::EditorPreview)
+		if (bPreviewIgnoreAttenuation && World && World->WorldType == EWorldType::EditorPreview && !Sound->IsLooping())
 		{
 			UGameplayStatics::PlaySound2D(World, Sound, VolumeMultiplier, PitchMultiplier);
+			return;
 		}
-		else
 #endif
-		{
-			if (bFollow)
-			{
-				UGameplayStatics::SpawnSoundAttached(Sound, SequenceRenderComponent, AttachName, FVector(ForceInit), EAttachLocation::SnapToTarget, false, VolumeMultiplier, PitchMultiplier);
-			}
-			else
-			{
-				UGameplayStatics::PlaySoundAtLocation(GetWorld(), Sound, SequenceRenderComponent->GetComponentLocation(), VolumeMultiplier, PitchMultiplier);
-			}
-		}
+
+		PlaySoundForComponent(Sound, SequenceRenderComponent, VolumeMultiplier, PitchMultiplier, bFollow, AttachName, GetContainingAsset());
+	}
+}
+
+void UPaperZDAnimNotify_PlaySound::PlaySoundForComponent(USoundBase* Sound, UPrimitiveComponent* RenderComponent, float VolumeMultiplier, float PitchMultiplier, bool bFollow, FName AttachName, const UObject* Source)
+{
+	if (Sound->IsLooping())
+	{
+		UE_LOG(LogAudio, Warning, TEXT("PlaySound notify: Anim %s tried to spawn infinitely looping sound asset %s. Spawning suppressed."), *GetNameSafe(Source), *GetNameSafe(Sound));
+		return;
+	}
+
+	if (bFollow)
+	{
+		UGameplayStatics::SpawnSoundAttached(Sound, RenderComponent, AttachName, FVector(ForceInit), EAttachLocation::SnapToTarget, false, VolumeMultiplier, PitchMultiplier);
+	}
+	else
+	{
+		UGameplayStatics::PlaySoundAtLocation(RenderComponent->GetWorld(), Sound, RenderComponent->GetComponentLocation(), VolumeMultiplier, PitchMultiplier);
 	}
 }
 
+#if WITH_EDITOR
+bool UPaperZDAnimNotify_PlaySound::PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const
+{
+	//Child classes can change how the notify behaves
+	if (GetClass() != UPaperZDAnimNotify_PlaySound::StaticClass() || !Sound)
+	{
+		return false;
+	}
+
+	OutNotify.Type = EPaperZDPackedNotifyType::PlaySound;
+	OutNotify.Asset = Sound;
+	OutNotify.VolumeMultiplier = VolumeMultiplier;
+	OutNotify.PitchMultiplier = PitchMultiplier;
+	OutNotify.bAttached = bFollow;
+	OutNotify.Name = AttachName;
+	return true;
+}
+#endif
+
 FName UPaperZDAnimNotify_PlaySound::GetDisplayName_Implementation() const
 {
 	if (Sound)
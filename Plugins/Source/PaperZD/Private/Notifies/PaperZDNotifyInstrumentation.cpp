@@ -0,0 +1,27 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Notifies/PaperZDNotifyInstrumentation.h"
+#include "Notifies/PaperZDAnimNotify_Base.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimCounters.h"
+#include "PaperZDProfiler.h"
+#include "PaperZDNodeCost.h"
+#include "PaperZDTrace.h"
+
+void FPaperZDNotifyInstrumentation::OnNotifyFired(UPaperZDAnimInstance* OwningInstance, const UPaperZDAnimNotify_Base* Notify, float Time)
+{
+	FPaperZDAnimCounters::CountNotifyFired();
+	FPaperZDProfiler::CountNotifyFired(OwningInstance);
+	PAPERZD_COST_NOTIFY(OwningInstance);
+	PAPERZD_RECORD(OwningInstance, Notify, Notify, Time);
+	PAPERZD_TRACE_EVENT(NotifyFired, OwningInstance, Notify);
+}
+
+void FPaperZDNotifyInstrumentation::OnNotifyFired(UPaperZDAnimInstance* OwningInstance, const UObject* RecordedObject, FName NotifyName, const UClass* NotifyClass, float Time)
+{
+	FPaperZDAnimCounters::CountNotifyFired();
+	FPaperZDProfiler::CountNotifyFired(OwningInstance);
+	PAPERZD_COST_NOTIFY(OwningInstance);
+	PAPERZD_RECORD(OwningInstance, Notify, RecordedObject, Time);
+	PAPERZD_TRACE_EVENT(NotifyFired, OwningInstance, NotifyName, NotifyClass);
+}
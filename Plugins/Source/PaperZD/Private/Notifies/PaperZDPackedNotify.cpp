@@ -0,0 +1,67 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Notifies/PaperZDPackedNotify.h"
+#include "Notifies/PaperZDAnimNotify_PlaySound.h"
+#include "Notifies/PaperZDAnimNotify_ParticleEffect.h"
+#include "Notifies/PaperZDAnimNotifyCustom.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
+#include "Notifies/PaperZDNotifyInstrumentation.h"
+#include "PaperZDAnimInstance.h"
+#include "Particles/ParticleSystem.h"
+#include "Sound/SoundBase.h"
+
+UClass* FPaperZDPackedNotify::GetNotifyClass() const
+{
+	switch (Type)
+	{
+		case EPaperZDPackedNotifyType::PlaySound:
+			return UPaperZDAnimNotify_PlaySound::StaticClass();
+		case EPaperZDPackedNotifyType::ParticleEffect:
+			return UPaperZDAnimNotify_ParticleEffect::StaticClass();
+		default:
+			return UPaperZDAnimNotifyCustom::StaticClass();
+	}
+}
+
+FName FPaperZDPackedNotify::GetDisplayName() const
+{
+	//Sounds and particles display their asset, same as their objects
+	return Asset ? Asset->GetFName() : Name;
+}
+
+void FPaperZDPackedNotify::Fire(const UPaperZDAnimSequence* AnimSequence, UPrimitiveComponent* RenderComponent, UPaperZDAnimInstance* OwningInstance) const
+{
+	FPaperZDNotifyInstrumentation::OnNotifyFired(OwningInstance, Asset ? Asset : AnimSequence, GetDisplayName(), GetNotifyClass(), Time);
+
+	//Assets can still fail to load, even if they were set when the record was packed
+	switch (Type)
+	{
+		case EPaperZDPackedNotifyType::PlaySound:
+			if (USoundBase* Sound = Cast<USoundBase>(Asset))
+			{
+				if (RenderComponent)
+				{
+					UPaperZDAnimNotify_PlaySound::PlaySoundForComponent(Sound, RenderComponent, VolumeMultiplier, PitchMultiplier, bAttached, Name, AnimSequence);
+				}
+			}
+			break;
+
+		case EPaperZDPackedNotifyType::ParticleEffect:
+			if (UParticleSystem* PSTemplate = Cast<UParticleSystem>(Asset))
+			{
+				if (RenderComponent)
+				{
+					UPaperZDAnimNotify_ParticleEffect::SpawnEffectForComponent(PSTemplate, RenderComponent, AnimSequence->GetPackedNotifyTransform(TransformIndex), bAttached, Name, AnimSequence);
+				}
+			}
+			break;
+
+		case EPaperZDPackedNotifyType::Custom:
+			//Owning instance can be null on editor
+			if (OwningInstance)
+			{
+				UPaperZDAnimNotifyCustom::CallNotifyFunction(OwningInstance, Name);
+			}
+			break;
+	}
+}
@@ -0,0 +1,155 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAllocationCounter.h"
+
+#if PAPERZD_ALLOCATION_COUNTER_ENABLED
+
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+/**
+ * Allocator proxy that forwards everything to the allocator it replaced, counting the allocations while enabled.
+ * Never destroyed once installed, as any thread could still be holding it.
+ */
+class FPaperZDCountingMalloc : public FMalloc
+{
+	/* Allocator we forward to. */
+	FMalloc* InnerMalloc;
+
+public:
+	std::atomic<bool> bCounting;
+	std::atomic<uint32> CountingThreadId;
+	std::atomic<int64> NumAllocations;
+	std::atomic<int64> AllocatedBytes;
+
+public:
+	//ctor
+	FPaperZDCountingMalloc(FMalloc* InInnerMalloc)
+		: InnerMalloc(InInnerMalloc)
+		, bCounting(false)
+		, CountingThreadId(0)
+		, NumAllocations(0)
+		, AllocatedBytes(0)
+	{}
+
+	/* Installs the proxy in front of the current allocator the first time it's called. */
+	static FPaperZDCountingMalloc& Get()
+	{
+		static FPaperZDCountingMalloc* Instance = nullptr;
+		if (!Instance)
+		{
+			check(IsInGameThread());
+			Instance = new FPaperZDCountingMalloc(GMalloc);
+			GMalloc = Instance;
+		}
+		return *Instance;
+	}
+
+	//~ Begin FMalloc Interface
+	virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+	{
+		void* Result = InnerMalloc->Malloc(Size, Alignment);
+		CountAllocation(Size);
+		return Result;
+	}
+
+	virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override
+	{
+		void* Result = InnerMalloc->TryMalloc(Size, Alignment);
+		CountAllocation(Size);
+		return Result;
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		void* Result = InnerMalloc->Realloc(Original, Size, Alignment);
+		if (Result && Result != Original)
+		{
+			CountAllocation(Size);
+		}
+		return Result;
+	}
+
+	virtual void* TryRealloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		void* Result = InnerMalloc->TryRealloc(Original, Size, Alignment);
+		if (Result && Result != Original)
+		{
+			CountAllocation(Size);
+		}
+		return Result;
+	}
+
+	virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { InnerMalloc->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+	//~ End FMalloc Interface
+
+private:
+	FORCEINLINE void CountAllocation(SIZE_T Size)
+	{
+		if (bCounting.load(std::memory_order_relaxed))
+		{
+			const uint32 ThreadId = CountingThreadId.load(std::memory_order_relaxed);
+			if (ThreadId == 0 || ThreadId == FPlatformTLS::GetCurrentThreadId())
+			{
+				NumAllocations.fetch_add(1, std::memory_order_relaxed);
+				AllocatedBytes.fetch_add(static_cast<int64>(Size), std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+FPaperZDScopedAllocationCounter::FPaperZDScopedAllocationCounter(bool bInCurrentThreadOnly /* = false */)
+	: bCounting(true)
+	, NumAllocations(0)
+	, AllocatedBytes(0)
+{
+	FPaperZDCountingMalloc& CountingMalloc = FPaperZDCountingMalloc::Get();
+	check(!CountingMalloc.bCounting);
+
+	CountingMalloc.NumAllocations = 0;
+	CountingMalloc.AllocatedBytes = 0;
+	CountingMalloc.CountingThreadId = bInCurrentThreadOnly ? FPlatformTLS::GetCurrentThreadId() : 0;
+	CountingMalloc.bCounting = true;
+}
+
+FPaperZDScopedAllocationCounter::~FPaperZDScopedAllocationCounter()
+{
+	Stop();
+}
+
+void FPaperZDScopedAllocationCounter::Stop()
+{
+	if (bCounting)
+	{
+		FPaperZDCountingMalloc& CountingMalloc = FPaperZDCountingMalloc::Get();
+		CountingMalloc.bCounting = false;
+		NumAllocations = CountingMalloc.NumAllocations;
+		AllocatedBytes = CountingMalloc.AllocatedBytes;
+		bCounting = false;
+	}
+}
+
+int64 FPaperZDScopedAllocationCounter::GetNumAllocations() const
+{
+	return bCounting ? FPaperZDCountingMalloc::Get().NumAllocations.load() : NumAllocations;
+}
+
+int64 FPaperZDScopedAllocationCounter::GetAllocatedBytes() const
+{
+	return bCounting ? FPaperZDCountingMalloc::Get().AllocatedBytes.load() : AllocatedBytes;
+}
+
+#endif //PAPERZD_ALLOCATION_COUNTER_ENABLED
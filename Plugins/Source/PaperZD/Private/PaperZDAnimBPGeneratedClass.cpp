@@ -4,9 +4,60 @@
 #include "AnimNodes/PaperZDAnimNode_Base.h"
 #include "AnimNodes/PaperZDAnimNode_Sink.h"
 #include "AnimNodes/PaperZDAnimNode_StateMachine.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
+#include "PaperZDStats.h"
+#include "PaperZDAnimInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+//Stats declarations
+DECLARE_CYCLE_STAT(TEXT("Prewarm AnimBP Class"), STAT_PrewarmAnimClass, STATGROUP_PaperZD);
+
+//Console variables
+static TAutoConsoleVariable<float> CVarPrewarmTextureResidentTime(
+	TEXT("paperzd.PrewarmTextureResidentTime"),
+	5.0f,
+	TEXT("Seconds the textures of the animations referenced by a prewarmed AnimBP are forced to stay fully streamed in, so they don't display blurry on their first frames. Zero to leave streaming alone."),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdNodeMemory(
+	TEXT("paperzd.NodeMemory"),
+	TEXT("Prints the memory each AnimInstance uses for its AnimNodes, per loaded AnimBP class, and the random player entries kept once on the class. Only the random player data is split off the instances. The 'before' figure is an estimate, the current instance size plus that shared data, not a measurement of the old layout."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		TMap<const UClass*, int32> NumInstances;
+		for (TObjectIterator<UPaperZDAnimInstance> It; It; ++It)
+		{
+			if (!It->IsTemplate())
+			{
+				NumInstances.FindOrAdd(It->GetClass())++;
+			}
+		}
+
+		for (TObjectIterator<UPaperZDAnimBPGeneratedClass> It; It; ++It)
+		{
+			//Outdated classes left behind by the editor recompiling
+			if (It->HasAnyClassFlags(CLASS_NewerVersionExists) || It->GetNumAnimNodes() == 0)
+			{
+				continue;
+			}
+
+			SIZE_T InstanceBytes = 0;
+			SIZE_T SharedBytes = 0;
+			It->GetNodeMemoryUsage(InstanceBytes, SharedBytes);
+
+			//Before the split, every instance held its own copy of the shared data. Estimated, as the old layout isn't around to be measured
+			const int32 Instances = NumInstances.FindRef(*It);
+			UE_LOG(LogTemp, Display, TEXT("%s: %d instances, %llu bytes per instance (%llu bytes estimated before), %llu bytes of random player entries shared on the class, %llu bytes saved"),
+				*It->GetName(), Instances, (uint64)InstanceBytes, (uint64)(InstanceBytes + SharedBytes), (uint64)SharedBytes, (uint64)(SharedBytes * Instances));
+		}
+	}));
 
 UPaperZDAnimBPGeneratedClass::UPaperZDAnimBPGeneratedClass()
 	: Super()
+	, RootNodeProperty(nullptr)
+	, bSupportsParallelUpdate(false)
+	, bPrewarmed(false)
 {}
 
 void UPaperZDAnimBPGeneratedClass::Link(FArchive& Ar, bool bRelinkExistingProperties)
@@ -53,9 +104,22 @@ void UPaperZDAnimBPGeneratedClass::PurgeClass(bool bRecompilingOnLoad)
 	AnimNodeProperties.Empty();
 	EvaluateGraphExposedInputs.Empty();
 	StateMachines.Empty();
+	AnimPrograms.Empty();
 	AnimNotifyFunctionMapping.Empty();
+	RandomPlayers.Empty();
+	PrewarmedEventFunctions.Empty();
+	PrewarmedNotifyFunctions.Empty();
+#if WITH_EDITORONLY_DATA
+	AnimBPDebugData.StateMachines.Empty();
+	AnimBPDebugData.NodeGuidToLinkID.Empty();
+#endif
+#if PAPERZD_NODE_COST_ENABLED
+	NodeCostData = FPaperZDNodeCostData();
+#endif
 	RootNodeProperty = nullptr;
 	SupportedAnimationSource = nullptr;
+	bSupportsParallelUpdate = false;
+	bPrewarmed = false;
 }
 
 void UPaperZDAnimBPGeneratedClass::PostLoadDefaultObject(UObject* Object)
@@ -67,6 +131,8 @@ void UPaperZDAnimBPGeneratedClass::PostLoadDefaultObject(UObject* Object)
 	while (Iter)
 	{
 		FPaperZDExposedValueHandler::InitClass(Iter->EvaluateGraphExposedInputs, Object);
+		FPaperZDAnimStateMachine::InitClass(Iter->StateMachines, Iter);
+		FPaperZDAnimProgram::InitClass(Iter->AnimPrograms, this, Object);
 		Iter = Cast<UPaperZDAnimBPGeneratedClass>(Iter->GetSuperClass());
 	}
 
@@ -75,8 +141,22 @@ void UPaperZDAnimBPGeneratedClass::PostLoadDefaultObject(UObject* Object)
 
 void UPaperZDAnimBPGeneratedClass::CacheRequiredNodes(UObject* DefaultObject)
 {
-	for (FStructProperty* StructProp : AnimNodeProperties)
+	bSupportsParallelUpdate = true;
+	for (int32 LinkID = 0; LinkID < AnimNodeProperties.Num(); LinkID++)
 	{
+		//A single node that needs the game thread forces the whole graph to update there
+		FStructProperty* StructProp = AnimNodeProperties[LinkID];
+		FPaperZDAnimNode_Base* AnimNode = StructProp->ContainerPtrToValuePtr<FPaperZDAnimNode_Base>(DefaultObject);
+		bSupportsParallelUpdate &= AnimNode->CanUpdateInWorkerThread(this);
+
+		//Exposed values run as the node updates, the fast-path copies can do so anywhere but bound functions need the blueprint VM
+		const FPaperZDExposedValueHandler* Handler = AnimNode->ExposedValueHandler;
+		bSupportsParallelUpdate &= Handler == nullptr || Handler->BoundFunction == NAME_None;
+		AnimNode->NodeStruct = StructProp->Struct;
+#if PAPERZD_NODE_COST_ENABLED
+		AnimNode->NodeLinkID = LinkID;
+#endif
+
 		if (StructProp->Struct == FPaperZDAnimNode_Sink::StaticStruct())
 		{
 			//We're dealing with a sink node, check if this is actually the main sink
@@ -111,8 +191,18 @@ TArray<FPaperZDAnimNode_StateMachine*> UPaperZDAnimBPGeneratedClass::GetStateMac
 	return StateMachineNodes;
 }
 
+FPaperZDAnimNode_StateMachine* UPaperZDAnimBPGeneratedClass::GetStateMachineNode(UObject* AnimInstanceObject, int32 Index) const
+{
+	return StateMachineNodeProperties.IsValidIndex(Index) ? StateMachineNodeProperties[Index]->ContainerPtrToValuePtr<FPaperZDAnimNode_StateMachine>(AnimInstanceObject) : nullptr;
+}
+
 UFunction* UPaperZDAnimBPGeneratedClass::FindAnimNotifyFunction(FName AnimNotifyName) const
 {
+	if (UFunction* const* PrewarmedFunction = PrewarmedNotifyFunctions.Find(AnimNotifyName))
+	{
+		return *PrewarmedFunction;
+	}
+
 	const FName* pAnimFunctionName = AnimNotifyFunctionMapping.Find(AnimNotifyName);
 	if (pAnimFunctionName)
 	{
@@ -122,6 +212,129 @@ UFunction* UPaperZDAnimBPGeneratedClass::FindAnimNotifyFunction(FName AnimNotify
 	return nullptr;
 }
 
+UFunction* UPaperZDAnimBPGeneratedClass::FindEventFunction(FName EventName) const
+{
+	if (UFunction* const* PrewarmedFunction = PrewarmedEventFunctions.Find(EventName))
+	{
+		return *PrewarmedFunction;
+	}
+
+	return FindFunctionByName(EventName);
+}
+
+double UPaperZDAnimBPGeneratedClass::Prewarm()
+{
+	//Resolving functions accesses the shared function map of the class
+	check(IsInGameThread());
+	if (bPrewarmed)
+	{
+		return 0.0;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PrewarmAnimClass);
+	const double StartTime = FPlatformTime::Seconds();
+	UObject* DefaultObject = GetDefaultObject();
+
+	//Function pointers, the parent classes own part of the graph and the state machines
+	UPaperZDAnimBPGeneratedClass* Iter = this;
+	while (Iter)
+	{
+		//Usually done when the CDO loads, but classes compiled on the editor don't go through it, and rule functions are left unresolved when loading asynchronously
+		FPaperZDExposedValueHandler::InitClass(Iter->EvaluateGraphExposedInputs, DefaultObject);
+		FPaperZDAnimStateMachine::InitClass(Iter->StateMachines, Iter);
+
+		for (const FPaperZDAnimStateMachine& StateMachine : Iter->StateMachines)
+		{
+			for (const FPaperZDAnimStateMachineNode& Node : StateMachine.Nodes)
+			{
+				for (const FName EventName : { Node.OnStateEnterEventName, Node.OnStateExitEventName })
+				{
+					if (EventName != NAME_None && !PrewarmedEventFunctions.Contains(EventName))
+					{
+						PrewarmedEventFunctions.Add(EventName, FindFunctionByName(EventName));
+					}
+				}
+			}
+		}
+
+		Iter = Cast<UPaperZDAnimBPGeneratedClass>(Iter->GetSuperClass());
+	}
+
+	//Notifies only look into the mapping of this class
+	for (const TPair<FName, FName>& NotifyPair : AnimNotifyFunctionMapping)
+	{
+		PrewarmedNotifyFunctions.Add(NotifyPair.Key, FindFunctionByName(NotifyPair.Value));
+	}
+
+	//Animation data used by the class
+	TSet<const UPaperZDAnimSequence*> Sequences;
+	GetReferencedSequences(Sequences);
+	const float TextureResidentTime = CVarPrewarmTextureResidentTime.GetValueOnGameThread();
+	for (const UPaperZDAnimSequence* Sequence : Sequences)
+	{
+		Sequence->Prewarm(TextureResidentTime);
+	}
+
+	bPrewarmed = true;
+	return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+void UPaperZDAnimBPGeneratedClass::GetReferencedSequences(TSet<const UPaperZDAnimSequence*>& OutSequences) const
+{
+	const UPaperZDAnimBPGeneratedClass* Iter = this;
+	while (Iter)
+	{
+		//Sequences baked onto the class
+		for (const FPaperZDRandomPlayerData& RandomPlayer : Iter->RandomPlayers)
+		{
+			for (const FPaperZDRandomPlayerEntry& Entry : RandomPlayer.Entries)
+			{
+				if (Entry.AnimSequence)
+				{
+					OutSequences.Add(Entry.AnimSequence);
+				}
+			}
+		}
+
+		//Sequences that are only referenced from the graph functions (i.e. play overrides)
+		for (UObject* ReferencedObject : Iter->ScriptAndPropertyObjectReferences)
+		{
+			if (const UPaperZDAnimSequence* Sequence = Cast<UPaperZDAnimSequence>(ReferencedObject))
+			{
+				OutSequences.Add(Sequence);
+			}
+		}
+
+		Iter = Cast<UPaperZDAnimBPGeneratedClass>(Iter->GetSuperClass());
+	}
+
+	//Sequences referenced by the AnimNodes and the variables
+	const UObject* DefaultObject = GetDefaultObject(false);
+	if (DefaultObject)
+	{
+		for (TPropertyValueIterator<FObjectPropertyBase> It(this, DefaultObject); It; ++It)
+		{
+			if (const UPaperZDAnimSequence* Sequence = Cast<UPaperZDAnimSequence>(It.Key()->GetObjectPropertyValue(It.Value())))
+			{
+				OutSequences.Add(Sequence);
+			}
+		}
+	}
+}
+
+void UPaperZDAnimBPGeneratedClass::CreateCluster()
+{
+	//Blueprint clustering would otherwise absorb the sequences, tying the whole library to the first AnimBP that loads it
+	TSet<const UPaperZDAnimSequence*> Sequences;
+	GetReferencedSequences(Sequences);
+	for (const UPaperZDAnimSequence* Sequence : Sequences)
+	{
+		UPaperZDAnimSequence::CreateDependencyCluster(const_cast<UPaperZDAnimSequence*>(Sequence));
+	}
+
+	Super::CreateCluster();
+}
+
 FPaperZDAnimNode_Base* UPaperZDAnimBPGeneratedClass::GetAnimNodeByLinkID(UObject* AnimInstanceObject, int32 LinkID) const
 {
 	FPaperZDAnimNode_Base* AnimNode = nullptr;
@@ -155,3 +368,29 @@ const UPaperZDAnimationSource* UPaperZDAnimBPGeneratedClass::GetSupportedAnimati
 {
 	return SupportedAnimationSource;
 }
+
+void UPaperZDAnimBPGeneratedClass::GetNodeMemoryUsage(SIZE_T& OutInstanceBytes, SIZE_T& OutSharedBytes) const
+{
+	//Instances start as a copy of the CDO, so the containers allocate the same there
+	OutInstanceBytes = 0;
+	const UObject* DefaultObject = GetDefaultObject(false);
+	for (const FStructProperty* StructProp : AnimNodeProperties)
+	{
+		OutInstanceBytes += StructProp->ElementSize;
+		if (DefaultObject)
+		{
+			const void* NodeValue = StructProp->ContainerPtrToValuePtr<void>(DefaultObject);
+			for (TPropertyValueIterator<FArrayProperty> It(StructProp->Struct, NodeValue); It; ++It)
+			{
+				FScriptArrayHelper ArrayHelper(It.Key(), It.Value());
+				OutInstanceBytes += ArrayHelper.Num() * It.Key()->Inner->ElementSize;
+			}
+		}
+	}
+
+	OutSharedBytes = RandomPlayers.GetAllocatedSize();
+	for (const FPaperZDRandomPlayerData& RandomPlayer : RandomPlayers)
+	{
+		OutSharedBytes += RandomPlayer.GetAllocatedSize();
+	}
+}
@@ -0,0 +1,21 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAnimCounters.h"
+
+bool FPaperZDAnimCounters::bEnabled = false;
+std::atomic<int64> FPaperZDAnimCounters::NotifiesFired(0);
+std::atomic<int64> FPaperZDAnimCounters::StateTransitions(0);
+
+void FPaperZDAnimCounters::Reset()
+{
+	NotifiesFired.store(0, std::memory_order_relaxed);
+	StateTransitions.store(0, std::memory_order_relaxed);
+}
+
+FPaperZDAnimCounters::FSnapshot FPaperZDAnimCounters::GetSnapshot()
+{
+	FSnapshot Snapshot;
+	Snapshot.NotifiesFired = NotifiesFired.load(std::memory_order_relaxed);
+	Snapshot.StateTransitions = StateTransitions.load(std::memory_order_relaxed);
+	return Snapshot;
+}
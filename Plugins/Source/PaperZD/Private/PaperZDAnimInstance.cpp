@@ -4,12 +4,19 @@
 #include "PaperZDAnimBPGeneratedClass.h"
 #include "PaperZDCharacter.h"
 #include "PaperZDStats.h"
+#include "PaperZDTrace.h"
+#include "PaperZDProfiler.h"
+#include "PaperZDAnimSharing.h"
 #include "AnimSequences/Sources/PaperZDAnimationSource.h"
 #include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
 #include "AnimNodes/PaperZDAnimNode_Sink.h"
 #include "AnimNodes/PaperZDAnimNode_StateMachine.h"
 #include "AnimNodes/PaperZDAnimNode_PlaySequence.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
 
 //Stats declarations
 DECLARE_CYCLE_STAT(TEXT("[TOTAL]"), STAT_TickAnimInstance, STATGROUP_PaperZD);
@@ -17,12 +24,43 @@ DECLARE_CYCLE_STAT(TEXT("Update AnimGraph"), STAT_UpdateAnimGraph, STATGROUP_Pap
 DECLARE_CYCLE_STAT(TEXT("Render Animations"), STAT_RenderAnimations, STATGROUP_PaperZD);
 DECLARE_CYCLE_STAT(TEXT("Blueprint Tick"), STAT_AnimBPTick, STATGROUP_PaperZD);
 
+//Console variables
+static TAutoConsoleVariable<int32> CVarForceLightweightPlayer(
+	TEXT("paperzd.LightweightPlayer"),
+	0,
+	TEXT("If non zero, every AnimInstance initialized from now on uses the lightweight player, regardless of its class setting."),
+	ECVF_Default);
+
+#if PAPERZD_RECORDER_ENABLED
+namespace FPaperZDAnimInstanceHelpers
+{
+	/* Time stamp of the recorded frames, instances without a world (i.e. editor previews) record zero. */
+	float GetRecorderWorldTime(const UPaperZDAnimInstance* AnimInstance)
+	{
+		const UWorld* World = AnimInstance->GetWorld();
+		return World ? World->GetTimeSeconds() : 0.0f;
+	}
+}
+#endif
+
 UPaperZDAnimInstance::UPaperZDAnimInstance()
 	: Super()
 {
 	//Setup CDO values
 	bIgnoreTimeDilation = false;
 	bAllowTransitionalStates = true;
+	bRunningParallelUpdate = false;
+	bSkipRenderUpdate = false;
+	ParallelUpdateDeltaTime = 0.0f;
+	bAllowSleeping = false;
+	bUseLightweightPlayer = false;
+	bUsingLightweightPlayer = false;
+	SleepDeltaScale = 0.0f;
+	GraphUpdateCount = 0;
+	ProfileTickCycles = 0;
+#if PAPERZD_NODE_COST_ENABLED
+	bCapturingNodeCosts = false;
+#endif
 }
 
 UWorld* UPaperZDAnimInstance::GetWorld() const
@@ -32,6 +70,13 @@ UWorld* UPaperZDAnimInstance::GetWorld() const
 
 UPaperZDAnimPlayer* UPaperZDAnimInstance::GetPlayer() const
 {
+	//The lightweight player creates its object on demand, which can only be done from the game thread
+	if (!AnimPlayer && bUsingLightweightPlayer && IsInGameThread())
+	{
+		UPaperZDAnimInstance* MutableThis = const_cast<UPaperZDAnimInstance*>(this);
+		MutableThis->AnimPlayer = UPaperZDAnimPlayer::CreateProxy(MutableThis, MutableThis->PlayerState);
+	}
+
 	return AnimPlayer;
 }
 
@@ -40,29 +85,155 @@ bool UPaperZDAnimInstance::AllowsTransitionalStates() const
 	return bAllowTransitionalStates;
 }
 
+bool UPaperZDAnimInstance::CanSleep(float& OutSleepDeltaScale) const
+{
+	OutSleepDeltaScale = SleepDeltaScale;
+	return bAllowSleeping && RootNode && !bSequencerOverride && !bRunningParallelUpdate;
+}
+
+bool UPaperZDAnimInstance::GetAnimSharingDirection_Implementation(float& OutDirectionalAngle) const
+{
+	//Followers don't evaluate, but they keep the angle they had when they joined the group
+	OutDirectionalAngle = EvaluatedPlaybackData.DirectionalAngle;
+	return true;
+}
+
+bool UPaperZDAnimInstance::GetAnimSharingKey(int32 NumDirectionBuckets, FPaperZDAnimSharingKey& OutKey, float& OutDirectionalAngle) const
+{
+	if (!RootNode || bSequencerOverride || !GetAnimSharingDirection(OutDirectionalAngle))
+	{
+		return false;
+	}
+
+	//Buckets are centered on their direction, so the bucket zero goes from -HalfBucket to +HalfBucket
+	const int32 NumBuckets = FMath::Max(NumDirectionBuckets, 1);
+	const float BucketSize = 360.0f / NumBuckets;
+	OutKey.AnimClass = GetClass();
+	OutKey.StateHash = GetAnimSharingStateHash();
+	OutKey.DirectionBucket = FMath::FloorToInt(FRotator::ClampAxis(OutDirectionalAngle + BucketSize * 0.5f) / BucketSize) % NumBuckets;
+	return true;
+}
+
+uint32 UPaperZDAnimInstance::GetAnimSharingStateHash() const
+{
+	//Inactive nested machines are hashed too, which can only split groups that would have rendered the same
+	uint32 StateHash = 0;
+	const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
+	if (AnimClass)
+	{
+		for (int32 i = 0; i < AnimClass->GetNumStateMachineNodes(); i++)
+		{
+			const FPaperZDAnimNode_StateMachine* StateMachineNode = AnimClass->GetStateMachineNode(const_cast<UPaperZDAnimInstance*>(this), i);
+			StateHash = HashCombine(StateHash, GetTypeHash(StateMachineNode->GetCurrentStateIndex()));
+			StateHash = HashCombine(StateHash, GetTypeHash(StateMachineNode->IsPlayingTransitionalAnimation()));
+		}
+	}
+
+	return StateHash;
+}
+
+void UPaperZDAnimInstance::UpdateSharedStateMachines(float DeltaTime, const UPaperZDAnimInstance* SharedInstance)
+{
+	check(SharedInstance && SharedInstance->GetClass() == GetClass());
+	SCOPE_CYCLE_COUNTER(STAT_UpdateAnimGraph);
+	if (bIgnoreTimeDilation)
+	{
+		DeltaTime = GetDeltaTimeIgnoredDilation(DeltaTime);
+	}
+
+#if PAPERZD_RECORDER_ENABLED
+	Recorder.BeginFrame(FPaperZDAnimInstanceHelpers::GetRecorderWorldTime(this));
+#endif
+
+	//Both instances were on the same states, so the machines the shared instance updated are the active ones here too
+	GraphUpdateCount++;
+	const UPaperZDAnimBPGeneratedClass* AnimClass = CastChecked<UPaperZDAnimBPGeneratedClass>(GetClass());
+	const FPaperZDAnimationUpdateContext UpdateContext(this, DeltaTime);
+	for (int32 i = 0; i < AnimClass->GetNumStateMachineNodes(); i++)
+	{
+		const FPaperZDAnimNode_StateMachine* SharedMachine = AnimClass->GetStateMachineNode(const_cast<UPaperZDAnimInstance*>(SharedInstance), i);
+		if (SharedMachine->WasUpdatedOnLastGraphUpdate(SharedInstance))
+		{
+			AnimClass->GetStateMachineNode(this, i)->UpdateSharedState(UpdateContext, *SharedMachine);
+		}
+	}
+}
+
+void UPaperZDAnimInstance::PlaySharedAnimation(float DeltaTime, const FPaperZDAnimationPlaybackData& SharedPlaybackData)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickAnimInstance);
+	PAPERZD_TRACE_SCOPE(GetClass()->GetFName());
+	if (bIgnoreTimeDilation)
+	{
+		DeltaTime = GetDeltaTimeIgnoredDilation(DeltaTime);
+	}
+
+	//Notifies fire on the window this instance crossed, which accounts for its own time offset
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RenderAnimations);
+		PAPERZD_RECORD(this, Playback, SharedPlaybackData);
+		PlayerState.PlayShared(SharedPlaybackData, this, !bSkipRenderUpdate);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AnimBPTick);
+		FPaperZDProfiler::CountBlueprintEvent(this, GET_FUNCTION_NAME_CHECKED(UPaperZDAnimInstance, OnTick));
+		OnTick(DeltaTime);
+	}
+}
+
+void UPaperZDAnimInstance::WakeUp()
+{
+	if (Manager.GetObject())
+	{
+		Manager->OnWakeUpAnimInstance();
+	}
+}
+
 UFunction* UPaperZDAnimInstance::FindAnimNotifyFunction(FName AnimNotifyName) const
 {
 	UPaperZDAnimBPGeneratedClass* AnimClass = CastChecked<UPaperZDAnimBPGeneratedClass>(GetClass());
 	return AnimClass->FindAnimNotifyFunction(AnimNotifyName);
 }
 
+UFunction* UPaperZDAnimInstance::FindEventFunction(FName EventName) const
+{
+	const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
+	return AnimClass ? AnimClass->FindEventFunction(EventName) : FindFunction(EventName);
+}
+
 void UPaperZDAnimInstance::Tick(float DeltaTime)
 {
 	SCOPE_CYCLE_COUNTER(STAT_TickAnimInstance);
+	PAPERZD_TRACE_SCOPE(GetClass()->GetFName());
+	FPaperZDProfileTickScope ProfileScope(this, ProfileTickCycles, true, true);
 	if (bIgnoreTimeDilation)
 	{
 		//Modify the DeltaTime to use an non-dilated value
 		DeltaTime = GetDeltaTimeIgnoredDilation(DeltaTime);
 	}
 
+#if PAPERZD_RECORDER_ENABLED
+	Recorder.BeginFrame(FPaperZDAnimInstanceHelpers::GetRecorderWorldTime(this));
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	BeginNodeCostCapture();
+#endif
+
 	//Process the animation nodes
 	ProcessAnimations(DeltaTime);
 
 	//Call the blueprint method, if it exists
 	{
 		SCOPE_CYCLE_COUNTER(STAT_AnimBPTick);
+		FPaperZDProfiler::CountBlueprintEvent(this, GET_FUNCTION_NAME_CHECKED(UPaperZDAnimInstance, OnTick));
 		OnTick(DeltaTime);
 	}
+
+#if PAPERZD_NODE_COST_ENABLED
+	EndNodeCostCapture();
+#endif
 }
 
 void UPaperZDAnimInstance::OnTick_Implementation(float DeltaTime)
@@ -85,19 +256,85 @@ void UPaperZDAnimInstance::Init(TScriptInterface<IPaperZDAnimInstanceManager> In
 	}
 
 	//Init the player
-	AnimPlayer = NewObject<UPaperZDAnimPlayer>(this);
-	AnimPlayer->Init(AnimSource);
-	AnimPlayer->RegisterRenderComponent(Manager->GetRenderComponent());
-	Manager->OnSetupAnimPlayer(AnimPlayer);
+	PlayerState.Init(AnimSource, this);
+	bUsingLightweightPlayer = bUseLightweightPlayer || CVarForceLightweightPlayer.GetValueOnGameThread() != 0;
+	if (bUsingLightweightPlayer)
+	{
+		//Playback events come straight to us, the player object is left for whoever asks for it
+		PlayerState.SetEventInstance(this);
+	}
+	else
+	{
+		AnimPlayer = UPaperZDAnimPlayer::CreateProxy(this, PlayerState);
+
+		//Bind the corresponding delegates
+		AnimPlayer->OnPlaybackSequenceChanged.AddDynamic(this, &UPaperZDAnimInstance::OnAnimSequenceUpdated);
+		AnimPlayer->OnPlaybackSequenceComplete.AddDynamic(this, &UPaperZDAnimInstance::OnAnimSequencePlaybackComplete);
+	}
+
+	InitAnimGraph();
+}
+
+void UPaperZDAnimInstance::Reinit(TScriptInterface<IPaperZDAnimInstanceManager> InManager)
+{
+	Manager = InManager;
+
+	//Blueprint variables and AnimNodes go back to the class defaults, containers keep their memory when the sizes match
+	//Native members belong to this class and get reset below, native subclasses should reset any non-property state on OnInit
+	const UObject* DefaultObject = GetClass()->GetDefaultObject();
+	for (TFieldIterator<FProperty> It(GetClass()); It; ++It)
+	{
+		if (It->GetOwnerClass() != UPaperZDAnimInstance::StaticClass())
+		{
+			It->CopyCompleteValue_InContainer(this, DefaultObject);
+		}
+	}
+
+	bIgnoreTimeDilation = CastChecked<UPaperZDAnimInstance>(DefaultObject)->bIgnoreTimeDilation;
+	bSequencerOverride = false;
+	bSkipRenderUpdate = false;
+	ParallelUpdateDeltaTime = 0.0f;
+	SleepDeltaScale = 0.0f;
+	ProfileTickCycles = 0;
+	EvaluatedPlaybackData.Reset();
+	DeferredEvents.Reset();
+#if PAPERZD_RECORDER_ENABLED
+	Recorder.Reset();
+#endif
+
+	//The player keeps its playback handle and our delegate bindings
+	const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
+	PlayerState.ResetForReuse(AnimClass ? AnimClass->GetSupportedAnimationSource() : nullptr);
+
+	InitAnimGraph();
+}
 
-	//Bind the corresponding delegates
-	AnimPlayer->OnPlaybackSequenceChanged.AddDynamic(this, &UPaperZDAnimInstance::OnAnimSequenceUpdated);
-	AnimPlayer->OnPlaybackSequenceComplete.AddDynamic(this, &UPaperZDAnimInstance::OnAnimSequencePlaybackComplete);
+void UPaperZDAnimInstance::ReleaseFromManager()
+{
+	check(!bRunningParallelUpdate);
+
+	//Gives back any resource held on the render component (i.e. instanced sprites)
+	PlayerState.RegisterRenderComponent(nullptr);
+
+	Manager = nullptr;
+}
+
+void UPaperZDAnimInstance::InitAnimGraph()
+{
+	PlayerState.RegisterRenderComponent(Manager->GetRenderComponent());
+
+	//Handing the player to the manager would defeat the lightweight player
+	if (AnimPlayer)
+	{
+		Manager->OnSetupAnimPlayer(AnimPlayer);
+	}
 
 	//Let the blueprint initialize any variables we might need for updates
 	//We do this first as some AnimNodes might require access to blueprint logic on their initialization methods
 	OnInit();
 
+	PAPERZD_TRACE_EVENT(Instance, this);
+
 	//Initialize every animation node
 	if (RootNode)
 	{
@@ -126,9 +363,13 @@ void UPaperZDAnimInstance::JumpToNode(FName JumpName, FName StateMachineName /*
 	UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
 	if (AnimClass)
 	{
+		//The jump needs to be played right away
+		WakeUp();
+
 		FPaperZDAnimationBaseContext Context(this);
-		for (FPaperZDAnimNode_StateMachine* StateMachineNode : AnimClass->GetStateMachineNodes(this))
+		for (int32 i = 0; i < AnimClass->GetNumStateMachineNodes(); i++)
 		{
+			FPaperZDAnimNode_StateMachine* StateMachineNode = AnimClass->GetStateMachineNode(this, i);
 			if (StateMachineName != NAME_None && StateMachineNode->GetMachineName() == StateMachineName)
 			{
 				StateMachineNode->JumpToNode(JumpName, Context);
@@ -149,24 +390,160 @@ void UPaperZDAnimInstance::ProcessAnimations(float DeltaTime)
 		{
 			SCOPE_CYCLE_COUNTER(STAT_UpdateAnimGraph);
 
-			//First do a pass and update any animation node
+			//First do a pass and update any animation node, tracking the playback if we can sleep afterwards
+			if (bAllowSleeping)
+			{
+				PlayerState.BeginTrackingPlaybackEvents();
+			}
+
+			GraphUpdateCount++;
 			FPaperZDAnimationUpdateContext UpdateContext(this, DeltaTime);
 			RootNode->Update(UpdateContext);
+
+			SleepDeltaScale = bAllowSleeping ? PlayerState.EndTrackingPlaybackEvents() : 0.0f;
 		}
 
+		//Then evaluate the sink node, obtaining the final animation data
+		if (!bSkipRenderUpdate)
 		{
 			SCOPE_CYCLE_COUNTER(STAT_RenderAnimations);
-
-			//Then evaluate the sink node, obtaining the final animation data
-			FPaperZDAnimationPlaybackData PlaybackData;
-			RootNode->Evaluate(PlaybackData);
+			EvaluatedPlaybackData.Reset();
+			RootNode->Evaluate(EvaluatedPlaybackData);
+			PAPERZD_RECORD(this, Playback, EvaluatedPlaybackData);
 
 			//Pass to the AnimPlayer
-			AnimPlayer->Play(PlaybackData);
+			PlayerState.Play(EvaluatedPlaybackData);
 		}
 	}
 }
 
+bool UPaperZDAnimInstance::CanUpdateInParallel() const
+{
+	const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
+	return RootNode && !bSequencerOverride && AnimClass && AnimClass->SupportsParallelUpdate();
+}
+
+void UPaperZDAnimInstance::PreParallelUpdate(float DeltaTime)
+{
+	check(IsInGameThread());
+	PAPERZD_TRACE_SCOPE(GetClass()->GetFName());
+	FPaperZDProfileTickScope ProfileScope(this, ProfileTickCycles, true, false);
+	ParallelUpdateDeltaTime = bIgnoreTimeDilation ? GetDeltaTimeIgnoredDilation(DeltaTime) : DeltaTime;
+
+#if PAPERZD_RECORDER_ENABLED
+	Recorder.BeginFrame(FPaperZDAnimInstanceHelpers::GetRecorderWorldTime(this));
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	BeginNodeCostCapture();
+#endif
+
+	PlayerState.BeginDeferredGameThreadWork();
+	if (bAllowSleeping)
+	{
+		PlayerState.BeginTrackingPlaybackEvents();
+	}
+	bRunningParallelUpdate = true;
+}
+
+void UPaperZDAnimInstance::ParallelUpdateAnimations()
+{
+	check(bRunningParallelUpdate);
+	PAPERZD_TRACE_SCOPE(GetClass()->GetFName());
+	FPaperZDProfileTickScope ProfileScope(this, ProfileTickCycles, false, false);
+	{
+		SCOPE_CYCLE_COUNTER(STAT_UpdateAnimGraph);
+		GraphUpdateCount++;
+		FPaperZDAnimationUpdateContext UpdateContext(this, ParallelUpdateDeltaTime);
+		RootNode->Update(UpdateContext);
+	}
+
+	//Evaluation doesn't touch any object, so we can do it here and leave only the render update for the game thread
+	if (!bSkipRenderUpdate)
+	{
+		EvaluatedPlaybackData.Reset();
+		RootNode->Evaluate(EvaluatedPlaybackData);
+		PAPERZD_RECORD(this, Playback, EvaluatedPlaybackData);
+	}
+}
+
+void UPaperZDAnimInstance::PostParallelUpdate()
+{
+	check(IsInGameThread());
+	PAPERZD_TRACE_SCOPE(GetClass()->GetFName());
+	FPaperZDProfileTickScope ProfileScope(this, ProfileTickCycles, false, true);
+	bRunningParallelUpdate = false;
+
+	//State machine events are called first, as they would have been triggered before ticking the new state's playback
+	for (const FName& EventName : DeferredEvents)
+	{
+		CallDeferredEvent(EventName);
+	}
+	DeferredEvents.Reset();
+
+	//Notifies and playback events
+	PlayerState.FlushDeferredGameThreadWork();
+	SleepDeltaScale = bAllowSleeping ? PlayerState.EndTrackingPlaybackEvents() : 0.0f;
+
+	if (!bSkipRenderUpdate)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RenderAnimations);
+		PlayerState.Play(EvaluatedPlaybackData);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AnimBPTick);
+		FPaperZDProfiler::CountBlueprintEvent(this, GET_FUNCTION_NAME_CHECKED(UPaperZDAnimInstance, OnTick));
+		OnTick(ParallelUpdateDeltaTime);
+	}
+
+#if PAPERZD_NODE_COST_ENABLED
+	EndNodeCostCapture();
+#endif
+}
+
+void UPaperZDAnimInstance::QueueDeferredEvent(FName EventName)
+{
+	DeferredEvents.Add(EventName);
+}
+
+void UPaperZDAnimInstance::CallDeferredEvent(FName EventName)
+{
+	UFunction* FoundFunction = FindEventFunction(EventName);
+	if (FoundFunction)
+	{
+		//Create a buffer just in case (if we send a null buffer, the system will crash if the event has parameters)
+		uint8* Buffer = (uint8*)FMemory_Alloca(FoundFunction->ParmsSize);
+		FMemory::Memzero(Buffer, FoundFunction->ParmsSize);
+		FPaperZDProfiler::CountBlueprintCall(this);
+		ProcessEvent(FoundFunction, Buffer);
+	}
+}
+
+#if PAPERZD_NODE_COST_ENABLED
+void UPaperZDAnimInstance::BeginNodeCostCapture()
+{
+	//Native instances have no graph to measure
+	const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(GetClass());
+	bCapturingNodeCosts = AnimClass && FPaperZDNodeCostCapture::ShouldCapture(this);
+	if (bCapturingNodeCosts)
+	{
+		//Only allocates on the first capture
+		NodeCosts.Init(AnimClass);
+		NodeCosts.ActiveStates.Reset();
+	}
+}
+
+void UPaperZDAnimInstance::EndNodeCostCapture()
+{
+	if (bCapturingNodeCosts)
+	{
+		FPaperZDNodeCostCapture::MergeIntoClass(NodeCosts, CastChecked<UPaperZDAnimBPGeneratedClass>(GetClass()));
+		bCapturingNodeCosts = false;
+	}
+}
+#endif
+
 float UPaperZDAnimInstance::GetDeltaTimeIgnoredDilation(float DeltaTime)
 {
 	const float timeDilation = UGameplayStatics::GetGlobalTimeDilation(this);
@@ -176,6 +553,7 @@ float UPaperZDAnimInstance::GetDeltaTimeIgnoredDilation(float DeltaTime)
 void UPaperZDAnimInstance::PrepareForMovieSequence()
 {
 	bSequencerOverride = true;
+	WakeUp();
 }
 
 void UPaperZDAnimInstance::RestorePreMovieSequenceState()
@@ -0,0 +1,157 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAnimInstancePool.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimTickSubsystem.h"
+#include "PaperZDStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+//Stats declarations
+DECLARE_CYCLE_STAT(TEXT("Spawn Instance (New)"), STAT_AnimInstanceSpawnNew, STATGROUP_PaperZD);
+DECLARE_CYCLE_STAT(TEXT("Spawn Instance (Pooled)"), STAT_AnimInstanceSpawnPooled, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instance Pool Hits"), STAT_AnimInstancePoolHits, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instance Pool Misses"), STAT_AnimInstancePoolMisses, STATGROUP_PaperZD);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Free Instances"), STAT_AnimInstancePoolFree, STATGROUP_PaperZD);
+
+//Console variables
+static TAutoConsoleVariable<int32> CVarAnimInstancePool(
+	TEXT("paperzd.AnimInstancePool"),
+	1,
+	TEXT("If non zero, animation components that use the instance pool will reuse the AnimInstances released by other components of the same AnimBP."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimInstancePoolSize(
+	TEXT("paperzd.AnimInstancePoolSize"),
+	32,
+	TEXT("Maximum amount of released AnimInstances kept per AnimBP class, any instance released past this amount is left for the garbage collector."),
+	ECVF_Default);
+
+void UPaperZDAnimInstancePool::Deinitialize()
+{
+	for (const FPaperZDAnimInstancePoolBucket& Bucket : Buckets)
+	{
+		DEC_DWORD_STAT_BY(STAT_AnimInstancePoolFree, Bucket.FreeInstances.Num());
+	}
+
+	Buckets.Empty();
+	PendingReleases.Empty();
+	Super::Deinitialize();
+}
+
+bool UPaperZDAnimInstancePool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	//Only worlds that run gameplay will have components spawning and despawning
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UPaperZDAnimInstancePool::IsPoolingEnabled()
+{
+	return CVarAnimInstancePool.GetValueOnGameThread() != 0;
+}
+
+UPaperZDAnimInstance* UPaperZDAnimInstancePool::NewInstance(TSubclassOf<UPaperZDAnimInstance> AnimClass, UObject* Outer, TScriptInterface<IPaperZDAnimInstanceManager> InManager)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimInstanceSpawnNew);
+	UPaperZDAnimInstance* AnimInstance = NewObject<UPaperZDAnimInstance>(Outer, AnimClass);
+	AnimInstance->Init(InManager);
+	return AnimInstance;
+}
+
+UPaperZDAnimInstance* UPaperZDAnimInstancePool::AcquireInstance(TSubclassOf<UPaperZDAnimInstance> AnimClass, TScriptInterface<IPaperZDAnimInstanceManager> InManager)
+{
+	if (!AnimClass)
+	{
+		return nullptr;
+	}
+
+	FPaperZDAnimInstancePoolBucket* Bucket = FindBucket(AnimClass);
+	if (Bucket && Bucket->FreeInstances.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AnimInstanceSpawnPooled);
+		INC_DWORD_STAT(STAT_AnimInstancePoolHits);
+		DEC_DWORD_STAT(STAT_AnimInstancePoolFree);
+
+		UPaperZDAnimInstance* AnimInstance = Bucket->FreeInstances.Pop(false);
+		AnimInstance->Reinit(InManager);
+		return AnimInstance;
+	}
+
+	//Instances are owned by the pool, so they can outlive the component that acquired them
+	INC_DWORD_STAT(STAT_AnimInstancePoolMisses);
+	return NewInstance(AnimClass, this, InManager);
+}
+
+void UPaperZDAnimInstancePool::ReleaseInstance(UPaperZDAnimInstance* AnimInstance)
+{
+	if (!AnimInstance)
+	{
+		return;
+	}
+
+	//Only the instances we created can be kept, any other would still be owned by its component
+	AnimInstance->ReleaseFromManager();
+	const int32 MaxFreeInstances = CVarAnimInstancePoolSize.GetValueOnGameThread();
+	if (AnimInstance->GetOuter() != this || MaxFreeInstances <= 0)
+	{
+		return;
+	}
+
+	//Updates gathered by the running batch could still use the instance, so it can't be handed over to a component spawned during the batch
+	const UWorld* World = GetWorld();
+	const UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr;
+	if (TickSubsystem && TickSubsystem->IsTickingBatch())
+	{
+		PendingReleases.AddUnique(AnimInstance);
+		return;
+	}
+
+	AddFreeInstance(AnimInstance, MaxFreeInstances);
+}
+
+void UPaperZDAnimInstancePool::FlushPendingReleases()
+{
+	const int32 MaxFreeInstances = CVarAnimInstancePoolSize.GetValueOnGameThread();
+	for (UPaperZDAnimInstance* AnimInstance : PendingReleases)
+	{
+		if (AnimInstance)
+		{
+			AddFreeInstance(AnimInstance, MaxFreeInstances);
+		}
+	}
+
+	PendingReleases.Reset();
+}
+
+void UPaperZDAnimInstancePool::AddFreeInstance(UPaperZDAnimInstance* AnimInstance, int32 MaxFreeInstances)
+{
+	FPaperZDAnimInstancePoolBucket* Bucket = FindBucket(AnimInstance->GetClass());
+	if (!Bucket)
+	{
+		Bucket = &Buckets.AddDefaulted_GetRef();
+		Bucket->AnimClass = AnimInstance->GetClass();
+	}
+
+	if (Bucket->FreeInstances.Num() < MaxFreeInstances)
+	{
+		checkSlow(!Bucket->FreeInstances.Contains(AnimInstance));
+		Bucket->FreeInstances.Add(AnimInstance);
+		INC_DWORD_STAT(STAT_AnimInstancePoolFree);
+	}
+}
+
+int32 UPaperZDAnimInstancePool::GetNumFreeInstances(TSubclassOf<UPaperZDAnimInstance> AnimClass) const
+{
+	const FPaperZDAnimInstancePoolBucket* Bucket = FindBucket(AnimClass);
+	return Bucket ? Bucket->FreeInstances.Num() : 0;
+}
+
+FPaperZDAnimInstancePoolBucket* UPaperZDAnimInstancePool::FindBucket(const UClass* AnimClass)
+{
+	return Buckets.FindByPredicate([AnimClass](const FPaperZDAnimInstancePoolBucket& Bucket) { return Bucket.AnimClass == AnimClass; });
+}
+
+const FPaperZDAnimInstancePoolBucket* UPaperZDAnimInstancePool::FindBucket(const UClass* AnimClass) const
+{
+	return Buckets.FindByPredicate([AnimClass](const FPaperZDAnimInstancePoolBucket& Bucket) { return Bucket.AnimClass == AnimClass; });
+}
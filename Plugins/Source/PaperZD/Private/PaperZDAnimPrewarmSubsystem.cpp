@@ -0,0 +1,201 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAnimPrewarmSubsystem.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDStats.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectHash.h"
+
+//Stats declarations
+DECLARE_CYCLE_STAT(TEXT("Prewarm Gather Classes"), STAT_PrewarmGatherClasses, STATGROUP_PaperZD);
+
+//Console variables
+static TAutoConsoleVariable<int32> CVarPrewarmOnLevelLoad(
+	TEXT("paperzd.PrewarmOnLevelLoad"),
+	1,
+	TEXT("If non zero, the AnimBP classes referenced by a level are prewarmed when the level is added to a game world, so their first spawn doesn't hitch."),
+	ECVF_Default);
+
+namespace FPaperZDAnimPrewarmHelpers
+{
+	/* Adds the object to the walk, if it wasn't visited yet. */
+	void Enqueue(UObject* Object, TSet<UObject*>& Visited, TArray<UObject*>& Pending)
+	{
+		if (Object && !Visited.Contains(Object))
+		{
+			Visited.Add(Object);
+			Pending.Add(Object);
+		}
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UPaperZDAnimPrewarmSubsystem::OnLevelAdded);
+}
+
+void UPaperZDAnimPrewarmSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	LevelAddedHandle.Reset();
+	Super::Deinitialize();
+}
+
+bool UPaperZDAnimPrewarmSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	//Only worlds that run gameplay will spawn new actors
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UPaperZDAnimPrewarmSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//The persistent level, and any streamed level that was already visible
+	if (CVarPrewarmOnLevelLoad.GetValueOnGameThread() != 0)
+	{
+		for (ULevel* Level : InWorld.GetLevels())
+		{
+			PrewarmLevel(Level);
+		}
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	//Levels added before the world begins play are handled all at once
+	if (World == GetWorld() && World->HasBegunPlay() && CVarPrewarmOnLevelLoad.GetValueOnGameThread() != 0)
+	{
+		PrewarmLevel(Level);
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::PrewarmLevel(ULevel* Level)
+{
+	if (Level)
+	{
+		//The actor list isn't a property, so the actors are the roots of the walk
+		TArray<UObject*> Roots;
+		Roots.Reserve(Level->Actors.Num());
+		for (AActor* Actor : Level->Actors)
+		{
+			Roots.Add(Actor);
+		}
+
+		PrewarmReferencedClasses(Roots, Level->GetPackage()->GetName());
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::PrewarmAsset(UObject* Asset)
+{
+	if (Asset)
+	{
+		PrewarmReferencedClasses({ Asset }, Asset->GetName());
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::PrewarmAnimClass(TSubclassOf<UPaperZDAnimInstance> AnimClass)
+{
+	if (UPaperZDAnimBPGeneratedClass* GeneratedClass = Cast<UPaperZDAnimBPGeneratedClass>(AnimClass.Get()))
+	{
+		PrewarmClasses({ GeneratedClass }, GeneratedClass->GetName());
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::PrewarmReferencedClasses(const TArray<UObject*>& Roots, const FString& SourceName)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<UPaperZDAnimBPGeneratedClass*> AnimClasses;
+	GatherAnimClasses(Roots, AnimClasses);
+	const double GatherTime = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	const int32 NumPrewarmed = PrewarmClasses(AnimClasses, SourceName);
+	if (NumPrewarmed > 0)
+	{
+		const double TotalTime = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		UE_LOG(LogTemp, Display, TEXT("PaperZD: Prewarmed %d AnimBP classes referenced by '%s' in %.2f ms (%.2f ms finding them)."), NumPrewarmed, *SourceName, TotalTime, GatherTime);
+	}
+}
+
+void UPaperZDAnimPrewarmSubsystem::GatherAnimClasses(const TArray<UObject*>& Roots, TArray<UPaperZDAnimBPGeneratedClass*>& OutClasses)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PrewarmGatherClasses);
+	TSet<UObject*> Visited;
+	TArray<UObject*> Pending;
+	for (UObject* Root : Roots)
+	{
+		FPaperZDAnimPrewarmHelpers::Enqueue(Root, Visited, Pending);
+	}
+
+	while (Pending.Num() > 0)
+	{
+		UObject* Object = Pending.Pop(false);
+		if (UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(Object))
+		{
+			//The class prewarms what it references by itself
+			OutClasses.Add(AnimClass);
+		}
+		else if (UBlueprintGeneratedClass* BlueprintClass = Cast<UBlueprintGeneratedClass>(Object))
+		{
+			//Blueprint classes keep their component templates outered to the class, next to the functions
+			FPaperZDAnimPrewarmHelpers::Enqueue(BlueprintClass->GetDefaultObject(), Visited, Pending);
+			FPaperZDAnimPrewarmHelpers::Enqueue(BlueprintClass->GetSuperClass(), Visited, Pending);
+			ForEachObjectWithOuter(BlueprintClass, [&Visited, &Pending](UObject* Inner)
+			{
+				if (!Inner->IsA<UField>())
+				{
+					FPaperZDAnimPrewarmHelpers::Enqueue(Inner, Visited, Pending);
+				}
+			}, false);
+		}
+		else if (UPaperZDAnimInstance* AnimInstance = Cast<UPaperZDAnimInstance>(Object))
+		{
+			//Running instances only matter for their class
+			FPaperZDAnimPrewarmHelpers::Enqueue(AnimInstance->GetClass(), Visited, Pending);
+		}
+		else if (!Object->IsA<UClass>())
+		{
+			//Native default subobjects aren't always referenced by a property
+			if (AActor* Actor = Cast<AActor>(Object))
+			{
+				Actor->ForEachComponent(false, [&Visited, &Pending](UActorComponent* Component)
+				{
+					FPaperZDAnimPrewarmHelpers::Enqueue(Component, Visited, Pending);
+				});
+			}
+
+			//Follow into classes, and into the objects that live along with this one, other assets are left alone
+			const UObject* Outermost = Object->GetOutermostObject();
+			for (TPropertyValueIterator<FObjectPropertyBase> It(Object->GetClass(), Object); It; ++It)
+			{
+				UObject* Referenced = It.Key()->GetObjectPropertyValue(It.Value());
+				if (Referenced && (Referenced->IsA<UClass>() || Referenced->GetOutermostObject() == Outermost))
+				{
+					FPaperZDAnimPrewarmHelpers::Enqueue(Referenced, Visited, Pending);
+				}
+			}
+		}
+	}
+}
+
+int32 UPaperZDAnimPrewarmSubsystem::PrewarmClasses(const TArray<UPaperZDAnimBPGeneratedClass*>& AnimClasses, const FString& SourceName)
+{
+	int32 NumPrewarmed = 0;
+	for (UPaperZDAnimBPGeneratedClass* AnimClass : AnimClasses)
+	{
+		if (!AnimClass->IsPrewarmed())
+		{
+			const double PrewarmTime = AnimClass->Prewarm();
+			UE_LOG(LogTemp, Display, TEXT("PaperZD: Prewarmed AnimBP '%s' (referenced by '%s') in %.3f ms."), *AnimClass->GetName(), *SourceName, PrewarmTime);
+			NumPrewarmed++;
+		}
+	}
+
+	return NumPrewarmed;
+}
@@ -0,0 +1,189 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAnimRecorder.h"
+
+#if PAPERZD_RECORDER_ENABLED
+
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarRecorder(
+	TEXT("paperzd.Recorder"),
+	1,
+	TEXT("If non zero, every AnimInstance records its last updates so they can be inspected and scrubbed from the AnimBP editor. Each instance allocates its buffer on the first recorded frame. Not available on shipping builds."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRecorderCapacity(
+	TEXT("paperzd.Recorder.Capacity"),
+	256,
+	TEXT("Amount of records kept per AnimInstance, rounded up to a power of two. Each record takes 16 bytes, a simple AnimBP uses around 3 records per update. The default keeps around 85 updates in 4KB per instance, raise it to scrub further back."),
+	ECVF_Default);
+
+FPaperZDAnimRecorder::FPaperZDAnimRecorder()
+	: NumRecordsWritten(0)
+	, NumFrames(0)
+	, bRecording(false)
+{}
+
+bool FPaperZDAnimRecorder::IsEnabled()
+{
+	return CVarRecorder.GetValueOnAnyThread() != 0;
+}
+
+void FPaperZDAnimRecorder::BeginFrame(float WorldTime)
+{
+	bRecording = IsEnabled();
+	if (!bRecording)
+	{
+		return;
+	}
+
+	//Capacity changes discard the history, which only happens when tweaking the console variable
+	const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Clamp(CVarRecorderCapacity.GetValueOnAnyThread(), 64, 65536));
+	if (Records.Num() != Capacity)
+	{
+		Records.SetNumZeroed(Capacity);
+		NumRecordsWritten = 0;
+		NumFrames = 0;
+	}
+
+	Write(EPaperZDAnimRecordType::Frame, 0, INDEX_NONE, INDEX_NONE, INDEX_NONE, WorldTime);
+	NumFrames++;
+}
+
+void FPaperZDAnimRecorder::RecordPlayback(const FPaperZDAnimationPlaybackData& PlaybackData)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	const int32 Direction = FMath::RoundToInt(FRotator::ClampAxis(PlaybackData.DirectionalAngle) * 10.0f);
+	for (const FPaperZDWeightedAnimation& Animation : PlaybackData.WeightedAnimations)
+	{
+		const int32 Weight = FMath::RoundToInt(FMath::Clamp(Animation.Weight, 0.0f, 1.0f) * 10000.0f);
+		Write(EPaperZDAnimRecordType::Playback, GetObjectIndex(Animation.AnimSequencePtr.Get()), Direction, Weight, Animation.Layer, Animation.PlaybackTime);
+	}
+}
+
+void FPaperZDAnimRecorder::RecordNotify(const UObject* Notify, float Time)
+{
+	if (bRecording)
+	{
+		Write(EPaperZDAnimRecordType::Notify, GetObjectIndex(Notify), INDEX_NONE, INDEX_NONE, INDEX_NONE, Time);
+	}
+}
+
+void FPaperZDAnimRecorder::Reset()
+{
+	NumRecordsWritten = 0;
+	NumFrames = 0;
+	Objects.Reset();
+	ObjectIndices.Reset();
+}
+
+bool FPaperZDAnimRecorder::GetFrameRange(uint32& OutOldestFrame, uint32& OutNewestFrame) const
+{
+	//The oldest frame record could have been overwritten, only count the frames that still have it
+	uint32 NumAvailableFrames = 0;
+	for (uint64 RecordIndex = GetFirstAvailableRecord(); RecordIndex < NumRecordsWritten; RecordIndex++)
+	{
+		if (Records[GetBufferIndex(RecordIndex)].Type == EPaperZDAnimRecordType::Frame)
+		{
+			NumAvailableFrames++;
+		}
+	}
+
+	OutOldestFrame = NumFrames - NumAvailableFrames;
+	OutNewestFrame = NumFrames - 1;
+	return NumAvailableFrames > 0;
+}
+
+bool FPaperZDAnimRecorder::GetFrame(uint32 FrameNumber, FFrame& OutFrame) const
+{
+	OutFrame.FrameNumber = FrameNumber;
+	OutFrame.Records.Reset();
+
+	bool bFound = false;
+	ForEachRecord([&](uint32 RecordFrameNumber, float WorldTime, const FPaperZDAnimRecord& Record)
+	{
+		if (RecordFrameNumber == FrameNumber)
+		{
+			bFound = true;
+			OutFrame.WorldTime = WorldTime;
+			if (Record.Type != EPaperZDAnimRecordType::Frame)
+			{
+				OutFrame.Records.Add(Record);
+			}
+		}
+	});
+
+	return bFound;
+}
+
+void FPaperZDAnimRecorder::ForEachRecord(TFunctionRef<void(uint32 FrameNumber, float WorldTime, const FPaperZDAnimRecord& Record)> Visitor) const
+{
+	uint32 OldestFrame, NewestFrame;
+	if (!GetFrameRange(OldestFrame, NewestFrame))
+	{
+		return;
+	}
+
+	//Records before the first available frame belong to a frame that was partially overwritten
+	uint32 FrameNumber = OldestFrame - 1;
+	float WorldTime = 0.0f;
+	bool bInsideFrame = false;
+	for (uint64 RecordIndex = GetFirstAvailableRecord(); RecordIndex < NumRecordsWritten; RecordIndex++)
+	{
+		const FPaperZDAnimRecord& Record = Records[GetBufferIndex(RecordIndex)];
+		if (Record.Type == EPaperZDAnimRecordType::Frame)
+		{
+			FrameNumber++;
+			WorldTime = Record.Value;
+			bInsideFrame = true;
+		}
+
+		if (bInsideFrame)
+		{
+			Visitor(FrameNumber, WorldTime, Record);
+		}
+	}
+}
+
+const UObject* FPaperZDAnimRecorder::GetRecordedObject(uint16 ObjectIndex) const
+{
+	return Objects.IsValidIndex(ObjectIndex) ? Objects[ObjectIndex].Get() : nullptr;
+}
+
+uint16 FPaperZDAnimRecorder::GetObjectIndex(const UObject* Object)
+{
+	if (!Object)
+	{
+		return InvalidObjectIndex;
+	}
+
+	if (const uint16* ObjectIndex = ObjectIndices.Find(Object))
+	{
+		//A new object could have been allocated where a collected one was
+		Objects[*ObjectIndex] = Object;
+		return *ObjectIndex;
+	}
+
+	//The same sequences and notifies get used over and over, so the table stays small
+	if (Objects.Num() >= InvalidObjectIndex)
+	{
+		return InvalidObjectIndex;
+	}
+
+	const uint16 NewIndex = static_cast<uint16>(Objects.Add(Object));
+	ObjectIndices.Add(Object, NewIndex);
+	return NewIndex;
+}
+
+uint64 FPaperZDAnimRecorder::GetFirstAvailableRecord() const
+{
+	const uint64 Capacity = Records.Num();
+	return NumRecordsWritten > Capacity ? NumRecordsWritten - Capacity : 0;
+}
+
+#endif
@@ -0,0 +1,839 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDAnimTickSubsystem.h"
+#include "PaperZDAnimationComponent.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimInstancePool.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
+#include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "PaperZDStats.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "Misc/App.h"
+
+//Stats declarations
+DECLARE_CYCLE_STAT(TEXT("Batched Tick"), STAT_BatchedAnimTick, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Instances"), STAT_BatchedAnimInstances, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Classes"), STAT_BatchedAnimClasses, STATGROUP_PaperZD);
+DECLARE_CYCLE_STAT(TEXT("Parallel Update"), STAT_ParallelAnimUpdate, STATGROUP_PaperZD);
+DECLARE_CYCLE_STAT(TEXT("Parallel Update Fixup"), STAT_ParallelAnimFixup, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Parallel Instances"), STAT_ParallelAnimInstances, STATGROUP_PaperZD);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Update Budget (ms)"), STAT_AnimUpdateBudget, STATGROUP_PaperZD);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Update Budget Used (ms)"), STAT_AnimUpdateBudgetUsed, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Deferred Instances"), STAT_AnimUpdateBudgetDeferred, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sleeping Instances"), STAT_SleepingAnimInstances, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instances Put To Sleep"), STAT_AnimInstancesPutToSleep, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sharing Masters"), STAT_AnimSharingMasters, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sharing Followers"), STAT_AnimSharingFollowers, STATGROUP_PaperZD);
+DECLARE_CYCLE_STAT(TEXT("Sharing Follower Update"), STAT_AnimSharingFollowerUpdate, STATGROUP_PaperZD);
+
+//Console variables
+static TAutoConsoleVariable<int32> CVarForceBatchedTick(
+	TEXT("paperzd.BatchedTick"),
+	0,
+	TEXT("If non zero, every PaperZD animation component that begins play will be ticked by the world batched tick, regardless of its own setting."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarParallelUpdate(
+	TEXT("paperzd.ParallelUpdate"),
+	1,
+	TEXT("If non zero, batched AnimInstances whose AnimGraph is thread-safe will be updated in parallel on worker threads, with any blueprint work deferred to the game thread."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarUpdateBudget(
+	TEXT("paperzd.UpdateBudgetMs"),
+	0.0f,
+	TEXT("Time in milliseconds that the batched tick can spend updating PaperZD AnimInstances each frame. Normal priority instances that don't fit are deferred to the next frames in round robin order. Zero disables the budget."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarUpdateBudgetMaxDeferredFrames(
+	TEXT("paperzd.UpdateBudgetMaxDeferredFrames"),
+	10,
+	TEXT("Maximum number of consecutive frames an instance can be deferred by the update budget before being updated regardless. Zero means no limit."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAllowSleeping(
+	TEXT("paperzd.AllowSleeping"),
+	1,
+	TEXT("If non zero, batched AnimInstances that allow sleeping stop updating until their next keyframe change, notify, loop or completion."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimSharing(
+	TEXT("paperzd.AnimSharing"),
+	1,
+	TEXT("If non zero, batched components that enable animation sharing will share the update of their AnimInstance with the other instances on the same state machine states."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdUpdateBudgetStatus(
+	TEXT("paperzd.UpdateBudgetStatus"),
+	TEXT("Prints the update budget, the time used and the number of deferred instances on the last batched tick of the current world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr;
+		if (TickSubsystem)
+		{
+			UE_LOG(LogTemp, Display, TEXT("PaperZD update budget: %.3f ms, used: %.3f ms, deferred instances: %d"), TickSubsystem->GetLastUpdateBudget(), TickSubsystem->GetLastUpdateBudgetUsed(), TickSubsystem->GetLastDeferredInstances());
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+//// Batched tick function
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDBatchedAnimTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && IsValid(Target))
+	{
+		Target->TickBatch(DeltaTime);
+	}
+}
+
+FString FPaperZDBatchedAnimTickFunction::DiagnosticMessage()
+{
+	return TEXT("FPaperZDBatchedAnimTickFunction");
+}
+
+FName FPaperZDBatchedAnimTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("PaperZDBatchedAnimTick"));
+}
+
+//////////////////////////////////////////////////////////////////////////
+//// Sleep wheel
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDAnimSleepWheel::Schedule(UPaperZDAnimationComponent* Component, uint32 SleepSerial, double WakeTime)
+{
+	//Entries can't go into a slot that was already passed, they would wait a full turn
+	int64 SlotIndex = GetSlotIndex(WakeTime);
+	if (CurrentSlot == INDEX_NONE)
+	{
+		CurrentSlot = SlotIndex;
+	}
+	SlotIndex = FMath::Max(SlotIndex, CurrentSlot);
+
+	Slots[SlotIndex % NumSlots].Add({ Component, WakeTime, SleepSerial });
+	NumEntries++;
+}
+
+void FPaperZDAnimSleepWheel::Advance(double Time, TArray<FEntry>& OutExpiredEntries)
+{
+	if (CurrentSlot == INDEX_NONE || NumEntries == 0)
+	{
+		CurrentSlot = GetSlotIndex(Time);
+		return;
+	}
+
+	//Visit every slot up to the one that contains the given time, at most a full turn
+	const int64 TargetSlot = GetSlotIndex(Time);
+	const int64 LastSlot = FMath::Min(TargetSlot, CurrentSlot + NumSlots - 1);
+	for (int64 SlotIndex = CurrentSlot; SlotIndex <= LastSlot; SlotIndex++)
+	{
+		TArray<FEntry>& Slot = Slots[SlotIndex % NumSlots];
+		for (int32 i = Slot.Num() - 1; i >= 0; i--)
+		{
+			if (Slot[i].WakeTime <= Time)
+			{
+				OutExpiredEntries.Add(Slot[i]);
+				Slot.RemoveAtSwap(i, 1, false);
+				NumEntries--;
+			}
+		}
+	}
+
+	CurrentSlot = FMath::Max(TargetSlot, CurrentSlot);
+}
+
+void FPaperZDAnimSleepWheel::Reset()
+{
+	for (TArray<FEntry>& Slot : Slots)
+	{
+		Slot.Empty();
+	}
+
+	CurrentSlot = INDEX_NONE;
+	NumEntries = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//// Tick subsystem
+//////////////////////////////////////////////////////////////////////////
+UPaperZDAnimTickSubsystem::UPaperZDAnimTickSubsystem()
+	: Super()
+	, AverageParallelUpdateCost(0.05f)
+	, LastUpdateBudget(0.0f)
+	, LastUpdateBudgetUsed(0.0f)
+	, LastDeferredInstances(0)
+	, ViewLocationsFrame(0)
+	, BatchIndex(0)
+	, bTickingBatch(false)
+	, bPendingCompaction(false)
+{
+	//Same setup as the component tick it replaces
+	BatchedTickFunction.bCanEverTick = true;
+	BatchedTickFunction.bStartWithTickEnabled = true;
+	BatchedTickFunction.bTickEvenWhenPaused = false;
+	BatchedTickFunction.TickGroup = TG_DuringPhysics;
+}
+
+void UPaperZDAnimTickSubsystem::Deinitialize()
+{
+	if (BatchedTickFunction.IsTickFunctionRegistered())
+	{
+		BatchedTickFunction.UnRegisterTickFunction();
+	}
+
+	BatchedTickFunction.Target = nullptr;
+	Buckets.Empty();
+	PendingComponents.Empty();
+	SleepWheel.Reset();
+	SharingGroups.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UPaperZDAnimTickSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	//Only worlds that run gameplay will have components doing BeginPlay
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UPaperZDAnimTickSubsystem::IsBatchedTickForced()
+{
+	return CVarForceBatchedTick.GetValueOnGameThread() != 0;
+}
+
+float UPaperZDAnimTickSubsystem::GetUpdateBudget()
+{
+	return FMath::Max(CVarUpdateBudget.GetValueOnGameThread(), 0.0f);
+}
+
+bool UPaperZDAnimTickSubsystem::IsAnimSharingEnabled()
+{
+	return CVarAnimSharing.GetValueOnGameThread() != 0;
+}
+
+bool UPaperZDAnimTickSubsystem::IsSleepingEnabled()
+{
+	return CVarAllowSleeping.GetValueOnGameThread() != 0;
+}
+
+void UPaperZDAnimTickSubsystem::WakeComponent(UPaperZDAnimationComponent* InComponent)
+{
+	//The entry on the wheel becomes stale, the slept time gets applied on the next update of the component
+	if (InComponent->bAnimSleeping)
+	{
+		InComponent->bAnimSleeping = false;
+		InComponent->SleepSerial++;
+	}
+}
+
+void UPaperZDAnimTickSubsystem::RegisterComponent(UPaperZDAnimationComponent* InComponent)
+{
+	check(InComponent);
+	EnsureTickFunctionRegistered();
+
+	if (bTickingBatch)
+	{
+		PendingComponents.AddUnique(InComponent);
+	}
+	else
+	{
+		AddToBucket(InComponent);
+	}
+}
+
+void UPaperZDAnimTickSubsystem::UnregisterComponent(UPaperZDAnimationComponent* InComponent)
+{
+	PendingComponents.Remove(InComponent);
+
+	//Updates waiting for the budget shouldn't run for a component that is gone, nor should it sleep after its parallel update
+	for (FPaperZDBatchedAnimUpdate& BudgetedUpdate : BudgetedUpdates)
+	{
+		if (BudgetedUpdate.Component == InComponent)
+		{
+			BudgetedUpdate.Component = nullptr;
+		}
+	}
+
+	for (FPaperZDBatchedAnimUpdate& ParallelUpdate : ParallelUpdates)
+	{
+		if (ParallelUpdate.Component == InComponent)
+		{
+			ParallelUpdate.Component = nullptr;
+		}
+	}
+
+	//Same for sharing groups, followers of this component will skip this batch
+	for (FPaperZDAnimSharingMember& SharingMember : SharingCandidates)
+	{
+		if (SharingMember.Component == InComponent)
+		{
+			SharingMember.Component = nullptr;
+		}
+	}
+
+	for (FPaperZDAnimSharingMember& SharingMember : SharingFollowers)
+	{
+		if (SharingMember.Component == InComponent)
+		{
+			SharingMember.Component = nullptr;
+		}
+
+		if (SharingMember.Master == InComponent)
+		{
+			SharingMember.Master = nullptr;
+		}
+	}
+	InComponent->bFollowingSharedAnimation = false;
+
+	//Components outside of the batch tick on their own, which doesn't support sleeping. The time slept so far is kept for their next update,
+	//up to the previous frame as the tick of this frame brings its own delta time
+	WakeComponent(InComponent);
+	if (InComponent->SleepStartTime >= 0.0)
+	{
+		const UWorld* World = GetWorld();
+		const AActor* Owner = InComponent->GetOwner();
+		const float OwnerDilation = Owner ? Owner->CustomTimeDilation : 1.0f;
+		const double SleptTime = World ? World->GetTimeSeconds() - World->GetDeltaSeconds() - InComponent->SleepStartTime : 0.0;
+		InComponent->DeferredDeltaTime += FMath::Max(static_cast<float>(SleptTime), 0.0f) * OwnerDilation;
+		InComponent->SleepStartTime = -1.0;
+	}
+
+	for (int32 BucketIndex = 0; BucketIndex < Buckets.Num(); BucketIndex++)
+	{
+		FPaperZDAnimTickBucket& Bucket = Buckets[BucketIndex];
+		const int32 ComponentIndex = Bucket.Components.Find(InComponent);
+		if (ComponentIndex != INDEX_NONE)
+		{
+			if (bTickingBatch)
+			{
+				//Cannot shrink the array while iterating it, clear the slot and compact after the batch
+				Bucket.Components[ComponentIndex] = nullptr;
+				bPendingCompaction = true;
+			}
+			else
+			{
+				Bucket.Components.RemoveAtSwap(ComponentIndex);
+				if (Bucket.Components.Num() == 0)
+				{
+					Buckets.RemoveAtSwap(BucketIndex);
+				}
+			}
+
+			return;
+		}
+	}
+}
+
+void UPaperZDAnimTickSubsystem::TickBatch(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BatchedAnimTick);
+	INC_DWORD_STAT_BY(STAT_BatchedAnimClasses, Buckets.Num());
+
+	const double StartTime = FPlatformTime::Seconds();
+	const float UpdateBudget = GetUpdateBudget();
+	const bool bUseUpdateBudget = UpdateBudget > 0.0f;
+	int32 NumUpdatedInstances = 0;
+
+	//Wake up the sleeping components whose next playback event has been reached
+	const UWorld* World = GetWorld();
+	const double WorldTime = World ? World->GetTimeSeconds() : 0.0;
+	if (!SleepWheel.IsEmpty())
+	{
+		SleepWheel.Advance(WorldTime, ExpiredSleepEntries);
+		for (const FPaperZDAnimSleepWheel::FEntry& Entry : ExpiredSleepEntries)
+		{
+			UPaperZDAnimationComponent* Component = Entry.Component.Get();
+			if (Component && Component->SleepSerial == Entry.SleepSerial)
+			{
+				WakeComponent(Component);
+			}
+		}
+		ExpiredSleepEntries.Reset();
+	}
+
+	bTickingBatch = true;
+	BatchIndex++;
+	const bool bAllowParallelUpdate = CVarParallelUpdate.GetValueOnGameThread() != 0 && FApp::ShouldUseThreadingForPerformance();
+	for (FPaperZDAnimTickBucket& Bucket : Buckets)
+	{
+		//Index based, as the tick can null out entries on this bucket
+		for (int32 i = 0; i < Bucket.Components.Num(); i++)
+		{
+			UPaperZDAnimationComponent* Component = Bucket.Components[i];
+			if (Component && Component->bAnimSleeping)
+			{
+				INC_DWORD_STAT(STAT_SleepingAnimInstances);
+			}
+			else if (Component && Component->IsActive())
+			{
+				UPaperZDAnimInstance* AnimInstance = Component->GetAnimInstance();
+				if (AnimInstance)
+				{
+					//Sharing components wait until every member of their group is known, so a single master can be picked
+					if (Component->bEnableAnimSharing && GatherSharingMember(Component, AnimInstance))
+					{
+						continue;
+					}
+
+					Component->bFollowingSharedAnimation = false;
+					if (UpdateComponent(Component, AnimInstance, DeltaTime, WorldTime, bUseUpdateBudget, bAllowParallelUpdate))
+					{
+						NumUpdatedInstances++;
+					}
+				}
+			}
+		}
+	}
+
+	//Masters update right away, followers wait for their result
+	if (SharingCandidates.Num())
+	{
+		NumUpdatedInstances += ResolveSharingGroups(DeltaTime, WorldTime, bAllowParallelUpdate);
+	}
+
+	int32 NumDeferredInstances = 0;
+	if (BudgetedUpdates.Num())
+	{
+		const int32 NumBudgetedUpdated = RunBudgetedUpdates(StartTime + UpdateBudget / 1000.0, bAllowParallelUpdate);
+		NumDeferredInstances = BudgetedUpdates.Num() - NumBudgetedUpdated;
+		NumUpdatedInstances += NumBudgetedUpdated;
+		BudgetedUpdates.Reset();
+	}
+
+	if (ParallelUpdates.Num())
+	{
+		INC_DWORD_STAT_BY(STAT_ParallelAnimInstances, ParallelUpdates.Num());
+		{
+			SCOPE_CYCLE_COUNTER(STAT_ParallelAnimUpdate);
+			const double ParallelStartTime = FPlatformTime::Seconds();
+			ParallelFor(ParallelUpdates.Num(), [this](int32 Index)
+			{
+				ParallelUpdates[Index].AnimInstance->ParallelUpdateAnimations();
+			});
+
+			//Only the parallel phase is averaged, the rest of the batch is measured as it runs
+			const float ParallelTime = static_cast<float>((FPlatformTime::Seconds() - ParallelStartTime) * 1000.0);
+			AverageParallelUpdateCost = FMath::Lerp(AverageParallelUpdateCost, ParallelTime / ParallelUpdates.Num(), 0.1f);
+		}
+
+		//Every instance that went through the parallel phase needs its fixup, even if its owner got destroyed meanwhile
+		{
+			SCOPE_CYCLE_COUNTER(STAT_ParallelAnimFixup);
+			for (int32 i = 0; i < ParallelUpdates.Num(); i++)
+			{
+				ParallelUpdates[i].AnimInstance->PostParallelUpdate();
+				TrySleep(ParallelUpdates[i]);
+			}
+		}
+
+		ParallelUpdates.Reset();
+	}
+
+	//With every master done, the followers can render their result
+	if (SharingFollowers.Num())
+	{
+		NumUpdatedInstances += ApplySharedAnimations();
+	}
+	bTickingBatch = false;
+
+	const float UsedTime = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	LastUpdateBudget = UpdateBudget;
+	LastUpdateBudgetUsed = UsedTime;
+	LastDeferredInstances = NumDeferredInstances;
+	INC_DWORD_STAT_BY(STAT_BatchedAnimInstances, NumUpdatedInstances);
+	INC_FLOAT_STAT_BY(STAT_AnimUpdateBudget, UpdateBudget);
+	INC_FLOAT_STAT_BY(STAT_AnimUpdateBudgetUsed, UsedTime);
+	INC_DWORD_STAT_BY(STAT_AnimUpdateBudgetDeferred, NumDeferredInstances);
+
+	//Apply any modification that was requested during the batch
+	if (bPendingCompaction)
+	{
+		CompactBuckets();
+	}
+
+	//Instances released during the batch are safe to be reused now
+	if (UPaperZDAnimInstancePool* InstancePool = World ? World->GetSubsystem<UPaperZDAnimInstancePool>() : nullptr)
+	{
+		InstancePool->FlushPendingReleases();
+	}
+
+	if (PendingComponents.Num())
+	{
+		TArray<UPaperZDAnimationComponent*> ComponentsToAdd = MoveTemp(PendingComponents);
+		for (UPaperZDAnimationComponent* Component : ComponentsToAdd)
+		{
+			AddToBucket(Component);
+		}
+	}
+}
+
+bool UPaperZDAnimTickSubsystem::UpdateComponent(UPaperZDAnimationComponent* Component, UPaperZDAnimInstance* AnimInstance, float DeltaTime, double WorldTime, bool bUseUpdateBudget, bool bAllowParallelUpdate)
+{
+	//Respect the owner dilation, the same way the component tick function would
+	const AActor* Owner = Component->GetOwner();
+	const float OwnerDilation = Owner ? Owner->CustomTimeDilation : 1.0f;
+
+	//Instances that just woke up need to play the time they slept, up to the previous frame
+	if (Component->SleepStartTime >= 0.0)
+	{
+		Component->DeferredDeltaTime += FMath::Max(static_cast<float>(WorldTime - DeltaTime - Component->SleepStartTime), 0.0f) * OwnerDilation;
+		Component->SleepStartTime = -1.0;
+	}
+
+	//The level of detail decides if the instance updates this frame, and with how much time
+	float UpdateDeltaTime = DeltaTime * OwnerDilation;
+	if (!Component->UpdateLOD(DeltaTime * OwnerDilation, UpdateDeltaTime))
+	{
+		return false;
+	}
+
+	//Normal priority instances wait until every high priority one is known, so the budget can be allocated
+	if (bUseUpdateBudget && Component->GetUpdatePriority() != EPaperZDAnimUpdatePriority::High)
+	{
+		BudgetedUpdates.Add({ Component, AnimInstance, UpdateDeltaTime });
+		return false;
+	}
+
+	//The budget could have been disabled while this component had time held back
+	UpdateDeltaTime += Component->DeferredDeltaTime;
+	Component->DeferredDeltaTime = 0.0f;
+	Component->BudgetDeferredFrames = 0;
+
+	UpdateInstance({ Component, AnimInstance, UpdateDeltaTime }, bAllowParallelUpdate);
+	return true;
+}
+
+bool UPaperZDAnimTickSubsystem::GatherSharingMember(UPaperZDAnimationComponent* Component, UPaperZDAnimInstance* AnimInstance)
+{
+	FPaperZDAnimSharingKey SharingKey;
+	if (!IsAnimSharingEnabled() || !AnimInstance->GetAnimSharingKey(Component->AnimSharingDirectionBuckets, SharingKey, Component->AnimSharingDirectionalAngle))
+	{
+		return false;
+	}
+
+	Component->AnimSharingKey = SharingKey;
+	Component->AnimSharingBatchIndex = BatchIndex;
+	SharingGroups.FindOrAdd(SharingKey).LastBatchIndex = BatchIndex;
+	SharingCandidates.Add({ Component, AnimInstance, nullptr, 0.0f });
+	return true;
+}
+
+int32 UPaperZDAnimTickSubsystem::ResolveSharingGroups(float DeltaTime, double WorldTime, bool bAllowParallelUpdate)
+{
+	int32 NumUpdated = 0;
+
+	//Previous masters get the first chance, so the shared playback doesn't jump between instances
+	for (int32 i = 0; i < SharingCandidates.Num(); i++)
+	{
+		//Index based, as the updates can null out the component of a later entry
+		const FPaperZDAnimSharingMember Candidate = SharingCandidates[i];
+		FPaperZDAnimSharingGroup* Group = Candidate.Component ? SharingGroups.Find(Candidate.Component->AnimSharingKey) : nullptr;
+		if (Group && Group->Master.Get() == Candidate.Component)
+		{
+			SharingCandidates[i].Component = nullptr;
+			Group->Master = nullptr;
+			if (UpdateSharingMaster(*Group, Candidate, DeltaTime, WorldTime, bAllowParallelUpdate))
+			{
+				NumUpdated++;
+			}
+		}
+	}
+
+	//The rest follow the master of their group, or try to become its master if it had none updated on this batch
+	for (int32 i = 0; i < SharingCandidates.Num(); i++)
+	{
+		const FPaperZDAnimSharingMember Candidate = SharingCandidates[i];
+		UPaperZDAnimationComponent* Component = Candidate.Component;
+		if (!Component)
+		{
+			continue;
+		}
+
+		FPaperZDAnimSharingGroup& Group = SharingGroups.FindChecked(Component->AnimSharingKey);
+		UPaperZDAnimationComponent* Master = Group.MasterBatchIndex == BatchIndex ? Group.Master.Get() : nullptr;
+		if (Master)
+		{
+			//Followers advance their own time every frame, the level of detail only applies to the master
+			const AActor* Owner = Component->GetOwner();
+			const float OwnerDilation = Owner ? Owner->CustomTimeDilation : 1.0f;
+			Component->bFollowingSharedAnimation = true;
+			SharingFollowers.Add({ Component, Candidate.AnimInstance, Master, DeltaTime * OwnerDilation + Component->DeferredDeltaTime });
+			Component->DeferredDeltaTime = 0.0f;
+		}
+		else if (UpdateSharingMaster(Group, Candidate, DeltaTime, WorldTime, bAllowParallelUpdate))
+		{
+			NumUpdated++;
+		}
+	}
+	SharingCandidates.Reset();
+
+	//Groups that no component reported this batch are gone
+	for (auto It = SharingGroups.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastBatchIndex != BatchIndex)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	return NumUpdated;
+}
+
+bool UPaperZDAnimTickSubsystem::UpdateSharingMaster(FPaperZDAnimSharingGroup& Group, const FPaperZDAnimSharingMember& Candidate, float DeltaTime, double WorldTime, bool bAllowParallelUpdate)
+{
+	//Masters skip the budget, as deferring them would leave the whole group without an update
+	Candidate.Component->bFollowingSharedAnimation = false;
+	if (!UpdateComponent(Candidate.Component, Candidate.AnimInstance, DeltaTime, WorldTime, false, bAllowParallelUpdate))
+	{
+		return false;
+	}
+
+	//Instances that don't evaluate their animation have nothing to share
+	if (!Candidate.AnimInstance->IsSkippingRenderUpdate())
+	{
+		Group.Master = Candidate.Component;
+		Group.MasterBatchIndex = BatchIndex;
+		INC_DWORD_STAT(STAT_AnimSharingMasters);
+	}
+
+	return true;
+}
+
+int32 UPaperZDAnimTickSubsystem::ApplySharedAnimations()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimSharingFollowerUpdate);
+	INC_DWORD_STAT_BY(STAT_AnimSharingFollowers, SharingFollowers.Num());
+
+	int32 NumUpdated = 0;
+	for (int32 i = 0; i < SharingFollowers.Num(); i++)
+	{
+		//Index based, as playing the animation can null out later entries
+		const FPaperZDAnimSharingMember Follower = SharingFollowers[i];
+		if (!Follower.Component || Follower.Component->GetAnimInstance() != Follower.AnimInstance)
+		{
+			continue;
+		}
+
+		//Followers take their own transitions, one that ends up on other states or lost its master updates on its own
+		UPaperZDAnimInstance* MasterInstance = Follower.Master ? Follower.Master->GetAnimInstance() : nullptr;
+		if (MasterInstance && MasterInstance->GetClass() == Follower.AnimInstance->GetClass())
+		{
+			Follower.AnimInstance->UpdateSharedStateMachines(Follower.DeltaTime, MasterInstance);
+		}
+
+		if (!MasterInstance || MasterInstance->GetClass() != Follower.AnimInstance->GetClass() || Follower.AnimInstance->GetAnimSharingStateHash() != MasterInstance->GetAnimSharingStateHash())
+		{
+			Follower.Component->bFollowingSharedAnimation = false;
+			Follower.AnimInstance->Tick(Follower.DeltaTime);
+			NumUpdated++;
+			continue;
+		}
+
+		//Each follower renders with its own direction and time offset
+		SharedPlaybackData = MasterInstance->GetEvaluatedPlaybackData();
+		SharedPlaybackData.DirectionalAngle = Follower.Component->AnimSharingDirectionalAngle;
+		const float TimeOffset = Follower.Component->AnimSharingTimeOffset;
+		if (TimeOffset != 0.0f)
+		{
+			for (FPaperZDWeightedAnimation& WeightedAnimation : SharedPlaybackData.WeightedAnimations)
+			{
+				const UPaperZDAnimSequence* AnimSequence = WeightedAnimation.AnimSequencePtr.Get();
+				const float Duration = AnimSequence ? AnimSequence->GetTotalDuration() : 0.0f;
+				if (Duration > 0.0f)
+				{
+					const float OffsetTime = FMath::Fmod(WeightedAnimation.PlaybackTime + TimeOffset, Duration);
+					WeightedAnimation.PlaybackTime = OffsetTime < 0.0f ? OffsetTime + Duration : OffsetTime;
+				}
+			}
+		}
+
+		Follower.AnimInstance->PlaySharedAnimation(Follower.DeltaTime, SharedPlaybackData);
+	}
+
+	SharingFollowers.Reset();
+	return NumUpdated;
+}
+
+void UPaperZDAnimTickSubsystem::UpdateInstance(const FPaperZDBatchedAnimUpdate& Update, bool bAllowParallelUpdate)
+{
+	//Thread-safe graphs get prepared for the parallel phase, any other graph is updated in place
+	if (bAllowParallelUpdate && Update.AnimInstance->CanUpdateInParallel())
+	{
+		Update.AnimInstance->PreParallelUpdate(Update.DeltaTime);
+		ParallelUpdates.Add(Update);
+	}
+	else
+	{
+		Update.AnimInstance->Tick(Update.DeltaTime);
+		TrySleep(Update);
+	}
+}
+
+void UPaperZDAnimTickSubsystem::TrySleep(const FPaperZDBatchedAnimUpdate& Update)
+{
+	//The component could have unregistered or changed its instance during its own update
+	UPaperZDAnimationComponent* Component = Update.Component;
+	float SleepDeltaScale = 0.0f;
+	if (!Component || Component->GetAnimInstance() != Update.AnimInstance || !Update.AnimInstance->CanSleep(SleepDeltaScale) || !IsSleepingEnabled())
+	{
+		return;
+	}
+
+	//Shared animations need the master awake every frame, as the followers rely on it
+	if (Component->bEnableAnimSharing)
+	{
+		return;
+	}
+
+	//Only worth it if nothing happens on the next frame
+	const AActor* Owner = Component->GetOwner();
+	const float OwnerDilation = Owner ? Owner->CustomTimeDilation : 1.0f;
+	if (SleepDeltaScale > 1.0f && Update.DeltaTime > 0.0f && OwnerDilation > 0.0f)
+	{
+		//The scale is relative to the delta time the instance was updated with, which includes the owner dilation
+		const UWorld* World = GetWorld();
+		const double WorldTime = World ? World->GetTimeSeconds() : 0.0;
+		const double SleepDuration = SleepDeltaScale < MAX_flt ? static_cast<double>(SleepDeltaScale) * Update.DeltaTime / OwnerDilation : MAX_dbl;
+
+		Component->bAnimSleeping = true;
+		Component->SleepSerial++;
+		Component->SleepStartTime = WorldTime;
+		if (SleepDuration < MAX_dbl)
+		{
+			SleepWheel.Schedule(Component, Component->SleepSerial, WorldTime + SleepDuration);
+		}
+
+		INC_DWORD_STAT(STAT_AnimInstancesPutToSleep);
+	}
+}
+
+int32 UPaperZDAnimTickSubsystem::RunBudgetedUpdates(double BudgetEndTime, bool bAllowParallelUpdate)
+{
+	//The clock already accounts for everything the batch did so far, but the parallel phase runs afterwards and can only be estimated
+	double PendingParallelTime = ParallelUpdates.Num() * AverageParallelUpdateCost / 1000.0;
+	const int32 NumBudgeted = BudgetedUpdates.Num();
+	const int32 MaxDeferredFrames = CVarUpdateBudgetMaxDeferredFrames.GetValueOnGameThread();
+
+	//Round robin, starting from the first component that didn't get the budget on the previous batch
+	int32 FirstIndex = 0;
+	if (const UPaperZDAnimationComponent* CursorComponent = BudgetCursor.Get())
+	{
+		FirstIndex = FMath::Max(BudgetedUpdates.IndexOfByPredicate([CursorComponent](const FPaperZDBatchedAnimUpdate& Update) { return Update.Component == CursorComponent; }), 0);
+	}
+	BudgetCursor = nullptr;
+
+	int32 NumUpdated = 0;
+	bool bBudgetExhausted = false;
+	for (int32 i = 0; i < NumBudgeted; i++)
+	{
+		//Index based, as the updates can null out the component of a later entry
+		const FPaperZDBatchedAnimUpdate BudgetedUpdate = BudgetedUpdates[(FirstIndex + i) % NumBudgeted];
+		UPaperZDAnimationComponent* Component = BudgetedUpdate.Component;
+		if (!Component)
+		{
+			continue;
+		}
+
+		//Once the budget runs out it stays out, instances held back for too long are updated regardless so their playback doesn't drift too far behind
+		bBudgetExhausted = bBudgetExhausted || FPlatformTime::Seconds() + PendingParallelTime >= BudgetEndTime;
+		const bool bDeferredTooLong = MaxDeferredFrames > 0 && Component->BudgetDeferredFrames >= MaxDeferredFrames;
+		if (!bBudgetExhausted || bDeferredTooLong)
+		{
+			const int32 NumParallelUpdates = ParallelUpdates.Num();
+			UpdateInstance({ Component, BudgetedUpdate.AnimInstance, BudgetedUpdate.DeltaTime + Component->DeferredDeltaTime }, bAllowParallelUpdate);
+			if (ParallelUpdates.Num() > NumParallelUpdates)
+			{
+				PendingParallelTime += AverageParallelUpdateCost / 1000.0;
+			}
+
+			Component->DeferredDeltaTime = 0.0f;
+			Component->BudgetDeferredFrames = 0;
+			NumUpdated++;
+		}
+		else
+		{
+			if (!BudgetCursor.IsValid())
+			{
+				BudgetCursor = Component;
+			}
+
+			Component->DeferredDeltaTime += BudgetedUpdate.DeltaTime;
+			Component->BudgetDeferredFrames++;
+		}
+	}
+
+	return NumUpdated;
+}
+
+const TArray<FVector>& UPaperZDAnimTickSubsystem::GetViewLocations()
+{
+	if (ViewLocationsFrame != GFrameCounter)
+	{
+		ViewLocationsFrame = GFrameCounter;
+		ViewLocations.Reset();
+
+		UWorld* World = GetWorld();
+		if (World)
+		{
+			for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				const APlayerController* PlayerController = It->Get();
+				if (PlayerController && PlayerController->IsLocalController())
+				{
+					FVector ViewLocation;
+					FRotator ViewRotation;
+					PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+					ViewLocations.Add(ViewLocation);
+				}
+			}
+		}
+	}
+
+	return ViewLocations;
+}
+
+void UPaperZDAnimTickSubsystem::EnsureTickFunctionRegistered()
+{
+	if (!BatchedTickFunction.IsTickFunctionRegistered())
+	{
+		UWorld* World = GetWorld();
+		if (World && World->PersistentLevel)
+		{
+			BatchedTickFunction.Target = this;
+			BatchedTickFunction.RegisterTickFunction(World->PersistentLevel);
+		}
+	}
+}
+
+void UPaperZDAnimTickSubsystem::AddToBucket(UPaperZDAnimationComponent* InComponent)
+{
+	UClass* AnimClass = InComponent->GetAnimInstanceClass();
+	FPaperZDAnimTickBucket* Bucket = Buckets.FindByPredicate([AnimClass](const FPaperZDAnimTickBucket& InBucket) { return InBucket.AnimClass == AnimClass; });
+	if (!Bucket)
+	{
+		Bucket = &Buckets.AddDefaulted_GetRef();
+		Bucket->AnimClass = AnimClass;
+	}
+
+	Bucket->Components.AddUnique(InComponent);
+}
+
+void UPaperZDAnimTickSubsystem::CompactBuckets()
+{
+	for (int32 BucketIndex = Buckets.Num() - 1; BucketIndex >= 0; BucketIndex--)
+	{
+		FPaperZDAnimTickBucket& Bucket = Buckets[BucketIndex];
+		Bucket.Components.RemoveAllSwap([](const UPaperZDAnimationComponent* Component) { return Component == nullptr; });
+		if (Bucket.Components.Num() == 0)
+		{
+			Buckets.RemoveAtSwap(BucketIndex);
+		}
+	}
+
+	bPendingCompaction = false;
+}
@@ -2,11 +2,45 @@
 
 #include "PaperZDAnimationComponent.h"
 #include "PaperZDAnimInstance.h"
+#include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "PaperZDAnimTickSubsystem.h"
+#include "PaperZDAnimInstancePool.h"
+#include "PaperZDInstancedSpriteComponent.h"
+#include "PaperZDStats.h"
 #include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+//Stats declarations
+DECLARE_CYCLE_STAT(TEXT("Component Tick"), STAT_ComponentAnimTick, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Component Ticked Instances"), STAT_ComponentAnimInstances, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Full Rate Instances"), STAT_AnimLODFullRate, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Reduced Rate Instances"), STAT_AnimLODReducedRate, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD State Machine Only Instances"), STAT_AnimLODStateMachineOnly, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Suspended Instances"), STAT_AnimLODSuspended, STATGROUP_PaperZD);
 
 // Sets default values for this component's properties
 UPaperZDAnimationComponent::UPaperZDAnimationComponent()
 	: AnimInstanceClass(nullptr)
+	, bUseBatchedTick(false)
+	, bRegisteredForBatchedTick(false)
+	, bUseInstancePool(false)
+	, bAnimInstanceFromPool(false)
+	, UpdatePriority(EPaperZDAnimUpdatePriority::Normal)
+	, DeferredDeltaTime(0.0f)
+	, BudgetDeferredFrames(0)
+	, bAnimSleeping(false)
+	, SleepSerial(0)
+	, SleepStartTime(-1.0)
+	, bEnableAnimSharing(false)
+	, AnimSharingDirectionBuckets(8)
+	, AnimSharingBatchIndex(0)
+	, AnimSharingDirectionalAngle(0.0f)
+	, bFollowingSharedAnimation(false)
+	, Significance(1.0f)
+	, CurrentLOD(EPaperZDAnimLOD::FullRate)
+	, FramesSinceLODUpdate(0)
+	, AccumulatedLODDeltaTime(0.0f)
+	, AnimSharingTimeOffset(0.0f)
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
@@ -20,16 +54,43 @@ void UPaperZDAnimationComponent::BeginPlay()
 
 	//Create a fresh AnimInstance object
 	CreateAnimInstance();
+
+	//Move the update to the batched tick if requested
+	if (ShouldUseBatchedTick())
+	{
+		RegisterBatchedTick();
+	}
+}
+
+void UPaperZDAnimationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Leaving play, the component tick must stay disabled
+	UnregisterBatchedTick(false);
+
+	//Pooled instances are handed over to the next component that spawns
+	if (bAnimInstanceFromPool)
+	{
+		ReleaseAnimInstance();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UPaperZDAnimationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	//Need to update the AnimInstance
-	if (AnimInstance)
+	//Need to update the AnimInstance, if its level of detail allows it this frame
+	float UpdateDeltaTime = DeltaTime;
+	if (AnimInstance && UpdateLOD(DeltaTime, UpdateDeltaTime))
 	{
-		AnimInstance->Tick(DeltaTime);
+		//Time held back or slept while on the batched tick gets played on the first update after leaving it
+		UpdateDeltaTime += DeferredDeltaTime;
+		DeferredDeltaTime = 0.0f;
+
+		SCOPE_CYCLE_COUNTER(STAT_ComponentAnimTick);
+		INC_DWORD_STAT(STAT_ComponentAnimInstances);
+		AnimInstance->Tick(UpdateDeltaTime);
 	}
 }
 
@@ -40,9 +101,49 @@ AActor* UPaperZDAnimationComponent::GetOwningActor() const
 
 UPrimitiveComponent* UPaperZDAnimationComponent::GetRenderComponent() const
 {
+	if (UPaperZDInstancedSpriteComponent* InstancedSprite = InstancedRenderComponent.Get())
+	{
+		return InstancedSprite;
+	}
+
 	return Cast<UPrimitiveComponent>(RenderComponent.GetComponent(GetOwner()));
 }
 
+void UPaperZDAnimationComponent::SetInstancedRenderComponent(UPaperZDInstancedSpriteComponent* InInstancedRenderComponent)
+{
+	if (InstancedRenderComponent.Get() != InInstancedRenderComponent)
+	{
+		InstancedRenderComponent = InInstancedRenderComponent;
+		LODRenderComponent = nullptr;
+
+		//The player needs to move to the new component, which will give us an instance on it
+		if (AnimInstance)
+		{
+			AnimInstance->GetPlayerState().RegisterRenderComponent(GetRenderComponent());
+		}
+	}
+}
+
+void UPaperZDAnimationComponent::OnWakeUpAnimInstance()
+{
+	if (bAnimSleeping)
+	{
+		UWorld* World = GetWorld();
+		if (UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr)
+		{
+			TickSubsystem->WakeComponent(this);
+		}
+	}
+}
+
+bool UPaperZDAnimationComponent::ShouldUseBatchedTick() const
+{
+	//Budgeted, sleeping and sharing components need it too, as the budget, the sleep schedule and the sharing groups are handled by the batch
+	const bool bBudgeted = UpdatePriority != EPaperZDAnimUpdatePriority::High && UPaperZDAnimTickSubsystem::IsUpdateBudgetEnabled();
+	const bool bCanSleep = AnimInstance && AnimInstance->AllowsSleeping() && UPaperZDAnimTickSubsystem::IsSleepingEnabled();
+	return bUseBatchedTick || bBudgeted || bCanSleep || bEnableAnimSharing || UPaperZDAnimTickSubsystem::IsBatchedTickForced();
+}
+
 TSubclassOf<UPaperZDAnimInstance> UPaperZDAnimationComponent::GetSequencerAnimInstanceClass() const
 {
 	return AnimInstanceClass;
@@ -67,8 +168,17 @@ void UPaperZDAnimationComponent::CreateAnimInstance()
 {
 	if (AnimInstanceClass)
 	{
-		AnimInstance = NewObject<UPaperZDAnimInstance>(this, AnimInstanceClass);
-		AnimInstance->Init(this);
+		//A new instance starts awake
+		OnWakeUpAnimInstance();
+
+		//The pool only lives on game worlds
+		UWorld* World = GetWorld();
+		UPaperZDAnimInstancePool* InstancePool = bUseInstancePool && World && UPaperZDAnimInstancePool::IsPoolingEnabled() ? World->GetSubsystem<UPaperZDAnimInstancePool>() : nullptr;
+		bAnimInstanceFromPool = InstancePool != nullptr;
+		AnimInstance = InstancePool ? InstancePool->AcquireInstance(AnimInstanceClass, this) : UPaperZDAnimInstancePool::NewInstance(AnimInstanceClass, this, this);
+
+		//Fresh instances need to be configured for the level of detail we're on
+		ApplyLOD(CurrentLOD);
 	}
 	else
 	{
@@ -76,6 +186,19 @@ void UPaperZDAnimationComponent::CreateAnimInstance()
 	}
 }
 
+void UPaperZDAnimationComponent::ReleaseAnimInstance()
+{
+	UWorld* World = GetWorld();
+	UPaperZDAnimInstancePool* InstancePool = bAnimInstanceFromPool && World ? World->GetSubsystem<UPaperZDAnimInstancePool>() : nullptr;
+	if (InstancePool && AnimInstance)
+	{
+		InstancePool->ReleaseInstance(AnimInstance);
+	}
+
+	AnimInstance = nullptr;
+	bAnimInstanceFromPool = false;
+}
+
 void UPaperZDAnimationComponent::InitRenderComponent(UPrimitiveComponent* InRenderComponent)
 {
 	RenderComponent.PathToComponent = *InRenderComponent->GetPathName(GetOwner());
@@ -85,13 +208,191 @@ void UPaperZDAnimationComponent::SetAnimInstanceClass(TSubclassOf<UPaperZDAnimIn
 {
 	AnimInstanceClass = InAnimInstanceClass;
 
+	//Leave the batch before releasing the instance, so no update pending on the current batch keeps pointing to it
+	const bool bWasRegisteredForBatchedTick = bRegisteredForBatchedTick;
+	UnregisterBatchedTick();
+
 	//Potentially re-create the anim instance, only if we already initialized the AnimInstance
-	AnimInstance = nullptr;
+	ReleaseAnimInstance();
 	CreateAnimInstance();
+
+	//The batched tick groups components by class, so we need to join the group of the new class
+	if (bWasRegisteredForBatchedTick || (HasBegunPlay() && ShouldUseBatchedTick()))
+	{
+		RegisterBatchedTick();
+	}
 }
 
 void UPaperZDAnimationComponent::InitAnimInstanceClass(TSubclassOf<UPaperZDAnimInstance> InAnimInstanceClass)
 {
 	AnimInstanceClass = InAnimInstanceClass;
-	AnimInstance = nullptr;
+	ReleaseAnimInstance();
+}
+
+void UPaperZDAnimationComponent::SetSignificanceCallback(FPaperZDAnimSignificanceSignature InCallback)
+{
+	SignificanceCallback = InCallback;
+}
+
+bool UPaperZDAnimationComponent::UpdateLOD(float DeltaTime, float& OutUpdateDeltaTime)
+{
+	OutUpdateDeltaTime = DeltaTime;
+
+	//The settings could have been disabled at runtime, in which case we need to go back to full rate
+	Significance = LODSettings.bEnableLOD ? ComputeSignificance() : 1.0f;
+	const EPaperZDAnimLOD NewLOD = LODSettings.bEnableLOD ? LODSettings.GetLODForSignificance(Significance) : EPaperZDAnimLOD::FullRate;
+	if (NewLOD != CurrentLOD)
+	{
+		ApplyLOD(NewLOD);
+	}
+
+	switch (CurrentLOD)
+	{
+		case EPaperZDAnimLOD::FullRate:			INC_DWORD_STAT(STAT_AnimLODFullRate);			break;
+		case EPaperZDAnimLOD::ReducedRate:		INC_DWORD_STAT(STAT_AnimLODReducedRate);		break;
+		case EPaperZDAnimLOD::StateMachineOnly:	INC_DWORD_STAT(STAT_AnimLODStateMachineOnly);	break;
+		default:								INC_DWORD_STAT(STAT_AnimLODSuspended);			break;
+	}
+
+	//Suspended instances don't update nor accumulate time
+	const FPaperZDAnimLODLevelSettings* LevelSettings = LODSettings.bEnableLOD ? LODSettings.GetLevelSettings(CurrentLOD) : nullptr;
+	if (CurrentLOD == EPaperZDAnimLOD::Suspended)
+	{
+		return false;
+	}
+	else if (LevelSettings && LevelSettings->UpdateInterval > 1)
+	{
+		AccumulatedLODDeltaTime += DeltaTime;
+		if (++FramesSinceLODUpdate < LevelSettings->UpdateInterval)
+		{
+			return false;
+		}
+
+		OutUpdateDeltaTime = AccumulatedLODDeltaTime;
+	}
+	else if (FramesSinceLODUpdate > 0)
+	{
+		//Coming from a reduced rate, flush the time that was waiting for the next update
+		OutUpdateDeltaTime = AccumulatedLODDeltaTime + DeltaTime;
+	}
+
+	FramesSinceLODUpdate = 0;
+	AccumulatedLODDeltaTime = 0.0f;
+	return true;
+}
+
+float UPaperZDAnimationComponent::ComputeSignificance()
+{
+	float OutSignificance = 1.0f;
+
+	//Distance to the closest view
+	UWorld* World = GetWorld();
+	UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr;
+	const AActor* Owner = GetOwner();
+	if (TickSubsystem && Owner)
+	{
+		const TArray<FVector>& ViewLocations = TickSubsystem->GetViewLocations();
+		if (ViewLocations.Num())
+		{
+			const FVector Location = Owner->GetActorLocation();
+			float MinDistanceSquared = MAX_flt;
+			for (const FVector& ViewLocation : ViewLocations)
+			{
+				MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(ViewLocation, Location));
+			}
+
+			const float FalloffRange = FMath::Max(LODSettings.ZeroSignificanceDistance - LODSettings.FullSignificanceDistance, KINDA_SMALL_NUMBER);
+			OutSignificance = 1.0f - FMath::Clamp((FMath::Sqrt(MinDistanceSquared) - LODSettings.FullSignificanceDistance) / FalloffRange, 0.0f, 1.0f);
+		}
+	}
+
+	//Off-screen penalty
+	if (!LODRenderComponent.IsValid())
+	{
+		LODRenderComponent = GetRenderComponent();
+	}
+
+	const UPrimitiveComponent* LODRenderComponentPtr = LODRenderComponent.Get();
+	if (LODRenderComponentPtr && !LODRenderComponentPtr->WasRecentlyRendered(LODSettings.RecentlyRenderedTolerance))
+	{
+		OutSignificance *= LODSettings.OffscreenSignificanceScale;
+	}
+
+	//User callbacks
+	if (NativeSignificanceCallback.IsBound())
+	{
+		OutSignificance *= FMath::Clamp(NativeSignificanceCallback.Execute(this), 0.0f, 1.0f);
+	}
+
+	if (SignificanceCallback.IsBound())
+	{
+		OutSignificance *= FMath::Clamp(SignificanceCallback.Execute(this), 0.0f, 1.0f);
+	}
+
+	return OutSignificance;
+}
+
+void UPaperZDAnimationComponent::ApplyLOD(EPaperZDAnimLOD InLOD)
+{
+	//Suspended instances stay frozen, so any time waiting to be applied gets discarded
+	if (InLOD == EPaperZDAnimLOD::Suspended)
+	{
+		FramesSinceLODUpdate = 0;
+		AccumulatedLODDeltaTime = 0.0f;
+		DeferredDeltaTime = 0.0f;
+		BudgetDeferredFrames = 0;
+		SleepStartTime = -1.0;
+	}
+
+	//Components entering a level that skips frames start on a phase of their own, so they don't all update on the same frame.
+	//Only when there's no accumulated time pending, which would otherwise wait longer than the interval
+	const FPaperZDAnimLODLevelSettings* LevelSettings = LODSettings.bEnableLOD ? LODSettings.GetLevelSettings(InLOD) : nullptr;
+	if (InLOD != EPaperZDAnimLOD::Suspended && LevelSettings && LevelSettings->UpdateInterval > 1 && FramesSinceLODUpdate == 0)
+	{
+		FramesSinceLODUpdate = static_cast<int32>(GetUniqueID() % static_cast<uint32>(LevelSettings->UpdateInterval));
+	}
+
+	CurrentLOD = InLOD;
+	if (AnimInstance)
+	{
+		AnimInstance->SetSkipRenderUpdate(InLOD == EPaperZDAnimLOD::StateMachineOnly);
+
+		//Suspended instances keep the policy they had, as they won't play anything until they wake up
+		const EPaperZDAnimLODNotifyPolicy NotifyPolicy = LevelSettings ? LevelSettings->NotifyPolicy : EPaperZDAnimLODNotifyPolicy::Fire;
+		if (LevelSettings || InLOD != EPaperZDAnimLOD::Suspended)
+		{
+			AnimInstance->GetPlayerState().SetNotifyPolicy(NotifyPolicy);
+		}
+	}
+}
+
+void UPaperZDAnimationComponent::RegisterBatchedTick()
+{
+	UWorld* World = GetWorld();
+	UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr;
+	if (TickSubsystem && !bRegisteredForBatchedTick)
+	{
+		TickSubsystem->RegisterComponent(this);
+		SetComponentTickEnabled(false);
+		bRegisteredForBatchedTick = true;
+	}
+}
+
+void UPaperZDAnimationComponent::UnregisterBatchedTick(bool bRestoreComponentTick /* = true */)
+{
+	if (bRegisteredForBatchedTick)
+	{
+		UWorld* World = GetWorld();
+		if (UPaperZDAnimTickSubsystem* TickSubsystem = World ? World->GetSubsystem<UPaperZDAnimTickSubsystem>() : nullptr)
+		{
+			TickSubsystem->UnregisterComponent(this);
+		}
+
+		if (bRestoreComponentTick)
+		{
+			SetComponentTickEnabled(true);
+		}
+
+		bRegisteredForBatchedTick = false;
+	}
 }
@@ -0,0 +1,264 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDInstancedSpriteComponent.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle_InstancedSprite.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDStats.h"
+#include "PaperZDTrace.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Instanced Sprite Tick"), STAT_InstancedSpriteTick, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instanced Sprite Instances"), STAT_InstancedSpriteInstances, STATGROUP_PaperZD);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instanced Sprite Keyframe Changes"), STAT_InstancedSpriteKeyFrameChanges, STATGROUP_PaperZD);
+
+static FAutoConsoleCommandWithWorld CmdVerifyInstancedSprites(
+	TEXT("paperzd.VerifyInstancedSprites"),
+	TEXT("Checks that every instanced sprite component on the world displays the keyframe that matches the playback of each of its instances. Runs on the CPU, works under NullRHI."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		int32 NumComponents = 0;
+		int32 NumInstances = 0;
+		int32 NumVerified = 0;
+		int32 NumErrors = 0;
+		for (TObjectIterator<UPaperZDInstancedSpriteComponent> It; It; ++It)
+		{
+			if (It->GetWorld() == World)
+			{
+				TArray<FString> Errors;
+				int32 NumComponentVerified = 0;
+				NumErrors += It->VerifyInstanceKeyFrames(&Errors, &NumComponentVerified);
+				NumInstances += It->GetNumAnimatedInstances();
+				NumVerified += NumComponentVerified;
+				NumComponents++;
+
+				for (const FString& Error : Errors)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("PaperZD instanced sprite '%s': %s"), *It->GetPathName(), *Error);
+				}
+			}
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("PaperZD instanced sprites verified: %d components, %d instances, %d checked against their AnimInstance, %d mismatches."), NumComponents, NumInstances, NumVerified, NumErrors);
+	}));
+
+UPaperZDInstancedSpriteComponent::UPaperZDInstancedSpriteComponent()
+	: bInstanceRenderDataDirty(false)
+{
+	//Ticks after the animations were updated, so every keyframe change of the frame goes into a single render state rebuild
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+	bTickInEditor = true;
+}
+
+void UPaperZDInstancedSpriteComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InstancedSpriteTick);
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	INC_DWORD_STAT_BY(STAT_InstancedSpriteInstances, GetNumAnimatedInstances());
+
+	UpdateFollowTransforms();
+	if (bInstanceRenderDataDirty)
+	{
+		bInstanceRenderDataDirty = false;
+		UpdateBounds();
+		MarkRenderStateDirty();
+	}
+}
+
+int32 UPaperZDInstancedSpriteComponent::RegisterAnimatedInstance(USceneComponent* InFollowComponent, const FTransform& InRelativeTransform /* = FTransform::Identity */, const UPaperZDAnimInstance* InOwningInstance /* = nullptr */)
+{
+	const FTransform WorldTransform = InFollowComponent ? InRelativeTransform * InFollowComponent->GetComponentTransform() : InRelativeTransform;
+
+	//Reuse a released slot if possible, so indices stay stable for the other instances
+	int32 InstanceIndex = INDEX_NONE;
+	if (FreeSlots.Num())
+	{
+		InstanceIndex = FreeSlots.Pop(false);
+		UpdateInstanceTransform(InstanceIndex, WorldTransform, true, false, true);
+	}
+	else
+	{
+		InstanceIndex = AddInstance(WorldTransform, nullptr, true);
+		Slots.AddDefaulted();
+		check(Slots.Num() == PerInstanceSpriteData.Num());
+	}
+
+	FInstanceSlot& Slot = Slots[InstanceIndex];
+	Slot.FollowComponent = InFollowComponent;
+	Slot.RelativeTransform = InRelativeTransform;
+	Slot.OwningInstance = InOwningInstance;
+	Slot.Flipbook = nullptr;
+	Slot.PlaybackTime = 0.0f;
+	Slot.KeyFrameIndex = INDEX_NONE;
+	Slot.bInUse = true;
+
+	bInstanceRenderDataDirty = true;
+	return InstanceIndex;
+}
+
+void UPaperZDInstancedSpriteComponent::ReleaseAnimatedInstance(int32 InstanceIndex)
+{
+	if (IsAnimatedInstanceValid(InstanceIndex))
+	{
+		//Instances without sprite aren't drawn
+		FInstanceSlot& Slot = Slots[InstanceIndex];
+		Slot.bInUse = false;
+		Slot.FollowComponent = nullptr;
+		Slot.OwningInstance = nullptr;
+		Slot.Flipbook = nullptr;
+		Slot.KeyFrameIndex = INDEX_NONE;
+		PerInstanceSpriteData[InstanceIndex].SourceSprite = nullptr;
+		FreeSlots.Add(InstanceIndex);
+		bInstanceRenderDataDirty = true;
+	}
+}
+
+void UPaperZDInstancedSpriteComponent::SetInstancePlayback(int32 InstanceIndex, const UPaperFlipbook* Flipbook, float PlaybackTime)
+{
+	if (!IsAnimatedInstanceValid(InstanceIndex))
+	{
+		return;
+	}
+
+	FInstanceSlot& Slot = Slots[InstanceIndex];
+	if (Slot.Flipbook.Get() != Flipbook)
+	{
+		PAPERZD_TRACE_EVENT(FlipbookSwap, this, Flipbook);
+	}
+
+	//Resolve the keyframe the same way the flipbook component would
+	const int32 KeyFrameIndex = Flipbook ? Flipbook->GetKeyFrameIndexAtTime(PlaybackTime) : INDEX_NONE;
+	UPaperSprite* Sprite = Flipbook ? Flipbook->GetSpriteAtFrame(KeyFrameIndex) : nullptr;
+	Slot.Flipbook = Flipbook;
+	Slot.PlaybackTime = PlaybackTime;
+	Slot.KeyFrameIndex = KeyFrameIndex;
+
+	FSpriteInstanceData& InstanceData = PerInstanceSpriteData[InstanceIndex];
+	if (InstanceData.SourceSprite != Sprite)
+	{
+		InstanceData.SourceSprite = Sprite;
+		if (Sprite)
+		{
+			InstanceData.MaterialIndex = InstanceMaterials.AddUnique(Sprite->GetDefaultMaterial());
+		}
+
+		INC_DWORD_STAT(STAT_InstancedSpriteKeyFrameChanges);
+		bInstanceRenderDataDirty = true;
+	}
+}
+
+bool UPaperZDInstancedSpriteComponent::GetInstanceKeyFrame(int32 InstanceIndex, const UPaperFlipbook*& OutFlipbook, int32& OutKeyFrameIndex) const
+{
+	OutFlipbook = IsAnimatedInstanceValid(InstanceIndex) ? Slots[InstanceIndex].Flipbook.Get() : nullptr;
+	OutKeyFrameIndex = OutFlipbook ? Slots[InstanceIndex].KeyFrameIndex : INDEX_NONE;
+	return OutFlipbook != nullptr;
+}
+
+bool UPaperZDInstancedSpriteComponent::VerifyInstanceKeyFrame(int32 InstanceIndex, const FPaperZDAnimationPlaybackData& PlaybackData, FString* OutError /* = nullptr */) const
+{
+	if (!IsAnimatedInstanceValid(InstanceIndex))
+	{
+		if (OutError)
+		{
+			*OutError = FString::Printf(TEXT("Instance %d isn't registered."), InstanceIndex);
+		}
+		return false;
+	}
+
+	//Resolve the expected keyframe from the playback data itself, the same way the playback handle does
+	const UPaperFlipbook* ExpectedFlipbook = UPaperZDPlaybackHandle_InstancedSprite::ResolveFlipbook(PlaybackData);
+	const float ExpectedTime = PlaybackData.WeightedAnimations.Num() ? PlaybackData.WeightedAnimations[0].PlaybackTime : 0.0f;
+	const int32 ExpectedKeyFrameIndex = ExpectedFlipbook ? ExpectedFlipbook->GetKeyFrameIndexAtTime(ExpectedTime) : INDEX_NONE;
+	const UPaperSprite* ExpectedSprite = ExpectedFlipbook ? ExpectedFlipbook->GetSpriteAtFrame(ExpectedKeyFrameIndex) : nullptr;
+
+	//Both the recorded keyframe and the sprite sent to the renderer must match
+	const FInstanceSlot& Slot = Slots[InstanceIndex];
+	const UPaperFlipbook* Flipbook = Slot.Flipbook.Get();
+	const UPaperSprite* RenderedSprite = PerInstanceSpriteData.IsValidIndex(InstanceIndex) ? PerInstanceSpriteData[InstanceIndex].SourceSprite.Get() : nullptr;
+	if (Flipbook != ExpectedFlipbook || Slot.KeyFrameIndex != ExpectedKeyFrameIndex || RenderedSprite != ExpectedSprite)
+	{
+		if (OutError)
+		{
+			*OutError = FString::Printf(TEXT("Instance %d expected keyframe %d (%s) of '%s' at time %.3f, got keyframe %d (%s) of '%s'."),
+				InstanceIndex, ExpectedKeyFrameIndex, *GetNameSafe(ExpectedSprite), *GetNameSafe(ExpectedFlipbook), ExpectedTime, Slot.KeyFrameIndex, *GetNameSafe(RenderedSprite), *GetNameSafe(Flipbook));
+		}
+		return false;
+	}
+
+	return true;
+}
+
+int32 UPaperZDInstancedSpriteComponent::VerifyInstanceKeyFrames(TArray<FString>* OutErrors /* = nullptr */, int32* OutNumVerified /* = nullptr */) const
+{
+	int32 NumErrors = 0;
+	int32 NumVerified = 0;
+	for (int32 InstanceIndex = 0; InstanceIndex < Slots.Num(); InstanceIndex++)
+	{
+		const FInstanceSlot& Slot = Slots[InstanceIndex];
+		const UPaperZDAnimInstance* OwningInstance = Slot.OwningInstance.Get();
+		if (!Slot.bInUse || !OwningInstance || OwningInstance->IsSkippingRenderUpdate())
+		{
+			continue;
+		}
+
+		//Nothing was evaluated yet, the instance was never played
+		const FPaperZDAnimationPlaybackData& PlaybackData = OwningInstance->GetEvaluatedPlaybackData();
+		if (PlaybackData.WeightedAnimations.Num() == 0)
+		{
+			continue;
+		}
+
+		FString Error;
+		NumVerified++;
+		if (!VerifyInstanceKeyFrame(InstanceIndex, PlaybackData, OutErrors ? &Error : nullptr))
+		{
+			NumErrors++;
+			if (OutErrors)
+			{
+				OutErrors->Add(MoveTemp(Error));
+			}
+		}
+	}
+
+	if (OutNumVerified)
+	{
+		*OutNumVerified = NumVerified;
+	}
+
+	return NumErrors;
+}
+
+void UPaperZDInstancedSpriteComponent::UpdateFollowTransforms()
+{
+	for (int32 InstanceIndex = 0; InstanceIndex < Slots.Num(); InstanceIndex++)
+	{
+		FInstanceSlot& Slot = Slots[InstanceIndex];
+		if (!Slot.bInUse || Slot.FollowComponent.IsExplicitlyNull())
+		{
+			continue;
+		}
+
+		//The character got destroyed without releasing its instance
+		const USceneComponent* FollowComponent = Slot.FollowComponent.Get();
+		if (!FollowComponent)
+		{
+			ReleaseAnimatedInstance(InstanceIndex);
+			continue;
+		}
+
+		const FTransform WorldTransform = Slot.RelativeTransform * FollowComponent->GetComponentTransform();
+		FTransform CurrentTransform;
+		GetInstanceTransform(InstanceIndex, CurrentTransform, true);
+		if (!CurrentTransform.Equals(WorldTransform))
+		{
+			UpdateInstanceTransform(InstanceIndex, WorldTransform, true, false, true);
+			bInstanceRenderDataDirty = true;
+		}
+	}
+}
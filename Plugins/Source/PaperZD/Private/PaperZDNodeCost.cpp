@@ -0,0 +1,147 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDNodeCost.h"
+
+#if PAPERZD_NODE_COST_ENABLED
+
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<int32> CVarNodeCost(
+	TEXT("paperzd.NodeCost"),
+	1,
+	TEXT("If non zero, AnimInstances running on game worlds (i.e. PIE) measure the cost of each AnimNode, state and transition rule, which the AnimBP editor displays on the graphs."),
+	ECVF_Default);
+
+//////////////////////////////////////////////////////////////////////////
+//// Node cost data
+//////////////////////////////////////////////////////////////////////////
+void FPaperZDNodeCostData::Init(const UPaperZDAnimBPGeneratedClass* AnimClass)
+{
+	const TArray<FPaperZDAnimStateMachine>& StateMachines = AnimClass->GetStateMachines();
+	const int32 NumNodes = AnimClass->GetNumAnimNodes();
+	int32 NumStates = 0;
+	int32 NumRules = 0;
+	for (const FPaperZDAnimStateMachine& StateMachine : StateMachines)
+	{
+		NumStates += StateMachine.Nodes.Num();
+		NumRules += StateMachine.TransitionRules.Num();
+	}
+
+	if (Nodes.Num() == NumNodes && States.Num() == NumStates && Rules.Num() == NumRules && StateOffsets.Num() == StateMachines.Num())
+	{
+		return;
+	}
+
+	Nodes.SetNum(NumNodes);
+	States.SetNum(NumStates);
+	Rules.SetNum(NumRules);
+	StateOffsets.Reset(StateMachines.Num());
+	RuleOffsets.Reset(StateMachines.Num());
+	NumStates = 0;
+	NumRules = 0;
+	for (const FPaperZDAnimStateMachine& StateMachine : StateMachines)
+	{
+		StateOffsets.Add(NumStates);
+		RuleOffsets.Add(NumRules);
+		NumStates += StateMachine.Nodes.Num();
+		NumRules += StateMachine.TransitionRules.Num();
+	}
+
+	Reset();
+}
+
+bool FPaperZDNodeCostData::MatchesLayout(const FPaperZDNodeCostData& Other) const
+{
+	return Nodes.Num() == Other.Nodes.Num() && States.Num() == Other.States.Num() && Rules.Num() == Other.Rules.Num() && StateOffsets == Other.StateOffsets;
+}
+
+void FPaperZDNodeCostData::Merge(const FPaperZDNodeCostData& Other)
+{
+	check(MatchesLayout(Other));
+	auto MergeCounters = [](TArray<FPaperZDCostCounter>& Target, const TArray<FPaperZDCostCounter>& Source)
+	{
+		for (int32 i = 0; i < Target.Num(); i++)
+		{
+			Target[i].Cycles += Source[i].Cycles;
+			Target[i].Count += Source[i].Count;
+			Target[i].NumNotifies += Source[i].NumNotifies;
+			Target[i].NumPassed += Source[i].NumPassed;
+			Target[i].NumTaken += Source[i].NumTaken;
+		}
+	};
+
+	MergeCounters(Nodes, Other.Nodes);
+	MergeCounters(States, Other.States);
+	MergeCounters(Rules, Other.Rules);
+	NumUpdates += Other.NumUpdates;
+}
+
+void FPaperZDNodeCostData::Reset()
+{
+	//Counters are plain data
+	FMemory::Memzero(Nodes.GetData(), Nodes.Num() * sizeof(FPaperZDCostCounter));
+	FMemory::Memzero(States.GetData(), States.Num() * sizeof(FPaperZDCostCounter));
+	FMemory::Memzero(Rules.GetData(), Rules.Num() * sizeof(FPaperZDCostCounter));
+	ActiveStates.Reset();
+	NumUpdates = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//// Node cost capture
+//////////////////////////////////////////////////////////////////////////
+bool FPaperZDNodeCostCapture::ShouldCapture(const UPaperZDAnimInstance* AnimInstance)
+{
+	//Editor previews would pollute the costs measured while playing
+	const UWorld* World = AnimInstance->GetWorld();
+	return CVarNodeCost.GetValueOnGameThread() != 0 && World && World->IsGameWorld();
+}
+
+void FPaperZDNodeCostCapture::ResetAll()
+{
+	for (TObjectIterator<UPaperZDAnimBPGeneratedClass> It; It; ++It)
+	{
+		It->GetNodeCostData().Reset();
+	}
+}
+
+void FPaperZDNodeCostCapture::MergeIntoClass(FPaperZDNodeCostData& InstanceData, UPaperZDAnimBPGeneratedClass* AnimClass)
+{
+	check(IsInGameThread());
+	FPaperZDNodeCostData& ClassData = AnimClass->GetNodeCostData();
+	if (!ClassData.MatchesLayout(InstanceData))
+	{
+		ClassData.Init(AnimClass);
+	}
+
+	//Instances of an outdated layout (class being recompiled) are discarded
+	if (ClassData.MatchesLayout(InstanceData))
+	{
+		ClassData.Merge(InstanceData);
+		ClassData.NumUpdates++;
+	}
+
+	InstanceData.Reset();
+}
+
+void FPaperZDNodeCostCapture::CountNotify(UPaperZDAnimInstance* AnimInstance)
+{
+	if (FPaperZDNodeCostData* CostData = AnimInstance ? AnimInstance->GetNodeCosts() : nullptr)
+	{
+		for (const int32 StateIndex : CostData->ActiveStates)
+		{
+			CostData->States[StateIndex].NumNotifies++;
+		}
+	}
+}
+
+uint64& FPaperZDNodeCostCapture::GetNestedCycles()
+{
+	static thread_local uint64 NestedCycles = 0;
+	return NestedCycles;
+}
+
+#endif
@@ -0,0 +1,372 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDProfiler.h"
+#include "PaperZDAnimInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "UObject/UObjectIterator.h"
+
+CSV_DEFINE_CATEGORY(PaperZD, true);
+
+bool FPaperZDProfiler::bActive = false;
+
+static FAutoConsoleCommand CmdProfile(
+	TEXT("paperzd.Profile"),
+	TEXT("Live aggregate profiler of the PaperZD AnimInstances, per AnimBP class.\n")
+	TEXT("paperzd.Profile Start: starts a new session.\n")
+	TEXT("paperzd.Profile Stop: stops recording, keeping the session data.\n")
+	TEXT("paperzd.Profile Dump [Csv]: prints the session data to the log, optionally writing it to Saved/Profiling/PaperZD."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Command = Args.Num() ? Args[0] : FString();
+		if (Command.Equals(TEXT("Start"), ESearchCase::IgnoreCase))
+		{
+			FPaperZDProfiler::Start();
+		}
+		else if (Command.Equals(TEXT("Stop"), ESearchCase::IgnoreCase))
+		{
+			FPaperZDProfiler::Stop();
+		}
+		else if (Command.Equals(TEXT("Dump"), ESearchCase::IgnoreCase))
+		{
+			FPaperZDProfiler::Dump(Args.Num() > 1 && Args[1].Equals(TEXT("Csv"), ESearchCase::IgnoreCase));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: paperzd.Profile Start|Stop|Dump [Csv]"));
+		}
+	}));
+
+namespace FPaperZDProfilerHelpers
+{
+	/* Tick costs are kept on a histogram with 4 buckets per power of two cycles, so the p99 is known within a 25% error without storing every sample. */
+	constexpr int32 NumCostBuckets = 64 * 4;
+
+	int32 GetCostBucket(uint64 Cycles)
+	{
+		if (Cycles < 4)
+		{
+			return static_cast<int32>(Cycles);
+		}
+
+		const int32 Octave = static_cast<int32>(FMath::FloorLog2_64(Cycles));
+		const int32 SubBucket = static_cast<int32>((Cycles >> (Octave - 2)) & 3);
+		return FMath::Min(Octave * 4 + SubBucket, NumCostBuckets - 1);
+	}
+
+	/* Highest amount of cycles that falls into the given bucket. */
+	uint64 GetCostBucketLimit(int32 Bucket)
+	{
+		//Below 4 cycles every bucket holds a single value, buckets 4 to 7 are never used
+		if (Bucket < 8)
+		{
+			return Bucket;
+		}
+
+		const int32 Octave = Bucket / 4;
+		const uint64 SubBucket = Bucket & 3;
+		return ((5 + SubBucket) << (Octave - 2)) - 1;
+	}
+
+	/* Counters that get merged both per frame (for the CSV profiler) and per session. */
+	struct FCounters
+	{
+		int64 NumTicks = 0;
+		uint64 TickCycles = 0;
+		int64 RuleEvaluations = 0;
+		int64 NotifiesFired = 0;
+		int64 BlueprintCalls = 0;
+		int64 FlipbookSwaps = 0;
+
+		void Accumulate(const FCounters& Other)
+		{
+			NumTicks += Other.NumTicks;
+			TickCycles += Other.TickCycles;
+			RuleEvaluations += Other.RuleEvaluations;
+			NotifiesFired += Other.NotifiesFired;
+			BlueprintCalls += Other.BlueprintCalls;
+			FlipbookSwaps += Other.FlipbookSwaps;
+		}
+	};
+
+	/* Data recorded for a single AnimBP class. */
+	struct FClassCounters
+	{
+		/* Since the session started. */
+		FCounters Session;
+
+		/* Since the last end of frame, only used by the CSV profiler. */
+		FCounters Frame;
+
+		/* Tick cost histogram of the session. */
+		uint32 CostHistogram[NumCostBuckets] = {};
+	};
+
+	/**
+	 * Counters owned by a single thread, keyed by AnimBP class name so no class pointer is kept alive after a recompile.
+	 * Only its thread writes to it. Merging happens on the game thread in between frames, when no parallel update is running.
+	 */
+	struct FThreadCounters
+	{
+		TMap<FName, FClassCounters> Classes;
+	};
+
+	/* Every thread that ever recorded, kept until shutdown since threads never tell when they finish. */
+	FCriticalSection RegistryLock;
+	TArray<TUniquePtr<FThreadCounters>> Registry;
+	thread_local FThreadCounters* LocalCounters = nullptr;
+
+	/* Session timing. */
+	double SessionStartTime = 0.0;
+	double SessionStopTime = 0.0;
+	FDelegateHandle EndFrameHandle;
+
+	FClassCounters& GetLocalClassCounters(const UObject* AnimInstance)
+	{
+		if (!LocalCounters)
+		{
+			FScopeLock Lock(&RegistryLock);
+			LocalCounters = Registry.Add_GetRef(MakeUnique<FThreadCounters>()).Get();
+		}
+
+		return LocalCounters->Classes.FindOrAdd(AnimInstance->GetClass()->GetFName());
+	}
+
+	/* Session data of a single class after merging every thread. */
+	struct FClassReport
+	{
+		FName ClassName;
+		int32 NumInstances = 0;
+		FCounters Counters;
+		uint32 CostHistogram[NumCostBuckets] = {};
+
+		uint64 GetPercentileCycles(float Percentile) const
+		{
+			uint64 NumSamples = 0;
+			for (uint32 Count : CostHistogram)
+			{
+				NumSamples += Count;
+			}
+
+			const uint64 TargetSample = static_cast<uint64>(FMath::CeilToDouble(NumSamples * Percentile));
+			uint64 CumulativeSamples = 0;
+			for (int32 Bucket = 0; Bucket < NumCostBuckets; Bucket++)
+			{
+				CumulativeSamples += CostHistogram[Bucket];
+				if (CumulativeSamples >= TargetSample && CumulativeSamples > 0)
+				{
+					return GetCostBucketLimit(Bucket);
+				}
+			}
+
+			return 0;
+		}
+	};
+
+	TArray<FClassReport> BuildReports()
+	{
+		TMap<FName, FClassReport> Reports;
+		{
+			FScopeLock Lock(&RegistryLock);
+			for (const TUniquePtr<FThreadCounters>& ThreadCounters : Registry)
+			{
+				for (const TPair<FName, FClassCounters>& Pair : ThreadCounters->Classes)
+				{
+					FClassReport& Report = Reports.FindOrAdd(Pair.Key);
+					Report.ClassName = Pair.Key;
+					Report.Counters.Accumulate(Pair.Value.Session);
+					for (int32 Bucket = 0; Bucket < NumCostBuckets; Bucket++)
+					{
+						Report.CostHistogram[Bucket] += Pair.Value.CostHistogram[Bucket];
+					}
+				}
+			}
+		}
+
+		//Live instances are only counted when dumping, nothing needs to be tracked on creation or destruction
+		for (TObjectIterator<UPaperZDAnimInstance> It; It; ++It)
+		{
+			if (!It->HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+			{
+				const FName ClassName = It->GetClass()->GetFName();
+				FClassReport& Report = Reports.FindOrAdd(ClassName);
+				Report.ClassName = ClassName;
+				Report.NumInstances++;
+			}
+		}
+
+		TArray<FClassReport> SortedReports;
+		Reports.GenerateValueArray(SortedReports);
+		SortedReports.Sort([](const FClassReport& A, const FClassReport& B) { return A.Counters.TickCycles > B.Counters.TickCycles; });
+		return SortedReports;
+	}
+
+	/* Sends the counters of the frame to the CSV profiler, one stat per class and counter. */
+	void RecordCsvFrame()
+	{
+#if CSV_PROFILER
+		//Frame counters are reset even when not capturing, so a capture started mid session doesn't get a spike on its first frame
+		TMap<FName, FCounters> FrameCounters;
+		{
+			FScopeLock Lock(&RegistryLock);
+			for (const TUniquePtr<FThreadCounters>& ThreadCounters : Registry)
+			{
+				for (TPair<FName, FClassCounters>& Pair : ThreadCounters->Classes)
+				{
+					FrameCounters.FindOrAdd(Pair.Key).Accumulate(Pair.Value.Frame);
+					Pair.Value.Frame = FCounters();
+				}
+			}
+		}
+
+		if (!FCsvProfiler::Get()->IsCapturing() || !FCsvProfiler::Get()->IsCategoryEnabled(CSV_CATEGORY_INDEX(PaperZD)))
+		{
+			return;
+		}
+
+		for (const TPair<FName, FCounters>& Pair : FrameCounters)
+		{
+			const FString ClassName = Pair.Key.ToString();
+			const FCounters& Counters = Pair.Value;
+			const ECsvCustomStatOp Op = ECsvCustomStatOp::Set;
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/Updates"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(Counters.NumTicks), Op);
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/TickMs"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(FPlatformTime::ToMilliseconds64(Counters.TickCycles)), Op);
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/RuleEvaluations"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(Counters.RuleEvaluations), Op);
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/Notifies"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(Counters.NotifiesFired), Op);
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/BlueprintCalls"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(Counters.BlueprintCalls), Op);
+			FCsvProfiler::RecordCustomStat(ClassName + TEXT("/FlipbookSwaps"), CSV_CATEGORY_INDEX(PaperZD), static_cast<float>(Counters.FlipbookSwaps), Op);
+		}
+#endif
+	}
+}
+
+void FPaperZDProfiler::Start()
+{
+	using namespace FPaperZDProfilerHelpers;
+	check(IsInGameThread());
+
+	//Threads only write to their counters while updating animations, which doesn't overlap with the console commands
+	{
+		FScopeLock Lock(&RegistryLock);
+		for (const TUniquePtr<FThreadCounters>& ThreadCounters : Registry)
+		{
+			ThreadCounters->Classes.Reset();
+		}
+	}
+
+	if (!EndFrameHandle.IsValid())
+	{
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&RecordCsvFrame);
+	}
+
+	SessionStartTime = FPlatformTime::Seconds();
+	bActive = true;
+	UE_LOG(LogTemp, Display, TEXT("PaperZD profiler started."));
+}
+
+void FPaperZDProfiler::Stop()
+{
+	using namespace FPaperZDProfilerHelpers;
+	check(IsInGameThread());
+
+	if (bActive)
+	{
+		bActive = false;
+		SessionStopTime = FPlatformTime::Seconds();
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+		UE_LOG(LogTemp, Display, TEXT("PaperZD profiler stopped after %.2f seconds."), SessionStopTime - SessionStartTime);
+	}
+}
+
+void FPaperZDProfiler::Dump(bool bWriteCsvFile /* = false */)
+{
+	using namespace FPaperZDProfilerHelpers;
+	check(IsInGameThread());
+
+	const double SessionSeconds = FMath::Max((bActive ? FPlatformTime::Seconds() : SessionStopTime) - SessionStartTime, UE_SMALL_NUMBER);
+	const TArray<FClassReport> Reports = BuildReports();
+
+	FString Csv = TEXT("Class,Instances,Updates,AvgTickUs,P99TickUs,RuleEvaluationsPerSec,NotifiesPerSec,BlueprintCallsPerTick,FlipbookSwaps\n");
+	UE_LOG(LogTemp, Display, TEXT("PaperZD profile, %.2f seconds%s:"), SessionSeconds, bActive ? TEXT(" (still recording)") : TEXT(""));
+	UE_LOG(LogTemp, Display, TEXT("%-48s %9s %10s %10s %10s %12s %12s %10s %10s"), TEXT("Class"), TEXT("Instances"), TEXT("Updates"), TEXT("Avg us"), TEXT("P99 us"), TEXT("Rules/s"), TEXT("Notifies/s"), TEXT("BP/tick"), TEXT("Swaps"));
+	for (const FClassReport& Report : Reports)
+	{
+		const FCounters& Counters = Report.Counters;
+		const double NumTicks = FMath::Max<double>(Counters.NumTicks, 1.0);
+		const double AvgTickUs = FPlatformTime::ToMilliseconds64(Counters.TickCycles) * 1000.0 / NumTicks;
+		const double P99TickUs = Counters.NumTicks ? FPlatformTime::ToMilliseconds64(Report.GetPercentileCycles(0.99f)) * 1000.0 : 0.0;
+		const double RulesPerSecond = Counters.RuleEvaluations / SessionSeconds;
+		const double NotifiesPerSecond = Counters.NotifiesFired / SessionSeconds;
+		const double BlueprintCallsPerTick = Counters.BlueprintCalls / NumTicks;
+
+		UE_LOG(LogTemp, Display, TEXT("%-48s %9d %10lld %10.2f %10.2f %12.1f %12.1f %10.2f %10lld"), *Report.ClassName.ToString(), Report.NumInstances, Counters.NumTicks,
+			AvgTickUs, P99TickUs, RulesPerSecond, NotifiesPerSecond, BlueprintCallsPerTick, Counters.FlipbookSwaps);
+		Csv += FString::Printf(TEXT("%s,%d,%lld,%f,%f,%f,%f,%f,%lld\n"), *Report.ClassName.ToString(), Report.NumInstances, Counters.NumTicks,
+			AvgTickUs, P99TickUs, RulesPerSecond, NotifiesPerSecond, BlueprintCallsPerTick, Counters.FlipbookSwaps);
+	}
+
+	if (bWriteCsvFile)
+	{
+		const FString FilePath = FPaths::ProfilingDir() / TEXT("PaperZD") / FString::Printf(TEXT("PaperZDProfile_%s.csv"), *FDateTime::Now().ToString());
+		if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+		{
+			UE_LOG(LogTemp, Display, TEXT("PaperZD profile written to '%s'."), *FilePath);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("Couldn't write the PaperZD profile to '%s'."), *FilePath);
+		}
+	}
+}
+
+void FPaperZDProfiler::RecordTickInternal(const UObject* AnimInstance, uint64 Cycles)
+{
+	FPaperZDProfilerHelpers::FClassCounters& Counters = FPaperZDProfilerHelpers::GetLocalClassCounters(AnimInstance);
+	Counters.Session.NumTicks++;
+	Counters.Session.TickCycles += Cycles;
+	Counters.Frame.NumTicks++;
+	Counters.Frame.TickCycles += Cycles;
+	Counters.CostHistogram[FPaperZDProfilerHelpers::GetCostBucket(Cycles)]++;
+}
+
+void FPaperZDProfiler::CountRuleEvaluationsInternal(const UObject* AnimInstance, int32 NumEvaluations)
+{
+	FPaperZDProfilerHelpers::FClassCounters& Counters = FPaperZDProfilerHelpers::GetLocalClassCounters(AnimInstance);
+	Counters.Session.RuleEvaluations += NumEvaluations;
+	Counters.Frame.RuleEvaluations += NumEvaluations;
+}
+
+void FPaperZDProfiler::CountNotifyFiredInternal(const UObject* AnimInstance)
+{
+	FPaperZDProfilerHelpers::FClassCounters& Counters = FPaperZDProfilerHelpers::GetLocalClassCounters(AnimInstance);
+	Counters.Session.NotifiesFired++;
+	Counters.Frame.NotifiesFired++;
+}
+
+void FPaperZDProfiler::CountBlueprintCallInternal(const UObject* AnimInstance)
+{
+	FPaperZDProfilerHelpers::FClassCounters& Counters = FPaperZDProfilerHelpers::GetLocalClassCounters(AnimInstance);
+	Counters.Session.BlueprintCalls++;
+	Counters.Frame.BlueprintCalls++;
+}
+
+void FPaperZDProfiler::CountBlueprintEventInternal(const UObject* AnimInstance, FName EventName)
+{
+	if (AnimInstance->GetClass()->IsFunctionImplementedInScript(EventName))
+	{
+		CountBlueprintCallInternal(AnimInstance);
+	}
+}
+
+void FPaperZDProfiler::CountFlipbookSwapInternal(const UObject* AnimInstance)
+{
+	FPaperZDProfilerHelpers::FClassCounters& Counters = FPaperZDProfilerHelpers::GetLocalClassCounters(AnimInstance);
+	Counters.Session.FlipbookSwaps++;
+	Counters.Frame.FlipbookSwaps++;
+}
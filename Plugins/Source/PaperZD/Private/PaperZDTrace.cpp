@@ -0,0 +1,165 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDTrace.h"
+
+#if PAPERZD_TRACE_ENABLED
+
+#include "PaperZDAnimInstance.h"
+#include "Notifies/PaperZDAnimNotify_Base.h"
+#include "PaperFlipbook.h"
+#include "GameFramework/Actor.h"
+#include "HAL/PlatformTime.h"
+
+UE_TRACE_CHANNEL_DEFINE(PaperZDChannel);
+
+UE_TRACE_EVENT_BEGIN(PaperZD, Instance)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, ClassName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, OwnerName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, StateEntered)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, MachineName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, StateName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, StateExited)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, MachineName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, StateName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, Transition)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, MachineName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, FromStateName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, ToStateName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, RuleEvaluations)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, MachineName)
+	UE_TRACE_EVENT_FIELD(int32, NumEvaluations)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, NotifyFired)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, InstanceId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, NotifyName)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, NotifyClassName)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(PaperZD, FlipbookSwap)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ComponentId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, FlipbookName)
+UE_TRACE_EVENT_END()
+
+namespace FPaperZDTraceHelpers
+{
+	/* Ids are the object index, which stays valid for the lifetime of the object. */
+	FORCEINLINE uint32 GetObjectId(const UObject* Object)
+	{
+		return Object ? static_cast<uint32>(Object->GetUniqueID()) : 0;
+	}
+}
+
+void FPaperZDTrace::BeginScope(FName Name)
+{
+	FCpuProfilerTrace::OutputBeginDynamicEvent(*Name.ToString());
+}
+
+void FPaperZDTrace::EndScope()
+{
+	FCpuProfilerTrace::OutputEndEvent();
+}
+
+void FPaperZDTrace::OutputInstance(const UPaperZDAnimInstance* AnimInstance)
+{
+	const FString ClassName = AnimInstance->GetClass()->GetName();
+	const AActor* Owner = AnimInstance->GetOwningActor();
+	const FString OwnerName = Owner ? Owner->GetName() : FString();
+	UE_TRACE_LOG(PaperZD, Instance, PaperZDChannel)
+		<< Instance.Cycle(FPlatformTime::Cycles64())
+		<< Instance.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< Instance.ClassName(*ClassName, ClassName.Len())
+		<< Instance.OwnerName(*OwnerName, OwnerName.Len());
+}
+
+void FPaperZDTrace::OutputStateEntered(const UObject* AnimInstance, FName MachineName, FName StateName)
+{
+	const FString Machine = MachineName.ToString();
+	const FString State = StateName.ToString();
+	UE_TRACE_LOG(PaperZD, StateEntered, PaperZDChannel)
+		<< StateEntered.Cycle(FPlatformTime::Cycles64())
+		<< StateEntered.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< StateEntered.MachineName(*Machine, Machine.Len())
+		<< StateEntered.StateName(*State, State.Len());
+}
+
+void FPaperZDTrace::OutputStateExited(const UObject* AnimInstance, FName MachineName, FName StateName)
+{
+	const FString Machine = MachineName.ToString();
+	const FString State = StateName.ToString();
+	UE_TRACE_LOG(PaperZD, StateExited, PaperZDChannel)
+		<< StateExited.Cycle(FPlatformTime::Cycles64())
+		<< StateExited.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< StateExited.MachineName(*Machine, Machine.Len())
+		<< StateExited.StateName(*State, State.Len());
+}
+
+void FPaperZDTrace::OutputTransition(const UObject* AnimInstance, FName MachineName, FName FromStateName, FName ToStateName)
+{
+	const FString Machine = MachineName.ToString();
+	const FString FromState = FromStateName.ToString();
+	const FString ToState = ToStateName.ToString();
+	UE_TRACE_LOG(PaperZD, Transition, PaperZDChannel)
+		<< Transition.Cycle(FPlatformTime::Cycles64())
+		<< Transition.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< Transition.MachineName(*Machine, Machine.Len())
+		<< Transition.FromStateName(*FromState, FromState.Len())
+		<< Transition.ToStateName(*ToState, ToState.Len());
+}
+
+void FPaperZDTrace::OutputRuleEvaluations(const UObject* AnimInstance, FName MachineName, int32 NumEvaluations)
+{
+	const FString Machine = MachineName.ToString();
+	UE_TRACE_LOG(PaperZD, RuleEvaluations, PaperZDChannel)
+		<< RuleEvaluations.Cycle(FPlatformTime::Cycles64())
+		<< RuleEvaluations.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< RuleEvaluations.MachineName(*Machine, Machine.Len())
+		<< RuleEvaluations.NumEvaluations(NumEvaluations);
+}
+
+void FPaperZDTrace::OutputNotifyFired(const UPaperZDAnimInstance* AnimInstance, const UPaperZDAnimNotify_Base* Notify)
+{
+	OutputNotifyFired(AnimInstance, Notify->GetDisplayName(), Notify->GetClass());
+}
+
+void FPaperZDTrace::OutputNotifyFired(const UPaperZDAnimInstance* AnimInstance, FName InNotifyName, const UClass* NotifyClass)
+{
+	const FString NotifyName = InNotifyName.ToString();
+	const FString NotifyClassName = NotifyClass->GetName();
+	UE_TRACE_LOG(PaperZD, NotifyFired, PaperZDChannel)
+		<< NotifyFired.Cycle(FPlatformTime::Cycles64())
+		<< NotifyFired.InstanceId(FPaperZDTraceHelpers::GetObjectId(AnimInstance))
+		<< NotifyFired.NotifyName(*NotifyName, NotifyName.Len())
+		<< NotifyFired.NotifyClassName(*NotifyClassName, NotifyClassName.Len());
+}
+
+void FPaperZDTrace::OutputFlipbookSwap(const UObject* RenderComponent, const UPaperFlipbook* Flipbook)
+{
+	const FString FlipbookName = GetNameSafe(Flipbook);
+	UE_TRACE_LOG(PaperZD, FlipbookSwap, PaperZDChannel)
+		<< FlipbookSwap.Cycle(FPlatformTime::Cycles64())
+		<< FlipbookSwap.ComponentId(FPaperZDTraceHelpers::GetObjectId(RenderComponent))
+		<< FlipbookSwap.FlipbookName(*FlipbookName, FlipbookName.Len());
+}
+
+#endif
@@ -148,7 +148,7 @@ namespace ZD
 
 				// If the playback status is jumping, ie. one such occurrence is setting the time for thumbnail generation, disable anim notifies updates because it could fire audio
  				const bool bFireNotifies = !bPreviewPlayback || (PlayerStatus != EMovieScenePlayerStatus::Jumping && PlayerStatus != EMovieScenePlayerStatus::Stopped);
-				AnimInstance->GetPlayer()->SetIsPreviewPlayer(bPreviewPlayback);
+				AnimInstance->GetPlayerState().SetIsPreviewPlayer(bPreviewPlayback);
 
 				//Start collecting the animations into the final playback data structure
 				FPaperZDAnimationPlaybackData PlaybackData;
@@ -157,14 +157,14 @@ namespace ZD
 					//Process the notifies if needed
 					if (bFireNotifies)
 					{
-						AnimInstance->GetPlayer()->ProcessAnimSequenceNotifies(Params.SequencePtr.Get(), Params.PreviousEvalTime, Params.EvalTime, Params.Weight, AnimInstance); 
+						AnimInstance->GetPlayerState().ProcessAnimSequenceNotifies(Params.SequencePtr.Get(), Params.PreviousEvalTime, Params.EvalTime, Params.Weight, AnimInstance); 
 					}
 
 					PlaybackData.AddAnimation(Params.SequencePtr.Get(), Params.EvalTime, Params.Weight);
 				}
 
 				//Request the player to play the animations. The logic of how to render is inside the handles
-				AnimInstance->GetPlayer()->Play(PlaybackData);
+				AnimInstance->GetPlayerState().Play(PlaybackData);
 			}
 		}
 	};
@@ -0,0 +1,108 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "PaperZDInstancedSpriteComponent.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle_InstancedSprite.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "AnimSequences/PaperZDAnimSequence_Flipbook.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FPaperZDInstancedSpriteTestHelpers
+{
+	/* Creates a transient flipbook with the given number of single frame keyframes, each with its own sprite. */
+	UPaperFlipbook* CreateFlipbook(int32 NumKeyFrames, float FramesPerSecond)
+	{
+		UPaperFlipbook* Flipbook = NewObject<UPaperFlipbook>(GetTransientPackage(), NAME_None, RF_Transient);
+		FScopedFlipbookMutator Mutator(Flipbook);
+		Mutator.FramesPerSecond = FramesPerSecond;
+		for (int32 i = 0; i < NumKeyFrames; i++)
+		{
+			FPaperFlipbookKeyFrame& KeyFrame = Mutator.KeyFrames.AddDefaulted_GetRef();
+			KeyFrame.Sprite = NewObject<UPaperSprite>(GetTransientPackage(), NAME_None, RF_Transient);
+			KeyFrame.FrameRun = 1;
+		}
+
+		return Flipbook;
+	}
+
+	/* Creates a transient, non directional, flipbook sequence that plays the given flipbook. */
+	UPaperZDAnimSequence_Flipbook* CreateSequence(UPaperFlipbook* Flipbook)
+	{
+		//The data source is private, but always holds one entry after initialization
+		UPaperZDAnimSequence_Flipbook* Sequence = NewObject<UPaperZDAnimSequence_Flipbook>(GetTransientPackage(), NAME_None, RF_Transient);
+		FArrayProperty* DataSourceProperty = Sequence->GetAnimDataSourceProperty();
+		FScriptArrayHelper ArrayHelper(DataSourceProperty, DataSourceProperty->ContainerPtrToValuePtr<uint8>(Sequence));
+		CastFieldChecked<FObjectProperty>(DataSourceProperty->Inner)->SetObjectPropertyValue(ArrayHelper.GetRawPtr(0), Flipbook);
+		return Sequence;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPaperZDInstancedSpriteKeyFramesTest, "PaperZD.InstancedSprite.KeyFrames", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FPaperZDInstancedSpriteKeyFramesTest::RunTest(const FString& Parameters)
+{
+	using namespace FPaperZDInstancedSpriteTestHelpers;
+	const int32 NumInstances = 64;
+	const int32 NumKeyFrames = 8;
+	const float FramesPerSecond = 10.0f;
+
+	//Two sequences, so the instances also swap flipbooks halfway through
+	UPaperFlipbook* Flipbooks[2] = { CreateFlipbook(NumKeyFrames, FramesPerSecond), CreateFlipbook(NumKeyFrames, FramesPerSecond) };
+	UPaperZDAnimSequence_Flipbook* Sequences[2] = { CreateSequence(Flipbooks[0]), CreateSequence(Flipbooks[1]) };
+
+	//Nothing gets registered with a world or rendered, the whole check runs on the CPU and works under NullRHI
+	UPaperZDInstancedSpriteComponent* InstancedSprite = NewObject<UPaperZDInstancedSpriteComponent>(GetTransientPackage(), NAME_None, RF_Transient);
+	TArray<UPaperZDPlaybackHandle_InstancedSprite*> Handles;
+	for (int32 i = 0; i < NumInstances; i++)
+	{
+		UPaperZDPlaybackHandle_InstancedSprite* Handle = NewObject<UPaperZDPlaybackHandle_InstancedSprite>(GetTransientPackage(), NAME_None, RF_Transient);
+		Handle->ConfigureRenderComponent(InstancedSprite);
+		Handles.Add(Handle);
+	}
+	TestEqual(TEXT("Registered instances"), InstancedSprite->GetNumAnimatedInstances(), NumInstances);
+
+	//Every instance plays at its own time, across a few steps that cross keyframe and flipbook boundaries
+	const float Duration = Flipbooks[0]->GetTotalDuration();
+	for (int32 Step = 0; Step < 4; Step++)
+	{
+		TArray<FPaperZDAnimationPlaybackData> PlaybackData;
+		PlaybackData.SetNum(NumInstances);
+		for (int32 i = 0; i < NumInstances; i++)
+		{
+			const float Time = FMath::Fmod((i + Step * 3) * 0.37f, Duration);
+			PlaybackData[i].SetAnimation(Sequences[(i + Step) % 2], Time);
+			Handles[i]->UpdateRenderPlayback(InstancedSprite, PlaybackData[i]);
+		}
+
+		for (int32 i = 0; i < NumInstances; i++)
+		{
+			FString Error;
+			if (!InstancedSprite->VerifyInstanceKeyFrame(Handles[i]->GetInstanceIndex(), PlaybackData[i], &Error))
+			{
+				AddError(FString::Printf(TEXT("Step %d: %s"), Step, *Error));
+			}
+		}
+	}
+
+	//The verification must catch an instance that didn't receive the playback it should be displaying
+	FPaperZDAnimationPlaybackData StalePlayback;
+	StalePlayback.SetAnimation(Sequences[0], 0.0f);
+	Handles[0]->UpdateRenderPlayback(InstancedSprite, StalePlayback);
+
+	FPaperZDAnimationPlaybackData ExpectedPlayback;
+	ExpectedPlayback.SetAnimation(Sequences[0], (NumKeyFrames - 1) / FramesPerSecond);
+	TestFalse(TEXT("Stale instance detected"), InstancedSprite->VerifyInstanceKeyFrame(Handles[0]->GetInstanceIndex(), ExpectedPlayback));
+
+	//Released instances stop being valid
+	const int32 ReleasedIndex = Handles[1]->GetInstanceIndex();
+	Handles[1]->ConditionalBeginDestroy();
+	TestFalse(TEXT("Released instance is invalid"), InstancedSprite->IsAnimatedInstanceValid(ReleasedIndex));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -2,6 +2,8 @@
 
 #pragma once
 #include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "UObject/UnrealType.h"
+#include "PaperZDNodeCost.h"
 #include "PaperZDAnimNode_Base.generated.h"
 
 struct FPaperZDAnimNode_Base;
@@ -113,12 +115,139 @@ public:
 	void Evaluate(FPaperZDAnimationPlaybackData& OutputData);
  };
 
+ /**
+  * Conversion applied when copying a fast-path binding.
+  */
+UENUM()
+enum class EPaperZDExposedValueCopyType : uint8
+{
+	/* Plain old data of the same type, copied as raw memory. */
+	MemCopy,
+
+	/* Boolean copy, respects bitfield masks on both ends. */
+	BoolCopy,
+
+	/* Same type, but the property requires its own copy operator. */
+	ComplexCopy,
+
+	/* Blueprint float (double) written into a native float. */
+	DoubleToFloat,
+
+	/* Native float written into a double. */
+	FloatToDouble
+};
+
+/**
+ * Copy of a single AnimInstance member variable into a node property, done directly without going through the blueprint VM.
+ * Only names are serialized, offsets are resolved when the class initializes as the class layout can change without a recompile.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDExposedValueCopyRecord
+{
+	GENERATED_BODY()
+
+	/* Name of the AnimInstance property we read from. */
+	UPROPERTY()
+	FName SourcePropertyName;
+
+	/* Name of the property inside the node struct we write to. */
+	UPROPERTY()
+	FName DestPropertyName;
+
+	/* Index into the destination property, if it is an array. */
+	UPROPERTY()
+	int32 DestArrayIndex;
+
+	/* Conversion to use when copying. */
+	UPROPERTY()
+	EPaperZDExposedValueCopyType CopyType;
+
+private:
+	/* Resolved source property. */
+	FProperty* SourceProperty;
+
+	/* Resolved destination property, the inner property if the destination is an array. */
+	FProperty* DestValueProperty;
+
+	/* Destination array, if any. */
+	FArrayProperty* DestArrayProperty;
+
+	/* Offset from the AnimInstance to the source value. */
+	int32 SourceOffset;
+
+	/* Offset from the AnimInstance to the destination value (or array). */
+	int32 DestOffset;
+
+	/* Amount of bytes to copy on MemCopy. */
+	int32 Size;
+
+public:
+	//ctor
+	FPaperZDExposedValueCopyRecord()
+		: SourcePropertyName(NAME_None)
+		, DestPropertyName(NAME_None)
+		, DestArrayIndex(INDEX_NONE)
+		, CopyType(EPaperZDExposedValueCopyType::MemCopy)
+		, SourceProperty(nullptr)
+		, DestValueProperty(nullptr)
+		, DestArrayProperty(nullptr)
+		, SourceOffset(INDEX_NONE)
+		, DestOffset(INDEX_NONE)
+		, Size(0)
+	{}
+
+	/* Resolves the offsets for the given class and node property, returns false if the record cannot be used. */
+	bool Initialize(UClass* InClass, const FStructProperty* NodeProperty);
+
+	/* Applies the copy on the given AnimInstance. Must be initialized. */
+	void Copy(UObject* AnimInstance) const
+	{
+		const uint8* SourcePtr = reinterpret_cast<const uint8*>(AnimInstance) + SourceOffset;
+		uint8* DestPtr = reinterpret_cast<uint8*>(AnimInstance) + DestOffset;
+		if (DestArrayProperty)
+		{
+			FScriptArrayHelper ArrayHelper(DestArrayProperty, DestPtr);
+			if (!ArrayHelper.IsValidIndex(DestArrayIndex))
+			{
+				return;
+			}
+			DestPtr = ArrayHelper.GetRawPtr(DestArrayIndex);
+		}
+
+		switch (CopyType)
+		{
+			case EPaperZDExposedValueCopyType::MemCopy:
+				FMemory::Memcpy(DestPtr, SourcePtr, Size);
+				break;
+			case EPaperZDExposedValueCopyType::BoolCopy:
+				static_cast<FBoolProperty*>(DestValueProperty)->SetPropertyValue(DestPtr, static_cast<FBoolProperty*>(SourceProperty)->GetPropertyValue(SourcePtr));
+				break;
+			case EPaperZDExposedValueCopyType::ComplexCopy:
+				DestValueProperty->CopySingleValue(DestPtr, SourcePtr);
+				break;
+			case EPaperZDExposedValueCopyType::DoubleToFloat:
+				*reinterpret_cast<float*>(DestPtr) = static_cast<float>(*reinterpret_cast<const double*>(SourcePtr));
+				break;
+			case EPaperZDExposedValueCopyType::FloatToDouble:
+				*reinterpret_cast<double*>(DestPtr) = static_cast<double>(*reinterpret_cast<const float*>(SourcePtr));
+				break;
+		}
+	}
+
+	/* Obtains the copy operation needed to go from the source to the destination property, returns false if they cannot be copied directly. */
+	static bool GetCopyType(const FProperty* InSourceProperty, const FProperty* InDestProperty, EPaperZDExposedValueCopyType& OutCopyType);
+};
+
  // An exposed value updater
 USTRUCT()
 struct PAPERZD_API FPaperZDExposedValueHandler
 {
 	GENERATED_BODY()
 
+	/* Direct copies that don't need to go through the bound function. */
+	UPROPERTY()
+	TArray<FPaperZDExposedValueCopyRecord> CopyRecords;
+
 	/* The function to call to update associated properties (can be NULL). */
 	UPROPERTY()
 	FName BoundFunction;
@@ -165,9 +294,23 @@ struct PAPERZD_API FPaperZDAnimNode_Base
 	//Friendship for initial setup
 	friend struct FPaperZDExposedValueHandler;
 
+	//Friendship for the linear execution of the graph
+	friend struct FPaperZDAnimProgram;
+
+	//Friendship for caching the node struct
+	friend class UPaperZDAnimBPGeneratedClass;
+
 	/* Pointer to the value handler that is responsible of updating the internal values by calling the generated functions. */
 	FPaperZDExposedValueHandler* ExposedValueHandler;
 
+	/* Struct of this node, set on the class default object and copied to every instance. Names the node scopes on the trace. */
+	const UScriptStruct* NodeStruct;
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* LinkID of this node, set on the class default object and copied to every instance. Indexes the measured costs. */
+	int32 NodeLinkID;
+#endif
+
 public:
 	//ctor
 	FPaperZDAnimNode_Base();
@@ -182,6 +325,17 @@ public:
 	/* Evaluates the node data to obtain the final Animation Data structure to be output. */
 	void Evaluate(FPaperZDAnimationPlaybackData& OutAnimationData);
 
+	/**
+	 * True if the node can be updated and evaluated outside of the game thread.
+	 * Nodes that call into blueprint logic, or touch shared global state, should return false so the AnimInstance falls back to a game thread update.
+	 * Exposed value handlers are checked by the class itself, fast-path copies can run on any thread but bound functions keep the graph on the game thread.
+	 */
+	virtual bool CanUpdateInWorkerThread(const UPaperZDAnimBPGeneratedClass* AnimClass) const { return true; }
+
+private:
+	/* Runs the exposed value handler if any. */
+	void UpdateExposedValues(const FPaperZDAnimationBaseContext& Context);
+
 protected:
 	/* Initialize method for the AnimNode, called once when the AnimInstance initializes itself. */
 	virtual void OnInitialize(const FPaperZDAnimationInitContext& Context) {}
@@ -20,6 +20,9 @@ struct PAPERZD_API FPaperZDAnimNode_LayerAnimations : public FPaperZDAnimNode_Ba
 	UPROPERTY(EditAnywhere, EditFixedSize, Category = "Input", meta = (PinShownByDefault, UIMin = "0.0", ClampMin = "0.0", UIMax = "1.0", ClampMax = "1.0"))
 	TArray<float> LayerWeight;
 
+	/* Scratch data used to evaluate each layer, kept around so it doesn't allocate every evaluation. */
+	FPaperZDAnimationPlaybackData LayerData;
+
 public:
 	//ctor
 	FPaperZDAnimNode_LayerAnimations();
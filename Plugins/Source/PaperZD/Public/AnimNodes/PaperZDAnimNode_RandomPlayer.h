@@ -48,6 +48,45 @@ struct FPaperZDRandomPlayerEntry
 	{}
 };
 
+/**
+ * Data of a random player that never changes at runtime.
+ * Baked once onto the generated class when compiling, so every AnimInstance shares it instead of holding its own copy.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDRandomPlayerData
+{
+	GENERATED_BODY()
+
+	/* Sequences to choose from. */
+	UPROPERTY()
+	TArray<FPaperZDRandomPlayerEntry> Entries;
+
+	/* Indices of the entries, ordered by decreasing play chance. */
+	UPROPERTY()
+	TArray<int32> ChanceOrder;
+
+	/* The sum of all the play chances. */
+	UPROPERTY()
+	float AggregatedChance;
+
+	/* If true, each instance plays every entry once, on its own shuffled order, before looping. */
+	UPROPERTY()
+	bool bShuffleMode;
+
+public:
+	//ctor
+	FPaperZDRandomPlayerData()
+		: AggregatedChance(0.0f)
+		, bShuffleMode(false)
+	{}
+
+	/* Bakes the given entries, precomputing the order in which their chances are checked. */
+	void Init(const TArray<FPaperZDRandomPlayerEntry>& InEntries, bool bInShuffleMode);
+
+	/* Obtain the memory allocated by this data. */
+	SIZE_T GetAllocatedSize() const { return Entries.GetAllocatedSize() + ChanceOrder.GetAllocatedSize(); }
+};
+
 /**
  * Plays sequences randomly by choosing from a provided list.
  */
@@ -56,6 +95,7 @@ struct PAPERZD_API FPaperZDAnimNode_RandomPlayer : public FPaperZDAnimNode_Base
 {
 	GENERATED_BODY()
 
+#if WITH_EDITORONLY_DATA
 	/* Animation sequence to play. */
 	UPROPERTY(EditAnywhere, Category = "Settings")
 	TArray<FPaperZDRandomPlayerEntry> Entries;	
@@ -63,6 +103,14 @@ struct PAPERZD_API FPaperZDAnimNode_RandomPlayer : public FPaperZDAnimNode_Base
 	/* If true, the player will create a shuffle list that will ensure each entry gets played at least once before looping. */
 	UPROPERTY(EditAnywhere, Category = "Settings")
 	bool bShuffleMode;
+#endif
+
+	/* Index of the baked entries on the generated class. */
+	UPROPERTY()
+	int32 RandomPlayerIndex;
+
+	/* Baked entries, shared with every other instance of the class. */
+	const FPaperZDRandomPlayerData* PlayerData;
 
 	/* The internal playback time. */
 	float PlaybackTime;
@@ -76,18 +124,12 @@ struct PAPERZD_API FPaperZDAnimNode_RandomPlayer : public FPaperZDAnimNode_Base
 	/* Selected playrate for the animation. */
 	float PlayRate;
 
-	/**
-	 * A list with the indices of the entries ordered by decreasing play chance when not in shuffle mode.
-	 * In shuffle mode it contains the order in which to play the entries (already shuffled).
-	 */
-	TArray<int32> OrderedList;
+	/* Order in which to play the entries when in shuffle mode, already shuffled. */
+	TArray<int32> ShuffleList;
 
 	/* Current index of the shuffle list. */
 	int32 ShuffleIndex;
 
-	/* The sum of all the play chances. */
-	float AggregatedChance;
-
 public:
 	//ctor
 	FPaperZDAnimNode_RandomPlayer();
@@ -96,11 +138,12 @@ public:
 	virtual void OnInitialize(const FPaperZDAnimationInitContext& InitContext) override;
 	virtual void OnUpdate(const FPaperZDAnimationUpdateContext& UpdateContext) override;
 	virtual void OnEvaluate(FPaperZDAnimationPlaybackData& OutData) override;
+	virtual bool CanUpdateInWorkerThread(const UPaperZDAnimBPGeneratedClass* AnimClass) const override;
 	//~End FPaperZDAnimNode_Base Interface
 
 private:
-	/* Updates the index list. */
-	void GenerateOrderedList();
+	/* Shuffles the entries into the shuffle list. */
+	void GenerateShuffleList();
 
 	/* Obtains the next entry to play (either by randomly choosing one, or by popping one from the shuffle list). */
 	void PickNextEntry();
@@ -33,4 +33,10 @@ public:
 	virtual void OnEvaluate(FPaperZDAnimationPlaybackData& OutData) override;
 	//~End FPaperZDAnimNode_Base Interface
 
+	/* Caches the directional angle from the current input, without updating the linked animation. */
+	void UpdateDirectionalAngle();
+
+	/* Obtain the cached directional angle. */
+	float GetDirectionalAngle() const { return CachedDirectionalAngle; }
+
 };
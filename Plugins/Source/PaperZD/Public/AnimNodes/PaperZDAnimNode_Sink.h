@@ -4,6 +4,8 @@
 #include "AnimNodes/PaperZDAnimNode_Base.h"
 #include "PaperZDAnimNode_Sink.generated.h"
 
+struct FPaperZDAnimProgram;
+
 /**
  * Sink runtime node that collects the final animation data
  */
@@ -12,6 +14,9 @@ struct PAPERZD_API FPaperZDAnimNode_Sink : public FPaperZDAnimNode_Base
 {
 	GENERATED_BODY()
 
+	//Friendship for binding the program
+	friend struct FPaperZDAnimProgram;
+
 	/* Resulting Animation Data. */
 	UPROPERTY(EditAnywhere, Category = "Input")
 	FPaperZDAnimDataLink Result;
@@ -20,6 +25,9 @@ struct PAPERZD_API FPaperZDAnimNode_Sink : public FPaperZDAnimNode_Base
 	UPROPERTY()
 	FName Name;
 
+	/* Linear program that runs this graph without recursing through the links, bound on the default object. */
+	const FPaperZDAnimProgram* Program;
+
 public:
 	//ctor
 	FPaperZDAnimNode_Sink();
@@ -20,12 +20,19 @@ struct PAPERZD_API FPaperZDAnimNode_StateMachine : public FPaperZDAnimNode_Base
 	//Context to be passed around when evaluating if a node can be transitioned to
 	struct FNodeEvaluationContext
 	{
-		UObject* AnimInstance;
-		TSet<int32> VisitedNodes;
+		UPaperZDAnimInstance* AnimInstance;
+
+		//One bit per state machine node, the inline storage covers most machines without allocating
+		TBitArray<> VisitedNodes;
+
+		//Number of transition rules evaluated, reported to the trace
+		mutable int32 NumRuleEvaluations;
 
 		//ctor
-		FNodeEvaluationContext(UObject* InAnimInstance = nullptr)
+		FNodeEvaluationContext(UPaperZDAnimInstance* InAnimInstance, int32 NumNodes)
 			: AnimInstance(InAnimInstance)
+			, VisitedNodes(false, NumNodes)
+			, NumRuleEvaluations(0)
 		{}
 	};
 
@@ -34,7 +41,7 @@ struct PAPERZD_API FPaperZDAnimNode_StateMachine : public FPaperZDAnimNode_Base
 	{
 		FPaperZDAnimNode_StateMachine* StateMachine;
 		const FPaperZDAnimationUpdateContext UpdateContext;
-		FDelegateHandle SequenceCompleteHandle;
+		uint32 StartSequenceCompleteCount;
 
 	public:
 		//ctor
@@ -44,8 +51,6 @@ struct PAPERZD_API FPaperZDAnimNode_StateMachine : public FPaperZDAnimNode_Base
 		/* Updates the animation. */
 		void Update();
 		
-		/* Called when the transitional animation completes. */
-		void OnTransitionalAnimationComplete(const UPaperZDAnimSequence* AnimSequence);
 	};
 
 	/* Index of the baked state machine definition on the generated class. */
@@ -70,6 +75,9 @@ struct PAPERZD_API FPaperZDAnimNode_StateMachine : public FPaperZDAnimNode_Base
 	/* If true, the transitional animation graph has completed and should be popped on the next frame. */
 	bool bPopTransitionalAnimNode;
 
+	/* Graph update of the owning AnimInstance in which this node was last updated, see UPaperZDAnimInstance::GetGraphUpdateCount. */
+	uint32 LastGraphUpdate;
+
 public:
 	//ctor
 	FPaperZDAnimNode_StateMachine();
@@ -78,6 +86,7 @@ public:
 	virtual void OnInitialize(const FPaperZDAnimationInitContext& InitContext) override;
 	virtual void OnUpdate(const FPaperZDAnimationUpdateContext& UpdateContext) override;
 	virtual void OnEvaluate(FPaperZDAnimationPlaybackData& OutData) override;
+	virtual bool CanUpdateInWorkerThread(const UPaperZDAnimBPGeneratedClass* AnimClass) const override;
 	//~End FPaperZDAnimNode_Base Interface
 
 	/* Obtain the name of the state machine linked to this node. */
@@ -86,13 +95,36 @@ public:
 	/* Takes the given JumpLink and forcefully sets the new target state to the JumpNode's target. */
 	void JumpToNode(FName Name, const FPaperZDAnimationBaseContext& Context);
 
+	/* Obtain the index of the current state, or INDEX_NONE if the machine hasn't been initialized. */
+	int32 GetCurrentStateIndex() const { return CurrentStateIndex; }
+
+	/* True if a transitional animation is playing before the current state. */
+	bool IsPlayingTransitionalAnimation() const { return CurrentTransitionalAnimNode != nullptr; }
+
+	/* True if this node was updated on the last graph update of the given AnimInstance, false if its owning state wasn't active. */
+	bool WasUpdatedOnLastGraphUpdate(const UPaperZDAnimInstance* AnimInstance) const;
+
+	/**
+	 * Takes any pending transition and advances the state time, without updating the animation of the state.
+	 * Used by AnimInstances that follow the shared animation of another instance, running the same state machine.
+	 * @param UpdateContext		Context of the update.
+	 * @param SharedMachine		Same state machine on the instance that owns the shared animation, which already did its full update.
+	 */
+	void UpdateSharedState(const FPaperZDAnimationUpdateContext& UpdateContext, const FPaperZDAnimNode_StateMachine& SharedMachine);
+
 private:
+	/* Pops any completed transitional animation and takes every transition that can be taken from the current state. */
+	void UpdateTransitions(const FPaperZDAnimationUpdateContext& UpdateContext);
+
 	/* Sets the given state, triggering any delegate and adding the state's AnimNode to the queue. */
 	void SetState(int32 NewState, const FPaperZDAnimationBaseContext& Context);
 
 	/* True if the given node can be entered (its a state or a valid conduit). */
 	bool CanEnterNode(int32 NodeIndex, const FNodeEvaluationContext& EvaluationContext) const;
 
+	/* Evaluates the given transition rule, counting the evaluation. */
+	bool EvaluateTransitionRule(int32 RuleIndex, const FNodeEvaluationContext& EvaluationContext) const;
+
 	/* Check the list of transitions on the given node and return whether any of the transitions can be taken. */
 	const FPaperZDAnimStateMachineLink* CheckValidTransition(int32 NodeIndex, FNodeEvaluationContext& EvaluationContext) const;
 
@@ -0,0 +1,93 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+#include "AnimNodes/PaperZDAnimNode_Base.h"
+#include "PaperZDAnimProgram.generated.h"
+
+class UPaperZDAnimBPGeneratedClass;
+
+/**
+ * Operation that the linear program runs for each node.
+ */
+UENUM()
+enum class EPaperZDAnimProgramOp : uint8
+{
+	/* Node that only forwards its single input, nothing to do besides running its exposed values. */
+	PassThrough,
+
+	/* FPaperZDAnimNode_SetDirectionality, caches the angle on update and overwrites it on evaluate. */
+	SetDirectionality,
+
+	/* FPaperZDAnimNode_PlaySequence, leaf node that ticks and outputs its sequence. */
+	PlaySequence,
+
+	/* Any other node, goes through the regular virtual Update/Evaluate calls, which take care of its own inputs. Always the last instruction. */
+	Fallback
+};
+
+/**
+ * Single step of the linear program.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDAnimProgramInstruction
+{
+	GENERATED_BODY()
+
+	/* Operation to run. */
+	UPROPERTY()
+	EPaperZDAnimProgramOp Op;
+
+	/* LinkID of the node this instruction runs on. */
+	UPROPERTY()
+	int32 LinkID;
+
+	/* Offset of the node inside the AnimInstance, resolved when the class initializes. */
+	int32 NodeOffset;
+
+	//ctor
+	FPaperZDAnimProgramInstruction()
+		: Op(EPaperZDAnimProgramOp::Fallback)
+		, LinkID(INDEX_NONE)
+		, NodeOffset(INDEX_NONE)
+	{}
+};
+
+/**
+ * Flattened chain of nodes that starts at a sink node (main graph, state or transitional graph), sorted from the sink towards its leaf.
+ * The sink runs the chain in a loop instead of recursing through each FPaperZDAnimDataLink. Update walks the instructions forward and
+ * Evaluate walks them backwards, matching the order the recursive calls would have.
+ *
+ * Only single-input chains are flattened: any node with more than one input (blends, layers, random players, state machines...) stops
+ * the chain with a Fallback, and its whole subtree keeps updating recursively. States and transitional graphs own their sinks, so the
+ * chains inside a state machine still get their own programs. Each flattened node still opens its trace and cost scopes.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDAnimProgram
+{
+	GENERATED_BODY()
+
+	/* Instructions, the first one is always the sink node that owns this program. */
+	UPROPERTY()
+	TArray<FPaperZDAnimProgramInstruction> Instructions;
+
+public:
+	/* Resolves the node offsets and binds the program to its sink on the default object, returns false if the program doesn't match the class layout. */
+	bool Initialize(UPaperZDAnimBPGeneratedClass* InClass, UObject* InClassDefaultObject);
+
+	/* Updates every node after the sink, in order. */
+	void Update(FPaperZDAnimNode_Base* SinkNode, const FPaperZDAnimationUpdateContext& Context) const;
+
+	/* Evaluates every node after the sink, in reverse order. */
+	void Evaluate(FPaperZDAnimNode_Base* SinkNode, FPaperZDAnimationPlaybackData& OutData) const;
+
+	/* Called to initialize the programs of a given class. */
+	static void InitClass(TArray<FPaperZDAnimProgram>& Programs, UPaperZDAnimBPGeneratedClass* InClass, UObject* InClassDefaultObject);
+
+private:
+	/* Obtains the node for the given instruction, relative to the sink that runs the program. */
+	FORCEINLINE FPaperZDAnimNode_Base* GetNode(FPaperZDAnimNode_Base* SinkNode, const FPaperZDAnimProgramInstruction& Instruction) const
+	{
+		uint8* InstanceBase = reinterpret_cast<uint8*>(SinkNode) - Instructions[0].NodeOffset;
+		return reinterpret_cast<FPaperZDAnimNode_Base*>(InstanceBase + Instruction.NodeOffset);
+	}
+};
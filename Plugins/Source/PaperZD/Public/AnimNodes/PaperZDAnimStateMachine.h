@@ -2,18 +2,76 @@
 
 #pragma once
 #include "CoreMinimal.h"
+#include "PaperZDTrace.h"
 #include "PaperZDAnimStateMachine.generated.h"
 
+/**
+ * Operations supported by the native transition rule programs.
+ */
+UENUM()
+enum class EPaperZDTransitionRuleOp : uint8
+{
+	Constant,
+	ReadProperty,
+	Not,
+	And,
+	Or,
+	Xor,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+	Equal,
+	NotEqual
+};
+
+/**
+ * Single instruction of a native transition rule program.
+ * Programs are stored in postfix order and evaluated on a small value stack, where booleans are represented as 0/1.
+ */
+USTRUCT()
+struct FPaperZDTransitionRuleInstruction
+{
+	GENERATED_BODY()
+
+	/* Operation to run. */
+	UPROPERTY()
+	EPaperZDTransitionRuleOp Op;
+
+	/* Name of the AnimInstance property to read, for the ReadProperty operation. */
+	UPROPERTY()
+	FName PropertyName;
+
+	/* Value to push, for the Constant operation. */
+	UPROPERTY()
+	double ConstantValue;
+
+	/* Cached property, resolved when initializing the class. */
+	FProperty* CachedProperty;
+
+public:
+	//ctor
+	FPaperZDTransitionRuleInstruction()
+	: Op(EPaperZDTransitionRuleOp::Constant)
+	, PropertyName(NAME_None)
+	, ConstantValue(0.0)
+	, CachedProperty(nullptr)
+	{}
+
+	/* Maximum size of the value stack a program can use. */
+	static constexpr int32 MaxStackSize = 16;
+};
+
 /**
  * Contains the "rule" that governs if a transition/conduit can be taken or not.
- * Internally points to a runtime getter node for the baked transition graph.
+ * Internally points to a runtime getter node for the baked transition graph, or to a native program when the graph only reads and compares properties.
  */
 USTRUCT()
 struct FPaperZDAnimStateMachineTransitionRule
 {
 	GENERATED_BODY()
 
-	/* True if the rule contains blueprint logic and is bound to an UFunction. */
+	/* True if the rule contains logic, either bound to an UFunction or compiled into a native program. */
 	UPROPERTY()
 	bool bDynamicRule;
 
@@ -25,15 +83,53 @@ struct FPaperZDAnimStateMachineTransitionRule
 	UPROPERTY()
 	bool bConstantValue;
 
+	/* True if the logic of the rule was compiled into a native program, which runs without entering the blueprint VM. */
+	UPROPERTY()
+	bool bNativeRule;
+
+	/* Range of the native program inside the state machine's RuleProgram. */
+	UPROPERTY()
+	int32 NativeProgramIndex;
+
+	UPROPERTY()
+	int32 NativeProgramLength;
+
+	/**
+	 * Cached function and offset of its return value inside the parameter buffer, for dynamic rules that aren't native.
+	 * Resolved on the first evaluation when the class is initialized outside of the game thread (i.e. async loading), these rules are only evaluated on the game thread.
+	 */
+	mutable UFunction* CachedRuleFunction;
+	mutable int32 ReturnValueOffset;
+	mutable bool bRuleFunctionResolved;
+
 public:
 	FPaperZDAnimStateMachineTransitionRule()
 	: bDynamicRule(false)
 	, RuleFunctionName(NAME_None)
 	, bConstantValue(false)
+	, bNativeRule(false)
+	, NativeProgramIndex(INDEX_NONE)
+	, NativeProgramLength(0)
+	, CachedRuleFunction(nullptr)
+	, ReturnValueOffset(INDEX_NONE)
+	, bRuleFunctionResolved(false)
 	{}
 
 	/* Evaluates the transition rule, returning its value. */
-	bool EvaluateRule(UObject* AnimInstance) const;
+	bool EvaluateRule(UObject* AnimInstance, const TArray<FPaperZDTransitionRuleInstruction>& RuleProgram) const;
+
+	/* True if the rule can be evaluated outside of the game thread (it doesn't need to run blueprint logic). */
+	bool CanEvaluateInWorkerThread() const { return !bDynamicRule || bNativeRule; }
+
+	/* Caches the function and return value offset used by the dynamic rules, or leaves them for the first evaluation if not called on the game thread. */
+	void Initialize(UClass* InClass);
+
+private:
+	/* Finds the rule function on the given class and the offset of its return value. */
+	void ResolveRuleFunction(const UClass* InClass) const;
+
+	/* Runs the native program of this rule. */
+	bool EvaluateNativeProgram(UObject* AnimInstance, const TArray<FPaperZDTransitionRuleInstruction>& RuleProgram) const;
 };
 
 /**
@@ -102,12 +198,17 @@ struct FPaperZDAnimStateMachineNode
 	UPROPERTY()
 	FName OnStateExitEventName;
 
+	/* Name of the state or conduit on the graph, used for debugging and tracing. */
+	UPROPERTY()
+	FName StateName;
+
 public:
 	//ctor
 	FPaperZDAnimStateMachineNode()
 	: AnimNodeIndex(INDEX_NONE)
 	, bConduit(false)
 	, ConduitRuleIndex(INDEX_NONE)
+	, StateName(NAME_None)
 	{}
 };
 
@@ -115,7 +216,7 @@ public:
  * Holds the structure of an animation State Machine for PaperZD
  */
 USTRUCT()
-struct FPaperZDAnimStateMachine
+struct PAPERZD_API FPaperZDAnimStateMachine
 {
 	GENERATED_BODY()
 
@@ -139,10 +240,28 @@ struct FPaperZDAnimStateMachine
 	UPROPERTY()
 	TMap<FName, int32> JumpLinks;
 
+	/* Instructions of every native transition rule on this machine, each rule points to its own range. */
+	UPROPERTY()
+	TArray<FPaperZDTransitionRuleInstruction> RuleProgram;
+
 public:
 	//ctor
 	FPaperZDAnimStateMachine()
 	: MachineName(NAME_None)
 	, InitialState(INDEX_NONE)
 	{}
+
+	/* Evaluates the transition rule with the given index. */
+	bool EvaluateTransitionRule(int32 RuleIndex, UObject* AnimInstance) const
+	{
+		const FPaperZDAnimStateMachineTransitionRule& Rule = TransitionRules[RuleIndex];
+		PAPERZD_TRACE_SCOPE(Rule.RuleFunctionName);
+		return Rule.EvaluateRule(AnimInstance, RuleProgram);
+	}
+
+	/* Resolves the cached data that every transition rule needs for its evaluation. */
+	void Initialize(UClass* InClass);
+
+	/* Called to initialize the state machines of a given class. */
+	static void InitClass(TArray<FPaperZDAnimStateMachine>& StateMachines, UClass* InClass);
 };
@@ -0,0 +1,231 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Templates/SubclassOf.h"
+#include "Algo/BinarySearch.h"
+#include "Notifies/PaperZDPackedNotify.h"
+
+class UPaperZDAnimNotify_Base;
+
+/**
+ * Time sorted view of the notifies stored on an AnimSequence, used to only tick the notifies that can trigger on a given playback window.
+ * Point notifies are sorted by their trigger time, while notify states are kept as an interval list sorted by their start time.
+ * Notifies that don't derive from UPaperZDAnimNotify or UPaperZDAnimNotifyState have an unknown trigger logic and get ticked on every window.
+ * Cooked sequences can also store built-in notifies as packed records, which the index visits straight from the sequence as they're already sorted.
+ */
+struct PAPERZD_API FPaperZDAnimNotifyIndex
+{
+	/* Single notify on the index, with its time interval cached. */
+	struct FEntry
+	{
+		/* The notify object, owned by the AnimSequence. */
+		UPaperZDAnimNotify_Base* Notify;
+
+		/* Time in which the notify triggers, or starts for notify states. */
+		float StartTime;
+
+		/* Time in which the notify ends, same as the start time for point notifies. */
+		float EndTime;
+
+		/* True if the given time is inside the notify state interval, matches the check done by the notify state when ticking. */
+		FORCEINLINE bool IsActiveAt(float Time) const { return Time > StartTime && Time < EndTime; }
+	};
+
+private:
+	/* Point notifies, sorted by time. */
+	TArray<FEntry> PointNotifies;
+
+	/* Notify states, sorted by start time. */
+	TArray<FEntry> StateNotifies;
+
+	/* Notifies that must be ticked on every window. */
+	TArray<FEntry> UnindexedNotifies;
+
+	/* Packed notifies, sorted by time and owned by the AnimSequence. */
+	const TArray<FPaperZDPackedNotify>* PackedNotifies;
+
+	/* Longest notify state on the index, bounds the search for the states active at a given time. */
+	float MaxStateDuration;
+
+	/* Number and hash of the notifies the index was built with, used to detect changes on the source array. */
+	int32 NumSourceNotifies;
+	uint32 SourceNotifiesHash;
+
+	/* True once the index has been built. */
+	bool bBuilt;
+
+public:
+	//ctor
+	FPaperZDAnimNotifyIndex();
+
+	/**
+	 * Builds the index from the given notifies, any previous data is discarded.
+	 * @param AnimNotifies		Notify objects to index.
+	 * @param InPackedNotifies	Packed notifies sorted by time, referenced by the index so they must outlive it.
+	 */
+	void Build(const TArray<UPaperZDAnimNotify_Base*>& AnimNotifies, const TArray<FPaperZDPackedNotify>* InPackedNotifies = nullptr);
+
+	/* True if the index has been built. */
+	FORCEINLINE bool IsBuilt() const { return bBuilt; }
+
+	/* Checks if the index still matches the given notifies, notifies can be added or moved at any time while on the editor. */
+	bool IsUpToDate(const TArray<UPaperZDAnimNotify_Base*>& AnimNotifies) const;
+
+	/**
+	 * Calls the given function on every notify that can trigger while the playback goes from PreviousTime to CurrentTime.
+	 * Handles looping and reverse playback with the same rules the notifies use, the notifies will still run their own checks when ticked.
+	 * Point notifies are visited in playback order.
+	 * @param PreviousTime	Playback time at the start of the window.
+	 * @param CurrentTime	Playback time at the end of the window.
+	 * @param DeltaTime		Signed time that was played, negative for reverse playback.
+	 * @param Func			Function with the signature void(UPaperZDAnimNotify_Base*).
+	 */
+	template<typename FuncType>
+	void ForEachNotifyInWindow(float PreviousTime, float CurrentTime, float DeltaTime, FuncType&& Func) const
+	{
+		for (const FEntry& Entry : UnindexedNotifies)
+		{
+			Func(Entry.Notify);
+		}
+
+		//States only do work when the window starts or ends inside of them
+		if (StateNotifies.Num())
+		{
+			const float WindowMin = FMath::Min(PreviousTime, CurrentTime);
+			const float WindowMax = FMath::Max(PreviousTime, CurrentTime);
+			for (int32 i = LowerBound(StateNotifies, WindowMin - MaxStateDuration - KINDA_SMALL_NUMBER); i < StateNotifies.Num() && StateNotifies[i].StartTime < WindowMax; i++)
+			{
+				const FEntry& Entry = StateNotifies[i];
+				if (Entry.IsActiveAt(PreviousTime) || Entry.IsActiveAt(CurrentTime))
+				{
+					Func(Entry.Notify);
+				}
+			}
+		}
+
+		//Point notifies trigger when crossed
+		auto PointFunc = [&Func](const FEntry& Entry) { Func(Entry.Notify); };
+		ForEachPointInWindow(PointNotifies, PreviousTime, CurrentTime, DeltaTime, PointFunc);
+	}
+
+	/**
+	 * Calls the given function on every packed notify that triggers while the playback goes from PreviousTime to CurrentTime, in playback order.
+	 * Packed notifies have no logic of their own, the crossing rules are the ones UPaperZDAnimNotify uses.
+	 * @param Func			Function with the signature void(const FPaperZDPackedNotify&).
+	 */
+	template<typename FuncType>
+	void ForEachPackedNotifyInWindow(float PreviousTime, float CurrentTime, float DeltaTime, FuncType&& Func) const
+	{
+		if (PackedNotifies && PackedNotifies->Num())
+		{
+			//The ranges are closed, the ends of the window still need to be checked
+			auto CrossedFunc = [&](const FPaperZDPackedNotify& PackedNotify)
+			{
+				if (IsPointCrossed(PackedNotify.Time, PreviousTime, CurrentTime, DeltaTime))
+				{
+					Func(PackedNotify);
+				}
+			};
+			ForEachPointInWindow(*PackedNotifies, PreviousTime, CurrentTime, DeltaTime, CrossedFunc);
+		}
+	}
+
+	/**
+	 * Finds the first notify of the given class that the playback reaches when starting at the given time.
+	 * @param NotifyClass	Class of the notify, child classes are accepted.
+	 * @param Time			Time to start searching from, notifies placed exactly at this time are accepted.
+	 * @param bLooping		If true, the search wraps around the sequence when no notify is found before reaching its end.
+	 * @param bReverse		If true, the search goes backwards in time. Notify states are reached at their end time.
+	 * @return				The found entry, or nullptr.
+	 */
+	const FEntry* FindNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse) const;
+
+	/**
+	 * Finds the time at which the playback reaches the next notify of the given class, packed notifies included.
+	 * Same search as FindNextNotify, for callers that only need to know when the notify gets reached.
+	 * @return	True if a notify was found.
+	 */
+	bool FindNextNotifyTime(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutTime) const;
+
+	/* Obtains every notify that triggers or is active in the given time range, sorted by time. */
+	void GetNotifiesInRange(float StartTime, float EndTime, TArray<UPaperZDAnimNotify_Base*>& OutNotifies) const;
+
+	/* True if any notify state is active at the given time, or if there are notifies that need to be ticked on every window. */
+	bool NeedsTickAt(float Time) const;
+
+private:
+	/* True if the playback window crosses the given time, same rules UPaperZDAnimNotify uses when ticked. */
+	static FORCEINLINE bool IsPointCrossed(float Time, float PreviousTime, float CurrentTime, float DeltaTime)
+	{
+		if (DeltaTime > 0.0f)
+		{
+			return CurrentTime < PreviousTime ? (CurrentTime >= Time || PreviousTime <= Time) : (CurrentTime > Time && PreviousTime <= Time);
+		}
+
+		return CurrentTime > PreviousTime ? (CurrentTime <= Time || PreviousTime >= Time) : (CurrentTime < Time && PreviousTime >= Time);
+	}
+
+	/* Time in which a point entry triggers. */
+	static FORCEINLINE float GetPointTime(const FEntry& Entry) { return Entry.StartTime; }
+	static FORCEINLINE float GetPointTime(const FPaperZDPackedNotify& PackedNotify) { return PackedNotify.Time; }
+
+	/* Calls the function on every point entry crossed by the playback window, looping windows are split in two ranges. */
+	template<typename PointType, typename FuncType>
+	static void ForEachPointInWindow(const TArray<PointType>& Points, float PreviousTime, float CurrentTime, float DeltaTime, FuncType& Func)
+	{
+		if (DeltaTime > 0.0f)
+		{
+			if (CurrentTime < PreviousTime)
+			{
+				ForEachPointInRange(Points, PreviousTime, MAX_flt, false, Func);
+				ForEachPointInRange(Points, -MAX_flt, CurrentTime, false, Func);
+			}
+			else
+			{
+				ForEachPointInRange(Points, PreviousTime, CurrentTime, false, Func);
+			}
+		}
+		else
+		{
+			if (CurrentTime > PreviousTime)
+			{
+				ForEachPointInRange(Points, -MAX_flt, PreviousTime, true, Func);
+				ForEachPointInRange(Points, CurrentTime, MAX_flt, true, Func);
+			}
+			else
+			{
+				ForEachPointInRange(Points, CurrentTime, PreviousTime, true, Func);
+			}
+		}
+	}
+
+	/* Calls the function on every point entry with its time inside the closed range, in ascending or descending order. */
+	template<typename PointType, typename FuncType>
+	static void ForEachPointInRange(const TArray<PointType>& Points, float RangeMin, float RangeMax, bool bDescending, FuncType& Func)
+	{
+		auto Projection = [](const PointType& Point) { return GetPointTime(Point); };
+		const int32 First = Algo::LowerBoundBy(Points, RangeMin, Projection);
+		const int32 Last = Algo::UpperBoundBy(Points, RangeMax, Projection);
+		if (bDescending)
+		{
+			for (int32 i = Last - 1; i >= First; i--)
+			{
+				Func(Points[i]);
+			}
+		}
+		else
+		{
+			for (int32 i = First; i < Last; i++)
+			{
+				Func(Points[i]);
+			}
+		}
+	}
+
+	/* Index of the first entry that starts at or after the given time. */
+	static FORCEINLINE int32 LowerBound(const TArray<FEntry>& Entries, float Time)
+	{
+		return Algo::LowerBoundBy(Entries, Time, &FEntry::StartTime);
+	}
+};
@@ -3,6 +3,7 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "Notifies/PaperZDAnimNotify_Base.h"
+#include "AnimSequences/PaperZDAnimNotifyIndex.h"
 #include "PaperZDAnimSequence.generated.h"
 
 DECLARE_DELEGATE(FOnPostEditUndo)
@@ -60,6 +61,22 @@ public:
 	 {}
   };
 
+/**
+ * Bin of the angle lookup table used by directional sequences.
+ * Bins are smaller than the angle covered by a single direction, so each bin can hold at most one direction change.
+ */
+struct FPaperZDDirectionalLookupBin
+{
+	/* Angle at which the bin changes direction, placed past the end of the bin if there's no change. */
+	float SplitAngle;
+
+	/* Data source index for the angles before the split. */
+	int32 Index;
+
+	/* Data source index for the angles after the split. */
+	int32 SplitIndex;
+};
+
 /**
  * The AnimSequence is the class responsible of handling how a given Animation source plays on the registered RenderComponent and handling meta info like AnimNotifies. 
  */
@@ -88,6 +105,14 @@ private:
 	UPROPERTY()
 	TArray<UPaperZDAnimNotify_Base*> AnimNotifies;
 
+	/* Built-in notifies stored as plain data, sorted by time. Only filled on cooked data, where they replace their notify objects. */
+	UPROPERTY()
+	TArray<FPaperZDPackedNotify> PackedNotifies;
+
+	/* Offset transforms used by the packed notifies. */
+	UPROPERTY()
+	TArray<FTransform> PackedNotifyTransforms;
+
 #if WITH_EDITORONLY_DATA
 	/* DEPRECATED: Points to the AnimBP that owned this AnimSequence before the creation of AnimSources. */
 	UPROPERTY(AssetRegistrySearchable)
@@ -99,11 +124,32 @@ private:
 
 	/* Called when the list of notifies changes somehow. */
 	FOnNotifyChangeSignature OnNotifyChange;
+
+	/* Notifies the sequence had before packing them for the cooked package, restored once the package is saved. */
+	UPROPERTY(Transient)
+	TArray<UPaperZDAnimNotify_Base*> CookSourceNotifies;
 #endif
 
 	/* Cached DataSource property for faster lookup. */
 	FArrayProperty* CachedAnimDataSourceProperty;
 
+	/* Cached address of the DataSource array inside this object and the size of its elements, lets the data be read without going through reflection. */
+	const FScriptArray* CachedAnimDataSourceArray;
+	int32 CachedAnimDataSourceElementSize;
+
+	/* Angle to data source index table for directional sequences, with the directional offset already applied. Only built on the game thread, when loading or editing the sequence. */
+	TArray<FPaperZDDirectionalLookupBin> DirectionalLookupTable;
+
+	/* Number of bins per degree on the lookup table. */
+	float DirectionalLookupScale;
+
+	/* Number of directions and angle offset the lookup table was built with, the table is stale if they don't match the sequence. */
+	int32 DirectionalLookupNum;
+	float DirectionalLookupOffset;
+
+	/* Time sorted view of the AnimNotifies, built on load and lazily rebuilt whenever the notifies change on the editor. */
+	mutable FPaperZDAnimNotifyIndex NotifyIndex;
+
 public:
 	UPROPERTY()
 	FName DisplayName_DEPRECATED; //@Deprecated
@@ -140,10 +186,30 @@ public:
 	//Required for version support
 	virtual void PostLoad() override;
 	virtual void Serialize(FArchive& Ar) override;
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostSaveRoot(bool bCleanupIsRequired) override;
+#endif
 
 	/* Called after initializing the properties, but before serialization. */
 	virtual void PostInitProperties() override;
 
+	/**
+	 * Cooked sequences become garbage collection clusters along with their notifies and data sources (i.e. the flipbooks of each direction),
+	 * so the collector doesn't traverse every one of them on each pass. Controlled with paperzd.ClusterAnimSequences.
+	 */
+	virtual bool CanBeClusterRoot() const override;
+	virtual void CreateCluster() override;
+
+	/* True if sequences and their animation sources can become garbage collection clusters. */
+	static bool CanCreateClusters();
+
+	/**
+	 * Creates the cluster of an object referenced by a cluster about to be created, so it gets referenced as its own cluster instead of being absorbed by the new one.
+	 * Does nothing if the object can't be a cluster root, is already clustered or hasn't finished loading.
+	 */
+	static void CreateDependencyCluster(UObject* Dependency);
+
 	/* Helper to get the AnimSource member name for the editor and others property windows */
 	static FName GetAnimSourceMemberName() { return UPaperZDAnimSequence::AnimSourceMemberName; }
 
@@ -156,6 +222,34 @@ public:
 	/* Get the AnimNotifies linked to this sequence. */
 	const TArray<UPaperZDAnimNotify_Base*>& GetAnimNotifies() const;
 
+	/* Get the built-in notifies that were packed when cooking, sorted by time. Packed notifies aren't part of the AnimNotifies. */
+	FORCEINLINE const TArray<FPaperZDPackedNotify>& GetPackedNotifies() const { return PackedNotifies; }
+
+	/* Obtain the offset transform of a packed notify. */
+	FORCEINLINE const FTransform& GetPackedNotifyTransform(int32 TransformIndex) const { return PackedNotifyTransforms[TransformIndex]; }
+
+	/* Get the time sorted index of the AnimNotifies linked to this sequence, should only be used on the game thread. */
+	const FPaperZDAnimNotifyIndex& GetNotifyIndex() const;
+
+	/**
+	 * Finds the first notify of the given class that the playback reaches when starting at the given time.
+	 * @param NotifyClass		Class of the notify to search for, child classes are accepted.
+	 * @param Time				Playback time to start searching from, notifies placed exactly at this time are accepted.
+	 * @param bLooping			If true, the search wraps around the sequence when no notify is found before reaching its end.
+	 * @param bReverse			If true, the search goes backwards in time. Notify states are reached at their end time when going backwards.
+	 * @param OutNotifyTime		The time at which the notify is reached.
+	 * @return					The found notify, or null if there's none. Built-in notifies packed on cooked data have no object and aren't returned, use FindNextNotifyTime to account for them.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "AnimSequence")
+	UPaperZDAnimNotify_Base* FindNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutNotifyTime) const;
+
+	/* Finds the time at which the playback reaches the next notify of the given class, packed notifies included. Returns false if there's none. */
+	bool FindNextNotifyTime(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, float Time, bool bLooping, bool bReverse, float& OutNotifyTime) const;
+
+	/* Obtains every notify that triggers or is active in the given time range, sorted by time. Packed notifies have no object and aren't returned. */
+	UFUNCTION(BlueprintCallable, Category = "AnimSequence")
+	void GetNotifiesInRange(float StartTime, float EndTime, TArray<UPaperZDAnimNotify_Base*>& OutNotifies) const;
+
 	/* Originally meant to hold the Display name, can be overridden if you don't want the default FName to be used when referring to this sequence. */
 	virtual FName GetSequenceName() const;
 
@@ -170,6 +264,22 @@ public:
 	/* Obtains the number of frames on this animation. */
 	virtual int32 GetNumberOfFrames() const;
 
+	/**
+	 * Obtains how much playback time is left until the rendered data changes, starting at the given time.
+	 * Used to let idle AnimInstances sleep while nothing visible happens. The default implementation returns zero, as the sequence doesn't know how its data changes.
+	 * @param Time		Playback time to start from.
+	 * @param bReverse	If true, the playback goes backwards in time.
+	 * @return			Time until the next change, or MAX_flt if the data doesn't change until the sequence ends.
+	 */
+	virtual float GetTimeToNextVisibleChange(float Time, bool bReverse) const { return 0.0f; }
+
+	/**
+	 * Gets the sequence ready to be played for the first time, called when an AnimBP that references it gets prewarmed.
+	 * Override to make the render data of the sequence resident ahead of time.
+	 * @param TextureResidentTime	Seconds the textures used by the sequence should be kept fully streamed in, zero to leave streaming alone.
+	 */
+	virtual void Prewarm(float TextureResidentTime) const;
+
 	/* Obtain the frame number, given the playback time. */
 	int32 GetFrameAtTime(const float Time) const;
 
@@ -187,17 +297,15 @@ public:
 
 	/**
 	 * Agnostic getter implementation for the internal AnimationData Source array.
-	 * For better performance, one should code a specialization.
+	 * The type must match the type of the elements stored on the data source.
 	 */
 	template<typename T>
 	T GetAnimationDataByIndex(int32 DirectionalIndex = 0) const
 	{
-		FArrayProperty* ArrayProperty = GetAnimDataSourceProperty();
-		FScriptArrayHelper ArrayHelper(ArrayProperty, ArrayProperty->ContainerPtrToValuePtr<uint8>(this));
-
+		checkSlow(CachedAnimDataSourceArray && CachedAnimDataSourceElementSize == sizeof(T));
 		const int32 Index = bDirectionalSequence ? DirectionalIndex : 0;
-		uint8* Ptr = ArrayHelper.GetRawPtr(Index);
-		return *reinterpret_cast<T*>(Ptr);
+		checkSlow(CachedAnimDataSourceArray->IsValidIndex(Index));
+		return static_cast<const T*>(CachedAnimDataSourceArray->GetData())[Index];
 	}
 
 	/**
@@ -215,24 +323,40 @@ public:
 			return GetAnimationDataByIndex<T>(DirectionalPreviewIndex);
 		}
 #endif	
-		if (bDirectionalSequence)
+		//Non-directional sequences will always use the first index
+		return GetAnimationDataByIndex<T>(bDirectionalSequence ? GetDirectionalIndex(DirectionalAngle) : 0);
+	 }
+
+	/**
+	 * Obtains the data source index to use for the given angle, using the precomputed lookup table.
+	 * @param	DirectionalAngle		The angle in degrees against the top of the animation.
+	 */
+	FORCEINLINE int32 GetDirectionalIndex(float DirectionalAngle) const
+	{
+		const int32 Num = CachedAnimDataSourceArray ? CachedAnimDataSourceArray->Num() : 0;
+		if (Num <= 1)
+		{
+			return 0;
+		}
+
+		//Read-only, as it can run on a parallel update. A stale table (data changed without an edit notification) falls back to computing the index
+		if (DirectionalLookupNum != Num || DirectionalLookupOffset != DirectionalAngleOffset)
 		{
-			//Obtain the directional preview index from the given angle
-			FArrayProperty* ArrayProperty = GetAnimDataSourceProperty();
-			FScriptArrayHelper ArrayHelper(ArrayProperty, ArrayProperty->ContainerPtrToValuePtr<uint8>(this));
-			const int32 Num = ArrayHelper.Num();
-			const float AngleSepparation = 360.0f / Num;
-
-			//We need to account for angles that are negative, for this we add a full revolution and then obtain the modulo, which will ensure we're always at a normalized range
-			const int32 Area = (DirectionalAngle + DirectionalAngleOffset + AngleSepparation / 2.0f + 360.0f) / AngleSepparation;
-			return GetAnimationDataByIndex<T>(Area % Num);
+			return ComputeDirectionalIndex(DirectionalAngle, Num);
 		}
-		else
-		{ 
-			//Non-directional sequences will always use the first index
-			return GetAnimationDataByIndex<T>();
+
+		//Normalize into the [0, 360) range, angles are expected to be in [-360, 360) so the modulo is rarely needed
+		float Angle = DirectionalAngle < 0.0f ? DirectionalAngle + 360.0f : DirectionalAngle;
+		if (Angle < 0.0f || Angle >= 360.0f)
+		{
+			Angle = FMath::Fmod(Angle, 360.0f);
+			Angle = Angle < 0.0f ? Angle + 360.0f : Angle;
 		}
-	 }
+
+		const int32 BinIndex = FMath::Min((int32)(Angle * DirectionalLookupScale), DirectionalLookupTable.Num() - 1);
+		const FPaperZDDirectionalLookupBin& Bin = DirectionalLookupTable[BinIndex];
+		return Angle < Bin.SplitAngle ? Bin.Index : Bin.SplitIndex;
+	}
 
 	/* True if this sequence is currently being used as a "Directional Sequence" */
 	FORCEINLINE bool IsDirectionalSequence() const { return bDirectionalSequence; }
@@ -242,6 +366,7 @@ public:
 
 #if WITH_EDITOR
 	void PostEditUndo() override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 
 	/* Initializes the AnimTracks, making sure that we have enough metadata for any AnimNotify that we have stored. */
 	void InitTracks();
@@ -296,6 +421,17 @@ protected:
 	virtual FName GetDataSourcePropertyName() const;
 
 private:
+#if WITH_EDITOR
+	/* Moves the built-in notifies into packed records and keeps their objects out of the package, used while cooking. */
+	void PackBuiltInNotifies();
+#endif
+
 	/* Initializes the Animation Data Source and makes sure its correctly configured for later use. */
 	void InitDataSource();
+
+	/* Builds the angle lookup table for the current number of directions and angle offset. Game thread only. */
+	void BuildDirectionalLookupTable();
+
+	/* Obtains the data source index for the given angle without the lookup table, used while the table is stale. */
+	int32 ComputeDirectionalIndex(float DirectionalAngle, int32 NumDirections) const;
 };
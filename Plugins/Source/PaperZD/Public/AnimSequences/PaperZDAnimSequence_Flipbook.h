@@ -37,6 +37,8 @@ public:
 	virtual float GetTotalDuration() const override;
 	virtual float GetFramesPerSecond() const override;
 	virtual bool IsDataSourceEntrySet(int32 EntryIndex) const override;
+	virtual float GetTimeToNextVisibleChange(float Time, bool bReverse) const override;
+	virtual void Prewarm(float TextureResidentTime) const override;
 	//~ End UPaperZDAnimSequence Interface
 
 private:
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "AnimSequences/PaperZDAnimSequence.h"
 #include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "PaperZDAnimLOD.h"
 #include "PaperZDAnimPlayer.generated.h"
 
 class UPrimitiveComponent;
@@ -29,13 +30,50 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlaybackSequenceLoopedSignature,
 DECLARE_MULTICAST_DELEGATE_OneParam(FOnPlaybackSequenceCompleteSignature_Native, const UPaperZDAnimSequence*);
 
 /**
- * Object responsible for driving the animation sequences playback, ticking notifies and parsing the animation data into the final animation mix.
+ * Notify window recorded while the player was deferring its game thread work.
  */
-UCLASS()
-class PAPERZD_API UPaperZDAnimPlayer : public UObject
+struct FPaperZDDeferredNotifyTick
+{
+	const UPaperZDAnimSequence* AnimSequence;
+	UPaperZDAnimInstance* OwningInstance;
+	float DeltaTime;
+	float PlaybackMarker;
+	float PreviousTime;
+};
+
+/**
+ * Playback event (loop or completion) recorded while the player was deferring its game thread work.
+ */
+struct FPaperZDDeferredPlaybackEvent
+{
+	const UPaperZDAnimSequence* AnimSequence;
+	bool bLooped;
+};
+
+/**
+ * Playback ticked while tracking the next playback event, used to compute how long an idle AnimInstance can sleep.
+ */
+struct FPaperZDTrackedPlayback
+{
+	const UPaperZDAnimSequence* AnimSequence;
+	float PlaybackMarker;
+	float DeltaTime;
+	bool bLooping;
+};
+
+/**
+ * Playback state of an AnimPlayer, responsible for driving the animation sequences playback, ticking notifies and parsing the animation data into the final animation mix.
+ * Kept as a plain struct so AnimInstances can embed it, the player object is only a blueprint facing view over it.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDAnimPlayerState
 {
 	GENERATED_BODY()
 
+private:
+	//The player object shares the settings exposed to blueprints
+	friend class UPaperZDAnimPlayer;
+
 	/* Pointer to the handle that manages render playback for the animation instance. */
 	UPROPERTY(Transient)
 	UPaperZDPlaybackHandle* PlaybackHandle;
@@ -44,15 +82,229 @@ class PAPERZD_API UPaperZDAnimPlayer : public UObject
 	UPROPERTY(Transient)
 	TWeakObjectPtr<UPrimitiveComponent> RegisteredRenderComponent;
 
-	/* Copy of the last stored playback data. */
+	/* Player object that views this state, if it was created. It broadcasts the playback events to blueprints and owns the playback settings while it exists. */
+	UPaperZDAnimPlayer* PlayerObject;
+
+	/* AnimInstance that receives the playback events directly, used by the lightweight player instead of binding to the player object. */
+	UPaperZDAnimInstance* EventInstance;
+
+	/* Playback data used when playing a single animation directly. */
 	FPaperZDAnimationPlaybackData LastPlaybackData;
 
 	/* The main animation sent by the playback data struct, which we use as basis for getting the playback progress information. */
 	FPaperZDWeightedAnimation LastWeightedAnimation;
 
+	/* Notifies and blueprint events that were recorded while deferring game thread work, waiting to be flushed. */
+	TArray<FPaperZDDeferredNotifyTick> DeferredNotifyTicks;
+	TArray<FPaperZDDeferredPlaybackEvent> DeferredPlaybackEvents;
+
+	/* Number of non-looping sequences that completed their playback, lets the AnimNodes detect completions without binding to a delegate. */
+	uint32 SequenceCompleteCount;
+
+	/* How notifies are handled on the following updates, driven by the animation LOD. */
+	EPaperZDAnimLODNotifyPolicy NotifyPolicy;
+
+	/* Notify window held back while using the catch-up notify policy. Only the last played sequence is kept, moving to another one triggers the window held so far. */
+	FPaperZDDeferredNotifyTick PendingCatchUpTick;
+	bool bHasPendingCatchUp;
+
+	/* Playbacks ticked since tracking started, the event times are only computed when tracking ends on the game thread. */
+	TArray<FPaperZDTrackedPlayback, TInlineAllocator<2>> TrackedPlaybacks;
+	bool bTrackPlaybackEvents;
+
+	/* Playback settings used while there isn't a player object. */
+	EAnimPlayerPlaybackMode PlaybackMode;
+	bool bFireSequenceChangedEvents;
+
 	//State variables
 	bool bPlaying;
 	bool bPreviewPlayer;
+	bool bDeferGameThreadWork;
+
+public:
+	/* Native delegate called when a non-looping sequence completes its playback (used for transitional animation notifies). */
+	FOnPlaybackSequenceCompleteSignature_Native OnPlaybackSequenceComplete_Native;
+
+public:
+	//ctor
+	FPaperZDAnimPlayerState();
+
+	//The player object and the event instance point back to the owner, so the state can't be copied
+	FPaperZDAnimPlayerState(const FPaperZDAnimPlayerState&) = delete;
+	FPaperZDAnimPlayerState& operator=(const FPaperZDAnimPlayerState&) = delete;
+
+	/* Obtain the last played time of the primary animation that is currently being played. */
+	float GetCurrentPlaybackTime() const;
+
+	/* Obtain the progress, ranging from [0-1] of the the primary animation that is currently being played. */
+	float GetPlaybackProgress() const;
+
+	/* Obtain the current, biggest weighted, animation sequence that was rendered this frame. */
+	const UPaperZDAnimSequence* GetCurrentAnimSequence() const;
+
+	/* Obtain the time left until the current animation sequence reaches a notify of the given class, see UPaperZDAnimPlayer::GetTimeToNextNotify. */
+	bool GetTimeToNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, bool bLooping, float& OutTimeRemaining) const;
+
+	/* Obtain the current playback mode. */
+	EAnimPlayerPlaybackMode GetPlaybackMode() const;
+
+	/* True if the "OnPlaybackSequenceChanged" events should be fired. */
+	bool ShouldFireSequenceChangedEvents() const;
+
+	/* Obtain the player object that views this state, null if it wasn't created. */
+	UPaperZDAnimPlayer* GetPlayerObject() const { return PlayerObject; }
+
+	/* Obtain the handle that manages render playback. */
+	UPaperZDPlaybackHandle* GetPlaybackHandle() const { return PlaybackHandle; }
+
+	/* Resets the cached current animation to none. */
+	void ClearCachedAnimationData();
+
+	/**
+	 * Initializes this state for use with the given Animation Source.
+	 * @param AnimationSource	Source whose sequences will be played.
+	 * @param Outer				Object that owns this state, the playback handle is created inside of it.
+	 */
+	void Init(const UPaperZDAnimationSource* AnimationSource, UObject* Outer);
+
+	/**
+	 * Restores the playback state to the one right after initializing, keeping the playback handle. Used when a pooled AnimInstance gets reused.
+	 * Delegate bindings on the player object made by objects other than the owning AnimInstance are removed.
+	 */
+	void ResetForReuse(const UPaperZDAnimationSource* AnimationSource);
+
+	/* Makes the given AnimInstance receive the playback events directly, instead of binding to the player object. */
+	void SetEventInstance(UPaperZDAnimInstance* InEventInstance) { EventInstance = InEventInstance; }
+
+	/* Changes if this is a preview player or not. Some AnimSequences play or configure differently on PreviewMode. */
+	void SetIsPreviewPlayer(bool bInPreviewPlayer);
+
+	/**
+	 * Ticks the playback of the given animation asset.
+	 * @param AnimSequence		Asset which will be ticked.
+	 * @param PlaybackMarker	A reference to the current playback marker that points at the current progress, will get updated with the new value.
+	 * @param DeltaTime			The delta time to tick.
+	 * @param bLooping			Whether the animation should start again after reaching the end.
+	 * @param OwningInstance	The AnimInstance that owns the playback.
+	 * @param EffectiveWeight	The weight of the sequence that is playing, if below a given value the sequence will only update the time but not trigger any notifies.
+	 * @param bIgnoreNotifies	If no notifies should be triggered, even if their EffectiveWeight allows them to be called.
+	 */
+	void TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance = nullptr, float EffectiveWeight = 1.0f, bool bSkipNotifies = false);
+
+	/**
+	 * Processes the given AnimSequence and triggers all the notifies that are relevant in the playback window.
+	 */
+	void ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight = 1.0f, UPaperZDAnimInstance* OwningInstance = nullptr);
+
+	/**
+	 * Plays the given single animation
+	 */
+	void PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime);
+
+	/**
+	 * Evaluates the given animation data structure and potentially mixes all the given animations into a final pose, if the AnimSequence source supports it.
+	 */
+	void Play(const FPaperZDAnimationPlaybackData& PlaybackData);
+
+	/**
+	 * Plays animation data evaluated by another instance, triggering the notifies of the primary animation crossed since the last animation played.
+	 * @param PlaybackData		Animation data to play.
+	 * @param OwningInstance	Instance that receives the notifies.
+	 * @param bRender			If false, the notifies are triggered but the render component isn't updated.
+	 */
+	void PlayShared(const FPaperZDAnimationPlaybackData& PlaybackData, UPaperZDAnimInstance* OwningInstance, bool bRender = true);
+
+	/* Registers the render component to use for rendering the animation sequences. */
+	void RegisterRenderComponent(UPrimitiveComponent* RenderComponent);
+
+	/* Returns true if the player is currently running. */
+	bool IsPlaying() const { return bPlaying; }
+
+	/* Resumes the updating of the animation nodes. */
+	void ResumePlayback();
+
+	/* Pauses the updating of the animation nodes. */
+	void PausePlayback();
+
+	/**
+	 * Starts recording the notifies and blueprint events triggered by the playback instead of running them, used when ticking the playback outside of the game thread.
+	 * Native delegates are still broadcasted in place, as they are used by the AnimNodes themselves.
+	 */
+	void BeginDeferredGameThreadWork();
+
+	/* Stops recording and runs every notify and event that was recorded, must be called on the game thread. */
+	void FlushDeferredGameThreadWork();
+
+	/* Obtain the number of non-looping sequences that have completed their playback, only meant to be compared against a previous value. */
+	uint32 GetSequenceCompleteCount() const { return SequenceCompleteCount; }
+
+	/**
+	 * Changes how notifies are handled on the following updates, used by the animation LOD.
+	 * Leaving the catch-up policy triggers the held back notifies once if the new policy fires notifies, or discards them otherwise. Must be called on the game thread.
+	 */
+	void SetNotifyPolicy(EPaperZDAnimLODNotifyPolicy InNotifyPolicy);
+
+	/* Obtain how notifies are currently being handled. */
+	EPaperZDAnimLODNotifyPolicy GetNotifyPolicy() const { return NotifyPolicy; }
+
+	/* Starts recording the playbacks ticked from now on, so the time until their next event can be computed. */
+	void BeginTrackingPlaybackEvents();
+
+	/**
+	 * Stops recording and computes how soon any of the recorded playbacks reaches a keyframe change, a notify, a loop or its completion. Must be called on the game thread.
+	 * @return	The time until the closest event, as a multiple of the delta time each playback was ticked with. MAX_flt if no playback was ticked.
+	 */
+	float EndTrackingPlaybackEvents();
+
+private:
+	/* True if the given weight can be considered as "relevant" for triggering notifies and calling events. */
+	bool IsRelevantWeight(float Weight) const;
+
+	/* Adds the given window to the held back catch-up window, triggering and replacing it if it was recorded for a different sequence or direction. */
+	void AccumulateCatchUpWindow(const FPaperZDDeferredNotifyTick& NotifyTick);
+
+	/* Triggers the held back catch-up window, if any. Deferred along with the other notifies while the game thread work is deferred. */
+	void FlushCatchUpWindow();
+
+	/* Ticks every notify of the sequence that can trigger on the given window. */
+	void TickNotifiesInWindow(const FPaperZDDeferredNotifyTick& NotifyTick, UPrimitiveComponent* RenderComponent);
+
+	/* Fires the sequence changed events if the primary animation changed from the given one. */
+	void NotifySequenceChanged(const UPaperZDAnimSequence* PreviousAnimSequence);
+
+	/* Sends the playback events to the player object and the event instance. */
+	void BroadcastSequenceComplete(const UPaperZDAnimSequence* AnimSequence);
+	void BroadcastSequenceLooped(const UPaperZDAnimSequence* AnimSequence);
+
+	/* Name used to identify this player on the log. */
+	FString GetDebugName() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FPaperZDAnimPlayerState> : public TStructOpsTypeTraitsBase2<FPaperZDAnimPlayerState>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Object responsible for driving the animation sequences playback, ticking notifies and parsing the animation data into the final animation mix.
+ * Standalone players own their playback state. AnimInstances embed the state themselves and use the player as a proxy to expose it to blueprints,
+ * which instances with the lightweight player only create when requested.
+ */
+UCLASS()
+class PAPERZD_API UPaperZDAnimPlayer : public UObject
+{
+	GENERATED_BODY()
+
+	/* Playback state of a standalone player, unused when the player is the proxy of a state embedded on an AnimInstance. */
+	UPROPERTY(Transient)
+	FPaperZDAnimPlayerState OwnedState;
+
+	/* The playback state viewed by this player. */
+	FPaperZDAnimPlayerState* State;
 
 public:
 	/**
@@ -68,7 +320,6 @@ public:
 	 */
 	UPROPERTY(BlueprintAssignable, Category = "Playback")
 	FOnPlaybackSequenceCompleteSignature OnPlaybackSequenceComplete;
-	FOnPlaybackSequenceCompleteSignature_Native OnPlaybackSequenceComplete_Native;
 
 	/**
 	 * Called when the currently played AnimSequence loops. Only called if the playback is set to loop.
@@ -91,6 +342,21 @@ public:
 	//ctor
 	UPaperZDAnimPlayer();
 
+	/**
+	 * Creates a player that views the given playback state, taking over its playback settings.
+	 * @param Outer		Owner of the playback state, the player must not outlive it.
+	 * @param InState	State to view.
+	 */
+	static UPaperZDAnimPlayer* CreateProxy(UObject* Outer, FPaperZDAnimPlayerState& InState);
+
+	/* Obtain the playback state viewed by this player. */
+	FPaperZDAnimPlayerState& GetState() { return *State; }
+	const FPaperZDAnimPlayerState& GetState() const { return *State; }
+
+	//~Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~End UObject Interface
+
 	/**
 	 * Obtain the last played time of the primary animation that is currently being played.
 	 * 
@@ -118,41 +384,17 @@ public:
 	 UFUNCTION(BlueprintPure, Category = "Playback")
 	 const UPaperZDAnimSequence* GetCurrentAnimSequence() const;
 
-	/* Resets the cached current animation to none. */
-	void ClearCachedAnimationData();
-
-	/* Initializes this player for use with the given Animation Source. */
-	void Init(const UPaperZDAnimationSource* AnimationSource);
-
-	/* Changes if this is a preview player or not. Some AnimSequences play or configure differently on PreviewMode. */
-	void SetIsPreviewPlayer(bool bInPreviewPlayer);
-
-	/**
-	 * Ticks the playback of the given animation asset.
-	 * @param AnimSequence		Asset which will be ticked.
-	 * @param PlaybackMarker	A reference to the current playback marker that points at the current progress, will get updated with the new value.
-	 * @param DeltaTime			The delta time to tick.
-	 * @param bLooping			Whether the animation should start again after reaching the end.
-	 * @param OwningInstance	The AnimInstance that owns the playback.
-	 * @param EffectiveWeight	The weight of the sequence that is playing, if below a given value the sequence will only update the time but not trigger any notifies.
-	 * @param bIgnoreNotifies	If no notifies should be triggered, even if their EffectiveWeight allows them to be called.
-	 */
-	void TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance = nullptr, float EffectiveWeight = 1.0f, bool bSkipNotifies = false);
-
 	/**
-	 * Processes the given AnimSequence and triggers all the notifies that are relevant in the playback window.
+	 * Obtain the time left until the current, biggest weighted, animation sequence reaches a notify of the given class.
+	 * Useful for gameplay code that needs to know ahead of time when an action frame will happen.
+	 * The returned time is measured in sequence time, without taking into account any play rate applied by the AnimNodes.
+	 * @param NotifyClass		Class of the notify to search for, child classes are accepted.
+	 * @param bLooping			If true, the search wraps around the sequence when no notify is found before reaching its end.
+	 * @param OutTimeRemaining	Time left until the notify is reached.
+	 * @return					True if a notify was found.
 	 */
-	 void ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight = 1.0f, UPaperZDAnimInstance* OwningInstance = nullptr);
-
-	/**
-	 * Plays the given single animation
-	 */
-	void PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime);
-
-	/**
-	 * Evaluates the given animation data structure and potentially mixes all the given animations into a final pose, if the AnimSequence source supports it.
-	 */
-	 void Play(const FPaperZDAnimationPlaybackData& PlaybackData);
+	UFUNCTION(BlueprintCallable, Category = "Playback")
+	bool GetTimeToNextNotify(TSubclassOf<UPaperZDAnimNotify_Base> NotifyClass, bool bLooping, float& OutTimeRemaining) const;
 
 	/**
 	 * Registers the render component to use for rendering the animation sequences.
@@ -163,7 +405,7 @@ public:
 
 	/* Returns true if the player is currently running. */
 	UFUNCTION(BlueprintPure, Category = "Playback")
-	bool IsPlaying() const { return bPlaying; }
+	bool IsPlaying() const { return State->IsPlaying(); }
 
 	/* Resumes the updating of the animation nodes. */
 	UFUNCTION(BlueprintCallable, Category = "Playback")
@@ -172,12 +414,31 @@ public:
 	/* Pauses the updating of the animation nodes. */
 	UFUNCTION(BlueprintCallable, Category = "Playback")
 	void PausePlayback();
+
+	//Native playback controls, see FPaperZDAnimPlayerState
+	void ClearCachedAnimationData();
+	void Init(const UPaperZDAnimationSource* AnimationSource);
+	void ResetForReuse(const UPaperZDAnimationSource* AnimationSource);
+	void SetIsPreviewPlayer(bool bInPreviewPlayer);
+	void TickPlayback(const UPaperZDAnimSequence* AnimSequence, float& PlaybackMarker, float DeltaTime, bool bLooping, UPaperZDAnimInstance* OwningInstance = nullptr, float EffectiveWeight = 1.0f, bool bSkipNotifies = false);
+	void ProcessAnimSequenceNotifies(const UPaperZDAnimSequence* AnimSequence, float FromTime, float ToTime, float Weight = 1.0f, UPaperZDAnimInstance* OwningInstance = nullptr);
+	void PlaySingleAnimation(const UPaperZDAnimSequence* AnimSequence, float Playtime);
+	void Play(const FPaperZDAnimationPlaybackData& PlaybackData);
+	void BeginDeferredGameThreadWork();
+	void FlushDeferredGameThreadWork();
+	uint32 GetSequenceCompleteCount() const { return State->GetSequenceCompleteCount(); }
+	void SetNotifyPolicy(EPaperZDAnimLODNotifyPolicy InNotifyPolicy);
+	EPaperZDAnimLODNotifyPolicy GetNotifyPolicy() const { return State->GetNotifyPolicy(); }
+	void BeginTrackingPlaybackEvents();
+	float EndTrackingPlaybackEvents();
+
+	/**
+	 * Obtains how much sequence time is left until the given playback reaches a keyframe change, a notify, a loop or its completion.
+	 * @return	The time until the event, MAX_flt if no event will ever happen.
+	 */
+	static float GetTimeToNextPlaybackEvent(const UPaperZDAnimSequence* AnimSequence, float PlaybackMarker, bool bLooping, bool bReverse);
 	
 	//@Deprecated Function: The playback progress is now managed by each "PlaySequence" node and thus, this method will not do anything.
 	UFUNCTION(BlueprintCallable, Category = "Playback", meta = (DeprecatedFunction, DeprecationMessage = "Playback progress is now managed and stored by each PlaySequence node. This method will have no effect and will be removed in a later version."))
 	void SetCurrentPlaybackTime(float InCurrentTime) {}
-
-private:
-	/* True if the given weight can be considered as "relevant" for triggering notifies and calling events. */
-	bool IsRelevantWeight(float Weight) const;
 };
@@ -48,8 +48,8 @@ public:
  */
 struct FPaperZDAnimationPlaybackData
 {
-	/* The list of weighted animations to apply. */
-	TArray<FPaperZDWeightedAnimation> WeightedAnimations;
+	/* The list of weighted animations to apply, inlined as most graphs only output a few animations at a time. */
+	TArray<FPaperZDWeightedAnimation, TInlineAllocator<4>> WeightedAnimations;
 
 	/* The directional angle to use with multi-directional sequences. */
 	float DirectionalAngle;
@@ -60,6 +60,9 @@ public:
 		: DirectionalAngle(0.0f)
 	{}
 
+	/* Clears the playback data, keeping the allocated memory for reuse. */
+	void Reset();
+
 	/* Overwrites the playback data to only hold the given animation. */
 	void SetAnimation(const UPaperZDAnimSequence* Sequence, float PlaybackTime);
 
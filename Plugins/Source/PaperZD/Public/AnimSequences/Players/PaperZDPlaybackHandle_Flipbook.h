@@ -6,16 +6,50 @@
 #include "AnimSequences/Players/PaperZDPlaybackHandle.h"
 #include "PaperZDPlaybackHandle_Flipbook.generated.h"
 
+class UPaperFlipbook;
+
 /**
  * Playback handle that manages rendering of Paper2D flipbook components.
+ * Keeps track of the keyframe last pushed to the component and skips any update that wouldn't change the rendered keyframe.
  */
 UCLASS()
 class PAPERZD_API UPaperZDPlaybackHandle_Flipbook : public UPaperZDPlaybackHandle
 {
 	GENERATED_BODY()
-	
+
+	/* If true, the playback position sent to the component snaps to the keyframe boundaries instead of following the exact playback time. */
+	bool bFrameQuantized;
+
+	/* Component and flipbook that received the last update, only used for comparison. */
+	const UPrimitiveComponent* LastRenderComponent;
+	const UPaperFlipbook* LastFlipbook;
+
+	/* Playback position that was last set on the component. */
+	float LastPlaybackPosition;
+
+	/* Time range covered by the last rendered keyframe, the start is exclusive and the end inclusive to match how Paper2D resolves the keyframes. */
+	float KeyFrameStartTime;
+	float KeyFrameEndTime;
+
+	/* Time at which the last rendered keyframe ends, used as the snapped position when frame-quantized. */
+	float KeyFrameSnapTime;
+
+public:
+	//ctor
+	UPaperZDPlaybackHandle_Flipbook();
+
 	//~ Begin UPaperZDPlaybackHandle Interface
 	virtual void UpdateRenderPlayback(UPrimitiveComponent* RenderComponent, const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback = false) override;
 	virtual void ConfigureRenderComponent(UPrimitiveComponent* RenderComponent, bool bIsPreviewPlayback = false) override;
 	//~ End UPaperZDPlaybackHandle Interface
+
+	/* Changes whether the playback position sent to the component snaps to the keyframe boundaries. */
+	void SetFrameQuantized(bool bInFrameQuantized);
+
+	/* Forgets the last rendered state, forcing the next update to be pushed to the component. */
+	void InvalidateRenderState();
+
+private:
+	/* Checks if the given time still resolves to the last rendered keyframe. */
+	FORCEINLINE bool IsInsideRenderedKeyFrame(float Time) const { return Time > KeyFrameStartTime && Time <= KeyFrameEndTime; }
 };
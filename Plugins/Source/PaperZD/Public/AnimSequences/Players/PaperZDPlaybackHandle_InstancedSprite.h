@@ -0,0 +1,49 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle_Flipbook.h"
+#include "PaperZDPlaybackHandle_InstancedSprite.generated.h"
+
+class UPaperZDInstancedSpriteComponent;
+class UPaperFlipbook;
+
+/**
+ * Playback handle that renders flipbook animations as a single instance of a shared instanced sprite component.
+ * The instance follows the root of the actor that owns the AnimInstance. Any other render component falls back to the regular flipbook handling.
+ */
+UCLASS()
+class PAPERZD_API UPaperZDPlaybackHandle_InstancedSprite : public UPaperZDPlaybackHandle_Flipbook
+{
+	GENERATED_BODY()
+
+	/* Instanced component that holds our instance. */
+	TWeakObjectPtr<UPaperZDInstancedSpriteComponent> InstancedComponent;
+
+	/* Index of our instance on the instanced component. */
+	int32 InstanceIndex;
+
+public:
+	//ctor
+	UPaperZDPlaybackHandle_InstancedSprite();
+
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+	//~ Begin UPaperZDPlaybackHandle Interface
+	virtual void UpdateRenderPlayback(UPrimitiveComponent* RenderComponent, const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback = false) override;
+	virtual void ConfigureRenderComponent(UPrimitiveComponent* RenderComponent, bool bIsPreviewPlayback = false) override;
+	//~ End UPaperZDPlaybackHandle Interface
+
+	/* Obtain the index of the instance this handle renders to, INDEX_NONE if not rendering through an instanced component. */
+	int32 GetInstanceIndex() const { return InstanceIndex; }
+
+	/* Obtain the flipbook the given playback data displays, the same one this handle pushes to its instance. */
+	static const UPaperFlipbook* ResolveFlipbook(const FPaperZDAnimationPlaybackData& PlaybackData, bool bIsPreviewPlayback = false);
+
+private:
+	/* Gives back the instance we were holding, if any. */
+	void ReleaseInstance();
+};
@@ -70,6 +70,10 @@ public:
 	/* Returns the render component class to use for this animation source. Used for creating preview render components and validate which components can be used when trying to render the animations contained on this source. */
 	virtual TSubclassOf<UPrimitiveComponent> GetRenderComponentClass() const { return nullptr; }
 
+	//~ Begin UObject Interface
+	virtual bool CanBeClusterRoot() const override;
+	//~ End UObject Interface
+
 #if WITH_EDITOR
 	//~ Begin UObject Interface
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
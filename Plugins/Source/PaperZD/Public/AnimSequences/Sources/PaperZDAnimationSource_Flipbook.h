@@ -13,12 +13,28 @@ class PAPERZD_API UPaperZDAnimationSource_Flipbook : public UPaperZDAnimationSou
 {
 	GENERATED_BODY()
 
+public:
+	/**
+	 * If true, the playback position sent to the flipbook components snaps to the keyframe boundaries instead of following the exact playback time.
+	 * The rendered keyframes are the same either way, but the position reported by the component only changes when the keyframe does.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Rendering")
+	bool bFrameQuantizedPlayback;
+
+	/**
+	 * If true, the AnimBPs of this source can render through a PaperZD Instanced Sprite component, drawing many characters as instances of a single component.
+	 * Regular flipbook components keep working as usual.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Rendering")
+	bool bSupportsInstancedRendering;
+
 public:
 	//ctor
 	UPaperZDAnimationSource_Flipbook();
 	
 	//~ Begin UPaperZDAnimationSource Interface
 	virtual TSubclassOf<UPaperZDPlaybackHandle> GetPlaybackHandleClass() const override;
+	virtual void InitPlaybackHandle(UPaperZDPlaybackHandle* Handle) const override;
 	virtual TSubclassOf<UPrimitiveComponent> GetRenderComponentClass() const override;
 	//~ End UPaperZDAnimationSource Interface
 };
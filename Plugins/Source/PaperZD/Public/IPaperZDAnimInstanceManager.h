@@ -41,6 +41,11 @@ public:
 	 */
 	virtual void OnSetupAnimPlayer(UPaperZDAnimPlayer* AnimPlayer) {}
 
+	/**
+	 * Called when the AnimInstance requests to be woken up, managers that let their instance sleep should resume its update.
+	 */
+	virtual void OnWakeUpAnimInstance() {}
+
 	/**
 	 * Called to obtain the world context, defaults to the world of the owning actor, if available.
 	 * If none returns, then methods that require world context won't be available.
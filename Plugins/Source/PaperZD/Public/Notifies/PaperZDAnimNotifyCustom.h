@@ -19,5 +19,13 @@ public:
 #if WITH_EDITOR
 	/* Custom notifies cannot be placed directly. */
 	virtual bool CanBePlaced(UPaperZDAnimSequence* Animation) const override { return false; }
+
+	virtual bool PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const override;
 #endif
+
+	/* Calls the function the AnimBP registered for the given custom notify name, shared with the packed version of this notify. */
+	static void CallNotifyFunction(UPaperZDAnimInstance* OwningInstance, FName NotifyName);
+
+protected:
+	virtual bool SupportsClustering() const override { return true; }
 };
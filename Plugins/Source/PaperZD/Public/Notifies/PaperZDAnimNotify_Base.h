@@ -6,6 +6,7 @@
 #include "PaperZDAnimNotify_Base.generated.h"
 
 class UPaperZDAnimSequence;
+struct FPaperZDPackedNotify;
 
 /**
  * Base class for all the plugin's notifies.
@@ -48,10 +49,17 @@ public:
 	*/
 	virtual class UWorld* GetWorld() const override;
 
+	//~Begin UObject Interface
+	virtual bool CanBeInCluster() const override;
+	//~End UObject Interface
+
 	//Called each Tick to process the notify and trigger it when necessary 
 	//Playtime and PreviousPlaytime are given for convenience, because the animation can loop
 	virtual void TickNotify(float DeltaTime, float Playtime, float LastPlaybackTime, UPrimitiveComponent* AnimRenderComponent, UPaperZDAnimInstance* OwningInstance = nullptr);
 
+	/* Ticks the notify on behalf of a player. Notifies that support clustering let go of the render component right after, as the collector doesn't see what clustered objects reference. */
+	void ProcessNotifyTick(float DeltaTime, float Playtime, float LastPlaybackTime, UPrimitiveComponent* AnimRenderComponent, UPaperZDAnimInstance* OwningInstance);
+
 	/**
 	 * Obtain the name to be displayed on the editor's detail's panel
 	 */
@@ -60,9 +68,25 @@ public:
 
 #if WITH_EDITOR
 	virtual bool CanBePlaced(UPaperZDAnimSequence* Animation) const { return true; }
+
+	/**
+	 * Override to let cooked sequences store this notify as a packed record instead of keeping the object.
+	 * Only built-in notifies can be packed, as the record gets dispatched by a native handler that knows nothing about child classes.
+	 * @param OutNotify			Record to fill, comes with the time already set.
+	 * @param OutTransforms		Transforms shared by the records of the sequence, for notifies that need one.
+	 * @return					True if the notify was packed.
+	 */
+	virtual bool PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const { return false; }
 #endif
 
 protected:
 	/* Obtain the asset that contains this notify instance.*/
 	UObject* GetContainingAsset() const;
+
+	/**
+	 * Override to let the notify join the garbage collection cluster of its sequence. Blueprint notifies never do.
+	 * The collector stops tracking the references of clustered notifies, so they can only reference assets and must use the render component only while ticking, it gets cleared afterwards.
+	 * Cooked sequences pack the built-in notifies instead, so this only affects the notifies that don't get packed: native child classes, or every notify when cooking with paperzd.PackBuiltInNotifies off.
+	 */
+	virtual bool SupportsClustering() const { return false; }
 };
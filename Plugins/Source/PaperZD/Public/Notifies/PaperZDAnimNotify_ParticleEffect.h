@@ -57,6 +57,18 @@ public:
 	//Override the native notify implementation
 	void OnReceiveNotify_Implementation(UPaperZDAnimInstance* OwningInstance = nullptr) override;
 	FName GetDisplayName_Implementation() const override;
-	
-	
+
+#if WITH_EDITOR
+	virtual bool PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const override;
+#endif
+
+	/**
+	 * Spawns the particle system around the given render component, shared with the packed version of this notify.
+	 * @param Offset	Location, rotation and scale offsets from the socket.
+	 * @param Source	Asset reported if the system can't be spawned.
+	 */
+	static void SpawnEffectForComponent(UParticleSystem* PSTemplate, UPrimitiveComponent* RenderComponent, const FTransform& Offset, bool bAttached, FName SocketName, const UObject* Source);
+
+protected:
+	virtual bool SupportsClustering() const override { return true; }
 };
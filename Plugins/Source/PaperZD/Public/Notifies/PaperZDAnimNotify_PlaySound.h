@@ -41,4 +41,16 @@ public:
 	void OnReceiveNotify_Implementation(UPaperZDAnimInstance *OwningInstance = nullptr) override;
 	FName GetDisplayName_Implementation() const override;
 
+#if WITH_EDITOR
+	virtual bool PackNotify(FPaperZDPackedNotify& OutNotify, TArray<FTransform>& OutTransforms) const override;
+#endif
+
+	/**
+	 * Plays the sound around the given render component, shared with the packed version of this notify.
+	 * @param Source	Asset reported if the sound can't be played.
+	 */
+	static void PlaySoundForComponent(USoundBase* Sound, UPrimitiveComponent* RenderComponent, float VolumeMultiplier, float PitchMultiplier, bool bFollow, FName AttachName, const UObject* Source);
+
+protected:
+	virtual bool SupportsClustering() const override { return true; }
 };
@@ -0,0 +1,28 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPaperZDAnimInstance;
+class UPaperZDAnimNotify_Base;
+
+/**
+ * Reports a notify that triggers to every diagnostic tool at once: counters, profiler, node costs, recorder and trace.
+ * Notifies call it right before running their event, so every kind of notify gets measured the same way.
+ */
+struct PAPERZD_API FPaperZDNotifyInstrumentation
+{
+	/* Called when a notify triggers, or a notify state begins. */
+	static void OnNotifyFired(UPaperZDAnimInstance* OwningInstance, const UPaperZDAnimNotify_Base* Notify, float Time);
+
+	/**
+	 * Called when a notify that isn't an object triggers, i.e. a packed notify.
+	 * @param OwningInstance	Instance that receives the notify, can be null on editor.
+	 * @param RecordedObject	Object shown by the recorder for this notify.
+	 * @param NotifyName		Name reported to the trace.
+	 * @param NotifyClass		Class of the notify the record stands for.
+	 * @param Time				Time of the notify on its sequence.
+	 */
+	static void OnNotifyFired(UPaperZDAnimInstance* OwningInstance, const UObject* RecordedObject, FName NotifyName, const UClass* NotifyClass, float Time);
+};
@@ -0,0 +1,91 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "PaperZDPackedNotify.generated.h"
+
+class UPrimitiveComponent;
+class UPaperZDAnimInstance;
+class UPaperZDAnimSequence;
+
+/**
+ * Built-in notify types that can be stored as packed records.
+ */
+UENUM()
+enum class EPaperZDPackedNotifyType : uint8
+{
+	PlaySound,
+	ParticleEffect,
+	Custom
+};
+
+/**
+ * Plain data version of a built-in notify (play sound, particle effect or custom notify), stored on cooked AnimSequences instead of the notify object.
+ * Records are kept sorted by time on the sequence and get dispatched by native handlers, so the playback can scan them without touching any object.
+ * Notifies that aren't built-in, or are child classes of the built-in ones, always stay as objects.
+ */
+USTRUCT()
+struct PAPERZD_API FPaperZDPackedNotify
+{
+	GENERATED_BODY()
+
+	/* Playback time that triggers this notify. */
+	UPROPERTY()
+	float Time;
+
+	/* Type of the notify, selects the handler and the meaning of the rest of the fields. */
+	UPROPERTY()
+	EPaperZDPackedNotifyType Type;
+
+	/* If the sound follows the render component, or if the particle effect gets attached to it. */
+	UPROPERTY()
+	bool bAttached;
+
+	/* Socket to attach to or spawn at for sounds and particles, function name for custom notifies. */
+	UPROPERTY()
+	FName Name;
+
+	/* Sound or particle system to spawn. */
+	UPROPERTY()
+	UObject* Asset;
+
+	/* Volume and pitch multipliers for sounds. */
+	UPROPERTY()
+	float VolumeMultiplier;
+
+	UPROPERTY()
+	float PitchMultiplier;
+
+	/* Index of the offset transform of particle effects, stored apart on the sequence so the records stay small. */
+	UPROPERTY()
+	int32 TransformIndex;
+
+public:
+	//ctor
+	FPaperZDPackedNotify()
+		: Time(0.0f)
+		, Type(EPaperZDPackedNotifyType::Custom)
+		, bAttached(false)
+		, Name(NAME_None)
+		, Asset(nullptr)
+		, VolumeMultiplier(1.0f)
+		, PitchMultiplier(1.0f)
+		, TransformIndex(INDEX_NONE)
+	{}
+
+	/* Obtain the notify class this record was packed from. */
+	UClass* GetNotifyClass() const;
+
+	/* Obtain the name the notify object would display. */
+	FName GetDisplayName() const;
+
+	/**
+	 * Triggers the notify, with the same bookkeeping the notify objects do when they fire.
+	 * @param AnimSequence		Sequence that stores the record.
+	 * @param RenderComponent	Render component the sequence is playing on.
+	 * @param OwningInstance	Instance that plays the sequence, null on the editor.
+	 */
+	void Fire(const UPaperZDAnimSequence* AnimSequence, UPrimitiveComponent* RenderComponent, UPaperZDAnimInstance* OwningInstance) const;
+};
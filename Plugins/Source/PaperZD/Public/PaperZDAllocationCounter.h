@@ -0,0 +1,43 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#ifndef PAPERZD_ALLOCATION_COUNTER_ENABLED
+#define PAPERZD_ALLOCATION_COUNTER_ENABLED !UE_BUILD_SHIPPING
+#endif
+
+#if PAPERZD_ALLOCATION_COUNTER_ENABLED
+
+/**
+ * Counts the heap allocations done through the engine allocator while in scope, used by benchmarks and tests to check the allocation behavior of the runtime.
+ * The first counter installs a forwarding proxy in front of GMalloc, which stays in place afterwards and only counts while a counter is active.
+ * Only one counter can be active at a time, and it should be created and destroyed on the game thread. Compiled out of shipping builds, so the proxy never replaces the allocator there.
+ */
+class PAPERZD_API FPaperZDScopedAllocationCounter
+{
+public:
+	/**
+	 * Starts counting.
+	 * @param bInCurrentThreadOnly	If true, only the allocations done by the thread that creates the counter are counted, ignoring any unrelated engine thread.
+	 */
+	explicit FPaperZDScopedAllocationCounter(bool bInCurrentThreadOnly = false);
+	~FPaperZDScopedAllocationCounter();
+
+	/* Stops counting, the counters keep their value. */
+	void Stop();
+
+	/* Number of allocations done so far, reallocations that had to move the block count as allocations. */
+	int64 GetNumAllocations() const;
+
+	/* Bytes requested by those allocations. */
+	int64 GetAllocatedBytes() const;
+
+private:
+	bool bCounting;
+	int64 NumAllocations;
+	int64 AllocatedBytes;
+};
+
+#endif //PAPERZD_ALLOCATION_COUNTER_ENABLED
@@ -25,7 +25,11 @@ public:
 	/* Animation source that we're implementing. */
 	UPROPERTY(AssetRegistrySearchable, VisibleDefaultsOnly, Category = "PaperZD")
 	UPaperZDAnimationSource* SupportedAnimationSource = nullptr;
-	
+
+	/* If true, the compiler will warn about every pin binding that cannot use the fast path and needs to run through the blueprint VM, which also keeps the AnimBP from updating in parallel. Otherwise they're only listed as notes. */
+	UPROPERTY(EditAnywhere, Category = "Optimization")
+	bool bWarnAboutBlueprintUsage = true;
+
 private:
 	/* Names of the registered notifies. */
 	UPROPERTY()
@@ -5,19 +5,52 @@
 #include "Engine/BlueprintGeneratedClass.h"
 #include "AnimNodes/PaperZDAnimNode_Base.h"
 #include "AnimNodes/PaperZDAnimStateMachine.h"
+#include "AnimNodes/PaperZDAnimProgram.h"
+#include "AnimNodes/PaperZDAnimNode_RandomPlayer.h"
+#include "PaperZDNodeCost.h"
 #include "PaperZDAnimBPGeneratedClass.generated.h"
 
 struct FPaperZDAnimNode_Sink;
 struct FPaperZDAnimNode_StateMachine;
 class UPaperZDAnimationSource;
+class UPaperZDAnimInstance;
 
 /**
- * Structure that holds the debug data for a given AnimBP class
+ * Maps the editor nodes of a state machine graph to the indices they were baked into.
+ */
+struct FPaperZDStateMachineDebugData
+{
+	/* Index of the baked state machine on the generated class. */
+	int32 StateMachineIndex;
+
+	/* State and conduit nodes, keyed by their guid. */
+	TMap<FGuid, int32> NodeGuidToStateIndex;
+
+	/* Transition nodes, keyed by their guid, mapped to the index of the rule that drives them. */
+	TMap<FGuid, int32> TransitionGuidToRuleIndex;
+
+	//ctor
+	FPaperZDStateMachineDebugData()
+		: StateMachineIndex(INDEX_NONE)
+	{}
+};
+
+/**
+ * Structure that holds the debug data for a given AnimBP class.
+ * Generated while compiling, lets the editor map what the AnimInstances record back to the graph nodes.
  */
 USTRUCT()
 struct PAPERZD_API FPaperZDAnimBPDebugData
 {
 	GENERATED_BODY()
+
+#if WITH_EDITORONLY_DATA
+	/* State machines, keyed by the guid of their AnimGraph node. Guids survive the graph cloning done by the compiler. */
+	TMap<FGuid, FPaperZDStateMachineDebugData> StateMachines;
+
+	/* LinkID of every AnimNode, keyed by the guid of its AnimGraph node. */
+	TMap<FGuid, int32> NodeGuidToLinkID;
+#endif
 };
 
 /**
@@ -31,6 +64,7 @@ class PAPERZD_API UPaperZDAnimBPGeneratedClass : public UBlueprintGeneratedClass
 	/* Grant access to the compile time accessor. */
 	friend class FPaperZDAnimBPGeneratedClassAccess;
 	friend class FPaperZDAnimBPCompilerContext;
+	friend struct FPaperZDAnimProgram;
 
 	/* The animation source that the class has been compiled to support. */
 	UPROPERTY()
@@ -44,6 +78,14 @@ class PAPERZD_API UPaperZDAnimBPGeneratedClass : public UBlueprintGeneratedClass
 	UPROPERTY()
 	TArray<FPaperZDAnimStateMachine> StateMachines;
 
+	/* Linear programs for each sink node whose graph could be flattened. */
+	UPROPERTY()
+	TArray<FPaperZDAnimProgram> AnimPrograms;
+
+	/* Constant data of the random player nodes, shared by every instance. */
+	UPROPERTY()
+	TArray<FPaperZDRandomPlayerData> RandomPlayers;
+
 	/* Mapping between Custom AnimNotify name to function name. */
 	UPROPERTY()
 	TMap<FName, FName> AnimNotifyFunctionMapping;
@@ -55,6 +97,26 @@ class PAPERZD_API UPaperZDAnimBPGeneratedClass : public UBlueprintGeneratedClass
 	/* Pointer to the root node property. */
 	FStructProperty* RootNodeProperty;
 
+	/* True if every AnimNode on this class, along with its exposed values, can be updated outside of the game thread. */
+	bool bSupportsParallelUpdate;
+
+	/* State machine events and custom notifies resolved while prewarming, keyed by the name they're looked up with. */
+	TMap<FName, UFunction*> PrewarmedEventFunctions;
+	TMap<FName, UFunction*> PrewarmedNotifyFunctions;
+
+	/* True once the class has been prewarmed, reset when the class gets purged. */
+	bool bPrewarmed;
+
+#if WITH_EDITORONLY_DATA
+	/* Data generated while compiling for debugging the instances of this class. */
+	FPaperZDAnimBPDebugData AnimBPDebugData;
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* Costs measured by the instances of this class on the current, or last, play session. */
+	FPaperZDNodeCostData NodeCostData;
+#endif
+
 public:
 	//ctor
 	UPaperZDAnimBPGeneratedClass();
@@ -68,6 +130,10 @@ public:
 	virtual void PostLoadDefaultObject(UObject* Object) override;
 	// End of UClass interface
 
+	// UObject interface
+	virtual void CreateCluster() override;
+	// End of UObject interface
+
 	/* Called after a link, to cache the nodes that require special treatment. */
 	void CacheRequiredNodes(UObject* DefaultObject);
 
@@ -77,9 +143,35 @@ public:
 	/* Obtain a list of the StateMachine nodes that live on the AnimInstance. */
 	TArray<FPaperZDAnimNode_StateMachine*> GetStateMachineNodes(UObject* AnimInstanceObject) const;
 
+	/* Obtain the number of AnimNodes on this class, LinkIDs go from zero to this number. */
+	int32 GetNumAnimNodes() const { return AnimNodeProperties.Num(); }
+
+	/* Obtain the number of StateMachine nodes on this class. */
+	int32 GetNumStateMachineNodes() const { return StateMachineNodeProperties.Num(); }
+
+	/* Obtain the StateMachine node at the given index that lives on the AnimInstance, without allocating a list. */
+	FPaperZDAnimNode_StateMachine* GetStateMachineNode(UObject* AnimInstanceObject, int32 Index) const;
+
 	/* Finds the function implementation for the AnimNotify with the given name. */
 	UFunction* FindAnimNotifyFunction(FName AnimNotifyName) const;
 
+	/* Finds the function implementation for the state machine event with the given name. */
+	UFunction* FindEventFunction(FName EventName) const;
+
+	/**
+	 * Resolves ahead of time the work the first instance of this class would otherwise do lazily: the functions bound to the exposed values,
+	 * state machine events and custom notifies, and gets the animation data referenced by the class ready to render.
+	 * Does nothing if the class was already prewarmed.
+	 * @return	Time spent prewarming, in milliseconds.
+	 */
+	double Prewarm();
+
+	/* True if the class has been prewarmed. */
+	bool IsPrewarmed() const { return bPrewarmed; }
+
+	/* Gathers the sequences referenced by this class and its parents: the ones baked onto the class, the ones used by the graph functions and the ones held by the AnimNodes and variables. */
+	void GetReferencedSequences(TSet<const UPaperZDAnimSequence*>& OutSequences) const;
+
 	/* Obtain the AnimNode that is linked by the given LinkID. */
 	FPaperZDAnimNode_Base* GetAnimNodeByLinkID(UObject* AnimInstanceObject, int32 LinkID) const;
 
@@ -96,8 +188,32 @@ public:
 	/* Get the list of state machine definitions. */
 	const TArray<FPaperZDAnimStateMachine>& GetStateMachines() const;
 
+	/* Get the constant data of the random player nodes. */
+	const TArray<FPaperZDRandomPlayerData>& GetRandomPlayers() const { return RandomPlayers; }
+
+	/**
+	 * Measures the memory used by the AnimNodes of this class.
+	 * @param OutInstanceBytes	Bytes each AnimInstance holds for its AnimNodes, including what their containers allocate.
+	 * @param OutSharedBytes	Bytes of constant node data kept once on the class, that each AnimInstance would otherwise hold a copy of. Only the random player entries are kept on the class.
+	 */
+	void GetNodeMemoryUsage(SIZE_T& OutInstanceBytes, SIZE_T& OutSharedBytes) const;
+
 	/* Obtain the type of AnimSequence supported by this class. */
 	const UPaperZDAnimationSource* GetSupportedAnimationSource() const;
+
+	/* True if the animation graph of this class can be updated outside of the game thread. */
+	bool SupportsParallelUpdate() const { return bSupportsParallelUpdate; }
+
+#if WITH_EDITORONLY_DATA
+	/* Obtain the data generated while compiling for debugging the instances of this class. */
+	const FPaperZDAnimBPDebugData& GetAnimBPDebugData() const { return AnimBPDebugData; }
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* Obtain the costs measured by the instances of this class. */
+	FPaperZDNodeCostData& GetNodeCostData() { return NodeCostData; }
+	const FPaperZDNodeCostData& GetNodeCostData() const { return NodeCostData; }
+#endif
 };
 
 /* Helper function to quickly obtain the ZD AnimGeneratedClass from the given object. */
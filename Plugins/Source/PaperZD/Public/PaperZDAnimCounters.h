@@ -0,0 +1,55 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Process wide counters of the animation events, used to measure the runtime behavior outside of the stats system (i.e. on benchmarks).
+ * Counting is disabled by default, so the only cost on a normal run is the check of the flag.
+ * Events can happen on the parallel update, so the counters are atomic.
+ */
+struct PAPERZD_API FPaperZDAnimCounters
+{
+	/* Snapshot of every counter. */
+	struct FSnapshot
+	{
+		int64 NotifiesFired = 0;
+		int64 StateTransitions = 0;
+	};
+
+private:
+	static bool bEnabled;
+	static std::atomic<int64> NotifiesFired;
+	static std::atomic<int64> StateTransitions;
+
+public:
+	/* Starts or stops counting, the counters keep their value. */
+	static void SetEnabled(bool bInEnabled) { bEnabled = bInEnabled; }
+	static bool IsEnabled() { return bEnabled; }
+
+	/* Sets every counter back to zero. */
+	static void Reset();
+
+	/* Obtain the current value of every counter. */
+	static FSnapshot GetSnapshot();
+
+	/* Called when a notify triggers, or a notify state begins. */
+	static FORCEINLINE void CountNotifyFired()
+	{
+		if (bEnabled)
+		{
+			NotifiesFired.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	/* Called when a state machine follows a transition. */
+	static FORCEINLINE void CountStateTransition()
+	{
+		if (bEnabled)
+		{
+			StateTransitions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+};
@@ -5,14 +5,18 @@
 #include "UObject/Interface.h"
 #include "Templates/SubclassOf.h"
 #include "IPaperZDAnimInstanceManager.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "PaperZDAnimRecorder.h"
+#include "PaperZDNodeCost.h"
 #include "PaperZDAnimInstance.generated.h"
 
 class UPaperZDAnimSequence;
-class UPaperZDAnimPlayer;
 class UWorld;
 class UFunction;
 class APaperZDCharacter;
 struct FPaperZDAnimNode_Sink;
+struct FPaperZDAnimSharingKey;
 
 /**
  * Runtime class that the AnimBP gets compiled into.
@@ -22,7 +26,11 @@ class PAPERZD_API UPaperZDAnimInstance : public UObject
 {
 	GENERATED_BODY()
 
-	/* Pointer to the Animation Player that is responsible of the playback of the sequences. */
+	/* Playback state of the sequences, driven directly by the AnimNodes. */
+	UPROPERTY(Transient)
+	FPaperZDAnimPlayerState PlayerState;
+
+	/* Player object that exposes the playback state to blueprints. Only created when requested if the instance uses the lightweight player. */
 	UPROPERTY(Transient)
 	UPaperZDAnimPlayer* AnimPlayer;
 
@@ -41,6 +49,46 @@ class PAPERZD_API UPaperZDAnimInstance : public UObject
 
 	/* If true, sequencer is currently running a movie scene through this AnimInstance and hence, we have paused the AnimSequence update and evaluations. */
 	bool bSequencerOverride;
+
+	/* True if the instance was initialized with the lightweight player. */
+	bool bUsingLightweightPlayer;
+
+	/* True while the AnimGraph is being updated outside of the game thread. */
+	bool bRunningParallelUpdate;
+
+	/* If true, the AnimGraph keeps updating but its result isn't evaluated nor sent to the render component. */
+	bool bSkipRenderUpdate;
+
+	/* Delta time prepared on the game thread for the parallel update. */
+	float ParallelUpdateDeltaTime;
+
+	/* Time until the next playback event after the last update, as a multiple of the delta time used. Only computed when sleeping is allowed. */
+	float SleepDeltaScale;
+
+	/* Number of times the AnimGraph has been updated, state machines compare against it to know if they were active on the last update. */
+	uint32 GraphUpdateCount;
+
+	/* Cycles spent on the current update across the game thread and the parallel phase, only tracked while the profiler is active. */
+	uint64 ProfileTickCycles;
+
+	/* Animation data evaluated on the last update, reused every frame to avoid allocating. The parallel update leaves it waiting to be played on the game thread. */
+	FPaperZDAnimationPlaybackData EvaluatedPlaybackData;
+
+	/* Blueprint events requested by the AnimNodes during the parallel update, called on the game thread afterwards. */
+	TArray<FName> DeferredEvents;
+
+#if PAPERZD_RECORDER_ENABLED
+	/* History of the last updates, inspected by the AnimBP editor. */
+	FPaperZDAnimRecorder Recorder;
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* Costs measured along the current update, merged into the class when the update ends. */
+	FPaperZDNodeCostData NodeCosts;
+
+	/* True if the current update is measuring its costs. */
+	bool bCapturingNodeCosts;
+#endif
 	
 public:
 
@@ -57,6 +105,22 @@ private:
 	UPROPERTY(EditAnywhere, Category = "PaperZD")
 	bool bAllowTransitionalStates;
 
+	/**
+	 * If true, the instance stops updating while nothing observable changes, sleeping until its sequences reach the next keyframe change, notify, loop or completion.
+	 * Only meant for AnimBPs whose transition inputs don't change on their own. Waking up on a variable change is manual: the instance doesn't watch its variables,
+	 * so any change to the ones the transitions read must be followed by a call to "WakeUp". Jumping to a node and sequencer overrides already wake the instance up.
+	 * The blueprint tick isn't called while sleeping. Requires the owner to be updated by the batched tick, which animation components do automatically when this is set.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD", AdvancedDisplay)
+	bool bAllowSleeping;
+
+	/**
+	 * If true, the instance doesn't create its player object unless something asks for it through "GetPlayer", saving an object per instance for the garbage collector to walk.
+	 * The playback events are sent straight to the instance, and the manager isn't given the player on setup. Can be forced on every instance with paperzd.LightweightPlayer.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD", AdvancedDisplay)
+	bool bUseLightweightPlayer;
+
 public:
 	//ctor
 	UPaperZDAnimInstance();
@@ -70,9 +134,83 @@ public:
 	/* Getter for transitional states */
 	bool AllowsTransitionalStates() const;
 
+	/* True if this instance can sleep while nothing observable changes. */
+	bool AllowsSleeping() const { return bAllowSleeping; }
+
+	/**
+	 * Checks if the instance can go to sleep after its last update.
+	 * @param OutSleepDeltaScale	Time the instance can sleep for, as a multiple of the delta time it was last updated with.
+	 * @return						True if the instance can sleep.
+	 */
+	bool CanSleep(float& OutSleepDeltaScale) const;
+
+	/**
+	 * Obtains the directional angle used to share the animation with other instances of the same AnimBP, only called when the owner enables animation sharing.
+	 * The state the instance shares is taken from its state machines. The angle picks the direction bucket, and followers render the shared animation with their own angle.
+	 * By default reports the angle evaluated on the last own update, AnimBPs with directional sequences should report the angle they feed to their nodes.
+	 * @param OutDirectionalAngle	Directional angle of the instance in degrees.
+	 * @return						False if the instance can't share its animation right now.
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "PaperZD|Sharing")
+	bool GetAnimSharingDirection(float& OutDirectionalAngle) const;
+
+	/**
+	 * Builds the key used to share the animation of this instance, from the current state of every state machine and the reported direction.
+	 * @param NumDirectionBuckets	Number of buckets the directional angle is split into.
+	 * @param OutKey				The resulting key.
+	 * @param OutDirectionalAngle	Directional angle reported by the instance.
+	 * @return						False if the instance can't share its animation right now.
+	 */
+	bool GetAnimSharingKey(int32 NumDirectionBuckets, FPaperZDAnimSharingKey& OutKey, float& OutDirectionalAngle) const;
+
+	/* Hash of the current state of every state machine, including whether they're playing a transitional animation. Instances with the same hash render the same animation. */
+	uint32 GetAnimSharingStateHash() const;
+
+	/**
+	 * Advances the state machines of an instance that follows the shared animation of another one: the transitions and state events run, but no animation is updated.
+	 * Only the state machines the shared instance updated on its last update are advanced, as those are the active ones on both.
+	 * @param DeltaTime			Time to advance.
+	 * @param SharedInstance	Instance that owns the shared animation, already updated this frame.
+	 */
+	void UpdateSharedStateMachines(float DeltaTime, const UPaperZDAnimInstance* SharedInstance);
+
+	/**
+	 * Renders the animation shared by another instance, triggering the notifies crossed since the last shared animation rendered and calling the blueprint tick.
+	 * @param DeltaTime				Time the instance advanced.
+	 * @param SharedPlaybackData	Playback data to render, already adjusted with the direction and time offset of this instance.
+	 */
+	void PlaySharedAnimation(float DeltaTime, const FPaperZDAnimationPlaybackData& SharedPlaybackData);
+
+	/* Number of times the AnimGraph has been updated, or had its state machines advanced while following a shared animation. */
+	uint32 GetGraphUpdateCount() const { return GraphUpdateCount; }
+
+	/* Obtain the animation data evaluated on the last update. */
+	const FPaperZDAnimationPlaybackData& GetEvaluatedPlaybackData() const { return EvaluatedPlaybackData; }
+
+#if PAPERZD_RECORDER_ENABLED
+	/* Obtain the history of the last updates of this instance. */
+	FPaperZDAnimRecorder& GetRecorder() { return Recorder; }
+	const FPaperZDAnimRecorder& GetRecorder() const { return Recorder; }
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* Obtain the costs being measured on the current update, null if they aren't being captured. */
+	FPaperZDNodeCostData* GetNodeCosts() { return bCapturingNodeCosts ? &NodeCosts : nullptr; }
+#endif
+
+	/**
+	 * Wakes the instance up if it was sleeping, so it updates on the next frame.
+	 * Should be called after changing any variable used by the transitions of an AnimBP that allows sleeping, as variable changes don't wake the instance up on their own.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD")
+	void WakeUp();
+
 	/* Tries to find the UFunction that implements the notify with the given name. */
 	UFunction* FindAnimNotifyFunction(FName AnimNotifyName) const;
 
+	/* Tries to find the UFunction that implements the state machine event with the given name. */
+	UFunction* FindEventFunction(FName EventName) const;
+
 	/**
 	 * Called every tick, after all the animations have been processed.
 	 */
@@ -104,10 +242,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "PaperZD")
 	void JumpToNode(FName JumpName, FName StateMachineName = NAME_None);
 
-	/* Obtains the current player, responsible of storing the playback information of this AnimInstance. */
+	/**
+	 * Obtains the current player, responsible of storing the playback information of this AnimInstance.
+	 * Instances that use the lightweight player create it the first time it's requested, native code should prefer "GetPlayerState".
+	 */
 	UFUNCTION(BlueprintPure, Category = "PaperZD|Playback")
 	UPaperZDAnimPlayer* GetPlayer() const;
 
+	/* Obtains the playback state of this AnimInstance, without requiring the player object to exist. */
+	FPaperZDAnimPlayerState& GetPlayerState() { return PlayerState; }
+	const FPaperZDAnimPlayerState& GetPlayerState() const { return PlayerState; }
+
+	/* True if the instance was initialized with the lightweight player. */
+	bool IsUsingLightweightPlayer() const { return bUsingLightweightPlayer; }
+
 	/**
 	 * Event called when we update playback, changing to a new sequence. 
 	 * Only called for Animation Blueprints with "non-blendable" animation sources (like flipbooks), as these will only ever run one animation at a time.
@@ -133,6 +281,36 @@ public:
 	/* Called after sequencer finished playing and thus, should return to normal execution path for the animations. */
 	void RestorePreMovieSequenceState();
 
+	/**
+	 * Stops (or resumes) evaluating the AnimGraph and sending the result to the render component, while still updating it.
+	 * Used by the animation LOD to keep the state machines running for instances that don't need to be rendered.
+	 */
+	void SetSkipRenderUpdate(bool bInSkipRenderUpdate) { bSkipRenderUpdate = bInSkipRenderUpdate; }
+
+	/* True if the instance is currently skipping the render update. */
+	bool IsSkippingRenderUpdate() const { return bSkipRenderUpdate; }
+
+	/* True if the AnimGraph of this instance can currently be updated outside of the game thread. */
+	bool CanUpdateInParallel() const;
+
+	/* True while the AnimGraph is being updated outside of the game thread, AnimNodes should defer any blueprint call while this is set. */
+	bool IsRunningParallelUpdate() const { return bRunningParallelUpdate; }
+
+	/**
+	 * Game thread phase prior to the parallel update.
+	 * Computes the effective delta time and starts deferring the game thread work. Exposed values run as their nodes update, like on the serial path.
+	 */
+	void PreParallelUpdate(float DeltaTime);
+
+	/* Thread-safe phase, updates and evaluates the AnimGraph while recording any game thread work it triggers. */
+	void ParallelUpdateAnimations();
+
+	/* Game thread phase after the parallel update, runs the deferred work, plays the resulting animation and calls the blueprint tick. */
+	void PostParallelUpdate();
+
+	/* Requests a blueprint event to be called once the parallel update finishes. */
+	void QueueDeferredEvent(FName EventName);
+
 	 /** Gets the length in seconds of the asset referenced in an asset player node */
 	UFUNCTION(BlueprintPure, Category="Asset Player", meta=(DisplayName="Length", BlueprintInternalUseOnly="true", AnimGetter="true"))
 	float GetInstanceAssetPlayerLength(int32 AssetPlayerIndex);
@@ -154,9 +332,35 @@ public:
 	float GetInstanceAssetPlayerTimeFromEndFraction(int32 AssetPlayerIndex);
 
 private:
+	//The pool reuses released instances
+	friend class UPaperZDAnimInstancePool;
+
+	/**
+	 * Initializes an instance released to the pool for a new manager.
+	 * Restores the blueprint variables and AnimNodes to the class defaults in place, reusing the player and its playback handle.
+	 */
+	void Reinit(TScriptInterface<IPaperZDAnimInstanceManager> InManager);
+
+	/* Detaches the instance from its manager and render component, so it can be kept on the pool. */
+	void ReleaseFromManager();
+
+	/* Second half of the initialization, shared by new and reused instances. Hooks the player to the manager and initializes the AnimGraph. */
+	void InitAnimGraph();
+
 	/* Obtains the equivalent delta time to use ignoring time dilation. */
 	float GetDeltaTimeIgnoredDilation(float DeltaTime);
 
 	/* Process the animation nodes. */
 	void ProcessAnimations(float DeltaTime);
+
+	/* Calls a blueprint event that was deferred during the parallel update. */
+	void CallDeferredEvent(FName EventName);
+
+#if PAPERZD_NODE_COST_ENABLED
+	/* Starts measuring the costs of an update, if they're being captured. */
+	void BeginNodeCostCapture();
+
+	/* Merges the costs measured along the update into the class. */
+	void EndNodeCostCapture();
+#endif
 };
@@ -0,0 +1,95 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "IPaperZDAnimInstanceManager.h"
+#include "PaperZDAnimInstancePool.generated.h"
+
+class UPaperZDAnimInstance;
+
+/**
+ * Released AnimInstances of a single AnimBP class, waiting to be acquired again.
+ */
+USTRUCT()
+struct FPaperZDAnimInstancePoolBucket
+{
+	GENERATED_BODY()
+
+	/* Generated class shared by every instance on this bucket. */
+	UPROPERTY()
+	UClass* AnimClass;
+
+	/* Instances ready to be acquired. */
+	UPROPERTY()
+	TArray<UPaperZDAnimInstance*> FreeInstances;
+
+	//ctor
+	FPaperZDAnimInstancePoolBucket()
+		: AnimClass(nullptr)
+	{}
+};
+
+/**
+ * Keeps the AnimInstances released by short lived actors (projectiles, hit effects, enemies) so the next spawn of the same AnimBP can reuse them.
+ * Reused instances skip the creation of the instance, its player and its playback handle, and get their variables and AnimNodes restored to the class defaults in place.
+ * The amount of instances kept per class is controlled with paperzd.AnimInstancePoolSize.
+ */
+UCLASS()
+class PAPERZD_API UPaperZDAnimInstancePool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/* Released instances, one bucket per AnimBP class. */
+	UPROPERTY(Transient)
+	TArray<FPaperZDAnimInstancePoolBucket> Buckets;
+
+	/* Instances released while the batched tick was running, they can still have updates pending on the batch. */
+	UPROPERTY(Transient)
+	TArray<UPaperZDAnimInstance*> PendingReleases;
+
+public:
+	//~Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~End USubsystem Interface
+
+	//~Begin UWorldSubsystem Interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	//~End UWorldSubsystem Interface
+
+	/**
+	 * Obtains an initialized AnimInstance of the given class for the given manager, reusing a released one if available.
+	 * @param AnimClass		Class of the AnimInstance to obtain.
+	 * @param InManager		Manager that will own the instance until it gets released.
+	 * @return				The initialized instance, null if no class was given.
+	 */
+	UPaperZDAnimInstance* AcquireInstance(TSubclassOf<UPaperZDAnimInstance> AnimClass, TScriptInterface<IPaperZDAnimInstanceManager> InManager);
+
+	/**
+	 * Detaches the given instance from its manager and keeps it for later reuse, if the pool of its class isn't full. The instance shouldn't be used after this.
+	 * Instances released while the batched tick is running only become available once the batch finishes.
+	 */
+	void ReleaseInstance(UPaperZDAnimInstance* AnimInstance);
+
+	/* Makes the instances released during the batched tick available for reuse, called by the tick subsystem once the batch finishes. */
+	void FlushPendingReleases();
+
+	/* Obtain the amount of released instances kept for the given class. */
+	int32 GetNumFreeInstances(TSubclassOf<UPaperZDAnimInstance> AnimClass) const;
+
+	/* Creates and initializes a fresh AnimInstance without going through the pool, used when pooling isn't available. */
+	static UPaperZDAnimInstance* NewInstance(TSubclassOf<UPaperZDAnimInstance> AnimClass, UObject* Outer, TScriptInterface<IPaperZDAnimInstanceManager> InManager);
+
+	/* Checks if pooling is globally enabled. */
+	static bool IsPoolingEnabled();
+
+private:
+	/* Adds the instance to the free list of its class, if there's room for it. */
+	void AddFreeInstance(UPaperZDAnimInstance* AnimInstance, int32 MaxFreeInstances);
+
+	/* Obtain the bucket of the given class, if any. */
+	FPaperZDAnimInstancePoolBucket* FindBucket(const UClass* AnimClass);
+	const FPaperZDAnimInstancePoolBucket* FindBucket(const UClass* AnimClass) const;
+};
@@ -0,0 +1,175 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperZDAnimLOD.generated.h"
+
+/**
+ * Level of detail used to update an animation instance, picked from its significance.
+ */
+UENUM(BlueprintType)
+enum class EPaperZDAnimLOD : uint8
+{
+	/* Updated and rendered every frame. */
+	FullRate,
+
+	/* Updated and rendered every few frames, using the delta time accumulated since the last update. */
+	ReducedRate,
+
+	/* The AnimGraph keeps updating so the state machines stay in sync, but the result is never pushed to the render component. */
+	StateMachineOnly,
+
+	/* Not updated at all, the playback time is frozen until the instance becomes significant again. */
+	Suspended,
+
+	MAX UMETA(Hidden)
+};
+
+/**
+ * How the notifies of an instance are handled while on a given level of detail.
+ */
+UENUM(BlueprintType)
+enum class EPaperZDAnimLODNotifyPolicy : uint8
+{
+	/* Notifies trigger normally on every update. */
+	Fire,
+
+	/* Notifies never trigger. */
+	Skip,
+
+	/* Notifies are held back and trigger once, as a single window from where the playback was held to where it is now, when the instance moves to a level that fires them. */
+	CatchUp
+};
+
+/**
+ * Priority of an animation instance when the frame update budget is active.
+ */
+UENUM(BlueprintType)
+enum class EPaperZDAnimUpdatePriority : uint8
+{
+	/* Time sliced with every other normal priority instance when the update budget runs out. */
+	Normal,
+
+	/* Always updated, regardless of the budget. Meant for the player and other important characters. */
+	High
+};
+
+/**
+ * Update settings for a single level of detail.
+ */
+USTRUCT(BlueprintType)
+struct PAPERZD_API FPaperZDAnimLODLevelSettings
+{
+	GENERATED_BODY()
+
+	/* Minimum significance needed to use this level. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinSignificance;
+
+	/* Number of frames between updates, the delta time of the skipped frames is accumulated into the next update. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "1"))
+	int32 UpdateInterval;
+
+	/* How the notifies are handled while on this level. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD")
+	EPaperZDAnimLODNotifyPolicy NotifyPolicy;
+
+	//ctor
+	FPaperZDAnimLODLevelSettings()
+		: MinSignificance(0.0f)
+		, UpdateInterval(1)
+		, NotifyPolicy(EPaperZDAnimLODNotifyPolicy::Fire)
+	{}
+
+	FPaperZDAnimLODLevelSettings(float InMinSignificance, int32 InUpdateInterval, EPaperZDAnimLODNotifyPolicy InNotifyPolicy)
+		: MinSignificance(InMinSignificance)
+		, UpdateInterval(InUpdateInterval)
+		, NotifyPolicy(InNotifyPolicy)
+	{}
+};
+
+/**
+ * Configures how an animation component computes its significance and which level of detail each significance maps to.
+ * Significance ranges from 0 to 1 and is the product of the distance to the closest view, a penalty for not being recently rendered and an optional user callback.
+ */
+USTRUCT(BlueprintType)
+struct PAPERZD_API FPaperZDAnimLODSettings
+{
+	GENERATED_BODY()
+
+	/* If false, the instance always updates at full rate. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD")
+	bool bEnableLOD;
+
+	/* Distance to the closest view under which the distance doesn't reduce the significance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.0", EditCondition = "bEnableLOD"))
+	float FullSignificanceDistance;
+
+	/* Distance to the closest view at which the significance drops to zero. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.0", EditCondition = "bEnableLOD"))
+	float ZeroSignificanceDistance;
+
+	/* Multiplier applied to the significance when the render component wasn't recently rendered. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "bEnableLOD"))
+	float OffscreenSignificanceScale;
+
+	/* Time since the render component was last rendered for it to still be considered on screen. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (ClampMin = "0.0", EditCondition = "bEnableLOD"))
+	float RecentlyRenderedTolerance;
+
+	/* Settings for the full rate level. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (EditCondition = "bEnableLOD"))
+	FPaperZDAnimLODLevelSettings FullRate;
+
+	/* Settings for the reduced rate level. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (EditCondition = "bEnableLOD"))
+	FPaperZDAnimLODLevelSettings ReducedRate;
+
+	/* Settings for the state machine only level, instances below its significance get suspended. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LOD", meta = (EditCondition = "bEnableLOD"))
+	FPaperZDAnimLODLevelSettings StateMachineOnly;
+
+	//ctor
+	FPaperZDAnimLODSettings()
+		: bEnableLOD(false)
+		, FullSignificanceDistance(1000.0f)
+		, ZeroSignificanceDistance(5000.0f)
+		, OffscreenSignificanceScale(0.25f)
+		, RecentlyRenderedTolerance(0.2f)
+		, FullRate(0.75f, 1, EPaperZDAnimLODNotifyPolicy::Fire)
+		, ReducedRate(0.3f, 3, EPaperZDAnimLODNotifyPolicy::Fire)
+		, StateMachineOnly(0.05f, 1, EPaperZDAnimLODNotifyPolicy::Skip)
+	{}
+
+	/* Obtains the level of detail that the given significance maps to. */
+	EPaperZDAnimLOD GetLODForSignificance(float Significance) const
+	{
+		if (Significance >= FullRate.MinSignificance)
+		{
+			return EPaperZDAnimLOD::FullRate;
+		}
+		else if (Significance >= ReducedRate.MinSignificance)
+		{
+			return EPaperZDAnimLOD::ReducedRate;
+		}
+		else if (Significance >= StateMachineOnly.MinSignificance)
+		{
+			return EPaperZDAnimLOD::StateMachineOnly;
+		}
+
+		return EPaperZDAnimLOD::Suspended;
+	}
+
+	/* Obtains the settings of the given level, suspended instances have no settings as they don't update. */
+	const FPaperZDAnimLODLevelSettings* GetLevelSettings(EPaperZDAnimLOD LOD) const
+	{
+		switch (LOD)
+		{
+			case EPaperZDAnimLOD::FullRate:			return &FullRate;
+			case EPaperZDAnimLOD::ReducedRate:		return &ReducedRate;
+			case EPaperZDAnimLOD::StateMachineOnly:	return &StateMachineOnly;
+			default:								return nullptr;
+		}
+	}
+};
@@ -0,0 +1,74 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "PaperZDAnimPrewarmSubsystem.generated.h"
+
+class ULevel;
+class UPaperZDAnimInstance;
+class UPaperZDAnimBPGeneratedClass;
+
+/**
+ * Prewarms the AnimBP classes a world is going to use, so the first spawn of each class doesn't pay for resolving its functions and streaming its animations.
+ * Levels are prewarmed automatically when they're added to the world (controlled with paperzd.PrewarmOnLevelLoad), which covers both the actors placed on them
+ * and the actor classes they reference (i.e. the enemies a spawner can spawn). Other sets can be prewarmed on demand by passing the asset that references them.
+ * The time spent on each class is reported on the log.
+ */
+UCLASS()
+class PAPERZD_API UPaperZDAnimPrewarmSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/* Handle to the level streaming delegate. */
+	FDelegateHandle LevelAddedHandle;
+
+public:
+	//~Begin USubsystem Interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End USubsystem Interface
+
+	//~Begin UWorldSubsystem Interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	//~End UWorldSubsystem Interface
+
+	/* Prewarms every AnimBP class referenced by the actors of the given level, including the ones used by the actor classes they reference. */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD|Prewarm")
+	void PrewarmLevel(ULevel* Level);
+
+	/* Prewarms every AnimBP class referenced by the given asset (i.e. a data asset that lists the enemies of a wave), including the ones used by the actor classes it references. */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD|Prewarm")
+	void PrewarmAsset(UObject* Asset);
+
+	/* Prewarms a single AnimBP class. */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD|Prewarm")
+	void PrewarmAnimClass(TSubclassOf<UPaperZDAnimInstance> AnimClass);
+
+	/**
+	 * Walks the references of the given objects looking for AnimBP classes.
+	 * Besides the AnimBP classes themselves, the walk follows into blueprint classes and into the objects that live on the same package as the referencing object
+	 * (components, subobjects, actors of the same level), so anything that isn't loaded or lives on another asset is left alone.
+	 * @param Roots			Objects to start the walk from.
+	 * @param OutClasses	AnimBP classes found, without duplicates.
+	 */
+	static void GatherAnimClasses(const TArray<UObject*>& Roots, TArray<UPaperZDAnimBPGeneratedClass*>& OutClasses);
+
+	/**
+	 * Prewarms the given AnimBP classes and reports the time spent on each one.
+	 * @param AnimClasses	Classes to prewarm, the ones already prewarmed are skipped.
+	 * @param SourceName	What referenced the classes, for the report.
+	 * @return				Amount of classes that got prewarmed.
+	 */
+	static int32 PrewarmClasses(const TArray<UPaperZDAnimBPGeneratedClass*>& AnimClasses, const FString& SourceName);
+
+private:
+	/* Called when a streamed level becomes part of a world. */
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	/* Finds and prewarms the AnimBP classes referenced by the given objects. */
+	void PrewarmReferencedClasses(const TArray<UObject*>& Roots, const FString& SourceName);
+};
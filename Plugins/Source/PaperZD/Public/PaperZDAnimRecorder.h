@@ -0,0 +1,184 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+#ifndef PAPERZD_RECORDER_ENABLED
+#define PAPERZD_RECORDER_ENABLED !UE_BUILD_SHIPPING
+#endif
+
+#if PAPERZD_RECORDER_ENABLED
+
+struct FPaperZDAnimationPlaybackData;
+
+/**
+ * Types of record stored by the AnimInstance recorder.
+ */
+enum class EPaperZDAnimRecordType : uint8
+{
+	/* Start of an update. Value: world time. */
+	Frame,
+
+	/* Active state of a state machine after its update. Index: state machine. Args: state. Value: time on the state. */
+	State,
+
+	/* Transition taken by a state machine. Index: state machine. Args: from state, to state, transition rule. */
+	Transition,
+
+	/* Animation evaluated by the AnimGraph. Index: sequence object. Args: direction (tenths of degree), weight (ten thousandths), layer. Value: playback time. */
+	Playback,
+
+	/* Notify triggered, or notify state that began. Index: notify object. Value: time of the notify. */
+	Notify
+};
+
+/**
+ * Single entry of the recorder, every kind of record shares the same compact layout.
+ */
+struct FPaperZDAnimRecord
+{
+	EPaperZDAnimRecordType Type;
+
+	/* State machine index or object index, depending on the type. */
+	uint16 Index;
+
+	/* Arguments that depend on the type. */
+	int16 Args[3];
+
+	/* Value that depends on the type. */
+	float Value;
+};
+
+static_assert(sizeof(FPaperZDAnimRecord) == 16, "AnimInstance records should be kept compact");
+
+/**
+ * Fixed size ring buffer that records what an AnimInstance did over its last updates: active states, transitions, evaluated animations and notifies.
+ * Memory is allocated once, on the first recorded frame. Recording afterwards only writes to the buffer, objects are referenced through a small table that only grows with new sequences or notifies.
+ * Records are written by whichever thread updates the instance and read by the editor on the game thread, in between updates.
+ */
+class PAPERZD_API FPaperZDAnimRecorder
+{
+public:
+	/* Index used for objects that didn't fit on the table. */
+	static constexpr uint16 InvalidObjectIndex = MAX_uint16;
+
+	/* Every record of a single frame. */
+	struct FFrame
+	{
+		uint32 FrameNumber = 0;
+		float WorldTime = 0.0f;
+		TArray<FPaperZDAnimRecord> Records;
+	};
+
+private:
+	/* Ring buffer, its size is always a power of two. */
+	TArray<FPaperZDAnimRecord> Records;
+
+	/* Total amount of records written, the head of the buffer. */
+	uint64 NumRecordsWritten;
+
+	/* Total amount of frames begun. */
+	uint32 NumFrames;
+
+	/* True if the current frame is being recorded. */
+	bool bRecording;
+
+	/* Objects referenced by the records. */
+	TArray<TWeakObjectPtr<const UObject>> Objects;
+	TMap<const UObject*, uint16> ObjectIndices;
+
+public:
+	//ctor
+	FPaperZDAnimRecorder();
+
+	/* True if recording is enabled for every AnimInstance, controlled with paperzd.Recorder. */
+	static bool IsEnabled();
+
+	/* Starts recording a new update, allocating the buffer the first time. */
+	void BeginFrame(float WorldTime);
+
+	/* Records the active state of a state machine. */
+	FORCEINLINE void RecordState(int32 MachineIndex, int32 StateIndex, float StateTime)
+	{
+		if (bRecording)
+		{
+			Write(EPaperZDAnimRecordType::State, MachineIndex, StateIndex, INDEX_NONE, INDEX_NONE, StateTime);
+		}
+	}
+
+	/* Records a transition between two states. */
+	FORCEINLINE void RecordTransition(int32 MachineIndex, int32 FromStateIndex, int32 ToStateIndex, int32 RuleIndex)
+	{
+		if (bRecording)
+		{
+			Write(EPaperZDAnimRecordType::Transition, MachineIndex, FromStateIndex, ToStateIndex, RuleIndex, 0.0f);
+		}
+	}
+
+	/* Records the animations evaluated by the AnimGraph. */
+	void RecordPlayback(const FPaperZDAnimationPlaybackData& PlaybackData);
+
+	/* Records a triggered notify, packed notifies pass their asset or sequence instead. */
+	void RecordNotify(const UObject* Notify, float Time);
+
+	/* Discards every record. */
+	void Reset();
+
+	/* Total amount of records written, changes every time something gets recorded. */
+	uint64 GetNumRecordsWritten() const { return NumRecordsWritten; }
+
+	/**
+	 * Obtain the frames still available on the buffer.
+	 * @return	False if no complete frame is available.
+	 */
+	bool GetFrameRange(uint32& OutOldestFrame, uint32& OutNewestFrame) const;
+
+	/* Obtain every record of the given frame, false if it isn't available anymore. */
+	bool GetFrame(uint32 FrameNumber, FFrame& OutFrame) const;
+
+	/* Visits every record of the complete frames still available, oldest first, along with the number and world time of the frame they belong to. */
+	void ForEachRecord(TFunctionRef<void(uint32 FrameNumber, float WorldTime, const FPaperZDAnimRecord& Record)> Visitor) const;
+
+	/* Obtain the object referenced by a Playback or Notify record. */
+	const UObject* GetRecordedObject(uint16 ObjectIndex) const;
+
+private:
+	/* Writes a record on the head of the buffer. */
+	FORCEINLINE void Write(EPaperZDAnimRecordType Type, int32 Index, int32 Arg0, int32 Arg1, int32 Arg2, float Value)
+	{
+		FPaperZDAnimRecord& Record = Records[GetBufferIndex(NumRecordsWritten)];
+		Record.Type = Type;
+		Record.Index = static_cast<uint16>(Index);
+		Record.Args[0] = static_cast<int16>(Arg0);
+		Record.Args[1] = static_cast<int16>(Arg1);
+		Record.Args[2] = static_cast<int16>(Arg2);
+		Record.Value = Value;
+		NumRecordsWritten++;
+	}
+
+	/* Position of the given record on the buffer. */
+	FORCEINLINE int32 GetBufferIndex(uint64 RecordIndex) const { return static_cast<int32>(RecordIndex & static_cast<uint64>(Records.Num() - 1)); }
+
+	/* Obtain the index of the given object on the table, adding it if needed. */
+	uint16 GetObjectIndex(const UObject* Object);
+
+	/* Index of the first record still available on the buffer. */
+	uint64 GetFirstAvailableRecord() const;
+};
+
+#define PAPERZD_RECORD(AnimInstance, RecordName, ...) \
+	do \
+	{ \
+		if (AnimInstance) \
+		{ \
+			(AnimInstance)->GetRecorder().Record##RecordName(__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+#define PAPERZD_RECORD(AnimInstance, RecordName, ...)
+
+#endif
@@ -0,0 +1,84 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPaperZDAnimationComponent;
+class UPaperZDAnimInstance;
+
+/**
+ * Identifies the AnimInstances that can share a single update: same AnimBP class, same state on every state machine and same direction bucket.
+ */
+struct FPaperZDAnimSharingKey
+{
+	/* AnimBP generated class of the instance. */
+	UClass* AnimClass;
+
+	/* Hash of the state machine states of the instance, see UPaperZDAnimInstance::GetAnimSharingStateHash. */
+	uint32 StateHash;
+
+	/* Bucket the directional angle of the instance falls into. */
+	int32 DirectionBucket;
+
+	//ctor
+	FPaperZDAnimSharingKey()
+		: AnimClass(nullptr)
+		, StateHash(0)
+		, DirectionBucket(0)
+	{}
+
+	bool operator==(const FPaperZDAnimSharingKey& Other) const
+	{
+		return AnimClass == Other.AnimClass && StateHash == Other.StateHash && DirectionBucket == Other.DirectionBucket;
+	}
+
+	bool operator!=(const FPaperZDAnimSharingKey& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend uint32 GetTypeHash(const FPaperZDAnimSharingKey& Key)
+	{
+		return HashCombine(HashCombine(GetTypeHash(Key.AnimClass), Key.StateHash), GetTypeHash(Key.DirectionBucket));
+	}
+};
+
+/**
+ * Components that currently share the same key. The master gets updated normally and every other member copies its result.
+ */
+struct FPaperZDAnimSharingGroup
+{
+	/* Component whose AnimInstance drives the group. */
+	TWeakObjectPtr<UPaperZDAnimationComponent> Master;
+
+	/* Last batch in which any member of the group was seen, used to discard groups that are no longer in use. */
+	uint32 LastBatchIndex;
+
+	/* Last batch in which the master got updated, members only follow a master updated on the same batch. */
+	uint32 MasterBatchIndex;
+
+	//ctor
+	FPaperZDAnimSharingGroup()
+		: LastBatchIndex(0)
+		, MasterBatchIndex(0)
+	{}
+};
+
+/**
+ * Member of a sharing group recorded during the batch, waiting for its master to be picked or to finish its update.
+ */
+struct FPaperZDAnimSharingMember
+{
+	/* Component that owns the instance, nulled out if it unregisters during the batch. */
+	UPaperZDAnimationComponent* Component;
+
+	/* Instance of the component. */
+	UPaperZDAnimInstance* AnimInstance;
+
+	/* Component that drives the group, only set for followers. Nulled out if it unregisters during the batch. */
+	UPaperZDAnimationComponent* Master;
+
+	/* Time the member advances this batch, only set for followers. */
+	float DeltaTime;
+};
@@ -0,0 +1,310 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "PaperZDAnimSharing.h"
+#include "PaperZDAnimTickSubsystem.generated.h"
+
+class UPaperZDAnimationComponent;
+class UPaperZDAnimTickSubsystem;
+class UPaperZDAnimInstance;
+
+/**
+ * Tick function that runs every batched AnimInstance of a world in a single pass.
+ */
+USTRUCT()
+struct FPaperZDBatchedAnimTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/* Subsystem that owns the batched components. */
+	UPaperZDAnimTickSubsystem* Target;
+
+	//ctor
+	FPaperZDBatchedAnimTickFunction()
+		: Target(nullptr)
+	{}
+
+	//~Begin FTickFunction Interface
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+	//~End FTickFunction Interface
+};
+
+template<>
+struct TStructOpsTypeTraits<FPaperZDBatchedAnimTickFunction> : public TStructOpsTypeTraitsBase2<FPaperZDBatchedAnimTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Group of animation components that share the same AnimBP generated class, ticked back to back so the graph data stays hot.
+ */
+USTRUCT()
+struct FPaperZDAnimTickBucket
+{
+	GENERATED_BODY()
+
+	/* Generated class shared by every component on this bucket. */
+	UPROPERTY()
+	UClass* AnimClass;
+
+	/* Components registered on this bucket, can contain null entries while the batch is running. */
+	UPROPERTY()
+	TArray<UPaperZDAnimationComponent*> Components;
+
+	//ctor
+	FPaperZDAnimTickBucket()
+		: AnimClass(nullptr)
+	{}
+};
+
+/**
+ * Update of an instance recorded during the batch, either waiting for the frame update budget to be allocated or for the parallel phase to finish.
+ */
+struct FPaperZDBatchedAnimUpdate
+{
+	/* Component that owns the instance, nulled out if it unregisters during the batch. */
+	UPaperZDAnimationComponent* Component;
+
+	/* Instance to update. */
+	UPaperZDAnimInstance* AnimInstance;
+
+	/* Time to update the instance with on this frame. Budgeted updates don't include the time held back by previous frames. */
+	float DeltaTime;
+};
+
+/**
+ * Hashed timer wheel that schedules the wake up of sleeping animation components, each slot covers a fixed amount of world time.
+ * Entries further away than a full turn stay on their slot until their time comes.
+ * Entries aren't removed when a component wakes up early, they get discarded when their slot is reached instead.
+ */
+struct FPaperZDAnimSleepWheel
+{
+	/* Single scheduled wake up. */
+	struct FEntry
+	{
+		TWeakObjectPtr<UPaperZDAnimationComponent> Component;
+		double WakeTime;
+		uint32 SleepSerial;
+	};
+
+private:
+	/* Number of slots and the world time each one covers, a full turn spans a bit over two seconds. */
+	static constexpr int32 NumSlots = 256;
+	static constexpr double SlotDuration = 1.0 / 120.0;
+
+	/* Entries stored on each slot. */
+	TArray<FEntry> Slots[NumSlots];
+
+	/* Absolute index of the slot that was last processed, which is processed again on the next advance as it may still hold entries. */
+	int64 CurrentSlot;
+
+	/* Number of entries on the wheel, including stale ones. */
+	int32 NumEntries;
+
+public:
+	//ctor
+	FPaperZDAnimSleepWheel()
+		: CurrentSlot(INDEX_NONE)
+		, NumEntries(0)
+	{}
+
+	/* Schedules the given component to wake up at the given world time. */
+	void Schedule(UPaperZDAnimationComponent* Component, uint32 SleepSerial, double WakeTime);
+
+	/* Moves the wheel to the given world time, collecting every entry whose wake time has been reached. */
+	void Advance(double Time, TArray<FEntry>& OutExpiredEntries);
+
+	/* Removes every entry. */
+	void Reset();
+
+	/* True if there are no entries on the wheel. */
+	bool IsEmpty() const { return NumEntries == 0; }
+
+private:
+	/* Absolute index of the slot that contains the given time. */
+	static int64 GetSlotIndex(double Time) { return static_cast<int64>(FMath::FloorToDouble(Time / SlotDuration)); }
+};
+
+/**
+ * Ticks every PaperZD animation component that opts into batched ticking using one tick function per world, instead of one per component.
+ * Components are grouped by their AnimBP generated class, so instances that run the same graph are updated consecutively.
+ * Instances with a thread-safe AnimGraph update in parallel on worker threads, followed by a game thread phase that runs any deferred blueprint work.
+ * When the frame update budget is active, normal priority instances are time sliced in round robin once the budget runs out, carrying their unprocessed time to their next update.
+ * Instances that allow sleeping stop updating until their next playback event, scheduled on a timer wheel.
+ * Components that enable animation sharing are grouped by their sharing key, only one master per group is updated and the rest render its result.
+ */
+UCLASS()
+class PAPERZD_API UPaperZDAnimTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/* Buckets of registered components, one per AnimBP class. */
+	UPROPERTY(Transient)
+	TArray<FPaperZDAnimTickBucket> Buckets;
+
+	/* Components that registered while the batch was running, added after the current batch finishes. */
+	UPROPERTY(Transient)
+	TArray<UPaperZDAnimationComponent*> PendingComponents;
+
+	/* Updates that will run on the parallel phase of the current batch, kept around to reuse its allocation. */
+	TArray<FPaperZDBatchedAnimUpdate> ParallelUpdates;
+
+	/* Normal priority updates gathered on the current batch while the update budget is active. */
+	TArray<FPaperZDBatchedAnimUpdate> BudgetedUpdates;
+
+	/* First component that didn't get the budget on the last batch, the next batch starts from it so every instance gets its turn regardless of the gathering order. */
+	TWeakObjectPtr<UPaperZDAnimationComponent> BudgetCursor;
+
+	/* Running average of the parallel phase time per instance, in milliseconds. That phase runs after the budget is allocated, so it can only be estimated from previous batches. */
+	float AverageParallelUpdateCost;
+
+	/* Budget, time used and number of deferred instances on the last batch. */
+	float LastUpdateBudget;
+	float LastUpdateBudgetUsed;
+	int32 LastDeferredInstances;
+
+	/* Schedules the wake up of the sleeping components. */
+	FPaperZDAnimSleepWheel SleepWheel;
+
+	/* Entries that expired on the current batch, kept around to reuse its allocation. */
+	TArray<FPaperZDAnimSleepWheel::FEntry> ExpiredSleepEntries;
+
+	/* The tick function that drives the batch. */
+	FPaperZDBatchedAnimTickFunction BatchedTickFunction;
+
+	/* Locations of the local player views, refreshed once per frame for the animation LOD. */
+	TArray<FVector> ViewLocations;
+
+	/* Frame in which the view locations were last refreshed. */
+	uint64 ViewLocationsFrame;
+
+	/* Sharing groups alive on the last batch, by their key. */
+	TMap<FPaperZDAnimSharingKey, FPaperZDAnimSharingGroup> SharingGroups;
+
+	/* Components that want to share their animation on the current batch, waiting for their group master to be picked. */
+	TArray<FPaperZDAnimSharingMember> SharingCandidates;
+
+	/* Components that will render the result of their group master once the batch finishes updating. */
+	TArray<FPaperZDAnimSharingMember> SharingFollowers;
+
+	/* Scratch playback data used to apply the shared result to each follower, kept around to reuse its allocation. */
+	FPaperZDAnimationPlaybackData SharedPlaybackData;
+
+	/* Incremented on each batch, used to tell which components and groups were seen on the current one. */
+	uint32 BatchIndex;
+
+	/* True while the batch is running, used to defer any modification to the buckets. */
+	bool bTickingBatch;
+
+	/* True if at least one component was unregistered during the batch, and thus the buckets must be compacted. */
+	bool bPendingCompaction;
+
+public:
+	//ctor
+	UPaperZDAnimTickSubsystem();
+
+	//~Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~End USubsystem Interface
+
+	//~Begin UWorldSubsystem Interface
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	//~End UWorldSubsystem Interface
+
+	/* Adds the given component to the batch, the component should have its own tick disabled. */
+	void RegisterComponent(UPaperZDAnimationComponent* InComponent);
+
+	/* Removes the given component from the batch. */
+	void UnregisterComponent(UPaperZDAnimationComponent* InComponent);
+
+	/* Ticks every registered component, called by the batched tick function. */
+	void TickBatch(float DeltaTime);
+
+	/* True while the batch is running, instances gathered by the batch can still be pending their update. */
+	bool IsTickingBatch() const { return bTickingBatch; }
+
+	/* Checks if batched ticking has been globally forced for every animation component. */
+	static bool IsBatchedTickForced();
+
+	/* Obtain the time in milliseconds that the batch can spend updating instances each frame, zero if the budget is disabled. */
+	static float GetUpdateBudget();
+
+	/* Checks if the frame update budget is active. */
+	static bool IsUpdateBudgetEnabled() { return GetUpdateBudget() > 0.0f; }
+
+	/* Checks if instances are allowed to sleep while nothing observable changes. */
+	static bool IsSleepingEnabled();
+
+	/* Checks if components that enable animation sharing are allowed to share their updates. */
+	static bool IsAnimSharingEnabled();
+
+	/* Wakes up the given component if it was sleeping, its AnimInstance will update on the next batch with the time it slept. */
+	void WakeComponent(UPaperZDAnimationComponent* InComponent);
+
+	/* Obtain the budget, the time used and the number of deferred instances on the last batch. */
+	float GetLastUpdateBudget() const { return LastUpdateBudget; }
+	float GetLastUpdateBudgetUsed() const { return LastUpdateBudgetUsed; }
+	int32 GetLastDeferredInstances() const { return LastDeferredInstances; }
+
+	/* Obtain the location of every local player view on this world, used to compute the significance of the animation components. */
+	const TArray<FVector>& GetViewLocations();
+
+private:
+	/* Registers the tick function on the world, if not done already. */
+	void EnsureTickFunctionRegistered();
+
+	/* Adds the component to the bucket that matches its AnimBP class. */
+	void AddToBucket(UPaperZDAnimationComponent* InComponent);
+
+	/**
+	 * Runs the LOD and budget logic of the component, and updates its instance if it's due this frame.
+	 * @return	True if the instance was updated immediately, false if it was skipped or deferred to the budget.
+	 */
+	bool UpdateComponent(UPaperZDAnimationComponent* Component, UPaperZDAnimInstance* AnimInstance, float DeltaTime, double WorldTime, bool bUseUpdateBudget, bool bAllowParallelUpdate);
+
+	/* Adds the component to the sharing candidates if its instance reports a sharing key, returns false otherwise. */
+	bool GatherSharingMember(UPaperZDAnimationComponent* Component, UPaperZDAnimInstance* AnimInstance);
+
+	/**
+	 * Picks the master of every sharing group and updates it, the rest of the candidates become followers.
+	 * Only a master that actually updated on this batch is followed, if the level of detail skips it the next candidate of the group takes its place.
+	 * @return	Number of masters that were updated immediately.
+	 */
+	int32 ResolveSharingGroups(float DeltaTime, double WorldTime, bool bAllowParallelUpdate);
+
+	/* Updates the candidate outside of the budget, making it the master of the group if it updated and evaluated its animation. Returns true if it updated. */
+	bool UpdateSharingMaster(FPaperZDAnimSharingGroup& Group, const FPaperZDAnimSharingMember& Candidate, float DeltaTime, double WorldTime, bool bAllowParallelUpdate);
+
+	/**
+	 * Advances the state machines of each follower and renders the result of its master with its own directional angle and time offset, triggering its notifies.
+	 * Followers whose transitions took them to other states than their master update on their own instead.
+	 * @return	Number of followers that had to update on their own.
+	 */
+	int32 ApplySharedAnimations();
+
+	/* Updates the instance in place, or prepares it for the parallel phase if its graph is thread-safe. */
+	void UpdateInstance(const FPaperZDBatchedAnimUpdate& Update, bool bAllowParallelUpdate);
+
+	/* Puts the component to sleep after its update, if its AnimInstance allows it and its next playback event is far enough. */
+	void TrySleep(const FPaperZDBatchedAnimUpdate& Update);
+
+	/**
+	 * Allocates what's left of the budget to the gathered normal priority updates, in round robin order.
+	 * @param BudgetEndTime		Platform time in seconds at which the budget runs out.
+	 * @return					Number of instances that were updated, the rest are deferred to the next batch.
+	 */
+	int32 RunBudgetedUpdates(double BudgetEndTime, bool bAllowParallelUpdate);
+
+	/* Removes any null entry and empty bucket left behind by components that unregistered during the batch. */
+	void CompactBuckets();
+};
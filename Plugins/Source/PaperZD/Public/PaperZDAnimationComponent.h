@@ -6,10 +6,18 @@
 #include "Components/ActorComponent.h"
 #include "IPaperZDAnimInstanceManager.h"
 #include "Sequencer/IPaperZDSequencerSource.h"
+#include "PaperZDAnimLOD.h"
+#include "PaperZDAnimSharing.h"
 #include "PaperZDAnimationComponent.generated.h"
 
 class UPrimitiveComponent;
 class UPaperZDAnimInstance;
+class UPaperZDAnimationComponent;
+class UPaperZDInstancedSpriteComponent;
+
+//Callbacks that let the user scale the significance of an animation component, should return a value between 0 and 1
+DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam(float, FPaperZDAnimSignificanceSignature, UPaperZDAnimationComponent*, AnimationComponent);
+DECLARE_DELEGATE_RetVal_OneParam(float, FPaperZDAnimSignificanceSignature_Native, const UPaperZDAnimationComponent*);
 
 /**
  * Provides an interface for running an Animation Blueprint on any actor.
@@ -27,10 +35,108 @@ class PAPERZD_API UPaperZDAnimationComponent : public UActorComponent, public IP
 	UPROPERTY(EditAnywhere, Category = "PaperZD", meta = (AllowAnyComponent, UseComponentPicker, AllowedClasses = "PrimitiveComponent"))
 	FComponentReference RenderComponent;
 
+	/* Shared instanced sprite component used to render instead of the render component, see SetInstancedRenderComponent. */
+	UPROPERTY(Transient)
+	TWeakObjectPtr<UPaperZDInstancedSpriteComponent> InstancedRenderComponent;
+
 	/* The animation instance used for managing the animation. */
 	UPROPERTY(Transient, BlueprintReadOnly, Category = "PaperZD", meta = (AllowPrivateAccess = " true"))
 	UPaperZDAnimInstance* AnimInstance;
 
+	/**
+	 * If true, this component won't tick on its own and its AnimInstance will be updated by the world batched tick instead, alongside every other instance of the same AnimBP.
+	 * Reduces the per-component tick overhead when running big amounts of animated actors.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD", AdvancedDisplay)
+	bool bUseBatchedTick;
+
+	/* True if this component is currently registered on the world batched tick. */
+	bool bRegisteredForBatchedTick;
+
+	/**
+	 * If true, the AnimInstance is acquired from the world instance pool and given back to it when this component ends play.
+	 * Saves the creation and initialization cost of the instance on actors that spawn and despawn often, like projectiles or hit effects.
+	 * Reused instances get their variables and AnimNodes restored to the class defaults, but any other object bound to the instance or its player should bind again.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD", AdvancedDisplay)
+	bool bUseInstancePool;
+
+	/* True if the current AnimInstance was acquired from the instance pool. */
+	bool bAnimInstanceFromPool;
+
+	/**
+	 * Priority used by the frame update budget. High priority instances are always updated, while normal ones are time sliced when the budget runs out.
+	 * Components that begin play while the budget is active are updated by the world batched tick.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD", AdvancedDisplay)
+	EPaperZDAnimUpdatePriority UpdatePriority;
+
+	/* Time held back from this component by the update budget or while sleeping, applied on its next update. */
+	float DeferredDeltaTime;
+
+	/* Number of consecutive frames the update budget held back this component. */
+	int32 BudgetDeferredFrames;
+
+	/* True while the AnimInstance is sleeping, waiting for the batched tick to wake it up. */
+	bool bAnimSleeping;
+
+	/* Incremented every time the AnimInstance goes to sleep or wakes up, lets the batched tick ignore stale wake-up requests. */
+	uint32 SleepSerial;
+
+	/* World time in which the AnimInstance went to sleep, kept after waking up until the slept time is applied. Negative if there's no slept time to apply. */
+	double SleepStartTime;
+
+	/**
+	 * If true, this component shares the update of its AnimInstance with the other components running the same AnimBP in the same sharing state.
+	 * Only one instance per set of state machine states gets updated, the rest render its result. Followers still take their own transitions, trigger their notifies and call the blueprint tick,
+	 * leaving the group to update on their own as soon as their states differ. See UPaperZDAnimInstance::GetAnimSharingDirection.
+	 * Requires the batched tick, which is enabled automatically.
+	 */
+	UPROPERTY(EditAnywhere, Category = "PaperZD|Sharing")
+	bool bEnableAnimSharing;
+
+	/* Number of buckets the directional angle is split into when building the sharing key, only instances on the same bucket share their animation. */
+	UPROPERTY(EditAnywhere, Category = "PaperZD|Sharing", meta = (ClampMin = "1", EditCondition = "bEnableAnimSharing"))
+	int32 AnimSharingDirectionBuckets;
+
+	/* Key reported on the last batch and the batch it was reported on. */
+	FPaperZDAnimSharingKey AnimSharingKey;
+	uint32 AnimSharingBatchIndex;
+
+	/* Directional angle reported on the last batch, used to render the shared animation. */
+	float AnimSharingDirectionalAngle;
+
+	/* True if the AnimInstance followed another instance on the last batch. */
+	bool bFollowingSharedAnimation;
+
+	/* Blueprint callback that scales the significance of this component. */
+	FPaperZDAnimSignificanceSignature SignificanceCallback;
+
+	/* Render component used to check if the animation is on screen, resolved on the first LOD update. */
+	TWeakObjectPtr<UPrimitiveComponent> LODRenderComponent;
+
+	/* Significance computed on the last LOD update. */
+	float Significance;
+
+	/* Level of detail currently in use. */
+	EPaperZDAnimLOD CurrentLOD;
+
+	/* Frames and delta time accumulated since the last update of the AnimInstance, used by the levels that don't update every frame. The frame count starts on a per-component phase when entering those levels. */
+	int32 FramesSinceLODUpdate;
+	float AccumulatedLODDeltaTime;
+
+public:
+	/* Level of detail settings, lets far away or off-screen instances update less often. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PaperZD|LOD")
+	FPaperZDAnimLODSettings LODSettings;
+
+	/* Time offset applied to the shared animation while following another instance, desyncs identical actors visually. Meant for looping animations. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PaperZD|Sharing")
+	float AnimSharingTimeOffset;
+
+	/* Native callback that scales the significance of this component, applied alongside the blueprint one. */
+	FPaperZDAnimSignificanceSignature_Native NativeSignificanceCallback;
+
 public:	
 	// Sets default values for this component's properties
 	UPaperZDAnimationComponent();
@@ -38,17 +144,28 @@ public:
 	//getter
 	FORCEINLINE UPaperZDAnimInstance* GetAnimInstance() const { return AnimInstance; }
 	FORCEINLINE TSubclassOf<UPaperZDAnimInstance> GetAnimInstanceClass() const { return AnimInstanceClass; }
+	FORCEINLINE bool IsUsingBatchedTick() const { return bRegisteredForBatchedTick; }
 
 	//~ Begin UActorComponent Interface
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	//~ End UActorComponent Interface
 
 	//~ Begin IPaperZDAnimInstanceManager Interface
 	virtual AActor* GetOwningActor() const override;
 	virtual UPrimitiveComponent* GetRenderComponent() const override;
+	virtual void OnWakeUpAnimInstance() override;
 	//~ End IPaperZDAnimInstanceManager Interface
 
+	/* True if the AnimInstance is currently following the animation of another instance, instead of updating on its own. */
+	UFUNCTION(BlueprintPure, Category = "PaperZD|Sharing")
+	bool IsFollowingSharedAnimation() const { return bFollowingSharedAnimation; }
+
+	/* True if the AnimInstance is currently sleeping, waiting for its next playback event. */
+	UFUNCTION(BlueprintPure, Category = "PaperZD")
+	bool IsAnimationSleeping() const { return bAnimSleeping; }
+
 	//~ Begin IPaperZDSequencerSource Interface
 	virtual TSubclassOf<UPaperZDAnimInstance> GetSequencerAnimInstanceClass() const override;
 	virtual UPaperZDAnimInstance* GetSequencerAnimInstance() override;
@@ -60,14 +177,77 @@ public:
 	/* Sets the render component to use before the AnimInstance has been created, use it on construction to set up the values for initialization. */
 	void InitRenderComponent(UPrimitiveComponent* InRenderComponent);
 
+	/**
+	 * Renders the animation as an instance of the given shared component, which can live on any actor, instead of using the render component of this actor.
+	 * The animation source must support instanced rendering. Notifies will receive the shared component as their render component.
+	 * Pass null to go back to the render component.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD|Rendering")
+	void SetInstancedRenderComponent(UPaperZDInstancedSpriteComponent* InInstancedRenderComponent);
+
 	/* Sets the AnimInstanceClass to use, replacing any AnimInstane that could already be running. */
 	UFUNCTION(BlueprintCallable, Category = "PaperZD")
 		void SetAnimInstanceClass(TSubclassOf<UPaperZDAnimInstance> InAnimInstanceClass);
 
+	/* Sets the priority used by the frame update budget. */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD")
+	void SetUpdatePriority(EPaperZDAnimUpdatePriority InUpdatePriority) { UpdatePriority = InUpdatePriority; }
+
+	/* Obtain the priority used by the frame update budget. */
+	UFUNCTION(BlueprintPure, Category = "PaperZD")
+	EPaperZDAnimUpdatePriority GetUpdatePriority() const { return UpdatePriority; }
+
+	/* Enables animation sharing directly, as with bEnableAnimSharing. Used for initializing, must be called before the component registers. */
+	void InitAnimSharing(bool bInEnableAnimSharing) { bEnableAnimSharing = bInEnableAnimSharing; }
+
 	/* Sets the AnimInstanceClass directly, not triggering any event nor recreating the AnimInstance. Used for initializing. */
 	void InitAnimInstanceClass(TSubclassOf<UPaperZDAnimInstance> InAnimInstanceClass);
 
+	/* Sets the callback used to scale the significance of this component, the value returned should be between 0 and 1. */
+	UFUNCTION(BlueprintCallable, Category = "PaperZD|LOD")
+	void SetSignificanceCallback(FPaperZDAnimSignificanceSignature InCallback);
+
+	/* Obtain the level of detail currently in use. */
+	UFUNCTION(BlueprintPure, Category = "PaperZD|LOD")
+	EPaperZDAnimLOD GetAnimLOD() const { return CurrentLOD; }
+
+	/* Obtain the significance computed on the last update, ranging from 0 to 1. */
+	UFUNCTION(BlueprintPure, Category = "PaperZD|LOD")
+	float GetSignificance() const { return Significance; }
+
+	/**
+	 * Refreshes the significance and level of detail of this component, called before updating the AnimInstance.
+	 * @param DeltaTime				Time elapsed since the last frame.
+	 * @param OutUpdateDeltaTime	Time to update the AnimInstance with, including any time accumulated by the frames that skipped the update.
+	 * @return						True if the AnimInstance should be updated this frame.
+	 */
+	bool UpdateLOD(float DeltaTime, float& OutUpdateDeltaTime);
+
 private:
+	//The tick subsystem holds back the update of budgeted components
+	friend class UPaperZDAnimTickSubsystem;
+
 	/* Attempts to create a fresh AnimInstance object. */
 	void CreateAnimInstance();
+
+	/* Lets go of the current AnimInstance, giving it back to the instance pool if it came from it. */
+	void ReleaseAnimInstance();
+
+	/* True if this component should be updated by the world batched tick. */
+	bool ShouldUseBatchedTick() const;
+
+	/* Computes the significance of this component from the distance to the views, its render state and the user callbacks. */
+	float ComputeSignificance();
+
+	/* Changes the level of detail, configuring the AnimInstance for it. */
+	void ApplyLOD(EPaperZDAnimLOD InLOD);
+
+	/* Moves the update of the AnimInstance to the world batched tick. */
+	void RegisterBatchedTick();
+
+	/**
+	 * Removes the component from the world batched tick.
+	 * @param bRestoreComponentTick	If true, the update of the AnimInstance goes back to the component tick. Components ending play shouldn't tick again.
+	 */
+	void UnregisterBatchedTick(bool bRestoreComponentTick = true);
 };
@@ -0,0 +1,117 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "PaperZDInstancedSpriteComponent.generated.h"
+
+class UPaperFlipbook;
+class USceneComponent;
+class UPaperZDAnimInstance;
+struct FPaperZDAnimationPlaybackData;
+
+/**
+ * Render component that draws many PaperZD driven characters as instances of a single grouped sprite component.
+ * Each character owns a slot, which follows the transform of a scene component and displays the keyframe pushed by its playback handle.
+ * Slots keep their index for as long as they're registered, released slots are hidden and reused by the next registration.
+ * Render state is rebuilt at most once per frame, after every instance had its chance to update.
+ */
+UCLASS(ClassGroup = (PaperZD), meta = (BlueprintSpawnableComponent, DisplayName = "PaperZD Instanced Sprite"))
+class PAPERZD_API UPaperZDInstancedSpriteComponent : public UPaperGroupedSpriteComponent
+{
+	GENERATED_BODY()
+
+	/* CPU side state of a single instance, mirrors what was pushed to the grouped sprite data. */
+	struct FInstanceSlot
+	{
+		/* Scene component the instance follows, usually the root of the character. Instances without one stay where they were placed. */
+		TWeakObjectPtr<USceneComponent> FollowComponent;
+
+		/* Transform of the instance relative to the followed component. */
+		FTransform RelativeTransform;
+
+		/* AnimInstance whose playback drives the instance, used to verify it independently of what was pushed. */
+		TWeakObjectPtr<const UPaperZDAnimInstance> OwningInstance;
+
+		/* Flipbook and playback time last pushed to the instance. */
+		TWeakObjectPtr<const UPaperFlipbook> Flipbook;
+		float PlaybackTime;
+
+		/* Keyframe the playback time resolved to. */
+		int32 KeyFrameIndex;
+
+		/* True while the slot is owned by a character. */
+		bool bInUse;
+	};
+
+	/* One slot per grouped sprite instance, sharing its index. */
+	TArray<FInstanceSlot> Slots;
+
+	/* Released slots, reused before adding new instances. */
+	TArray<int32> FreeSlots;
+
+	/* True if any instance changed since the render state was last rebuilt. */
+	bool bInstanceRenderDataDirty;
+
+public:
+	//ctor
+	UPaperZDInstancedSpriteComponent();
+
+	//~ Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	//~ End UActorComponent Interface
+
+	/**
+	 * Reserves an instance for a character.
+	 * @param InFollowComponent		Scene component the instance follows, can be null.
+	 * @param InRelativeTransform	Transform of the instance relative to the followed component, or world transform when not following any.
+	 * @param InOwningInstance		AnimInstance whose playback drives the instance, can be null for preview players.
+	 * @return						Index of the instance, valid until released.
+	 */
+	int32 RegisterAnimatedInstance(USceneComponent* InFollowComponent, const FTransform& InRelativeTransform = FTransform::Identity, const UPaperZDAnimInstance* InOwningInstance = nullptr);
+
+	/* Hides the given instance and makes its slot available for reuse. */
+	void ReleaseAnimatedInstance(int32 InstanceIndex);
+
+	/* Checks if the given index points to a registered instance. */
+	bool IsAnimatedInstanceValid(int32 InstanceIndex) const { return Slots.IsValidIndex(InstanceIndex) && Slots[InstanceIndex].bInUse; }
+
+	/* Number of instances currently registered. */
+	int32 GetNumAnimatedInstances() const { return Slots.Num() - FreeSlots.Num(); }
+
+	/**
+	 * Displays the keyframe of the flipbook that matches the given playback time on the instance.
+	 * Only the sprite of the instance is touched, and only if it changed.
+	 */
+	void SetInstancePlayback(int32 InstanceIndex, const UPaperFlipbook* Flipbook, float PlaybackTime);
+
+	/**
+	 * Obtain the keyframe last pushed to the given instance.
+	 * @return	False if the instance isn't registered or never received a flipbook.
+	 */
+	bool GetInstanceKeyFrame(int32 InstanceIndex, const UPaperFlipbook*& OutFlipbook, int32& OutKeyFrameIndex) const;
+
+	/**
+	 * Checks on the CPU that the given instance displays the keyframe the given playback data resolves to, without relying on the renderer.
+	 * The expected flipbook and time are taken from the playback data, never from what was last pushed to the instance.
+	 * @param InstanceIndex		Instance to check.
+	 * @param PlaybackData		Playback data the instance should be displaying.
+	 * @param OutError			Optional, receives a description of the mismatch.
+	 * @return					True if the instance displays the expected keyframe.
+	 */
+	bool VerifyInstanceKeyFrame(int32 InstanceIndex, const FPaperZDAnimationPlaybackData& PlaybackData, FString* OutError = nullptr) const;
+
+	/**
+	 * Checks every registered instance against the playback data last evaluated by its AnimInstance. Safe to run headless, under NullRHI.
+	 * Instances without an AnimInstance, or whose AnimInstance isn't sending its playback to the render component, are skipped.
+	 * @param OutErrors			Optional, receives a description of each mismatch.
+	 * @param OutNumVerified	Optional, receives the number of instances that were checked.
+	 * @return					Number of instances that display the wrong keyframe.
+	 */
+	int32 VerifyInstanceKeyFrames(TArray<FString>* OutErrors = nullptr, int32* OutNumVerified = nullptr) const;
+
+private:
+	/* Moves every following instance to its followed component, releasing the ones whose component is gone. */
+	void UpdateFollowTransforms();
+};
@@ -0,0 +1,203 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+#ifndef PAPERZD_NODE_COST_ENABLED
+#define PAPERZD_NODE_COST_ENABLED WITH_EDITOR
+#endif
+
+#if PAPERZD_NODE_COST_ENABLED
+
+class UPaperZDAnimInstance;
+class UPaperZDAnimBPGeneratedClass;
+
+/**
+ * Cost measured for a single AnimNode, state machine state or transition rule.
+ */
+struct FPaperZDCostCounter
+{
+	/* Cycles spent. Exclusive for AnimNodes, inclusive of the whole graph for states. */
+	uint64 Cycles = 0;
+
+	/* Amount of updates for AnimNodes and states, amount of evaluations for rules. */
+	uint32 Count = 0;
+
+	/* Notifies fired while the state was active. */
+	uint32 NumNotifies = 0;
+
+	/* Times the rule evaluated to true. */
+	uint32 NumPassed = 0;
+
+	/* Times the transition driven by the rule was taken. */
+	uint32 NumTaken = 0;
+
+	/* Average time per update or evaluation. */
+	double GetAverageMicroseconds() const
+	{
+		return Count > 0 ? FPlatformTime::ToMilliseconds64(Cycles) * 1000.0 / Count : 0.0;
+	}
+};
+
+/**
+ * Every cost measured on an AnimBP class, laid out with the same indices the class uses at runtime.
+ * Each AnimInstance measures into its own copy while it updates, which gets merged into its class on the game thread when the update ends,
+ * so parallel updates never write to shared counters.
+ */
+struct PAPERZD_API FPaperZDNodeCostData
+{
+	/* AnimNodes, by LinkID. */
+	TArray<FPaperZDCostCounter> Nodes;
+
+	/* States of every state machine, starting at the offset of their machine. */
+	TArray<FPaperZDCostCounter> States;
+	TArray<int32> StateOffsets;
+
+	/* Transition rules of every state machine, starting at the offset of their machine. */
+	TArray<FPaperZDCostCounter> Rules;
+	TArray<int32> RuleOffsets;
+
+	/* States that were updated on the current update, notifies fired afterwards count towards them. */
+	TArray<int32> ActiveStates;
+
+	/* Amount of AnimInstance updates merged. */
+	uint32 NumUpdates = 0;
+
+	/* Sizes the counters to match the given class, only allocates if the layout changed. */
+	void Init(const UPaperZDAnimBPGeneratedClass* AnimClass);
+
+	/* True if the counters were sized for the given class. */
+	bool MatchesLayout(const FPaperZDNodeCostData& Other) const;
+
+	/* Adds the counters of another set with the same layout. */
+	void Merge(const FPaperZDNodeCostData& Other);
+
+	/* Zeroes every counter, keeping the layout. */
+	void Reset();
+
+	/* Obtain the counter of the given element, null if out of range. */
+	FORCEINLINE FPaperZDCostCounter* FindNode(int32 LinkID)
+	{
+		return Nodes.IsValidIndex(LinkID) ? &Nodes[LinkID] : nullptr;
+	}
+
+	FORCEINLINE FPaperZDCostCounter* FindState(int32 MachineIndex, int32 StateIndex)
+	{
+		const int32 Index = StateOffsets.IsValidIndex(MachineIndex) && StateIndex >= 0 ? StateOffsets[MachineIndex] + StateIndex : INDEX_NONE;
+		return States.IsValidIndex(Index) ? &States[Index] : nullptr;
+	}
+
+	FORCEINLINE FPaperZDCostCounter* FindRule(int32 MachineIndex, int32 RuleIndex)
+	{
+		const int32 Index = RuleOffsets.IsValidIndex(MachineIndex) && RuleIndex >= 0 ? RuleOffsets[MachineIndex] + RuleIndex : INDEX_NONE;
+		return Rules.IsValidIndex(Index) ? &Rules[Index] : nullptr;
+	}
+
+	/* Flags the given state as updated on the current update. */
+	FORCEINLINE void MarkStateActive(int32 MachineIndex, int32 StateIndex)
+	{
+		if (const FPaperZDCostCounter* Counter = FindState(MachineIndex, StateIndex))
+		{
+			ActiveStates.Add(UE_PTRDIFF_TO_INT32(Counter - States.GetData()));
+		}
+	}
+
+	const FPaperZDCostCounter* FindNode(int32 LinkID) const { return const_cast<FPaperZDNodeCostData*>(this)->FindNode(LinkID); }
+	const FPaperZDCostCounter* FindState(int32 MachineIndex, int32 StateIndex) const { return const_cast<FPaperZDNodeCostData*>(this)->FindState(MachineIndex, StateIndex); }
+	const FPaperZDCostCounter* FindRule(int32 MachineIndex, int32 RuleIndex) const { return const_cast<FPaperZDNodeCostData*>(this)->FindRule(MachineIndex, RuleIndex); }
+};
+
+/**
+ * Measures the per node cost of the AnimInstances running on game worlds (i.e. PIE), so the AnimBP editor can display it on the graphs.
+ * Controlled with paperzd.NodeCost, only available on editor builds.
+ */
+class PAPERZD_API FPaperZDNodeCostCapture
+{
+public:
+	/* True if the costs should be captured for the given instance. */
+	static bool ShouldCapture(const UPaperZDAnimInstance* AnimInstance);
+
+	/* Discards the costs measured on every class, called when a new play session begins. */
+	static void ResetAll();
+
+	/* Merges the costs measured by an instance into its class, and resets the instance counters. */
+	static void MergeIntoClass(FPaperZDNodeCostData& InstanceData, UPaperZDAnimBPGeneratedClass* AnimClass);
+
+	/* Called when a notify is fired, counts it towards the states updated on this update. */
+	static void CountNotify(UPaperZDAnimInstance* AnimInstance);
+
+	/* Cycles measured by the scopes nested inside the current one, on this thread. */
+	static uint64& GetNestedCycles();
+};
+
+/**
+ * Measures the rest of the scope into a counter, if any.
+ * Nested scopes are discounted from the outer ones when measuring exclusive time, so every AnimNode only pays for its own work.
+ */
+class FPaperZDCostScope
+{
+	FPaperZDCostCounter* Counter;
+	uint64 StartCycles;
+	uint64 OuterNestedCycles;
+	bool bExclusive;
+
+public:
+	/**
+	 * @param InCounter		Counter to measure into, null to measure nothing.
+	 * @param bInExclusive	If true, the time of the nested scopes isn't counted.
+	 * @param bCount		If true, the scope counts as an update or evaluation.
+	 */
+	FORCEINLINE FPaperZDCostScope(FPaperZDCostCounter* InCounter, bool bInExclusive, bool bCount = true)
+		: Counter(InCounter)
+		, StartCycles(0)
+		, OuterNestedCycles(0)
+		, bExclusive(bInExclusive)
+	{
+		if (Counter)
+		{
+			Counter->Count += bCount ? 1 : 0;
+			uint64& NestedCycles = FPaperZDNodeCostCapture::GetNestedCycles();
+			OuterNestedCycles = NestedCycles;
+			NestedCycles = 0;
+			StartCycles = FPlatformTime::Cycles64();
+		}
+	}
+
+	FORCEINLINE ~FPaperZDCostScope()
+	{
+		if (Counter)
+		{
+			const uint64 TotalCycles = FPlatformTime::Cycles64() - StartCycles;
+			uint64& NestedCycles = FPaperZDNodeCostCapture::GetNestedCycles();
+			Counter->Cycles += bExclusive ? TotalCycles - FMath::Min(NestedCycles, TotalCycles) : TotalCycles;
+			NestedCycles = OuterNestedCycles + TotalCycles;
+		}
+	}
+};
+
+/* Measures the rest of the scope into the given counter of the AnimInstance costs, if it's capturing. */
+#define PAPERZD_COST_SCOPE(AnimInstance, CounterType, bExclusive, bCount, ...) \
+	FPaperZDCostScope PREPROCESSOR_JOIN(CostScope_, __LINE__)((AnimInstance) && (AnimInstance)->GetNodeCosts() ? (AnimInstance)->GetNodeCosts()->Find##CounterType(__VA_ARGS__) : nullptr, bExclusive, bCount)
+
+/* Runs the given statement on the counter of the AnimInstance costs, if it's capturing. */
+#define PAPERZD_COST_COUNT(AnimInstance, CounterType, Statement, ...) \
+	do \
+	{ \
+		if (FPaperZDCostCounter* CostCounter = (AnimInstance) && (AnimInstance)->GetNodeCosts() ? (AnimInstance)->GetNodeCosts()->Find##CounterType(__VA_ARGS__) : nullptr) \
+		{ \
+			CostCounter->Statement; \
+		} \
+	} while (0)
+
+/* Counts a fired notify towards the active states of the AnimInstance. */
+#define PAPERZD_COST_NOTIFY(AnimInstance) FPaperZDNodeCostCapture::CountNotify(AnimInstance)
+
+#else
+
+#define PAPERZD_COST_SCOPE(AnimInstance, CounterType, bExclusive, bCount, ...)
+#define PAPERZD_COST_COUNT(AnimInstance, CounterType, Statement, ...)
+#define PAPERZD_COST_NOTIFY(AnimInstance)
+
+#endif
@@ -0,0 +1,136 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/**
+ * Live aggregate profiler of the AnimInstances, controlled with the "paperzd.Profile Start|Stop|Dump" console command.
+ * Gathers per AnimBP class: live instances, average and p99 tick cost, rule evaluations and notifies per second, blueprint VM calls per tick and flipbook swaps.
+ * Every thread records into its own counters, which are only merged when dumping or at the end of the frame, so recording never takes a lock.
+ * While stopped, the only cost on the hot path is the check of the flag.
+ */
+struct PAPERZD_API FPaperZDProfiler
+{
+private:
+	static bool bActive;
+
+public:
+	/* Starts a new profiling session, discarding the data of the previous one. */
+	static void Start();
+
+	/* Stops recording, the data stays available for dumping. */
+	static void Stop();
+
+	/* Merges the counters of every thread and prints them per AnimBP class, optionally writing them as CSV to Saved/Profiling/PaperZD. */
+	static void Dump(bool bWriteCsvFile = false);
+
+	/* True while a session is recording. */
+	static FORCEINLINE bool IsActive() { return bActive; }
+
+	/* Called once per completed update of an AnimInstance, with the cycles it took on any thread. Null instances (i.e. editor previews) are ignored by every call. */
+	static FORCEINLINE void RecordTick(const UObject* AnimInstance, uint64 Cycles)
+	{
+		if (bActive && AnimInstance)
+		{
+			RecordTickInternal(AnimInstance, Cycles);
+		}
+	}
+
+	/* Called by the state machines after looking for a transition, with the amount of rules evaluated. */
+	static FORCEINLINE void CountRuleEvaluations(const UObject* AnimInstance, int32 NumEvaluations)
+	{
+		if (bActive && AnimInstance)
+		{
+			CountRuleEvaluationsInternal(AnimInstance, NumEvaluations);
+		}
+	}
+
+	/* Called when a notify triggers, or a notify state begins. */
+	static FORCEINLINE void CountNotifyFired(const UObject* AnimInstance)
+	{
+		if (bActive && AnimInstance)
+		{
+			CountNotifyFiredInternal(AnimInstance);
+		}
+	}
+
+	/* Called right before the AnimInstance executes a function through the blueprint VM. */
+	static FORCEINLINE void CountBlueprintCall(const UObject* AnimInstance)
+	{
+		if (bActive && AnimInstance)
+		{
+			CountBlueprintCallInternal(AnimInstance);
+		}
+	}
+
+	/* Same as CountBlueprintCall, for BlueprintNativeEvents that only go through the VM when the AnimBP overrides them. */
+	static FORCEINLINE void CountBlueprintEvent(const UObject* AnimInstance, FName EventName)
+	{
+		if (bActive && AnimInstance)
+		{
+			CountBlueprintEventInternal(AnimInstance, EventName);
+		}
+	}
+
+	/* Called when the flipbook displayed by an AnimInstance changes. */
+	static FORCEINLINE void CountFlipbookSwap(const UObject* AnimInstance)
+	{
+		if (bActive && AnimInstance)
+		{
+			CountFlipbookSwapInternal(AnimInstance);
+		}
+	}
+
+private:
+	static void RecordTickInternal(const UObject* AnimInstance, uint64 Cycles);
+	static void CountRuleEvaluationsInternal(const UObject* AnimInstance, int32 NumEvaluations);
+	static void CountNotifyFiredInternal(const UObject* AnimInstance);
+	static void CountBlueprintCallInternal(const UObject* AnimInstance);
+	static void CountBlueprintEventInternal(const UObject* AnimInstance, FName EventName);
+	static void CountFlipbookSwapInternal(const UObject* AnimInstance);
+};
+
+/**
+ * Accumulates the cycles spent inside the scope while the profiler is active.
+ * Updates that are split between the game thread and the parallel phase accumulate on the same counter, the last part records the total.
+ */
+class FPaperZDProfileTickScope
+{
+	const UObject* AnimInstance;
+	uint64& AccumulatedCycles;
+	uint64 StartCycles;
+	bool bRecord;
+
+public:
+	/**
+	 * @param InAnimInstance		Instance being updated.
+	 * @param InAccumulatedCycles	Counter that persists between the parts of the update.
+	 * @param bFirstPart			If true, the counter is reset before accumulating.
+	 * @param bLastPart				If true, the total is recorded when leaving the scope.
+	 */
+	FORCEINLINE FPaperZDProfileTickScope(const UObject* InAnimInstance, uint64& InAccumulatedCycles, bool bFirstPart, bool bLastPart)
+		: AnimInstance(InAnimInstance)
+		, AccumulatedCycles(InAccumulatedCycles)
+		, StartCycles(FPaperZDProfiler::IsActive() ? FPlatformTime::Cycles64() : 0)
+		, bRecord(bLastPart)
+	{
+		if (bFirstPart)
+		{
+			AccumulatedCycles = 0;
+		}
+	}
+
+	FORCEINLINE ~FPaperZDProfileTickScope()
+	{
+		if (StartCycles)
+		{
+			AccumulatedCycles += FPlatformTime::Cycles64() - StartCycles;
+			if (bRecord)
+			{
+				FPaperZDProfiler::RecordTick(AnimInstance, AccumulatedCycles);
+			}
+		}
+	}
+};
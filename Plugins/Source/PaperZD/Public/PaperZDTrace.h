@@ -0,0 +1,90 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#ifndef PAPERZD_TRACE_ENABLED
+#define PAPERZD_TRACE_ENABLED (UE_TRACE_ENABLED && CPUPROFILERTRACE_ENABLED && !UE_BUILD_SHIPPING)
+#endif
+
+#if PAPERZD_TRACE_ENABLED
+
+class UClass;
+class UObject;
+class UPaperFlipbook;
+class UPaperZDAnimInstance;
+class UPaperZDAnimNotify_Base;
+
+/* Trace channel for PaperZD, enable it on Unreal Insights or with -trace=cpu,paperzd. */
+UE_TRACE_CHANNEL_EXTERN(PaperZDChannel, PAPERZD_API);
+
+/**
+ * Emits the PaperZD events on the trace stream, should only be called through the PAPERZD_TRACE macros so nothing is evaluated while the channel is disabled.
+ * Every event carries the id of the AnimInstance that caused it, which the Instance event maps to its AnimBP class and owner.
+ */
+struct PAPERZD_API FPaperZDTrace
+{
+	/* Scopes, shown as CPU timing events named after the AnimBP class, node type or transition rule. */
+	static void BeginScope(FName Name);
+	static void EndScope();
+
+	/* Emitted once per AnimInstance when it gets initialized. */
+	static void OutputInstance(const UPaperZDAnimInstance* AnimInstance);
+
+	/* State machine activity. */
+	static void OutputStateEntered(const UObject* AnimInstance, FName MachineName, FName StateName);
+	static void OutputStateExited(const UObject* AnimInstance, FName MachineName, FName StateName);
+	static void OutputTransition(const UObject* AnimInstance, FName MachineName, FName FromStateName, FName ToStateName);
+	static void OutputRuleEvaluations(const UObject* AnimInstance, FName MachineName, int32 NumEvaluations);
+
+	/* Notify triggered, or notify state that began. */
+	static void OutputNotifyFired(const UPaperZDAnimInstance* AnimInstance, const UPaperZDAnimNotify_Base* Notify);
+	static void OutputNotifyFired(const UPaperZDAnimInstance* AnimInstance, FName NotifyName, const UClass* NotifyClass);
+
+	/* Flipbook changed on a render component or instance. */
+	static void OutputFlipbookSwap(const UObject* RenderComponent, const UPaperFlipbook* Flipbook);
+};
+
+/* Timing scope that only does work while both the PaperZD and the CPU channels are enabled. */
+class FPaperZDTraceScope
+{
+	bool bActive;
+
+public:
+	FORCEINLINE explicit FPaperZDTraceScope(FName Name)
+		: bActive(UE_TRACE_CHANNELEXPR_IS_ENABLED(PaperZDChannel | CpuChannel))
+	{
+		if (bActive)
+		{
+			FPaperZDTrace::BeginScope(Name);
+		}
+	}
+
+	FORCEINLINE ~FPaperZDTraceScope()
+	{
+		if (bActive)
+		{
+			FPaperZDTrace::EndScope();
+		}
+	}
+};
+
+#define PAPERZD_TRACE_SCOPE(Name) FPaperZDTraceScope PREPROCESSOR_JOIN(PaperZDTraceScope, __LINE__)(Name)
+#define PAPERZD_TRACE_EVENT(EventName, ...) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(PaperZDChannel)) \
+		{ \
+			FPaperZDTrace::Output##EventName(__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+#define PAPERZD_TRACE_SCOPE(Name)
+#define PAPERZD_TRACE_EVENT(EventName, ...)
+
+#endif
@@ -30,6 +30,7 @@ public class PaperZDEditor : ModuleRules
                 Path.Combine(ModuleDirectory, "Private/Graphs"),
                 Path.Combine(ModuleDirectory, "Private/Graphs/Nodes"),
                 Path.Combine(ModuleDirectory, "Private/Graphs/Nodes/Slate"),
+                Path.Combine(ModuleDirectory, "Private/Commandlets"),
 				/*"PaperZDEditor/Private",
                 "PaperZDEditor/Private/Factories",
                 "PaperZDEditor/Private/AssetTypeActions",
@@ -87,6 +88,7 @@ public class PaperZDEditor : ModuleRules
                 "SequencerWidgets",
                 "EditorWidgets",
                 "ApplicationCore",
+                "Json",
 
                 //Plugin Management
                 "Projects",
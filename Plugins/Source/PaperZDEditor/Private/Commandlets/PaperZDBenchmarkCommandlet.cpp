@@ -0,0 +1,476 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDBenchmarkCommandlet.h"
+#include "PaperZDBenchmarkScenarios.h"
+#include "PaperZDAnimBP.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimationComponent.h"
+#include "PaperZDAnimCounters.h"
+#include "PaperZDAllocationCounter.h"
+#include "AnimSequences/Sources/PaperZDAnimationSource.h"
+#include "AnimSequences/PaperZDAnimSequence.h"
+#include "AnimSequences/Players/PaperZDAnimPlayer.h"
+#include "AnimSequences/Players/PaperZDPlaybackHandle.h"
+#include "Notifies/PaperZDAnimNotify_Base.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Components/PrimitiveComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectIterator.h"
+#include "UObject/UObjectArray.h"
+
+namespace FPaperZDBenchmarkHelpers
+{
+	/* Optional run of every scenario with a feature toggled, reported with a suffix on the scenario name. */
+	struct FVariant
+	{
+		const TCHAR* Suffix;
+		bool bEnableAnimSharing;
+		bool bForceLightweightPlayer;
+	};
+
+	/* Memory in use by the process. */
+	int64 GetUsedMemory()
+	{
+		return static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	/* Amount of live objects of the given class. */
+	template<typename T>
+	int32 CountObjects()
+	{
+		int32 NumObjects = 0;
+		for (TObjectIterator<T> It(RF_ClassDefaultObject); It; ++It)
+		{
+			NumObjects++;
+		}
+		return NumObjects;
+	}
+
+	/* Forces the given amount of full garbage collections after getting rid of any garbage left, so they only measure the reachability of live objects. Returns the average time in milliseconds. */
+	double TimeFullGC(int32 NumPasses)
+	{
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < NumPasses; Pass++)
+		{
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumPasses;
+	}
+
+	/* True if the object is the root or a member of a garbage collection cluster. */
+	bool IsClustered(const UObject* Object)
+	{
+		const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(Object);
+		return ObjectItem->GetOwnerIndex() != 0 || ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot);
+	}
+
+	/* Clusters the loaded AnimSequences the way cooked builds do on load, the editor never does. Returns the cluster roots created, sequences and animation sources, so they can be dissolved afterwards. */
+	TArray<UObject*> ClusterAnimSequences()
+	{
+		TArray<UObject*> Candidates;
+		for (TObjectIterator<UPaperZDAnimSequence> It(RF_ClassDefaultObject); It; ++It)
+		{
+			if (!IsClustered(*It))
+			{
+				Candidates.Add(*It);
+				if (It->GetAnimSource() && !IsClustered(It->GetAnimSource()))
+				{
+					Candidates.AddUnique(It->GetAnimSource());
+				}
+			}
+		}
+
+		for (UObject* Candidate : Candidates)
+		{
+			if (Candidate->IsA<UPaperZDAnimSequence>() && !Candidate->HasAnyFlags(RF_NeedLoad | RF_NeedPostLoad) && Candidate->CanBeClusterRoot())
+			{
+				Candidate->CreateCluster();
+			}
+		}
+
+		TArray<UObject*> ClusterRoots;
+		for (UObject* Candidate : Candidates)
+		{
+			if (GUObjectArray.ObjectToObjectItem(Candidate)->HasAnyFlags(EInternalObjectFlags::ClusterRoot))
+			{
+				ClusterRoots.Add(Candidate);
+			}
+		}
+		return ClusterRoots;
+	}
+
+	/* Dissolves the clusters created by ClusterAnimSequences. */
+	void DissolveClusters(const TArray<UObject*>& ClusterRoots)
+	{
+		for (UObject* ClusterRoot : ClusterRoots)
+		{
+			const FUObjectItem* ObjectItem = GUObjectArray.ObjectToObjectItem(ClusterRoot);
+			if (ObjectItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot))
+			{
+				GUObjectClusters.DissolveCluster(GUObjectClusters[ObjectItem->GetClusterIndex()]);
+			}
+		}
+	}
+
+	/* Parses a comma separated list of integers. */
+	TArray<int32> ParseCounts(const FString& CountsString)
+	{
+		TArray<FString> Entries;
+		CountsString.ParseIntoArray(Entries, TEXT(","));
+
+		TArray<int32> Counts;
+		for (const FString& Entry : Entries)
+		{
+			const int32 Count = FCString::Atoi(*Entry);
+			if (Count > 0)
+			{
+				Counts.Add(Count);
+			}
+		}
+		return Counts;
+	}
+
+	/* Obtain the AnimInstance class of a scenario, built by the commandlet when no path is given. Otherwise loads the AnimBP at the given path, or its generated class. */
+	TSubclassOf<UPaperZDAnimInstance> LoadAnimClass(const FString& Name, const FString& Path)
+	{
+		if (Path.IsEmpty())
+		{
+			const UPaperZDAnimBP* AnimBP = FPaperZDBenchmarkScenarios::CreateScenario(Name);
+			return AnimBP ? AnimBP->GeneratedClass.Get() : nullptr;
+		}
+
+		if (const UPaperZDAnimBP* AnimBP = LoadObject<UPaperZDAnimBP>(nullptr, *Path, nullptr, LOAD_NoWarn | LOAD_Quiet))
+		{
+			return AnimBP->GeneratedClass.Get();
+		}
+
+		return LoadObject<UClass>(nullptr, *Path, nullptr, LOAD_NoWarn | LOAD_Quiet);
+	}
+}
+
+UPaperZDBenchmarkCommandlet::UPaperZDBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPaperZDBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamsMap;
+	ParseCommandLine(*Params, Tokens, Switches, ParamsMap);
+
+	const FString* CountsParam = ParamsMap.Find(TEXT("Counts"));
+	const TArray<int32> Counts = FPaperZDBenchmarkHelpers::ParseCounts(CountsParam ? *CountsParam : TEXT("1,10,100,1000,10000"));
+	const FString* FramesParam = ParamsMap.Find(TEXT("Frames"));
+	const int32 NumFrames = FMath::Max(FramesParam ? FCString::Atoi(**FramesParam) : 300, 1);
+	const FString* WarmupParam = ParamsMap.Find(TEXT("WarmupFrames"));
+	const int32 NumWarmupFrames = FMath::Max(WarmupParam ? FCString::Atoi(**WarmupParam) : 10, 0);
+	const FString* DeltaTimeParam = ParamsMap.Find(TEXT("DeltaTime"));
+	const float DeltaTime = DeltaTimeParam ? FCString::Atof(**DeltaTimeParam) : 1.0f / 60.0f;
+	const FString* OutputParam = ParamsMap.Find(TEXT("Output"));
+	const FString OutputDir = OutputParam ? *OutputParam : FPaths::ProjectSavedDir() / TEXT("Profiling/PaperZD");
+	const FString* LabelParam = ParamsMap.Find(TEXT("Label"));
+	const FString Label = LabelParam ? *LabelParam : FString(FApp::GetBuildVersion());
+	const FString* GCPassesParam = ParamsMap.Find(TEXT("GCPasses"));
+	const int32 NumGCPasses = FMath::Max(GCPassesParam ? FCString::Atoi(**GCPassesParam) : 3, 0);
+	const bool bCompareClusters = Switches.Contains(TEXT("CompareClusters")) && NumGCPasses > 0;
+
+	//Variants run right after the regular pass, so their rows can be compared directly
+	TArray<FPaperZDBenchmarkHelpers::FVariant> Variants = { { TEXT(""), false, false } };
+	if (Switches.Contains(TEXT("Sharing")))
+	{
+		Variants.Add({ TEXT("+Sharing"), true, false });
+	}
+	if (Switches.Contains(TEXT("LightweightPlayer")))
+	{
+		Variants.Add({ TEXT("+Lightweight"), false, true });
+	}
+
+	//Gather the scenarios, either built-in ones given by name, project AnimBPs given as Name=Path pairs, or every built-in one by default
+	TArray<TPair<FString, FString>> Scenarios;
+	if (const FString* ScenariosParam = ParamsMap.Find(TEXT("Scenarios")))
+	{
+		TArray<FString> Entries;
+		ScenariosParam->ParseIntoArray(Entries, TEXT(","));
+		for (const FString& Entry : Entries)
+		{
+			FString Name, Path;
+			if (!Entry.Split(TEXT("="), &Name, &Path))
+			{
+				Name = Entry;
+			}
+			Scenarios.Emplace(Name, Path);
+		}
+	}
+	else
+	{
+		for (const FString& ScenarioName : FPaperZDBenchmarkScenarios::GetScenarioNames())
+		{
+			Scenarios.Emplace(ScenarioName, FString());
+		}
+	}
+
+	if (Counts.Num() == 0 || DeltaTime <= 0.0f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("PaperZDBenchmark: invalid instance counts or delta time."));
+		return 1;
+	}
+
+	//The cost and allocations of ticking an empty world are removed from every measurement
+	double BaselineMsPerFrame = 0.0;
+	double BaselineAllocationsPerFrame = 0.0;
+	{
+		UWorld* World = CreateBenchmarkWorld();
+		TickWorld(World, NumWarmupFrames, DeltaTime);
+		FPaperZDScopedAllocationCounter BaselineAllocations;
+		BaselineMsPerFrame = TickWorld(World, NumFrames, DeltaTime) / NumFrames;
+		BaselineAllocations.Stop();
+		BaselineAllocationsPerFrame = static_cast<double>(BaselineAllocations.GetNumAllocations()) / NumFrames;
+		DestroyBenchmarkWorld(World);
+	}
+
+	TArray<FResult> Results;
+	for (const TPair<FString, FString>& Scenario : Scenarios)
+	{
+		const TSubclassOf<UPaperZDAnimInstance> AnimClass = FPaperZDBenchmarkHelpers::LoadAnimClass(Scenario.Key, Scenario.Value);
+		if (!AnimClass)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("PaperZDBenchmark: skipping scenario '%s', %s."), *Scenario.Key,
+				Scenario.Value.IsEmpty() ? TEXT("it isn't a built-in scenario or it failed to compile") : *FString::Printf(TEXT("no AnimBP found at '%s'"), *Scenario.Value));
+			continue;
+		}
+
+		for (const int32 NumInstances : Counts)
+		{
+			for (const FPaperZDBenchmarkHelpers::FVariant& Variant : Variants)
+			{
+				const FString ScenarioName = Scenario.Key + Variant.Suffix;
+				const FResult& Result = Results.Add_GetRef(RunScenario(ScenarioName, AnimClass, NumInstances, NumFrames, NumWarmupFrames, DeltaTime, BaselineMsPerFrame, BaselineAllocationsPerFrame,
+					Variant.bEnableAnimSharing, Variant.bForceLightweightPlayer, NumGCPasses, bCompareClusters));
+				UE_LOG(LogTemp, Display, TEXT("PaperZDBenchmark: %s x%d: %.1f ns/instance/tick, %lld bytes/instance, %.2f allocations/instance on spawn, %.3f allocations/instance/tick, %lld notifies, %lld transitions, %d players, %d playback handles, %.3f ms per full GC."),
+					*Result.Scenario, Result.NumInstances, Result.NsPerInstanceTick, Result.SpawnMemoryPerInstance, Result.SpawnAllocationsPerInstance, Result.TickAllocationsPerInstanceTick, Result.NotifiesFired, Result.StateTransitions,
+					Result.NumAnimPlayers, Result.NumPlaybackHandles, Result.GCTimeMs);
+				if (bCompareClusters)
+				{
+					UE_LOG(LogTemp, Display, TEXT("PaperZDBenchmark: %s x%d: %.3f ms per full GC with the AnimSequences clustered, %d of %d notifies joined the clusters."),
+						*Result.Scenario, Result.NumInstances, Result.GCTimeClusteredMs, Result.NumClusteredNotifies, Result.NumNotifies);
+				}
+			}
+		}
+	}
+
+	if (Results.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("PaperZDBenchmark: no scenario could be run."));
+		return 1;
+	}
+
+	const FString BaseFileName = OutputDir / FString::Printf(TEXT("PaperZDBenchmark-%s"), *FDateTime::Now().ToString());
+	const bool bWritten = WriteCsv(BaseFileName + TEXT(".csv"), Label, Results) && WriteJson(BaseFileName + TEXT(".json"), Label, Results);
+	UE_LOG(LogTemp, Display, TEXT("PaperZDBenchmark: results written to '%s.csv/.json'."), *BaseFileName);
+	return bWritten ? 0 : 1;
+}
+
+UWorld* UPaperZDBenchmarkCommandlet::CreateBenchmarkWorld()
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("PaperZDBenchmarkWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+	return World;
+}
+
+void UPaperZDBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+double UPaperZDBenchmarkCommandlet::TickWorld(UWorld* World, int32 NumFrames, float DeltaTime)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		FApp::SetDeltaTime(DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+	}
+
+	return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+UPaperZDBenchmarkCommandlet::FResult UPaperZDBenchmarkCommandlet::RunScenario(const FString& ScenarioName, TSubclassOf<UPaperZDAnimInstance> AnimClass, int32 NumInstances, int32 NumFrames, int32 NumWarmupFrames, float DeltaTime,
+	double BaselineMsPerFrame, double BaselineAllocationsPerFrame, bool bEnableAnimSharing, bool bForceLightweightPlayer, int32 NumGCPasses, bool bCompareClusters)
+{
+	FResult Result;
+	Result.Scenario = ScenarioName;
+	Result.NumInstances = NumInstances;
+	Result.NumFrames = NumFrames;
+	Result.DeltaTime = DeltaTime;
+
+	//Render with whatever component the animation source expects
+	const UPaperZDAnimBP* AnimBP = Cast<UPaperZDAnimBP>(AnimClass->ClassGeneratedBy);
+	const UPaperZDAnimationSource* AnimSource = AnimBP ? AnimBP->GetSupportedAnimationSource() : nullptr;
+	TSubclassOf<UPrimitiveComponent> RenderClass = AnimSource ? AnimSource->GetRenderComponentClass() : nullptr;
+
+	//The instances pick the player mode when they initialize, so the variable only needs to be set while spawning
+	IConsoleVariable* LightweightPlayerCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("paperzd.LightweightPlayer"));
+	const int32 PreviousLightweightPlayer = LightweightPlayerCVar ? LightweightPlayerCVar->GetInt() : 0;
+	if (LightweightPlayerCVar && bForceLightweightPlayer)
+	{
+		LightweightPlayerCVar->Set(1, ECVF_SetByCode);
+	}
+
+	UWorld* World = CreateBenchmarkWorld();
+	const int64 MemoryBeforeSpawn = FPaperZDBenchmarkHelpers::GetUsedMemory();
+	FPaperZDScopedAllocationCounter SpawnAllocations;
+	for (int32 i = 0; i < NumInstances; i++)
+	{
+		AActor* Actor = World->SpawnActor<AActor>();
+		if (RenderClass)
+		{
+			UPrimitiveComponent* RenderComponent = NewObject<UPrimitiveComponent>(Actor, RenderClass);
+			Actor->SetRootComponent(RenderComponent);
+			Actor->AddInstanceComponent(RenderComponent);
+			RenderComponent->RegisterComponent();
+		}
+
+		//Registering the component on a world that has begun play creates the AnimInstance
+		UPaperZDAnimationComponent* AnimComponent = NewObject<UPaperZDAnimationComponent>(Actor);
+		if (UPrimitiveComponent* RenderComponent = Cast<UPrimitiveComponent>(Actor->GetRootComponent()))
+		{
+			AnimComponent->InitRenderComponent(RenderComponent);
+		}
+		AnimComponent->InitAnimInstanceClass(AnimClass);
+		AnimComponent->InitAnimSharing(bEnableAnimSharing);
+		Actor->AddInstanceComponent(AnimComponent);
+		AnimComponent->RegisterComponent();
+	}
+	SpawnAllocations.Stop();
+	if (LightweightPlayerCVar && bForceLightweightPlayer)
+	{
+		LightweightPlayerCVar->Set(PreviousLightweightPlayer, ECVF_SetByCode);
+	}
+
+	Result.SpawnMemoryPerInstance = (FPaperZDBenchmarkHelpers::GetUsedMemory() - MemoryBeforeSpawn) / NumInstances;
+	Result.SpawnAllocationsPerInstance = static_cast<double>(SpawnAllocations.GetNumAllocations()) / NumInstances;
+	Result.SpawnAllocatedBytesPerInstance = SpawnAllocations.GetAllocatedBytes() / NumInstances;
+
+	//Warm up, so first time initialization doesn't get measured
+	TickWorld(World, NumWarmupFrames, DeltaTime);
+
+	FPaperZDAnimCounters::Reset();
+	FPaperZDAnimCounters::SetEnabled(true);
+	const int64 MemoryBeforeTick = FPaperZDBenchmarkHelpers::GetUsedMemory();
+	FPaperZDScopedAllocationCounter TickAllocations;
+	const double TickTimeMs = TickWorld(World, NumFrames, DeltaTime);
+	TickAllocations.Stop();
+	Result.TickMemoryDelta = FPaperZDBenchmarkHelpers::GetUsedMemory() - MemoryBeforeTick;
+	FPaperZDAnimCounters::SetEnabled(false);
+
+	const FPaperZDAnimCounters::FSnapshot Counters = FPaperZDAnimCounters::GetSnapshot();
+	Result.NotifiesFired = Counters.NotifiesFired;
+	Result.StateTransitions = Counters.StateTransitions;
+	Result.TickTimeMs = TickTimeMs;
+	Result.NsPerInstanceTick = FMath::Max(TickTimeMs - BaselineMsPerFrame * NumFrames, 0.0) * 1000000.0 / (static_cast<double>(NumInstances) * NumFrames);
+
+	//Allocations done by the world itself and any other engine thread are included, compare against the empty world baseline
+	Result.TickAllocations = TickAllocations.GetNumAllocations();
+	Result.TickAllocationsPerInstanceTick = FMath::Max(Result.TickAllocations - BaselineAllocationsPerFrame * NumFrames, 0.0) / (static_cast<double>(NumInstances) * NumFrames);
+
+	//Objects the garbage collector has to walk because of the instances, the lightweight player gets rid of most of them
+	Result.NumAnimPlayers = FPaperZDBenchmarkHelpers::CountObjects<UPaperZDAnimPlayer>();
+	Result.NumPlaybackHandles = FPaperZDBenchmarkHelpers::CountObjects<UPaperZDPlaybackHandle>();
+
+	//Full collections with every instance alive. Includes every other object of the editor, compare rows with the same instance count
+	if (NumGCPasses > 0)
+	{
+		Result.GCTimeMs = FPaperZDBenchmarkHelpers::TimeFullGC(NumGCPasses);
+	}
+
+	//Same collections with the sequences clustered, the notifies that weren't packed join the cluster of their sequence
+	if (bCompareClusters)
+	{
+		const TArray<UObject*> ClusterRoots = FPaperZDBenchmarkHelpers::ClusterAnimSequences();
+		for (TObjectIterator<UPaperZDAnimNotify_Base> It(RF_ClassDefaultObject); It; ++It)
+		{
+			Result.NumNotifies++;
+			Result.NumClusteredNotifies += FPaperZDBenchmarkHelpers::IsClustered(*It) ? 1 : 0;
+		}
+
+		Result.GCTimeClusteredMs = FPaperZDBenchmarkHelpers::TimeFullGC(NumGCPasses);
+		FPaperZDBenchmarkHelpers::DissolveClusters(ClusterRoots);
+	}
+
+	DestroyBenchmarkWorld(World);
+	return Result;
+}
+
+bool UPaperZDBenchmarkCommandlet::WriteCsv(const FString& FilePath, const FString& Label, const TArray<FResult>& Results)
+{
+	FString Csv = TEXT("Label,Scenario,Instances,Frames,DeltaTime,TickTimeMs,NsPerInstanceTick,SpawnBytesPerInstance,SpawnAllocationsPerInstance,SpawnAllocatedBytesPerInstance,TickMemoryDeltaBytes,TickAllocations,TickAllocationsPerInstanceTick,NotifiesFired,StateTransitions,AnimPlayers,PlaybackHandles,GCTimeMs,GCTimeClusteredMs,ClusteredNotifies\n");
+	for (const FResult& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%f,%f,%f,%lld,%f,%lld,%lld,%lld,%f,%lld,%lld,%d,%d,%f,%f,%d\n"), *Label, *Result.Scenario, Result.NumInstances, Result.NumFrames, Result.DeltaTime,
+			Result.TickTimeMs, Result.NsPerInstanceTick, Result.SpawnMemoryPerInstance, Result.SpawnAllocationsPerInstance, Result.SpawnAllocatedBytesPerInstance,
+			Result.TickMemoryDelta, Result.TickAllocations, Result.TickAllocationsPerInstanceTick, Result.NotifiesFired, Result.StateTransitions, Result.NumAnimPlayers, Result.NumPlaybackHandles, Result.GCTimeMs, Result.GCTimeClusteredMs, Result.NumClusteredNotifies);
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *FilePath);
+}
+
+bool UPaperZDBenchmarkCommandlet::WriteJson(const FString& FilePath, const FString& Label, const TArray<FResult>& Results)
+{
+	TArray<TSharedPtr<FJsonValue>> JsonResults;
+	for (const FResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+		JsonResult->SetStringField(TEXT("Scenario"), Result.Scenario);
+		JsonResult->SetNumberField(TEXT("Instances"), Result.NumInstances);
+		JsonResult->SetNumberField(TEXT("Frames"), Result.NumFrames);
+		JsonResult->SetNumberField(TEXT("DeltaTime"), Result.DeltaTime);
+		JsonResult->SetNumberField(TEXT("TickTimeMs"), Result.TickTimeMs);
+		JsonResult->SetNumberField(TEXT("NsPerInstanceTick"), Result.NsPerInstanceTick);
+		JsonResult->SetNumberField(TEXT("SpawnBytesPerInstance"), static_cast<double>(Result.SpawnMemoryPerInstance));
+		JsonResult->SetNumberField(TEXT("SpawnAllocationsPerInstance"), Result.SpawnAllocationsPerInstance);
+		JsonResult->SetNumberField(TEXT("SpawnAllocatedBytesPerInstance"), static_cast<double>(Result.SpawnAllocatedBytesPerInstance));
+		JsonResult->SetNumberField(TEXT("TickMemoryDeltaBytes"), static_cast<double>(Result.TickMemoryDelta));
+		JsonResult->SetNumberField(TEXT("TickAllocations"), static_cast<double>(Result.TickAllocations));
+		JsonResult->SetNumberField(TEXT("TickAllocationsPerInstanceTick"), Result.TickAllocationsPerInstanceTick);
+		JsonResult->SetNumberField(TEXT("NotifiesFired"), static_cast<double>(Result.NotifiesFired));
+		JsonResult->SetNumberField(TEXT("StateTransitions"), static_cast<double>(Result.StateTransitions));
+		JsonResult->SetNumberField(TEXT("AnimPlayers"), Result.NumAnimPlayers);
+		JsonResult->SetNumberField(TEXT("PlaybackHandles"), Result.NumPlaybackHandles);
+		JsonResult->SetNumberField(TEXT("GCTimeMs"), Result.GCTimeMs);
+		JsonResult->SetNumberField(TEXT("GCTimeClusteredMs"), Result.GCTimeClusteredMs);
+		JsonResult->SetNumberField(TEXT("ClusteredNotifies"), Result.NumClusteredNotifies);
+		JsonResults.Add(MakeShared<FJsonValueObject>(JsonResult));
+	}
+
+	TSharedRef<FJsonObject> JsonRoot = MakeShared<FJsonObject>();
+	JsonRoot->SetStringField(TEXT("Label"), Label);
+	JsonRoot->SetArrayField(TEXT("Results"), JsonResults);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	return FJsonSerializer::Serialize(JsonRoot, Writer) && FFileHelper::SaveStringToFile(Json, *FilePath);
+}
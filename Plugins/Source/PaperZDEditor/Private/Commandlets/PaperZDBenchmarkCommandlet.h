@@ -0,0 +1,86 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PaperZDBenchmarkCommandlet.generated.h"
+
+class UPaperZDAnimInstance;
+class UWorld;
+
+/**
+ * Headless benchmark of the PaperZD runtime, meant to run with -nullrhi so results can be compared between builds.
+ * For every scenario and instance count, spawns the instances on a fresh game world, ticks it for a fixed amount of frames with a fixed delta time and reports
+ * the cost per instance and tick, the memory used, the heap allocations done, the notifies and state transitions that happened, the players and playback handles alive
+ * and the time of a full garbage collection with the instances alive. Results are written as CSV and JSON.
+ *
+ * Scenarios are AnimBPs that stress a single feature. The built-in ones are generated and compiled by the commandlet, so no content is needed:
+ * FlatPlaySequence, DeepStateMachine, ConduitChain, RandomPlayer, LayeredAnimations, HeavyNotifies and ExposedValues, all of them run by default.
+ * Project AnimBPs can be benchmarked too, by giving them as Name=Path pairs.
+ * With -Sharing, every scenario also runs with animation sharing enabled on its components, reported as "<Scenario>+Sharing".
+ * With -LightweightPlayer, every scenario also runs with paperzd.LightweightPlayer forced on, reported as "<Scenario>+Lightweight", to compare the garbage collection time
+ * without the player objects.
+ * The garbage collection time is averaged over -GCPasses collections, zero skips it.
+ * With -CompareClusters, the collections are timed again with the AnimSequences clustered as cooked builds do on load, reported as GCTimeClusteredMs. The sequences aren't cooked,
+ * so their built-in notifies aren't packed and join the clusters, as they would when cooking with paperzd.PackBuiltInNotifies off.
+ *
+ * Usage: UE4Editor-Cmd <Project> -run=PaperZDBenchmark -nullrhi [-Scenarios=FlatPlaySequence,Name=/Game/Path/ABP,...]
+ *        [-Counts=1,10,100,1000,10000] [-Frames=300] [-WarmupFrames=10] [-DeltaTime=0.016667] [-Sharing] [-LightweightPlayer] [-GCPasses=3] [-CompareClusters] [-Output=Dir] [-Label=BuildLabel]
+ */
+UCLASS()
+class UPaperZDBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	/* Measurements of a single scenario and instance count. */
+	struct FResult
+	{
+		FString Scenario;
+		int32 NumInstances = 0;
+		int32 NumFrames = 0;
+		float DeltaTime = 0.0f;
+		double TickTimeMs = 0.0;
+		double NsPerInstanceTick = 0.0;
+		int64 SpawnMemoryPerInstance = 0;
+		double SpawnAllocationsPerInstance = 0.0;
+		int64 SpawnAllocatedBytesPerInstance = 0;
+		int64 TickMemoryDelta = 0;
+		int64 TickAllocations = 0;
+		double TickAllocationsPerInstanceTick = 0.0;
+		int64 NotifiesFired = 0;
+		int64 StateTransitions = 0;
+		int32 NumAnimPlayers = 0;
+		int32 NumPlaybackHandles = 0;
+		double GCTimeMs = 0.0;
+		double GCTimeClusteredMs = 0.0;
+		int32 NumNotifies = 0;
+		int32 NumClusteredNotifies = 0;
+	};
+
+public:
+	//ctor
+	UPaperZDBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	/* Creates an empty game world that has begun play. */
+	static UWorld* CreateBenchmarkWorld();
+
+	/* Tears down a world created for the benchmark. */
+	static void DestroyBenchmarkWorld(UWorld* World);
+
+	/* Ticks the world the given amount of frames, returns the time it took in milliseconds. */
+	static double TickWorld(UWorld* World, int32 NumFrames, float DeltaTime);
+
+	/* Runs a single scenario with the given number of instances, optionally sharing their animation, forcing the lightweight player on them or timing the collection with clustered sequences. */
+	static FResult RunScenario(const FString& ScenarioName, TSubclassOf<UPaperZDAnimInstance> AnimClass, int32 NumInstances, int32 NumFrames, int32 NumWarmupFrames, float DeltaTime,
+		double BaselineMsPerFrame, double BaselineAllocationsPerFrame, bool bEnableAnimSharing, bool bForceLightweightPlayer, int32 NumGCPasses, bool bCompareClusters);
+
+	/* Writes the results to disk. */
+	static bool WriteCsv(const FString& FilePath, const FString& Label, const TArray<FResult>& Results);
+	static bool WriteJson(const FString& FilePath, const FString& Label, const TArray<FResult>& Results);
+};
@@ -0,0 +1,417 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "PaperZDBenchmarkScenarios.h"
+#include "PaperZDAnimBP.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimationComponent.h"
+#include "AnimNodes/PaperZDAnimNode_Base.h"
+#include "AnimNodes/PaperZDAnimNode_PlaySequence.h"
+#include "AnimSequences/PaperZDAnimSequence_Flipbook.h"
+#include "AnimSequences/Sources/PaperZDAnimationSource_Flipbook.h"
+#include "Notifies/PaperZDAnimNotifyCustom.h"
+#include "Graphs/PaperZDStateMachineSchema.h"
+#include "Graphs/PaperZDStateMachineGraph.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_Sink.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_PlaySequence.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_StateMachine.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_RandomPlayer.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_LayerAnimations.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_Root.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_State.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_Conduit.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_TransBase.h"
+#include "Graphs/Nodes/PaperZDTransitionGraphNode_Result.h"
+#include "K2Node_VariableGet.h"
+#include "EdGraphSchema_K2.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+#include "UObject/Package.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+namespace FPaperZDBenchmarkScenariosDefaults
+{
+	/* Playback rate of every flipbook. */
+	const float FramesPerSecond = 12.0f;
+
+	/* Keyframes of the regular sequences. */
+	const int32 NumKeyFrames = 8;
+
+	/* States on the ring of the deep state machine. */
+	const int32 NumDeepStates = 16;
+
+	/* Conduits between each pair of states of the conduit chain. */
+	const int32 NumChainedConduits = 8;
+
+	/* Entries of the random player and layers of the layered animations. */
+	const int32 NumRandomEntries = 4;
+	const int32 NumLayers = 4;
+
+	/* Custom notify fired by the heavy notifies scenario. */
+	const FName NotifyName = TEXT("BenchNotify");
+
+	/* States of the exposed values scenario, and the variable their play rate is bound to. */
+	const int32 NumExposedStates = 4;
+	const FName PlayRateVariableName = TEXT("BenchPlayRate");
+}
+
+const TArray<FString>& FPaperZDBenchmarkScenarios::GetScenarioNames()
+{
+	static const TArray<FString> ScenarioNames =
+	{
+		TEXT("FlatPlaySequence"),
+		TEXT("DeepStateMachine"),
+		TEXT("ConduitChain"),
+		TEXT("RandomPlayer"),
+		TEXT("LayeredAnimations"),
+		TEXT("HeavyNotifies"),
+		TEXT("ExposedValues")
+	};
+	return ScenarioNames;
+}
+
+UPaperZDAnimBP* FPaperZDBenchmarkScenarios::CreateScenario(const FString& ScenarioName)
+{
+	if (!GetScenarioNames().Contains(ScenarioName))
+	{
+		return nullptr;
+	}
+
+	FPaperZDBenchmarkScenarios Builder(ScenarioName);
+	UPaperZDAnimBP* AnimBP = Builder.CreateAnimBP(ScenarioName);
+	UEdGraph* AnimGraph = AnimBP->GetGraph();
+	if (ScenarioName == TEXT("FlatPlaySequence"))
+	{
+		Builder.BuildFlatPlaySequence(AnimGraph);
+	}
+	else if (ScenarioName == TEXT("DeepStateMachine"))
+	{
+		Builder.BuildDeepStateMachine(AnimGraph);
+	}
+	else if (ScenarioName == TEXT("ConduitChain"))
+	{
+		Builder.BuildConduitChain(AnimGraph);
+	}
+	else if (ScenarioName == TEXT("RandomPlayer"))
+	{
+		Builder.BuildRandomPlayer(AnimGraph);
+	}
+	else if (ScenarioName == TEXT("LayeredAnimations"))
+	{
+		Builder.BuildLayeredAnimations(AnimGraph);
+	}
+	else if (ScenarioName == TEXT("HeavyNotifies"))
+	{
+		Builder.BuildHeavyNotifies(AnimGraph);
+	}
+	else
+	{
+		Builder.BuildExposedValues(AnimGraph);
+	}
+
+	//Compile the way the editor would, failures are reported by the caller as a missing class
+	FKismetEditorUtilities::CompileBlueprint(AnimBP, EBlueprintCompileOptions::SkipGarbageCollection);
+	return AnimBP->Status != BS_Error && AnimBP->GeneratedClass ? AnimBP : nullptr;
+}
+
+UPaperZDAnimInstance* FPaperZDBenchmarkScenarios::SpawnAnimInstance(UWorld* World, TSubclassOf<UPaperZDAnimInstance> AnimClass)
+{
+	const UPaperZDAnimBP* AnimBP = CastChecked<UPaperZDAnimBP>(AnimClass->ClassGeneratedBy);
+	AActor* Actor = World->SpawnActor<AActor>();
+	UPrimitiveComponent* RenderComponent = NewObject<UPrimitiveComponent>(Actor, AnimBP->GetSupportedAnimationSource()->GetRenderComponentClass());
+	Actor->SetRootComponent(RenderComponent);
+	Actor->AddInstanceComponent(RenderComponent);
+	RenderComponent->RegisterComponent();
+
+	//Registering the component on a world that has begun play creates the AnimInstance
+	UPaperZDAnimationComponent* AnimComponent = NewObject<UPaperZDAnimationComponent>(Actor);
+	AnimComponent->InitRenderComponent(RenderComponent);
+	AnimComponent->InitAnimInstanceClass(AnimClass);
+	Actor->AddInstanceComponent(AnimComponent);
+	AnimComponent->RegisterComponent();
+	return AnimComponent->GetAnimInstance();
+}
+
+FPaperZDBenchmarkScenarios::FPaperZDBenchmarkScenarios(const FString& ScenarioName)
+{
+	Package = CreatePackage(*FString::Printf(TEXT("/Temp/PaperZDBenchmark/%s"), *ScenarioName));
+	Package->SetFlags(RF_Transient);
+
+	AnimSource = NewObject<UPaperZDAnimationSource_Flipbook>(Package, TEXT("AnimSource"), RF_Transient);
+	AnimSource->RegisterCustomNotify(FPaperZDBenchmarkScenariosDefaults::NotifyName);
+
+	//Sprites have no texture, nothing is meant to be seen and the benchmark runs without a renderer
+	for (int32 i = 0; i < FPaperZDBenchmarkScenariosDefaults::NumKeyFrames; i++)
+	{
+		Sprites.Add(NewObject<UPaperSprite>(Package, NAME_None, RF_Transient));
+	}
+}
+
+UPaperZDAnimSequence* FPaperZDBenchmarkScenarios::CreateSequence(int32 NumKeyFrames, bool bNotifyEveryKeyFrame /* = false */)
+{
+	UPaperFlipbook* Flipbook = NewObject<UPaperFlipbook>(Package, NAME_None, RF_Transient);
+	{
+		FScopedFlipbookMutator Mutator(Flipbook);
+		Mutator.FramesPerSecond = FPaperZDBenchmarkScenariosDefaults::FramesPerSecond;
+		for (int32 i = 0; i < NumKeyFrames; i++)
+		{
+			FPaperFlipbookKeyFrame& KeyFrame = Mutator.KeyFrames.AddDefaulted_GetRef();
+			KeyFrame.Sprite = Sprites[i % Sprites.Num()];
+			KeyFrame.FrameRun = 1;
+		}
+	}
+
+	//The data source is private to the sequence, but always holds its first entry after initialization
+	UPaperZDAnimSequence_Flipbook* Sequence = NewObject<UPaperZDAnimSequence_Flipbook>(Package, NAME_None, RF_Transient);
+	Sequence->SetAnimSource(AnimSource);
+	FArrayProperty* DataSourceProperty = Sequence->GetAnimDataSourceProperty();
+	FScriptArrayHelper ArrayHelper(DataSourceProperty, DataSourceProperty->ContainerPtrToValuePtr<uint8>(Sequence));
+	CastFieldChecked<FObjectProperty>(DataSourceProperty->Inner)->SetObjectPropertyValue(ArrayHelper.GetRawPtr(0), Flipbook);
+
+	if (bNotifyEveryKeyFrame)
+	{
+		const int32 TrackIndex = Sequence->CreateTrack();
+		for (int32 i = 0; i < NumKeyFrames; i++)
+		{
+			Sequence->AddNotifyToTrack(UPaperZDAnimNotifyCustom::StaticClass(), TrackIndex, FPaperZDBenchmarkScenariosDefaults::NotifyName, i / FPaperZDBenchmarkScenariosDefaults::FramesPerSecond);
+		}
+	}
+
+	Sequences.Add(Sequence);
+	return Sequence;
+}
+
+UPaperZDAnimBP* FPaperZDBenchmarkScenarios::CreateAnimBP(const FString& ScenarioName)
+{
+	const FName AnimBPName = *FString::Printf(TEXT("ABP_Bench_%s"), *ScenarioName);
+	UPaperZDAnimBP* AnimBP = CastChecked<UPaperZDAnimBP>(FKismetEditorUtilities::CreateBlueprint(UPaperZDAnimInstance::StaticClass(), Package, AnimBPName, BPTYPE_Normal, UPaperZDAnimBP::StaticClass(), UPaperZDAnimBPGeneratedClass::StaticClass()));
+	AnimBP->SupportedAnimationSource = AnimSource;
+	AnimBP->CreateGraph();
+	return AnimBP;
+}
+
+void FPaperZDBenchmarkScenarios::BuildFlatPlaySequence(UEdGraph* AnimGraph)
+{
+	AddPlaySequence(AnimGraph, CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames), FindSinkPin(AnimGraph));
+}
+
+void FPaperZDBenchmarkScenarios::BuildDeepStateMachine(UEdGraph* AnimGraph)
+{
+	FGraphNodeCreator<UPaperZDAnimGraphNode_StateMachine> NodeCreator(*AnimGraph);
+	UPaperZDAnimGraphNode_StateMachine* StateMachineNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+	FindAnimPin(StateMachineNode, EGPD_Output)->MakeLinkTo(FindSinkPin(AnimGraph));
+
+	//A ring of states whose transitions always pass, so every update walks the whole ring
+	UEdGraph* StateMachineGraph = StateMachineNode->GetStateMachineGraph();
+	const UEdGraphSchema* Schema = StateMachineGraph->GetSchema();
+	TArray<UPaperZDStateGraphNode_State*> States;
+	for (int32 i = 0; i < FPaperZDBenchmarkScenariosDefaults::NumDeepStates; i++)
+	{
+		UPaperZDStateGraphNode_State* State = FPaperZDStateMachineSchemaAction_NewNode::SpawnGraphNode<UPaperZDStateGraphNode_State>(StateMachineGraph, FVector2D(300.0f * i, 0.0f), false);
+		AddPlaySequence(State->GetBoundGraph(), CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames), FindSinkPin(State->GetBoundGraph()));
+		States.Add(State);
+	}
+
+	TArray<UPaperZDStateGraphNode_Root*> RootNodes;
+	StateMachineGraph->GetNodesOfClass(RootNodes);
+	Schema->TryCreateConnection(static_cast<UPaperZDStateGraphNode*>(RootNodes[0])->GetOutputPin(), States[0]->GetInputPin());
+	for (int32 i = 0; i < States.Num(); i++)
+	{
+		Schema->TryCreateConnection(States[i]->GetOutputPin(), States[(i + 1) % States.Num()]->GetInputPin());
+	}
+
+	SetTransitionRulesPassing(StateMachineGraph);
+}
+
+void FPaperZDBenchmarkScenarios::BuildConduitChain(UEdGraph* AnimGraph)
+{
+	FGraphNodeCreator<UPaperZDAnimGraphNode_StateMachine> NodeCreator(*AnimGraph);
+	UPaperZDAnimGraphNode_StateMachine* StateMachineNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+	FindAnimPin(StateMachineNode, EGPD_Output)->MakeLinkTo(FindSinkPin(AnimGraph));
+
+	//Two states that go back and forth through a chain of conduits on each direction
+	UEdGraph* StateMachineGraph = StateMachineNode->GetStateMachineGraph();
+	const UEdGraphSchema* Schema = StateMachineGraph->GetSchema();
+	UPaperZDStateGraphNode_State* States[2];
+	for (int32 i = 0; i < 2; i++)
+	{
+		States[i] = FPaperZDStateMachineSchemaAction_NewNode::SpawnGraphNode<UPaperZDStateGraphNode_State>(StateMachineGraph, FVector2D(0.0f, 600.0f * i), false);
+		AddPlaySequence(States[i]->GetBoundGraph(), CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames), FindSinkPin(States[i]->GetBoundGraph()));
+	}
+
+	TArray<UPaperZDStateGraphNode_Root*> RootNodes;
+	StateMachineGraph->GetNodesOfClass(RootNodes);
+	Schema->TryCreateConnection(static_cast<UPaperZDStateGraphNode*>(RootNodes[0])->GetOutputPin(), States[0]->GetInputPin());
+	for (int32 i = 0; i < 2; i++)
+	{
+		UPaperZDStateGraphNode* Previous = States[i];
+		for (int32 c = 0; c < FPaperZDBenchmarkScenariosDefaults::NumChainedConduits; c++)
+		{
+			UPaperZDStateGraphNode_Conduit* Conduit = FPaperZDStateMachineSchemaAction_NewNode::SpawnGraphNode<UPaperZDStateGraphNode_Conduit>(StateMachineGraph, FVector2D(300.0f * (c + 1), 200.0f + 200.0f * i), false);
+			Schema->TryCreateConnection(Previous->GetOutputPin(), Conduit->GetInputPin());
+			Previous = Conduit;
+		}
+		Schema->TryCreateConnection(Previous->GetOutputPin(), States[1 - i]->GetInputPin());
+	}
+
+	SetTransitionRulesPassing(StateMachineGraph);
+}
+
+void FPaperZDBenchmarkScenarios::BuildRandomPlayer(UEdGraph* AnimGraph)
+{
+	FGraphNodeCreator<UPaperZDAnimGraphNode_RandomPlayer> NodeCreator(*AnimGraph);
+	UPaperZDAnimGraphNode_RandomPlayer* RandomPlayerNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+
+	TArray<FString> Entries;
+	for (int32 i = 0; i < FPaperZDBenchmarkScenariosDefaults::NumRandomEntries; i++)
+	{
+		const UPaperZDAnimSequence* Sequence = CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames);
+		Entries.Add(FString::Printf(TEXT("(AnimSequence=\"%s\",ChanceToPlay=1.0,MinLoopCount=1,MaxLoopCount=3,MinPlayRate=0.8,MaxPlayRate=1.2)"), *Sequence->GetPathName()));
+	}
+	SetAnimNodeProperties(RandomPlayerNode, FString::Printf(TEXT("(Entries=(%s))"), *FString::Join(Entries, TEXT(","))));
+	FindAnimPin(RandomPlayerNode, EGPD_Output)->MakeLinkTo(FindSinkPin(AnimGraph));
+}
+
+void FPaperZDBenchmarkScenarios::BuildLayeredAnimations(UEdGraph* AnimGraph)
+{
+	FGraphNodeCreator<UPaperZDAnimGraphNode_LayerAnimations> NodeCreator(*AnimGraph);
+	UPaperZDAnimGraphNode_LayerAnimations* LayerNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+
+	//The node starts with two layers
+	for (int32 i = 2; i < FPaperZDBenchmarkScenariosDefaults::NumLayers; i++)
+	{
+		LayerNode->AddLayerPin();
+	}
+
+	for (int32 i = 0; i < FPaperZDBenchmarkScenariosDefaults::NumLayers; i++)
+	{
+		AddPlaySequence(AnimGraph, CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames + i), FindAnimPin(LayerNode, EGPD_Input, i));
+	}
+	FindAnimPin(LayerNode, EGPD_Output)->MakeLinkTo(FindSinkPin(AnimGraph));
+}
+
+void FPaperZDBenchmarkScenarios::BuildHeavyNotifies(UEdGraph* AnimGraph)
+{
+	AddPlaySequence(AnimGraph, CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames, true), FindSinkPin(AnimGraph));
+}
+
+void FPaperZDBenchmarkScenarios::BuildExposedValues(UEdGraph* AnimGraph)
+{
+	UBlueprint* Blueprint = FBlueprintEditorUtils::FindBlueprintForGraphChecked(AnimGraph);
+	FEdGraphPinType PlayRateType;
+	PlayRateType.PinCategory = UEdGraphSchema_K2::PC_Float;
+	FBlueprintEditorUtils::AddMemberVariable(Blueprint, FPaperZDBenchmarkScenariosDefaults::PlayRateVariableName, PlayRateType, TEXT("1.5"));
+
+	FGraphNodeCreator<UPaperZDAnimGraphNode_StateMachine> NodeCreator(*AnimGraph);
+	UPaperZDAnimGraphNode_StateMachine* StateMachineNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+	FindAnimPin(StateMachineNode, EGPD_Output)->MakeLinkTo(FindSinkPin(AnimGraph));
+
+	//The rules are left failing, so only the first state is ever reached while every state owns a bound play rate
+	UEdGraph* StateMachineGraph = StateMachineNode->GetStateMachineGraph();
+	const UEdGraphSchema* Schema = StateMachineGraph->GetSchema();
+	TArray<UPaperZDStateGraphNode_State*> States;
+	for (int32 i = 0; i < FPaperZDBenchmarkScenariosDefaults::NumExposedStates; i++)
+	{
+		UPaperZDStateGraphNode_State* State = FPaperZDStateMachineSchemaAction_NewNode::SpawnGraphNode<UPaperZDStateGraphNode_State>(StateMachineGraph, FVector2D(300.0f * i, 0.0f), false);
+		UEdGraphNode* PlaySequenceNode = AddPlaySequence(State->GetBoundGraph(), CreateSequence(FPaperZDBenchmarkScenariosDefaults::NumKeyFrames), FindSinkPin(State->GetBoundGraph()));
+		BindPinToVariable(PlaySequenceNode, GET_MEMBER_NAME_CHECKED(FPaperZDAnimNode_PlaySequence, PlayRate), FPaperZDBenchmarkScenariosDefaults::PlayRateVariableName);
+		States.Add(State);
+	}
+
+	TArray<UPaperZDStateGraphNode_Root*> RootNodes;
+	StateMachineGraph->GetNodesOfClass(RootNodes);
+	Schema->TryCreateConnection(static_cast<UPaperZDStateGraphNode*>(RootNodes[0])->GetOutputPin(), States[0]->GetInputPin());
+	for (int32 i = 0; i < States.Num(); i++)
+	{
+		Schema->TryCreateConnection(States[i]->GetOutputPin(), States[(i + 1) % States.Num()]->GetInputPin());
+	}
+}
+
+UEdGraphNode* FPaperZDBenchmarkScenarios::AddPlaySequence(UEdGraph* Graph, UPaperZDAnimSequence* Sequence, UEdGraphPin* TargetPin)
+{
+	FGraphNodeCreator<UPaperZDAnimGraphNode_PlaySequence> NodeCreator(*Graph);
+	UPaperZDAnimGraphNode_PlaySequence* PlaySequenceNode = NodeCreator.CreateNode(false);
+	NodeCreator.Finalize();
+
+	SetAnimNodeProperties(PlaySequenceNode, FString::Printf(TEXT("(AnimSequence=\"%s\",bLoopAnimation=True)"), *Sequence->GetPathName()));
+	FindAnimPin(PlaySequenceNode, EGPD_Output)->MakeLinkTo(TargetPin);
+	return PlaySequenceNode;
+}
+
+void FPaperZDBenchmarkScenarios::BindPinToVariable(UEdGraphNode* Node, FName PropertyName, FName VariableName)
+{
+	//Optional pins are private to every graph node class too, but exposed to reflection
+	FArrayProperty* OptionalPinsProperty = FindFProperty<FArrayProperty>(Node->GetClass(), TEXT("ShowPinForProperties"));
+	check(OptionalPinsProperty);
+	FScriptArrayHelper ArrayHelper(OptionalPinsProperty, OptionalPinsProperty->ContainerPtrToValuePtr<void>(Node));
+	for (int32 i = 0; i < ArrayHelper.Num(); i++)
+	{
+		FOptionalPinFromProperty* OptionalPin = reinterpret_cast<FOptionalPinFromProperty*>(ArrayHelper.GetRawPtr(i));
+		OptionalPin->bShowPin |= OptionalPin->PropertyName == PropertyName;
+	}
+	Node->ReconstructNode();
+
+	//A plain getter of a member variable, so the compiler puts the binding on the fast path
+	UEdGraph* Graph = Node->GetGraph();
+	FGraphNodeCreator<UK2Node_VariableGet> NodeCreator(*Graph);
+	UK2Node_VariableGet* VariableGet = NodeCreator.CreateNode(false);
+	VariableGet->VariableReference.SetSelfMember(VariableName);
+	NodeCreator.Finalize();
+	Graph->GetSchema()->TryCreateConnection(VariableGet->GetValuePin(), Node->FindPinChecked(PropertyName));
+}
+
+void FPaperZDBenchmarkScenarios::SetTransitionRulesPassing(UEdGraph* StateMachineGraph)
+{
+	TArray<UPaperZDStateGraphNode_TransBase*> TransitionNodes;
+	StateMachineGraph->GetNodesOfClass(TransitionNodes);
+	for (UPaperZDStateGraphNode_TransBase* TransitionNode : TransitionNodes)
+	{
+		UEdGraph* RuleGraph = TransitionNode->GetBoundGraph();
+		TArray<UPaperZDTransitionGraphNode_Result*> ResultNodes;
+		RuleGraph->GetNodesOfClass(ResultNodes);
+		for (UPaperZDTransitionGraphNode_Result* ResultNode : ResultNodes)
+		{
+			RuleGraph->GetSchema()->TrySetDefaultValue(*ResultNode->Pins[0], TEXT("true"));
+		}
+	}
+}
+
+UEdGraphPin* FPaperZDBenchmarkScenarios::FindAnimPin(UEdGraphNode* Node, EEdGraphPinDirection Direction, int32 Index /* = 0 */)
+{
+	int32 AnimPinIndex = 0;
+	for (UEdGraphPin* Pin : Node->Pins)
+	{
+		if (Pin->Direction == Direction && Pin->PinType.PinSubCategoryObject == FPaperZDAnimDataLink::StaticStruct() && AnimPinIndex++ == Index)
+		{
+			return Pin;
+		}
+	}
+
+	checkf(false, TEXT("Node '%s' has no animation pin %d."), *Node->GetName(), Index);
+	return nullptr;
+}
+
+UEdGraphPin* FPaperZDBenchmarkScenarios::FindSinkPin(UEdGraph* Graph)
+{
+	TArray<UPaperZDAnimGraphNode_Sink*> SinkNodes;
+	Graph->GetNodesOfClass(SinkNodes);
+	check(SinkNodes.Num());
+	return FindAnimPin(SinkNodes[0], EGPD_Input);
+}
+
+void FPaperZDBenchmarkScenarios::SetAnimNodeProperties(UEdGraphNode* Node, const FString& PropertiesText)
+{
+	//The runtime node is private to every graph node class, but always exposed to reflection under the same name
+	FStructProperty* AnimNodeProperty = FindFProperty<FStructProperty>(Node->GetClass(), TEXT("AnimNode"));
+	check(AnimNodeProperty);
+	AnimNodeProperty->ImportText(*PropertiesText, AnimNodeProperty->ContainerPtrToValuePtr<void>(Node), PPF_None, Node);
+}
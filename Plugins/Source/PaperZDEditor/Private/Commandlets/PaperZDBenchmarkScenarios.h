@@ -0,0 +1,85 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EdGraph/EdGraphNode.h"
+
+class UPackage;
+class UEdGraph;
+class UEdGraphPin;
+class UPaperSprite;
+class UPaperZDAnimBP;
+class UPaperZDAnimInstance;
+class UWorld;
+class UPaperZDAnimSequence;
+class UPaperZDAnimationSource_Flipbook;
+
+/**
+ * Builds the synthetic AnimBPs used by the benchmark commandlet, so it can run on any project without authored content.
+ * Each scenario stresses a single feature, and everything it creates lives on its own transient package under /Temp, which is never saved.
+ */
+class FPaperZDBenchmarkScenarios
+{
+	/* Package that holds every object of the scenario. */
+	UPackage* Package;
+
+	/* Animation source shared by the sequences and the AnimBP. */
+	UPaperZDAnimationSource_Flipbook* AnimSource;
+
+	/* One sprite per keyframe, shared by every flipbook. */
+	TArray<UPaperSprite*> Sprites;
+
+	/* Sequences created so far. */
+	TArray<UPaperZDAnimSequence*> Sequences;
+
+public:
+	/* Names of the scenarios that can be built. */
+	static const TArray<FString>& GetScenarioNames();
+
+	/**
+	 * Builds and compiles the AnimBP of the given scenario.
+	 * @return	The compiled AnimBP, or null if the scenario is unknown or failed to compile.
+	 */
+	static UPaperZDAnimBP* CreateScenario(const FString& ScenarioName);
+
+	/* Spawns an actor with its own render and animation components running the given class, on a world that has begun play. Used by the tests that drive the instances by hand. */
+	static UPaperZDAnimInstance* SpawnAnimInstance(UWorld* World, TSubclassOf<UPaperZDAnimInstance> AnimClass);
+
+private:
+	//ctor
+	FPaperZDBenchmarkScenarios(const FString& ScenarioName);
+
+	/* Creates a looping flipbook sequence, optionally with a custom notify on every keyframe. */
+	UPaperZDAnimSequence* CreateSequence(int32 NumKeyFrames, bool bNotifyEveryKeyFrame = false);
+
+	/* Creates an empty AnimBP bound to the animation source. */
+	UPaperZDAnimBP* CreateAnimBP(const FString& ScenarioName);
+
+	/* Scenario graphs, built onto the given AnimGraph. */
+	void BuildFlatPlaySequence(UEdGraph* AnimGraph);
+	void BuildDeepStateMachine(UEdGraph* AnimGraph);
+	void BuildConduitChain(UEdGraph* AnimGraph);
+	void BuildRandomPlayer(UEdGraph* AnimGraph);
+	void BuildLayeredAnimations(UEdGraph* AnimGraph);
+	void BuildHeavyNotifies(UEdGraph* AnimGraph);
+	void BuildExposedValues(UEdGraph* AnimGraph);
+
+	/* Creates a play sequence node for the given sequence and links it to the given input. */
+	UEdGraphNode* AddPlaySequence(UEdGraph* Graph, UPaperZDAnimSequence* Sequence, UEdGraphPin* TargetPin);
+
+	/* Shows the pin of the given runtime node property and binds it to a getter of the given member variable. */
+	static void BindPinToVariable(UEdGraphNode* Node, FName PropertyName, FName VariableName);
+
+	/* Makes every transition and conduit of the given state machine graph always pass. */
+	static void SetTransitionRulesPassing(UEdGraph* StateMachineGraph);
+
+	/* Obtain the animation pin of the node with the given direction and index among the animation pins. */
+	static UEdGraphPin* FindAnimPin(UEdGraphNode* Node, EEdGraphPinDirection Direction, int32 Index = 0);
+
+	/* Obtain the input of the sink node of the given graph. */
+	static UEdGraphPin* FindSinkPin(UEdGraph* Graph);
+
+	/* Sets the properties of the runtime node held by the graph node, given as exported text. */
+	static void SetAnimNodeProperties(UEdGraphNode* Node, const FString& PropertiesText);
+};
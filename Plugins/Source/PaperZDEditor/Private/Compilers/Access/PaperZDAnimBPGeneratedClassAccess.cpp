@@ -11,3 +11,13 @@ TArray<FPaperZDAnimStateMachine>& FPaperZDAnimBPGeneratedClassAccess::GetStateMa
 {
 	return GeneratedClass->StateMachines;
 }
+
+TArray<FPaperZDRandomPlayerData>& FPaperZDAnimBPGeneratedClassAccess::GetRandomPlayers() const
+{
+	return GeneratedClass->RandomPlayers;
+}
+
+FPaperZDAnimBPDebugData& FPaperZDAnimBPGeneratedClassAccess::GetDebugData() const
+{
+	return GeneratedClass->AnimBPDebugData;
+}
@@ -26,4 +26,10 @@ public:
 
 	/* Obtain the array of AnimStateMachine definitions. */
 	TArray<FPaperZDAnimStateMachine>& GetStateMachines() const;
+
+	/* Obtain the array of constant data of the random player nodes. */
+	TArray<FPaperZDRandomPlayerData>& GetRandomPlayers() const;
+
+	/* Obtain the debug data of the class. */
+	FPaperZDAnimBPDebugData& GetDebugData() const;
 };
@@ -6,13 +6,68 @@
 #include "Graphs/PaperZDAnimGraphSchema.h"
 #include "Graphs/Nodes/PaperZDAnimGraphNode_Base.h"
 #include "PaperZDAnimInstance.h"
+#include "PaperZDAnimBP.h"
 #include "K2Node_CustomEvent.h"
 #include "K2Node_CallArrayFunction.h"
 #include "K2Node_StructMemberSet.h"
 #include "K2Node_StructMemberGet.h"
+#include "K2Node_VariableGet.h"
+#include "K2Node_Knot.h"
 #include "Kismet2/BlueprintEditorUtils.h"
 #include "Kismet/KismetArrayLibrary.h"
 
+namespace FPaperZDFastPathHelpers
+{
+	/* Finds the variable getter that feeds the given pin, skipping reroute nodes. Fills the reason on failure. */
+	UK2Node_VariableGet* FindSourceVariableGet(const UEdGraphPin* DestPin, FString& OutReason)
+	{
+		if (DestPin->LinkedTo.Num() != 1)
+		{
+			OutReason = TEXT("pin has multiple links");
+			return nullptr;
+		}
+
+		UEdGraphPin* SourcePin = DestPin->LinkedTo[0];
+		while (UK2Node_Knot* Knot = Cast<UK2Node_Knot>(SourcePin->GetOwningNode()))
+		{
+			UEdGraphPin* KnotInput = Knot->GetInputPin();
+			if (KnotInput->LinkedTo.Num() != 1)
+			{
+				OutReason = TEXT("reroute node is not connected");
+				return nullptr;
+			}
+			SourcePin = KnotInput->LinkedTo[0];
+		}
+
+		UK2Node_VariableGet* VariableGet = Cast<UK2Node_VariableGet>(SourcePin->GetOwningNode());
+		if (!VariableGet)
+		{
+			OutReason = TEXT("value is computed by blueprint logic");
+			return nullptr;
+		}
+		else if (!VariableGet->IsNodePure() || !VariableGet->VariableReference.IsSelfContext())
+		{
+			OutReason = TEXT("variable is not a pure member of this AnimBP");
+			return nullptr;
+		}
+		else if (SourcePin->ParentPin != nullptr || SourcePin->SubPins.Num() > 0)
+		{
+			OutReason = TEXT("variable pin is split");
+			return nullptr;
+		}
+
+		//A self member can still be read from another object if the target pin is wired
+		const UEdGraphPin* SelfPin = VariableGet->FindPin(UEdGraphSchema_K2::PN_Self);
+		if (SelfPin && SelfPin->LinkedTo.Num() > 0)
+		{
+			OutReason = TEXT("variable is read from another object");
+			return nullptr;
+		}
+
+		return VariableGet;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 //FEvaluationHandlerRecord
 //////////////////////////////////////////////////////////////////////////
@@ -40,11 +95,92 @@ void FPaperZDAnimBPCompilerHandle_Base::FEvaluationHandlerRecord::RegisterPin(UE
 	Handler.CopyRecords.Emplace(DestPin, AssociatedProperty, AssociatedPropertyArrayIndex, MoveTemp(DestPropertyPath));
 }
 
+void FPaperZDAnimBPCompilerHandle_Base::FEvaluationHandlerRecord::BuildFastPathCopyRecords(const UClass* InSourceClass, FCompilerResultsLog& MessageLog, bool bWarnAboutBlueprintUsage)
+{
+	for (TPair<FName, FAnimNodeSinglePropertyHandler>& ServicedPropertyPair : ServicedProperties)
+	{
+		for (FPropertyCopyRecord& CopyRecord : ServicedPropertyPair.Value.CopyRecords)
+		{
+			FString Reason;
+			FProperty* SourceProperty = nullptr;
+			if (UK2Node_VariableGet* VariableGet = FPaperZDFastPathHelpers::FindSourceVariableGet(CopyRecord.DestPin, Reason))
+			{
+				SourceProperty = VariableGet->VariableReference.ResolveMember<FProperty>(const_cast<UClass*>(InSourceClass));
+				if (!SourceProperty)
+				{
+					Reason = TEXT("variable could not be resolved");
+				}
+			}
+
+			if (SourceProperty)
+			{
+				FArrayProperty* DestArrayProperty = CopyRecord.DestArrayIndex != INDEX_NONE ? CastField<FArrayProperty>(CopyRecord.DestProperty) : nullptr;
+				const FProperty* DestValueProperty = DestArrayProperty ? DestArrayProperty->Inner : CopyRecord.DestProperty;
+				if (FPaperZDExposedValueCopyRecord::GetCopyType(SourceProperty, DestValueProperty, CopyRecord.CopyType))
+				{
+					CopyRecord.SourcePropertyName = SourceProperty->GetFName();
+					CopyRecord.SourcePropertyPath = { SourceProperty->GetName() };
+				}
+				else
+				{
+					Reason = FString::Printf(TEXT("variable '%s' needs a type conversion"), *SourceProperty->GetName());
+				}
+			}
+
+			if (!CopyRecord.IsFastPath())
+			{
+				CopyRecord.InvalidateFastPath();
+				const FString Message = FString::Printf(TEXT("Binding @@ on @@ is not on the fast path (%s) and will run through the blueprint VM every update, keeping the AnimBP from updating in parallel"), *Reason);
+				if (bWarnAboutBlueprintUsage)
+				{
+					MessageLog.Warning(*Message, CopyRecord.DestPin, AnimGraphNode);
+				}
+				else
+				{
+					MessageLog.Note(*Message, CopyRecord.DestPin, AnimGraphNode);
+				}
+			}
+		}
+	}
+}
+
+bool FPaperZDAnimBPCompilerHandle_Base::FEvaluationHandlerRecord::IsFastPath() const
+{
+	for (const TPair<FName, FAnimNodeSinglePropertyHandler>& ServicedPropertyPair : ServicedProperties)
+	{
+		for (const FPropertyCopyRecord& CopyRecord : ServicedPropertyPair.Value.CopyRecords)
+		{
+			if (!CopyRecord.IsFastPath())
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 void FPaperZDAnimBPCompilerHandle_Base::FEvaluationHandlerRecord::SetupExposedHandler(FPaperZDExposedValueHandler& Handler) const
 {
-	//No FAST-PATH support, so we only copy the function name and its node property
+	//The function name is only set if some of the pins needed the blueprint VM
 	Handler.ValueHandlerNodeProperty = NodeVariableProperty;
 	Handler.BoundFunction = HandlerFunctionName;
+
+	//Every pin on the fast path gets copied directly
+	for (const TPair<FName, FAnimNodeSinglePropertyHandler>& ServicedPropertyPair : ServicedProperties)
+	{
+		for (const FPropertyCopyRecord& CopyRecord : ServicedPropertyPair.Value.CopyRecords)
+		{
+			if (CopyRecord.IsFastPath())
+			{
+				FPaperZDExposedValueCopyRecord& HandlerRecord = Handler.CopyRecords.AddDefaulted_GetRef();
+				HandlerRecord.SourcePropertyName = CopyRecord.SourcePropertyName;
+				HandlerRecord.DestPropertyName = CopyRecord.DestProperty->GetFName();
+				HandlerRecord.DestArrayIndex = CopyRecord.DestArrayIndex;
+				HandlerRecord.CopyType = CopyRecord.CopyType;
+			}
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -165,6 +301,13 @@ void FPaperZDAnimBPCompilerHandle_Base::AddStructEvalHandlers(UPaperZDAnimGraphN
 		}
 	}
 	
+	//Find out which of the bound pins can skip the blueprint VM
+	if (EvalHandler.NodeVariableProperty)
+	{
+		const UPaperZDAnimBP* AnimBP = InCompilerContext.GetAnimBP();
+		EvalHandler.BuildFastPathCopyRecords(AnimBP->SkeletonGeneratedClass, InCompilerContext.GetMessageLog(), AnimBP->bWarnAboutBlueprintUsage);
+	}
+
 	//Next, any property bindings we need to add
 	//@NOTE: Property binding support requires "PropertyAccess" module and special code. ~~PENDING~~
 }
@@ -178,7 +321,11 @@ void FPaperZDAnimBPCompilerHandle_Base::CreateEvaluationHandlerForNode(FPaperZDA
 		
 		if (Record.NodeVariableProperty)
 		{
-			CreateEvaluationHandler(InCompilationContext, InNode, Record);
+			//Handlers that only do direct copies don't need any generated function
+			if (!Record.IsFastPath())
+			{
+				CreateEvaluationHandler(InCompilationContext, InNode, Record);
+			}
 
 			int32 NewIndex = ValidEvaluationHandlerList.Add(Record);
 			ValidEvaluationHandlerMap.Add(InNode, NewIndex);
@@ -255,6 +402,12 @@ void FPaperZDAnimBPCompilerHandle_Base::CreateEvaluationHandler(FPaperZDAnimBPCo
 		{
 			if (TargetPin->PinType.IsArray())
 			{
+				//Nothing to generate if every element is copied directly
+				if (!SourceInfo->CopyRecords.ContainsByPredicate([](const FPropertyCopyRecord& CopyRecord) { return !CopyRecord.IsFastPath(); }))
+				{
+					continue;
+				}
+
 				//Create a getter ONLY for the array variable
 				UK2Node_StructMemberGet* ArrayGetter = InCompilationContext.SpawnIntermediateEventNode<UK2Node_StructMemberGet>(InNode, TargetPin, InCompilationContext.GetConsolidatedEventGraph());
 				ArrayGetter->VariableReference.SetSelfMember(Record.NodeVariableProperty->GetFName());
@@ -269,7 +422,8 @@ void FPaperZDAnimBPCompilerHandle_Base::CreateEvaluationHandler(FPaperZDAnimBPCo
 				for (FPropertyCopyRecord& CopyRecord : SourceInfo->CopyRecords)
 				{
 					int32 ArrayIndex = CopyRecord.DestArrayIndex;
-					if (UEdGraphPin* DestPin = CopyRecord.DestPin)
+					UEdGraphPin* DestPin = CopyRecord.DestPin;
+					if (DestPin && !CopyRecord.IsFastPath())
 					{
 						//The array SETTER
 						UK2Node_CallArrayFunction* ArraySet = InCompilationContext.SpawnIntermediateNode<UK2Node_CallArrayFunction>(InNode, InCompilationContext.GetConsolidatedEventGraph());
@@ -306,7 +460,7 @@ void FPaperZDAnimBPCompilerHandle_Base::CreateEvaluationHandler(FPaperZDAnimBPCo
 			else
 			{
 				//Single property, bind directly (the following check should always work)
-				if (SourceInfo->CopyRecords.Num() > 0 && SourceInfo->CopyRecords[0].DestPin != nullptr)
+				if (SourceInfo->CopyRecords.Num() > 0 && SourceInfo->CopyRecords[0].DestPin != nullptr && !SourceInfo->CopyRecords[0].IsFastPath())
 				{
 					UEdGraphPin* DestPin = SourceInfo->CopyRecords[0].DestPin;
 					PropertiesBeingSet.Add(DestPin->PinName);
@@ -3,12 +3,13 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "Compilers/Handles/IPaperZDAnimBPCompilerHandle.h"
+#include "AnimNodes/PaperZDAnimNode_Base.h"
 
 class FPaperZDAnimBPGeneratedClassAccess;
 class UPaperZDAnimGraphNode_Base;
 class UK2Node;
 class UEdGraphPin;
-struct FPaperZDExposedValueHandler;
+class FCompilerResultsLog;
 
 /**
  * Base compiler handle for every animation node, manages base compilation of variables and linkage.
@@ -68,28 +69,23 @@ class FPaperZDAnimBPCompilerHandle_Base : public IPaperZDAnimBPCompilerHandle, p
 		/** The property path relative to the class */
 		TArray<FString> DestPropertyPath;
 
-		//@NOTE: No FAST-PATH support for now
-// 		/** The index of the copy in the property access library */
-// 		int32 LibraryCopyIndex;
-// 
-// 		/** the batch type within the property access library */
-// 		EPropertyAccessBatchType LibraryBatchType;
-// 
-// 		/** Any operation we want to perform post-copy on the destination data */
-// 		EPostCopyOperation Operation;
-// 
-// 		/** Fast-path flag */
-// 		bool bIsFastPath;
+		/** The AnimInstance member variable that feeds this pin, if the pin is on the fast path */
+		FName SourcePropertyName;
+
+		/** Conversion needed when copying from the source to the destination */
+		EPaperZDExposedValueCopyType CopyType;
+
+		/** Fast-path flag */
+		bool bIsFastPath;
 
 		FPropertyCopyRecord(UEdGraphPin* InDestPin, FProperty* InDestProperty, int32 InDestArrayIndex, TArray<FString>&& InDestPropertyPath)
 			: DestPin(InDestPin)
 			, DestProperty(InDestProperty)
 			, DestArrayIndex(InDestArrayIndex)
 			, DestPropertyPath(MoveTemp(InDestPropertyPath))
-// 			, LibraryCopyIndex(INDEX_NONE)
-// 			, LibraryBatchType(EPropertyAccessBatchType::Unbatched)
-// 			, Operation(EPostCopyOperation::None)
-// 			, bIsFastPath(true)
+			, SourcePropertyName(NAME_None)
+			, CopyType(EPaperZDExposedValueCopyType::MemCopy)
+			, bIsFastPath(true)
 		{}
 
 		FPropertyCopyRecord(const TArray<FString>& InSourcePropertyPath, const TArray<FString>& InDestPropertyPath)
@@ -98,22 +94,20 @@ class FPaperZDAnimBPCompilerHandle_Base : public IPaperZDAnimBPCompilerHandle, p
 			, DestArrayIndex(INDEX_NONE)
 			, SourcePropertyPath(InSourcePropertyPath)
 			, DestPropertyPath(InDestPropertyPath)
-// 			, LibraryCopyIndex(INDEX_NONE)
-// 			, LibraryBatchType(EPropertyAccessBatchType::Unbatched)
-// 			, Operation(EPostCopyOperation::None)
-// 			, bIsFastPath(true)
+			, SourcePropertyName(NAME_None)
+			, CopyType(EPaperZDExposedValueCopyType::MemCopy)
+			, bIsFastPath(true)
 		{}
 
-		//@NOTE: No fast-path support
-// 		bool IsFastPath() const
-// 		{
-// 			return SourcePropertyPath.Num() > 0 && bIsFastPath;
-// 		}
-// 
-// 		void InvalidateFastPath()
-// 		{
-// 			bIsFastPath = false;
-// 		}
+		bool IsFastPath() const
+		{
+			return SourcePropertyPath.Num() > 0 && bIsFastPath;
+		}
+
+		void InvalidateFastPath()
+		{
+			bIsFastPath = false;
+		}
 	};
 
 	// Wireup record for a single anim node property (which might be an array)
@@ -164,6 +158,12 @@ class FPaperZDAnimBPCompilerHandle_Base : public IPaperZDAnimBPCompilerHandle, p
 		//Register this evaluation handler via the given pin
 		void RegisterPin(UEdGraphPin* DestPin, FProperty* AssociatedProperty, int32 AssociatedPropertyArrayIndex);
 
+		//Checks every copy record to see if it can be done as a direct copy from a member variable, warning about the ones that cannot
+		void BuildFastPathCopyRecords(const UClass* InSourceClass, FCompilerResultsLog& MessageLog, bool bWarnAboutBlueprintUsage);
+
+		//True if every copy record is on the fast path, meaning that no handler function is needed
+		bool IsFastPath() const;
+
 		//Copies the function's name into the exposed value handler
 		void SetupExposedHandler(FPaperZDExposedValueHandler& Handler) const;
 	};
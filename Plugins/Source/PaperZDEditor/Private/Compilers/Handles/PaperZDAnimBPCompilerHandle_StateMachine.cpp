@@ -11,6 +11,106 @@
 #include "EdGraphUtilities.h"
 #include "K2Node_FunctionEntry.h"
 #include "K2Node_FunctionResult.h"
+#include "K2Node_VariableGet.h"
+#include "K2Node_CallFunction.h"
+#include "K2Node_Knot.h"
+#include "Kismet/KismetMathLibrary.h"
+
+namespace FPaperZDNativeRuleUtils
+{
+	/* Finds the native operation that matches the given math library function, if supported. */
+	bool GetOperationForFunction(const FString& FunctionName, EPaperZDTransitionRuleOp& OutOp, bool& bOutNegate)
+	{
+		bOutNegate = false;
+
+		//Logical operators
+		static const TMap<FString, TPair<EPaperZDTransitionRuleOp, bool>> LogicalOps = {
+			{ TEXT("Not_PreBool"), { EPaperZDTransitionRuleOp::Not, false } },
+			{ TEXT("BooleanAND"), { EPaperZDTransitionRuleOp::And, false } },
+			{ TEXT("BooleanOR"), { EPaperZDTransitionRuleOp::Or, false } },
+			{ TEXT("BooleanXOR"), { EPaperZDTransitionRuleOp::Xor, false } },
+			{ TEXT("BooleanNAND"), { EPaperZDTransitionRuleOp::And, true } },
+			{ TEXT("BooleanNOR"), { EPaperZDTransitionRuleOp::Or, true } },
+		};
+
+		if (const TPair<EPaperZDTransitionRuleOp, bool>* LogicalOp = LogicalOps.Find(FunctionName))
+		{
+			OutOp = LogicalOp->Key;
+			bOutNegate = LogicalOp->Value;
+			return true;
+		}
+
+		//Comparisons follow the "Operation_TypeType" naming convention
+		static const TMap<FString, EPaperZDTransitionRuleOp> ComparisonOps = {
+			{ TEXT("Less"), EPaperZDTransitionRuleOp::Less },
+			{ TEXT("LessEqual"), EPaperZDTransitionRuleOp::LessEqual },
+			{ TEXT("Greater"), EPaperZDTransitionRuleOp::Greater },
+			{ TEXT("GreaterEqual"), EPaperZDTransitionRuleOp::GreaterEqual },
+			{ TEXT("EqualEqual"), EPaperZDTransitionRuleOp::Equal },
+			{ TEXT("NotEqual"), EPaperZDTransitionRuleOp::NotEqual },
+		};
+		static const TSet<FString> ComparisonTypes = { TEXT("BoolBool"), TEXT("ByteByte"), TEXT("IntInt"), TEXT("Int64Int64"), TEXT("FloatFloat"), TEXT("DoubleDouble") };
+
+		FString OpName, TypeName;
+		if (FunctionName.Split(TEXT("_"), &OpName, &TypeName) && ComparisonTypes.Contains(TypeName))
+		{
+			if (const EPaperZDTransitionRuleOp* ComparisonOp = ComparisonOps.Find(OpName))
+			{
+				OutOp = *ComparisonOp;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* Obtains the constant value stored as default on the given (unlinked) pin. */
+	bool GetPinConstantValue(const UEdGraphPin* Pin, double& OutValue)
+	{
+		const FName& Category = Pin->PinType.PinCategory;
+		if (Category == UEdGraphSchema_K2::PC_Boolean)
+		{
+			OutValue = Pin->GetDefaultAsString().ToBool() ? 1.0 : 0.0;
+			return true;
+		}
+		else if (Category == UEdGraphSchema_K2::PC_Float)
+		{
+			OutValue = FCString::Atod(*Pin->GetDefaultAsString());
+			return true;
+		}
+		else if (Category == UEdGraphSchema_K2::PC_Int || Category == UEdGraphSchema_K2::PC_Int64)
+		{
+			OutValue = (double)FCString::Atoi64(*Pin->GetDefaultAsString());
+			return true;
+		}
+		else if (Category == UEdGraphSchema_K2::PC_Byte)
+		{
+			//Enum pins store the name of the entry instead of its value
+			if (const UEnum* Enum = Cast<UEnum>(Pin->PinType.PinSubCategoryObject.Get()))
+			{
+				const int64 EnumValue = Enum->GetValueByNameString(Pin->GetDefaultAsString());
+				OutValue = (double)EnumValue;
+				return EnumValue != INDEX_NONE;
+			}
+
+			OutValue = (double)FCString::Atoi(*Pin->GetDefaultAsString());
+			return true;
+		}
+
+		return false;
+	}
+
+	/* True if the given property can be read by the native rules. */
+	bool IsSupportedProperty(const FProperty* Property)
+	{
+		if (const FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
+		{
+			return EnumProperty->GetUnderlyingProperty() != nullptr;
+		}
+
+		return Property && (Property->IsA<FBoolProperty>() || Property->IsA<FNumericProperty>());
+	}
+}
 
 void FPaperZDAnimBPCompilerHandle_StateMachine::Initialize(FPaperZDAnimBPCompilerAccess& InCompilerAccess)
 {
@@ -67,14 +167,24 @@ int32 FPaperZDAnimBPCompilerHandle_StateMachine::ProcessAnimationGraph(UEdGraph*
 	return InCompilationContext.GetAllocationIndexOfNode(TargetRootNode);
 }
 
-void FPaperZDAnimBPCompilerHandle_StateMachine::ProcessTransitionGraph(UEdGraph* SourceGraph, FPaperZDAnimStateMachineTransitionRule& OutTransitionRule, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData)
+void FPaperZDAnimBPCompilerHandle_StateMachine::ProcessTransitionGraph(UEdGraph* SourceGraph, FPaperZDAnimStateMachineTransitionRule& OutTransitionRule, TArray<FPaperZDTransitionRuleInstruction>& OutRuleProgram, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData)
 {
 	UPaperZDTransitionGraphNode_Result* ResultNode = CastChecked<UPaperZDAnimTransitionGraph>(SourceGraph)->GetResultNode();
 	check(ResultNode && ResultNode->Pins.Num());
 	UEdGraphPin* ResultPin = ResultNode->Pins[0];
 
 	//Depending if the result node is linked to anything, we will create a function graph for it, or just "fast-path" the value to the transition rule
-	if (ResultPin->LinkedTo.Num() > 0)
+	TArray<FPaperZDTransitionRuleInstruction> NativeProgram;
+	if (ResultPin->LinkedTo.Num() > 0 && CompileNativeTransitionRule(ResultPin, InCompilationContext.GetAnimBP()->SkeletonGeneratedClass, NativeProgram))
+	{
+		//The logic only reads properties and compares them, store it as a native program so it doesn't need to enter the blueprint VM
+		OutTransitionRule.bDynamicRule = true;
+		OutTransitionRule.bNativeRule = true;
+		OutTransitionRule.NativeProgramIndex = OutRuleProgram.Num();
+		OutTransitionRule.NativeProgramLength = NativeProgram.Num();
+		OutRuleProgram.Append(NativeProgram);
+	}
+	else if (ResultPin->LinkedTo.Num() > 0)
 	{
 		//Result pin has logic inside, we will create a function graph to hold the logic in place
 		UEdGraph* ClonedGraph = FEdGraphUtilities::CloneGraph(SourceGraph, InCompilationContext.GetConsolidatedEventGraph(), &InCompilationContext.GetMessageLog(), true);
@@ -174,6 +284,134 @@ FName FPaperZDAnimBPCompilerHandle_StateMachine::GenerateValidTransitionFunction
 	return FName(*TestString);
 }
 
+bool FPaperZDAnimBPCompilerHandle_StateMachine::CompileNativeTransitionRule(const UEdGraphPin* ResultPin, const UClass* InClass, TArray<FPaperZDTransitionRuleInstruction>& OutProgram) const
+{
+	if (!InClass || !EmitNativeRuleInstructions(ResultPin, InClass, OutProgram))
+	{
+		return false;
+	}
+
+	//Make sure the program fits on the runtime stack
+	int32 StackSize = 0;
+	int32 MaxStackSize = 0;
+	for (const FPaperZDTransitionRuleInstruction& Instruction : OutProgram)
+	{
+		if (Instruction.Op == EPaperZDTransitionRuleOp::Constant || Instruction.Op == EPaperZDTransitionRuleOp::ReadProperty)
+		{
+			StackSize++;
+		}
+		else if (Instruction.Op != EPaperZDTransitionRuleOp::Not)
+		{
+			StackSize--;
+		}
+
+		MaxStackSize = FMath::Max(MaxStackSize, StackSize);
+	}
+
+	return StackSize == 1 && MaxStackSize <= FPaperZDTransitionRuleInstruction::MaxStackSize;
+}
+
+bool FPaperZDAnimBPCompilerHandle_StateMachine::EmitNativeRuleInstructions(const UEdGraphPin* InputPin, const UClass* InClass, TArray<FPaperZDTransitionRuleInstruction>& OutProgram) const
+{
+	if (InputPin->SubPins.Num() > 0 || InputPin->PinType.IsContainer())
+	{
+		return false;
+	}
+
+	//Unlinked pins just hold a constant value
+	if (InputPin->LinkedTo.Num() == 0)
+	{
+		FPaperZDTransitionRuleInstruction& Instruction = OutProgram.AddDefaulted_GetRef();
+		Instruction.Op = EPaperZDTransitionRuleOp::Constant;
+		return FPaperZDNativeRuleUtils::GetPinConstantValue(InputPin, Instruction.ConstantValue);
+	}
+
+	const UEdGraphPin* SourcePin = InputPin->LinkedTo[0];
+	const UEdGraphNode* SourceNode = SourcePin->GetOwningNode();
+	if (const UK2Node_Knot* KnotNode = Cast<const UK2Node_Knot>(SourceNode))
+	{
+		//Reroute nodes are just a pass-through
+		return EmitNativeRuleInstructions(KnotNode->GetInputPin(), InClass, OutProgram);
+	}
+	else if (const UK2Node_VariableGet* VariableNode = Cast<const UK2Node_VariableGet>(SourceNode))
+	{
+		//Only the variables that live on the AnimInstance itself can be read natively
+		const UEdGraphPin* SelfPin = VariableNode->FindPin(UEdGraphSchema_K2::PN_Self);
+		if (!VariableNode->IsNodePure() || !VariableNode->VariableReference.IsSelfContext() || (SelfPin && SelfPin->LinkedTo.Num() > 0))
+		{
+			return false;
+		}
+
+		const FProperty* Property = FindFProperty<FProperty>(InClass, VariableNode->GetVarName());
+		if (!FPaperZDNativeRuleUtils::IsSupportedProperty(Property))
+		{
+			return false;
+		}
+
+		FPaperZDTransitionRuleInstruction& Instruction = OutProgram.AddDefaulted_GetRef();
+		Instruction.Op = EPaperZDTransitionRuleOp::ReadProperty;
+		Instruction.PropertyName = Property->GetFName();
+		return true;
+	}
+	else if (const UK2Node_CallFunction* CallNode = Cast<const UK2Node_CallFunction>(SourceNode))
+	{
+		//Only pure math library operators are supported
+		const UFunction* Function = CallNode->GetTargetFunction();
+		EPaperZDTransitionRuleOp Op;
+		bool bNegate;
+		if (!Function || Function->GetOwnerClass() != UKismetMathLibrary::StaticClass() || !CallNode->IsNodePure() || !FPaperZDNativeRuleUtils::GetOperationForFunction(Function->GetName(), Op, bNegate))
+		{
+			return false;
+		}
+
+		//Collect the operands in order, ignoring the hidden self pin of the library
+		TArray<const UEdGraphPin*> Operands;
+		for (const UEdGraphPin* Pin : CallNode->Pins)
+		{
+			if (Pin->Direction == EGPD_Input && Pin->PinType.PinCategory != UEdGraphSchema_K2::PC_Exec && Pin->PinName != UEdGraphSchema_K2::PN_Self)
+			{
+				Operands.Add(Pin);
+			}
+		}
+
+		const bool bUnaryOp = Op == EPaperZDTransitionRuleOp::Not;
+		if ((bUnaryOp && Operands.Num() != 1) || (!bUnaryOp && Operands.Num() < 2))
+		{
+			return false;
+		}
+
+		//Postfix order: first operand, then every other operand followed by the operation (covers the commutative nodes with extra pins)
+		if (!EmitNativeRuleInstructions(Operands[0], InClass, OutProgram))
+		{
+			return false;
+		}
+
+		for (int32 i = 1; i < Operands.Num(); i++)
+		{
+			if (!EmitNativeRuleInstructions(Operands[i], InClass, OutProgram))
+			{
+				return false;
+			}
+
+			OutProgram.AddDefaulted_GetRef().Op = Op;
+		}
+
+		if (bUnaryOp)
+		{
+			OutProgram.AddDefaulted_GetRef().Op = Op;
+		}
+
+		if (bNegate)
+		{
+			OutProgram.AddDefaulted_GetRef().Op = EPaperZDTransitionRuleOp::Not;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
 void FPaperZDAnimBPCompilerHandle_StateMachine::AutoWireAnimGetter(UPaperZDK2Node_AnimGetter* AnimGetter, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData)
 {
 	UEdGraphPin* ReferencedNodeTimePin = nullptr;
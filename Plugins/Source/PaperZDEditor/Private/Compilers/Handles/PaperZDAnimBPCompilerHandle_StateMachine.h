@@ -11,7 +11,9 @@ class UPaperZDK2Node_AnimGetter;
 class FPaperZDAnimBPCompilerAccess;
 class FPaperZDAnimBPGeneratedClassAccess;
 struct FPaperZDAnimStateMachineTransitionRule;
+struct FPaperZDTransitionRuleInstruction;
 class UEdGraph;
+class UEdGraphPin;
 
 
 /**
@@ -32,8 +34,11 @@ public:
 	/* Processes the given graph and any Animation node contained inside, returning the index of the SourceRootNode. */
 	int32 ProcessAnimationGraph(UEdGraph* SourceGraph, UPaperZDAnimGraphNode_Base* SourceRootNode, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData);
 
-	/* Processes the given Transition graph, creating a transition rule from it. */
-	void ProcessTransitionGraph(UEdGraph* SourceGraph, FPaperZDAnimStateMachineTransitionRule& OutTransitionRule, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData);
+	/**
+	 * Processes the given Transition graph, creating a transition rule from it.
+	 * Graphs that only read properties, compare them and combine the results with logical operators get compiled into a native program appended to OutRuleProgram.
+	 */
+	void ProcessTransitionGraph(UEdGraph* SourceGraph, FPaperZDAnimStateMachineTransitionRule& OutTransitionRule, TArray<FPaperZDTransitionRuleInstruction>& OutRuleProgram, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData);
 
 	/* Called when starting the compilation of the class. */
 	void HandleStartCompilingClass(const UClass* InClass, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData);
@@ -45,6 +50,12 @@ private:
 	/* Generates a valid transition function name that doesn't collide with any kismet name nor any generated function name. */
 	FName GenerateValidTransitionFunctionName(FPaperZDAnimBPCompilerAccess& InCompilationContext, const FString& InBaseName) const;
 
+	/* Attempts to compile the logic linked to the given result pin into a native program, returns false if the logic cannot run natively. */
+	bool CompileNativeTransitionRule(const UEdGraphPin* ResultPin, const UClass* InClass, TArray<FPaperZDTransitionRuleInstruction>& OutProgram) const;
+
+	/* Recursively emits the instructions that compute the value of the given input pin. */
+	bool EmitNativeRuleInstructions(const UEdGraphPin* InputPin, const UClass* InClass, TArray<FPaperZDTransitionRuleInstruction>& OutProgram) const;
+
 	/* Wires an AnimGetter node. */
 	void AutoWireAnimGetter(UPaperZDK2Node_AnimGetter* AnimGetter, FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData);
 };
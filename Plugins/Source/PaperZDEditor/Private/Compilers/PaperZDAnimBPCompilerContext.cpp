@@ -18,9 +18,34 @@
 #include "K2Node_FunctionEntry.h"
 #include "K2Node_Knot.h"
 #include "PaperZDCustomVersion.h"
+#include "AnimNodes/PaperZDAnimNode_Sink.h"
+#include "AnimNodes/PaperZDAnimNode_SetDirectionality.h"
+#include "AnimNodes/PaperZDAnimNode_PlaySequence.h"
 
 #define LOCTEXT_NAMESPACE "PaperZDAnimBlueprintCompiler"
 
+namespace FPaperZDAnimProgramCompilerHelpers
+{
+	/* Obtains the operation that the linear program should run for the given runtime node type. */
+	EPaperZDAnimProgramOp GetProgramOp(const UScriptStruct* NodeType)
+	{
+		if (NodeType->IsChildOf(FPaperZDAnimNode_Sink::StaticStruct()))
+		{
+			return EPaperZDAnimProgramOp::PassThrough;
+		}
+		else if (NodeType == FPaperZDAnimNode_SetDirectionality::StaticStruct())
+		{
+			return EPaperZDAnimProgramOp::SetDirectionality;
+		}
+		else if (NodeType == FPaperZDAnimNode_PlaySequence::StaticStruct())
+		{
+			return EPaperZDAnimProgramOp::PlaySequence;
+		}
+
+		return EPaperZDAnimProgramOp::Fallback;
+	}
+}
+
 //static definitions
 TMap<zid_t, TUniquePtr<IPaperZDCompilerHandleFactory>> FPaperZDAnimBPCompilerContext::RegisteredHandleFactories = TMap<zid_t, TUniquePtr<IPaperZDCompilerHandleFactory>>();
 //end static definitions
@@ -330,6 +355,8 @@ void FPaperZDAnimBPCompilerContext::OnPostCDOCompiled()
 	for (UPaperZDAnimBPGeneratedClass* ClassWithInputHandlers = NewAnimBlueprintClass; ClassWithInputHandlers != nullptr; ClassWithInputHandlers = Cast<UPaperZDAnimBPGeneratedClass>(ClassWithInputHandlers->GetSuperClass()))
 	{
 		FPaperZDExposedValueHandler::InitClass(ClassWithInputHandlers->EvaluateGraphExposedInputs, NewAnimBlueprintClass->ClassDefaultObject);
+		FPaperZDAnimStateMachine::InitClass(ClassWithInputHandlers->StateMachines, NewAnimBlueprintClass);
+		FPaperZDAnimProgram::InitClass(ClassWithInputHandlers->AnimPrograms, NewAnimBlueprintClass, NewAnimBlueprintClass->ClassDefaultObject);
 		ClassWithInputHandlers->CacheRequiredNodes(NewAnimBlueprintClass->ClassDefaultObject);
 	}
 }
@@ -379,6 +406,9 @@ void FPaperZDAnimBPCompilerContext::ProcessAllAnimationNodes()
 		// Process the animation nodes
 		ProcessAnimationNodes(RootAnimNodeList);
 
+		// Flatten the graphs now that every node has been allocated
+		BuildAnimProgramChains();
+
 		//Notify delegates
 		OnPostProcessAnimationNodes.Broadcast(AllSubGraphsAnimNodeList, CompilerAccess, ClassAccess);
 	}
@@ -388,6 +418,50 @@ void FPaperZDAnimBPCompilerContext::ProcessAllAnimationNodes()
 	}
 }
 
+void FPaperZDAnimBPCompilerContext::BuildAnimProgramChains()
+{
+	AnimProgramChains.Empty();
+	for (const TPair<UPaperZDAnimGraphNode_Base*, FProperty*>& AllocatedPair : AllocatedAnimNodes)
+	{
+		UPaperZDAnimGraphNode_Base* SinkNode = AllocatedPair.Key;
+		const UScriptStruct* SinkType = SinkNode->GetFNodeType();
+		if (!SinkType || !SinkType->IsChildOf(FPaperZDAnimNode_Sink::StaticStruct()))
+		{
+			continue;
+		}
+
+		//Follow the single input of each node until we find a leaf, or a node that needs to manage its own inputs.
+		//Branching subtrees aren't flattened, the node that owns them ends the chain and recurses through its links as usual
+		TArray<UPaperZDAnimGraphNode_Base*> Chain;
+		Chain.Add(SinkNode);
+		UPaperZDAnimGraphNode_Base* CurrentNode = SinkNode;
+		while (true)
+		{
+			const EPaperZDAnimProgramOp Op = FPaperZDAnimProgramCompilerHelpers::GetProgramOp(CurrentNode->GetFNodeType());
+			if (Op == EPaperZDAnimProgramOp::PlaySequence || Op == EPaperZDAnimProgramOp::Fallback)
+			{
+				break;
+			}
+
+			TArray<UPaperZDAnimGraphNode_Base*> LinkedNodes;
+			GetLinkedAnimNodes(CurrentNode, LinkedNodes);
+			if (LinkedNodes.Num() != 1 || Chain.Contains(LinkedNodes[0]) || LinkedNodes[0]->GetFNodeType() == nullptr)
+			{
+				break;
+			}
+
+			CurrentNode = LinkedNodes[0];
+			Chain.Add(CurrentNode);
+		}
+
+		//A lone sink gains nothing from a program
+		if (Chain.Num() > 1)
+		{
+			AnimProgramChains.Add(MoveTemp(Chain));
+		}
+	}
+}
+
 void FPaperZDAnimBPCompilerContext::ExpandSplitPins(UEdGraph* Graph)
 {
 	for (TArray<UEdGraphNode*>::TIterator NodeIt(Graph->Nodes); NodeIt; ++NodeIt)
@@ -522,6 +596,13 @@ void FPaperZDAnimBPCompilerContext::CopyTermDefaultsToDefaultObject(UObject* Def
 
 				LinkIndexMap.Add(AnimGraphNode, LinkIndexCount);
 				NodeBaseAddresses.Add(AnimGraphNode, DestinationPtr);
+
+				//The editor matches the measured node costs to the visual nodes through this
+				if (const UEdGraphNode* TrueSourceNode = Cast<UEdGraphNode>(MessageLog.FindSourceObject(AnimGraphNode)))
+				{
+					FPaperZDAnimBPGeneratedClassAccess ClassAccess(NewAnimBlueprintClass);
+					ClassAccess.GetDebugData().NodeGuidToLinkID.Add(TrueSourceNode->NodeGuid, LinkIndexCount);
+				}
 				++LinkIndexCount;
 			}
 		}
@@ -542,6 +623,32 @@ void FPaperZDAnimBPCompilerContext::CopyTermDefaultsToDefaultObject(UObject* Def
 				LinkRecord.PatchLinkIndex(DestinationPtr, LinkedNodeIdx, SourceNodeIdx);
 			}
 		}
+
+		//Emit the linear programs, now that the LinkIDs are known
+		NewAnimBlueprintClass->AnimPrograms.Empty(AnimProgramChains.Num());
+		for (const TArray<UPaperZDAnimGraphNode_Base*>& Chain : AnimProgramChains)
+		{
+			FPaperZDAnimProgram Program;
+			for (UPaperZDAnimGraphNode_Base* ChainNode : Chain)
+			{
+				//Nodes that didn't make it to the class invalidate the whole chain
+				const int32* LinkID = LinkIndexMap.Find(ChainNode);
+				if (!LinkID)
+				{
+					Program.Instructions.Empty();
+					break;
+				}
+
+				FPaperZDAnimProgramInstruction& Instruction = Program.Instructions.AddDefaulted_GetRef();
+				Instruction.Op = FPaperZDAnimProgramCompilerHelpers::GetProgramOp(ChainNode->GetFNodeType());
+				Instruction.LinkID = *LinkID;
+			}
+
+			if (Program.Instructions.Num() > 1)
+			{
+				NewAnimBlueprintClass->AnimPrograms.Add(MoveTemp(Program));
+			}
+		}
 	}
 
 	//Call delegates
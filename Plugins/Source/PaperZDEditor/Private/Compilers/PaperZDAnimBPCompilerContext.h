@@ -63,6 +63,9 @@ class FPaperZDAnimBPCompilerContext : public FKismetCompilerContext
 	//AnimData LinkRecords for later patch-up
 	TArray<FPaperZDAnimDataLinkRecord> LinkRecords;
 
+	//Chains of nodes, from each sink towards its leaf, to be emitted as linear programs once the LinkIDs are known
+	TArray<TArray<UPaperZDAnimGraphNode_Base*>> AnimProgramChains;
+
 public:
 	//ctor
 	FPaperZDAnimBPCompilerContext(UBlueprint* Blueprint, FCompilerResultsLog& InMessageLog, const FKismetCompilerOptions& InCompilerOptions);
@@ -127,6 +130,9 @@ private:
 	/* Compiles one animation node */
 	void ProcessAnimationNode(UPaperZDAnimGraphNode_Base* VisualAnimNode);
 
+	/* Flattens the single-input chain that starts at each sink into a list of nodes that can run without recursion, up to the first leaf or branching node. */
+	void BuildAnimProgramChains();
+
 	/* Expand split pins for a graph. */
 	void ExpandSplitPins(UEdGraph* Graph);
 
@@ -2,6 +2,7 @@
 
 #include "Editors/PaperZDAnimBPEditor.h"
 #include "Editors/Slate/SPaperZDModeSelectorWidget.h"
+#include "Editors/Slate/SPaperZDAnimRecorderScrubber.h"
 #include "PaperZDEditor.h"
 #include "PaperZDAnimInstance.h"
 #include "PaperZDAnimBP.h"
@@ -174,6 +175,8 @@ void FPaperZDAnimBPEditor::ExtendToolbar()
 			AddToolbarWidget(SNew(SPaperZDModeSelectorWidget, AnimBPBeingEdited->GetSupportedAnimationSource())
 				.DefaultAnimBP(AnimBPBeingEdited)
 				.bSourceSelected(false));
+
+			AddToolbarWidget(SNew(SPaperZDAnimRecorderScrubber, AnimBPBeingEdited));
 		}));
 
 	//Add the extender
@@ -0,0 +1,122 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Editors/Slate/SPaperZDAnimRecorderScrubber.h"
+#include "Editors/Util/PaperZDAnimRecorderDebugger.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SSlider.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Text/STextBlock.h"
+#include "EditorStyleSet.h"
+#include "Engine/Blueprint.h"
+
+#define LOCTEXT_NAMESPACE "PaperZD_AnimRecorderScrubber"
+
+void SPaperZDAnimRecorderScrubber::Construct(const FArguments& InArgs, UBlueprint* InBlueprint)
+{
+	Blueprint = InBlueprint;
+
+	//Build the widget
+	ChildSlot
+	[
+		SNew(SHorizontalBox)
+		.IsEnabled(this, &SPaperZDAnimRecorderScrubber::IsDebugging)
+		.ToolTipText(this, &SPaperZDAnimRecorderScrubber::GetFrameToolTipText)
+
+		//Live toggle
+		+SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		[
+			SNew(SCheckBox)
+			.Style(FEditorStyle::Get(), "ToolBar.ToggleButton")
+			.IsChecked(this, &SPaperZDAnimRecorderScrubber::GetLiveCheckState)
+			.OnCheckStateChanged(this, &SPaperZDAnimRecorderScrubber::OnLiveCheckStateChanged)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("LiveLabel", "Live"))
+				.TextStyle(FEditorStyle::Get(), "Toolbar.Label")
+				.Margin(FMargin(5.0f, 2.0f))
+			]
+		]
+
+		//Recorded frames
+		+SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		.Padding(5.0f, 0.0f)
+		[
+			SNew(SBox)
+			.WidthOverride(200.0f)
+			[
+				SNew(SSlider)
+				.Value(this, &SPaperZDAnimRecorderScrubber::GetSliderValue)
+				.OnValueChanged(this, &SPaperZDAnimRecorderScrubber::OnSliderValueChanged)
+			]
+		]
+
+		+SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		[
+			SNew(STextBlock)
+			.Text(this, &SPaperZDAnimRecorderScrubber::GetFrameText)
+			.TextStyle(FEditorStyle::Get(), "Toolbar.Label")
+		]
+	];
+}
+
+float SPaperZDAnimRecorderScrubber::GetSliderValue() const
+{
+	uint32 OldestFrame, NewestFrame, DisplayedFrame;
+	if (FPaperZDAnimRecorderDebugger::GetFrameRange(Blueprint.Get(), OldestFrame, NewestFrame) && FPaperZDAnimRecorderDebugger::GetDisplayedFrame(Blueprint.Get(), DisplayedFrame) && NewestFrame > OldestFrame)
+	{
+		return static_cast<float>(DisplayedFrame - OldestFrame) / static_cast<float>(NewestFrame - OldestFrame);
+	}
+
+	return 1.0f;
+}
+
+void SPaperZDAnimRecorderScrubber::OnSliderValueChanged(float NewValue)
+{
+	uint32 OldestFrame, NewestFrame;
+	if (FPaperZDAnimRecorderDebugger::GetFrameRange(Blueprint.Get(), OldestFrame, NewestFrame))
+	{
+		const uint32 FrameOffset = static_cast<uint32>(FMath::RoundToInt(NewValue * (NewestFrame - OldestFrame)));
+		FPaperZDAnimRecorderDebugger::SetScrubFrame(Blueprint.Get(), OldestFrame + FrameOffset);
+	}
+}
+
+ECheckBoxState SPaperZDAnimRecorderScrubber::GetLiveCheckState() const
+{
+	return FPaperZDAnimRecorderDebugger::IsLive(Blueprint.Get()) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+void SPaperZDAnimRecorderScrubber::OnLiveCheckStateChanged(ECheckBoxState NewState)
+{
+	FPaperZDAnimRecorderDebugger::SetLive(Blueprint.Get(), NewState == ECheckBoxState::Checked);
+}
+
+FText SPaperZDAnimRecorderScrubber::GetFrameText() const
+{
+	uint32 OldestFrame, NewestFrame, DisplayedFrame;
+	if (FPaperZDAnimRecorderDebugger::GetFrameRange(Blueprint.Get(), OldestFrame, NewestFrame) && FPaperZDAnimRecorderDebugger::GetDisplayedFrame(Blueprint.Get(), DisplayedFrame))
+	{
+		//Frames are shown as how many updates ago they were recorded
+		return FText::Format(LOCTEXT("FrameLabel", "Frame -{0}"), FText::AsNumber(NewestFrame - DisplayedFrame));
+	}
+
+	return LOCTEXT("NoFramesLabel", "No frames");
+}
+
+FText SPaperZDAnimRecorderScrubber::GetFrameToolTipText() const
+{
+	return FPaperZDAnimRecorderDebugger::GetFrameDescription(Blueprint.Get());
+}
+
+bool SPaperZDAnimRecorderScrubber::IsDebugging() const
+{
+	return FPaperZDAnimRecorderDebugger::GetDebuggedInstance(Blueprint.Get()) != nullptr;
+}
+
+#undef LOCTEXT_NAMESPACE
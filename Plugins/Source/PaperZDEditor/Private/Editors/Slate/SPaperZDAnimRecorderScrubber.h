@@ -0,0 +1,51 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/DeclarativeSyntaxSupport.h"
+#include "Widgets/SCompoundWidget.h"
+#include "Styling/SlateTypes.h"
+
+class UBlueprint;
+
+/**
+ * Toolbar widget that scrubs the history recorded by the AnimInstance being debugged on an AnimBP.
+ * The state machine graphs highlight the states and transitions of the frame selected here.
+ */
+class SPaperZDAnimRecorderScrubber : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SPaperZDAnimRecorderScrubber)
+	{}
+	SLATE_END_ARGS()
+
+	/* Constructs this widget. */
+	void Construct(const FArguments& InArgs, UBlueprint* InBlueprint);
+
+private:
+	/* Obtain the position of the displayed frame on the slider. */
+	float GetSliderValue() const;
+
+	/* Called when the user moves the slider. */
+	void OnSliderValueChanged(float NewValue);
+
+	/* Obtain the state of the live toggle. */
+	ECheckBoxState GetLiveCheckState() const;
+
+	/* Called when the live toggle changes. */
+	void OnLiveCheckStateChanged(ECheckBoxState NewState);
+
+	/* Obtain the label with the displayed frame. */
+	FText GetFrameText() const;
+
+	/* Obtain the full description of the displayed frame. */
+	FText GetFrameToolTipText() const;
+
+	/* True if there's an instance being debugged. */
+	bool IsDebugging() const;
+
+private:
+	/* Blueprint whose debugged instance we're scrubbing. */
+	TWeakObjectPtr<UBlueprint> Blueprint;
+};
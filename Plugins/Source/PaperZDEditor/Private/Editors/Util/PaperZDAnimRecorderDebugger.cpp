@@ -0,0 +1,278 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Editors/Util/PaperZDAnimRecorderDebugger.h"
+#include "Graphs/PaperZDStateMachineGraph.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_StateMachine.h"
+#include "Notifies/PaperZDAnimNotify_Base.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimRecorder.h"
+#include "Engine/Blueprint.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+
+#define LOCTEXT_NAMESPACE "PaperZD_AnimRecorderDebugger"
+
+#if PAPERZD_RECORDER_ENABLED
+
+namespace FPaperZDAnimRecorderDebuggerHelpers
+{
+	//Time a transition stays highlighted while live, a single frame wouldn't be noticeable
+	const float LiveTransitionHighlightTime = 0.5f;
+
+	/* What is displayed for a single blueprint. */
+	struct FDebugState
+	{
+		bool bLive = true;
+		uint32 ScrubFrame = 0;
+
+		//Cached view, only rebuilt when the instance records something or the scrubbing changes
+		TWeakObjectPtr<const UPaperZDAnimInstance> CachedInstance;
+		uint64 CachedNumRecordsWritten = 0;
+		bool bDirty = true;
+		bool bValid = false;
+		uint32 OldestFrame = 0;
+		uint32 NewestFrame = 0;
+		FPaperZDAnimRecorder::FFrame Frame;
+		TArray<FPaperZDAnimRecord> DisplayedTransitions;
+	};
+
+	TMap<TWeakObjectPtr<const UBlueprint>, FDebugState>& GetDebugStates()
+	{
+		static TMap<TWeakObjectPtr<const UBlueprint>, FDebugState> DebugStates;
+		return DebugStates;
+	}
+
+	FDebugState& FindOrAddDebugState(const UBlueprint* Blueprint)
+	{
+		TMap<TWeakObjectPtr<const UBlueprint>, FDebugState>& DebugStates = GetDebugStates();
+		FDebugState* DebugState = DebugStates.Find(Blueprint);
+		if (!DebugState)
+		{
+			//Good moment to forget about closed blueprints
+			for (auto It = DebugStates.CreateIterator(); It; ++It)
+			{
+				if (!It.Key().IsValid())
+				{
+					It.RemoveCurrent();
+				}
+			}
+
+			DebugState = &DebugStates.Add(Blueprint);
+		}
+
+		return *DebugState;
+	}
+
+	/* Obtain the up to date view of the given blueprint, null if there's nothing to display. */
+	const FDebugState* GetDebugState(const UBlueprint* Blueprint)
+	{
+		const UPaperZDAnimInstance* Instance = FPaperZDAnimRecorderDebugger::GetDebuggedInstance(Blueprint);
+		if (!Instance)
+		{
+			return nullptr;
+		}
+
+		FDebugState& State = FindOrAddDebugState(Blueprint);
+		const FPaperZDAnimRecorder& Recorder = Instance->GetRecorder();
+		if (State.bDirty || State.CachedInstance.Get() != Instance || State.CachedNumRecordsWritten != Recorder.GetNumRecordsWritten())
+		{
+			State.bDirty = false;
+			State.CachedInstance = Instance;
+			State.CachedNumRecordsWritten = Recorder.GetNumRecordsWritten();
+			State.DisplayedTransitions.Reset();
+			State.bValid = Recorder.GetFrameRange(State.OldestFrame, State.NewestFrame);
+			if (State.bValid)
+			{
+				const uint32 FrameNumber = State.bLive ? State.NewestFrame : FMath::Clamp(State.ScrubFrame, State.OldestFrame, State.NewestFrame);
+				State.bValid = Recorder.GetFrame(FrameNumber, State.Frame);
+			}
+
+			if (State.bValid)
+			{
+				//Scrubbing shows exactly what happened on the frame
+				const float MinWorldTime = State.bLive ? State.Frame.WorldTime - LiveTransitionHighlightTime : State.Frame.WorldTime;
+				Recorder.ForEachRecord([&State, MinWorldTime](uint32 FrameNumber, float WorldTime, const FPaperZDAnimRecord& Record)
+				{
+					if (Record.Type == EPaperZDAnimRecordType::Transition && FrameNumber <= State.Frame.FrameNumber && WorldTime >= MinWorldTime)
+					{
+						State.DisplayedTransitions.Add(Record);
+					}
+				});
+			}
+		}
+
+		return State.bValid ? &State : nullptr;
+	}
+
+	/* Obtain the debug data of the state machine that owns the given node, looking on the class hierarchy of the instance. */
+	const FPaperZDStateMachineDebugData* FindStateMachineDebugData(const UEdGraphNode* Node, const UPaperZDAnimInstance* Instance)
+	{
+		const UPaperZDStateMachineGraph* Graph = Node ? Cast<UPaperZDStateMachineGraph>(Node->GetGraph()) : nullptr;
+		if (!Graph || !Graph->OwnerAnimGraphNode)
+		{
+			return nullptr;
+		}
+
+		for (const UClass* Class = Instance->GetClass(); Class; Class = Class->GetSuperClass())
+		{
+			if (const UPaperZDAnimBPGeneratedClass* AnimClass = Cast<UPaperZDAnimBPGeneratedClass>(Class))
+			{
+				if (const FPaperZDStateMachineDebugData* DebugData = AnimClass->GetAnimBPDebugData().StateMachines.Find(Graph->OwnerAnimGraphNode->NodeGuid))
+				{
+					return DebugData;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+UPaperZDAnimInstance* FPaperZDAnimRecorderDebugger::GetDebuggedInstance(const UBlueprint* Blueprint)
+{
+	return Blueprint ? Cast<UPaperZDAnimInstance>(Blueprint->GetObjectBeingDebugged()) : nullptr;
+}
+
+bool FPaperZDAnimRecorderDebugger::GetFrameRange(const UBlueprint* Blueprint, uint32& OutOldestFrame, uint32& OutNewestFrame)
+{
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugState(Blueprint);
+	OutOldestFrame = State ? State->OldestFrame : 0;
+	OutNewestFrame = State ? State->NewestFrame : 0;
+	return State != nullptr;
+}
+
+bool FPaperZDAnimRecorderDebugger::GetDisplayedFrame(const UBlueprint* Blueprint, uint32& OutFrameNumber)
+{
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugState(Blueprint);
+	OutFrameNumber = State ? State->Frame.FrameNumber : 0;
+	return State != nullptr;
+}
+
+void FPaperZDAnimRecorderDebugger::SetScrubFrame(const UBlueprint* Blueprint, uint32 FrameNumber)
+{
+	FPaperZDAnimRecorderDebuggerHelpers::FDebugState& State = FPaperZDAnimRecorderDebuggerHelpers::FindOrAddDebugState(Blueprint);
+	State.bLive = false;
+	State.ScrubFrame = FrameNumber;
+	State.bDirty = true;
+}
+
+void FPaperZDAnimRecorderDebugger::SetLive(const UBlueprint* Blueprint, bool bLive)
+{
+	FPaperZDAnimRecorderDebuggerHelpers::FDebugState& State = FPaperZDAnimRecorderDebuggerHelpers::FindOrAddDebugState(Blueprint);
+	if (!bLive && State.bLive)
+	{
+		//Freeze on whatever was being displayed
+		uint32 DisplayedFrame;
+		State.ScrubFrame = GetDisplayedFrame(Blueprint, DisplayedFrame) ? DisplayedFrame : 0;
+	}
+
+	State.bLive = bLive;
+	State.bDirty = true;
+}
+
+bool FPaperZDAnimRecorderDebugger::IsLive(const UBlueprint* Blueprint)
+{
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugStates().Find(Blueprint);
+	return State ? State->bLive : true;
+}
+
+FText FPaperZDAnimRecorderDebugger::GetFrameDescription(const UBlueprint* Blueprint)
+{
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugState(Blueprint);
+	const UPaperZDAnimInstance* Instance = GetDebuggedInstance(Blueprint);
+	if (!State || !Instance)
+	{
+		return LOCTEXT("NothingRecorded", "Nothing recorded, select an instance to debug.");
+	}
+
+	const FPaperZDAnimRecorder& Recorder = Instance->GetRecorder();
+	TArray<FString> Lines;
+	Lines.Add(FString::Printf(TEXT("Frame %u of %u (%.3fs)"), State->Frame.FrameNumber - State->OldestFrame + 1, State->NewestFrame - State->OldestFrame + 1, State->Frame.WorldTime));
+	for (const FPaperZDAnimRecord& Record : State->Frame.Records)
+	{
+		if (Record.Type == EPaperZDAnimRecordType::Playback)
+		{
+			Lines.Add(FString::Printf(TEXT("%s @ %.3fs, direction %.1f, weight %.2f, layer %d"), *GetNameSafe(Recorder.GetRecordedObject(Record.Index)),
+				Record.Value, Record.Args[0] / 10.0f, Record.Args[1] / 10000.0f, Record.Args[2]));
+		}
+		else if (Record.Type == EPaperZDAnimRecordType::Notify)
+		{
+			//Packed notifies record their asset, or their sequence for custom notifies
+			const UObject* RecordedObject = Recorder.GetRecordedObject(Record.Index);
+			const UPaperZDAnimNotify_Base* Notify = Cast<UPaperZDAnimNotify_Base>(RecordedObject);
+			Lines.Add(FString::Printf(TEXT("Notify %s @ %.3fs"), Notify ? *Notify->GetDisplayName().ToString() : *GetNameSafe(RecordedObject), Record.Value));
+		}
+	}
+
+	return FText::FromString(FString::Join(Lines, TEXT("\n")));
+}
+
+bool FPaperZDAnimRecorderDebugger::GetStateInfo(const UEdGraphNode* StateNode, FStateInfo& OutInfo)
+{
+	OutInfo = FStateInfo();
+	const UBlueprint* Blueprint = StateNode ? FBlueprintEditorUtils::FindBlueprintForNode(StateNode) : nullptr;
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugState(Blueprint);
+	const FPaperZDStateMachineDebugData* DebugData = State ? FPaperZDAnimRecorderDebuggerHelpers::FindStateMachineDebugData(StateNode, GetDebuggedInstance(Blueprint)) : nullptr;
+	const int32* StateIndex = DebugData ? DebugData->NodeGuidToStateIndex.Find(StateNode->NodeGuid) : nullptr;
+	if (!StateIndex)
+	{
+		return false;
+	}
+
+	for (const FPaperZDAnimRecord& Record : State->Frame.Records)
+	{
+		if (Record.Type == EPaperZDAnimRecordType::State && Record.Index == DebugData->StateMachineIndex && Record.Args[0] == *StateIndex)
+		{
+			OutInfo.bActive = true;
+			OutInfo.StateTime = Record.Value;
+		}
+	}
+
+	for (const FPaperZDAnimRecord& Record : State->DisplayedTransitions)
+	{
+		if (Record.Index == DebugData->StateMachineIndex && (Record.Args[0] == *StateIndex || Record.Args[1] == *StateIndex))
+		{
+			OutInfo.bVisited = true;
+		}
+	}
+
+	return true;
+}
+
+bool FPaperZDAnimRecorderDebugger::IsTransitionActive(const UEdGraphNode* TransitionNode)
+{
+	const UBlueprint* Blueprint = TransitionNode ? FBlueprintEditorUtils::FindBlueprintForNode(TransitionNode) : nullptr;
+	const FPaperZDAnimRecorderDebuggerHelpers::FDebugState* State = FPaperZDAnimRecorderDebuggerHelpers::GetDebugState(Blueprint);
+	const FPaperZDStateMachineDebugData* DebugData = State ? FPaperZDAnimRecorderDebuggerHelpers::FindStateMachineDebugData(TransitionNode, GetDebuggedInstance(Blueprint)) : nullptr;
+	const int32* RuleIndex = DebugData ? DebugData->TransitionGuidToRuleIndex.Find(TransitionNode->NodeGuid) : nullptr;
+	if (!RuleIndex)
+	{
+		return false;
+	}
+
+	for (const FPaperZDAnimRecord& Record : State->DisplayedTransitions)
+	{
+		if (Record.Index == DebugData->StateMachineIndex && Record.Args[2] == *RuleIndex)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#else
+
+UPaperZDAnimInstance* FPaperZDAnimRecorderDebugger::GetDebuggedInstance(const UBlueprint* Blueprint) { return nullptr; }
+bool FPaperZDAnimRecorderDebugger::GetFrameRange(const UBlueprint* Blueprint, uint32& OutOldestFrame, uint32& OutNewestFrame) { return false; }
+bool FPaperZDAnimRecorderDebugger::GetDisplayedFrame(const UBlueprint* Blueprint, uint32& OutFrameNumber) { return false; }
+void FPaperZDAnimRecorderDebugger::SetScrubFrame(const UBlueprint* Blueprint, uint32 FrameNumber) {}
+void FPaperZDAnimRecorderDebugger::SetLive(const UBlueprint* Blueprint, bool bLive) {}
+bool FPaperZDAnimRecorderDebugger::IsLive(const UBlueprint* Blueprint) { return true; }
+FText FPaperZDAnimRecorderDebugger::GetFrameDescription(const UBlueprint* Blueprint) { return LOCTEXT("RecorderDisabled", "The recorder is disabled on this build."); }
+bool FPaperZDAnimRecorderDebugger::GetStateInfo(const UEdGraphNode* StateNode, FStateInfo& OutInfo) { return false; }
+bool FPaperZDAnimRecorderDebugger::IsTransitionActive(const UEdGraphNode* TransitionNode) { return false; }
+
+#endif
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,57 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBlueprint;
+class UEdGraphNode;
+class UPaperZDAnimInstance;
+
+/**
+ * Reads the history recorded by the AnimInstance being debugged on an AnimBP, so the graph widgets can display it.
+ * Each blueprint either follows the newest recorded frame (live) or stays on the frame picked on the scrubber.
+ */
+class FPaperZDAnimRecorderDebugger
+{
+public:
+	/* Debug info of a state or conduit, on the displayed frame. */
+	struct FStateInfo
+	{
+		/* True if this is the active state of its state machine. */
+		bool bActive = false;
+
+		/* True if a transition from or to this state was displayed along the frame. */
+		bool bVisited = false;
+
+		/* Time spent on the state, if active. */
+		float StateTime = 0.0f;
+	};
+
+	/* Obtain the AnimInstance that is being debugged for the given blueprint, if any. */
+	static UPaperZDAnimInstance* GetDebuggedInstance(const UBlueprint* Blueprint);
+
+	/* Obtain the frames still recorded by the debugged instance. */
+	static bool GetFrameRange(const UBlueprint* Blueprint, uint32& OutOldestFrame, uint32& OutNewestFrame);
+
+	/* Obtain the frame being displayed, false if there's nothing recorded. */
+	static bool GetDisplayedFrame(const UBlueprint* Blueprint, uint32& OutFrameNumber);
+
+	/* Stops following the instance and displays the given frame. */
+	static void SetScrubFrame(const UBlueprint* Blueprint, uint32 FrameNumber);
+
+	/* Sets whether the newest recorded frame should be displayed. */
+	static void SetLive(const UBlueprint* Blueprint, bool bLive);
+
+	/* True if the newest recorded frame is being displayed. */
+	static bool IsLive(const UBlueprint* Blueprint);
+
+	/* Obtain a readable description of the animations and notifies of the displayed frame. */
+	static FText GetFrameDescription(const UBlueprint* Blueprint);
+
+	/* Obtain the debug info of a state or conduit node, false if there's no debug data for it. */
+	static bool GetStateInfo(const UEdGraphNode* StateNode, FStateInfo& OutInfo);
+
+	/* True if the given transition node was taken on the displayed frame. While live, recent transitions are kept highlighted for a short time so they can be seen. */
+	static bool IsTransitionActive(const UEdGraphNode* TransitionNode);
+};
@@ -10,6 +10,11 @@ UPaperZDEditorSettings::UPaperZDEditorSettings() : Super()
 	ResultNodeTitleColor = FLinearColor(1.0f, 0.65f, 0.4f, 1.0f);
 	bAutomaticallyPurgeUnregisteredNotifyFunctions = true;
 
+	//Node costs
+	bShowNodeCosts = true;
+	NodeCostWarningMicroseconds = 2.0f;
+	NodeCostErrorMicroseconds = 10.0f;
+
 	//Timeline
 	TimelineScrubSnapValue = 1000;
 	TimelineDisplayFormat = EFrameNumberDisplayFormats::Frames;
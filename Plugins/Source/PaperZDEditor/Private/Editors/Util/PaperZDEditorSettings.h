@@ -50,6 +50,18 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = "Animation Blueprint")
 	bool bAutomaticallyPurgeUnregisteredNotifyFunctions;
 
+	/* Whether to display the per node costs measured on the last play session over the AnimBP graphs. */
+	UPROPERTY(EditAnywhere, config, Category = "Node Costs")
+	bool bShowNodeCosts;
+
+	/* Average cost per update above which a node or transition rule is highlighted as expensive. */
+	UPROPERTY(EditAnywhere, config, Category = "Node Costs", meta = (EditCondition = "bShowNodeCosts", ClampMin = "0.0", Units = "us"))
+	float NodeCostWarningMicroseconds;
+
+	/* Average cost per update above which a node or transition rule is highlighted as very expensive. */
+	UPROPERTY(EditAnywhere, config, Category = "Node Costs", meta = (EditCondition = "bShowNodeCosts", ClampMin = "0.0", Units = "us"))
+	float NodeCostErrorMicroseconds;
+
  	/* Colors to use on the time nodes for the montages. */ 
  	//UPROPERTY(EditAnywhere, config, Category = "Montages")  //@NOTE: Pending for montages 
  	FLinearColor SectionTimingNodeColor;
@@ -0,0 +1,153 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
+#include "Editors/Util/PaperZDEditorSettings.h"
+#include "Graphs/PaperZDStateMachineGraph.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_Base.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_StateMachine.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_State.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_Conduit.h"
+#include "Graphs/Nodes/PaperZDStateGraphNode_Transition.h"
+#include "AnimNodes/PaperZDAnimStateMachine.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDNodeCost.h"
+#include "Engine/Blueprint.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "SNodePanel.h"
+
+#if PAPERZD_NODE_COST_ENABLED
+
+namespace FPaperZDNodeCostOverlayHelpers
+{
+	/* Obtain the class the node was compiled into, if there are costs to display for it. */
+	const UPaperZDAnimBPGeneratedClass* GetMeasuredClass(const UEdGraphNode* Node)
+	{
+		const UBlueprint* Blueprint = Node ? FBlueprintEditorUtils::FindBlueprintForNode(Node) : nullptr;
+		const UPaperZDAnimBPGeneratedClass* AnimClass = Blueprint ? Cast<UPaperZDAnimBPGeneratedClass>(Blueprint->GeneratedClass) : nullptr;
+		const bool bShowCosts = GetDefault<UPaperZDEditorSettings>()->bShowNodeCosts;
+		return bShowCosts && AnimClass && AnimClass->GetNodeCostData().NumUpdates > 0 ? AnimClass : nullptr;
+	}
+
+	/* Obtain the debug data of the state machine that owns the given node. */
+	const FPaperZDStateMachineDebugData* FindStateMachineDebugData(const UEdGraphNode* Node, const UPaperZDAnimBPGeneratedClass* AnimClass)
+	{
+		const UPaperZDStateMachineGraph* Graph = Cast<UPaperZDStateMachineGraph>(Node->GetGraph());
+		return Graph && Graph->OwnerAnimGraphNode ? AnimClass->GetAnimBPDebugData().StateMachines.Find(Graph->OwnerAnimGraphNode->NodeGuid) : nullptr;
+	}
+
+	/* Obtain the cost counter of the transition rule that drives the given transition or conduit. */
+	const FPaperZDCostCounter* FindRuleCounter(const UEdGraphNode* Node, const UPaperZDAnimBPGeneratedClass* AnimClass)
+	{
+		const FPaperZDStateMachineDebugData* DebugData = FindStateMachineDebugData(Node, AnimClass);
+		if (!DebugData)
+		{
+			return nullptr;
+		}
+
+		int32 RuleIndex = INDEX_NONE;
+		if (Node->IsA<UPaperZDStateGraphNode_Conduit>())
+		{
+			//Conduits own their rule, which lives on the baked node
+			const int32* StateIndex = DebugData->NodeGuidToStateIndex.Find(Node->NodeGuid);
+			const TArray<FPaperZDAnimStateMachine>& StateMachines = AnimClass->GetStateMachines();
+			if (StateIndex && StateMachines.IsValidIndex(DebugData->StateMachineIndex) && StateMachines[DebugData->StateMachineIndex].Nodes.IsValidIndex(*StateIndex))
+			{
+				RuleIndex = StateMachines[DebugData->StateMachineIndex].Nodes[*StateIndex].ConduitRuleIndex;
+			}
+		}
+		else if (const int32* TransitionRuleIndex = DebugData->TransitionGuidToRuleIndex.Find(Node->NodeGuid))
+		{
+			RuleIndex = *TransitionRuleIndex;
+		}
+
+		return AnimClass->GetNodeCostData().FindRule(DebugData->StateMachineIndex, RuleIndex);
+	}
+
+	/* Obtain the color that represents the given cost. */
+	FLinearColor GetCostColor(double Microseconds)
+	{
+		const UPaperZDEditorSettings* Settings = GetDefault<UPaperZDEditorSettings>();
+		if (Microseconds >= Settings->NodeCostErrorMicroseconds)
+		{
+			return FLinearColor(0.85f, 0.15f, 0.1f);
+		}
+		else if (Microseconds >= Settings->NodeCostWarningMicroseconds)
+		{
+			return FLinearColor(0.9f, 0.7f, 0.1f);
+		}
+
+		return FLinearColor(0.2f, 0.6f, 0.25f);
+	}
+
+	/* Describes the cost of a transition rule. */
+	FString DescribeRule(const FPaperZDCostCounter& Counter)
+	{
+		return FString::Printf(TEXT("Evaluated %u, passed %u, taken %u, %.2f µs"), Counter.Count, Counter.NumPassed, Counter.NumTaken, Counter.GetAverageMicroseconds());
+	}
+}
+
+void FPaperZDNodeCostOverlay::GetNodeCostPopups(const UEdGraphNode* Node, TArray<FGraphInformationPopupInfo>& Popups)
+{
+	const UPaperZDAnimBPGeneratedClass* AnimClass = FPaperZDNodeCostOverlayHelpers::GetMeasuredClass(Node);
+	if (!AnimClass)
+	{
+		return;
+	}
+
+	const FPaperZDNodeCostData& CostData = AnimClass->GetNodeCostData();
+	if (Node->IsA<UPaperZDStateGraphNode_Transition>() || Node->IsA<UPaperZDStateGraphNode_Conduit>())
+	{
+		const FPaperZDCostCounter* Counter = FPaperZDNodeCostOverlayHelpers::FindRuleCounter(Node, AnimClass);
+		if (Counter && Counter->Count > 0)
+		{
+			const double Microseconds = Counter->GetAverageMicroseconds();
+			Popups.Emplace(nullptr, FPaperZDNodeCostOverlayHelpers::GetCostColor(Microseconds), FPaperZDNodeCostOverlayHelpers::DescribeRule(*Counter));
+		}
+	}
+	else if (Node->IsA<UPaperZDStateGraphNode_State>())
+	{
+		const FPaperZDStateMachineDebugData* DebugData = FPaperZDNodeCostOverlayHelpers::FindStateMachineDebugData(Node, AnimClass);
+		const int32* StateIndex = DebugData ? DebugData->NodeGuidToStateIndex.Find(Node->NodeGuid) : nullptr;
+		const FPaperZDCostCounter* Counter = StateIndex ? CostData.FindState(DebugData->StateMachineIndex, *StateIndex) : nullptr;
+		if (Counter && Counter->Count > 0)
+		{
+			//States are measured along with their whole graph
+			const double Microseconds = Counter->GetAverageMicroseconds();
+			Popups.Emplace(nullptr, FPaperZDNodeCostOverlayHelpers::GetCostColor(Microseconds), FString::Printf(TEXT("%.2f µs/update, %u notifies"), Microseconds, Counter->NumNotifies));
+		}
+	}
+	else if (Node->IsA<UPaperZDAnimGraphNode_Base>())
+	{
+		const int32* LinkID = AnimClass->GetAnimBPDebugData().NodeGuidToLinkID.Find(Node->NodeGuid);
+		const FPaperZDCostCounter* Counter = LinkID ? CostData.FindNode(*LinkID) : nullptr;
+		if (Counter && Counter->Count > 0)
+		{
+			const double Microseconds = Counter->GetAverageMicroseconds();
+			Popups.Emplace(nullptr, FPaperZDNodeCostOverlayHelpers::GetCostColor(Microseconds), FString::Printf(TEXT("%.2f µs"), Microseconds));
+		}
+	}
+}
+
+bool FPaperZDNodeCostOverlay::GetExpensiveTransitionColor(const UEdGraphNode* TransitionNode, FLinearColor& OutColor)
+{
+	const UPaperZDAnimBPGeneratedClass* AnimClass = FPaperZDNodeCostOverlayHelpers::GetMeasuredClass(TransitionNode);
+	const FPaperZDCostCounter* Counter = AnimClass ? FPaperZDNodeCostOverlayHelpers::FindRuleCounter(TransitionNode, AnimClass) : nullptr;
+	if (Counter && Counter->Count > 0)
+	{
+		const double Microseconds = Counter->GetAverageMicroseconds();
+		if (Microseconds >= GetDefault<UPaperZDEditorSettings>()->NodeCostWarningMicroseconds)
+		{
+			OutColor = FPaperZDNodeCostOverlayHelpers::GetCostColor(Microseconds);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#else
+
+void FPaperZDNodeCostOverlay::GetNodeCostPopups(const UEdGraphNode* Node, TArray<FGraphInformationPopupInfo>& Popups) {}
+bool FPaperZDNodeCostOverlay::GetExpensiveTransitionColor(const UEdGraphNode* TransitionNode, FLinearColor& OutColor) { return false; }
+
+#endif
@@ -0,0 +1,22 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UEdGraphNode;
+struct FGraphInformationPopupInfo;
+
+/**
+ * Displays the per node costs measured by the AnimInstances on the last play session over the AnimBP graphs.
+ * Expensive nodes and transition rules are color coded using the thresholds on the editor settings.
+ */
+class FPaperZDNodeCostOverlay
+{
+public:
+	/* Adds the popup with the measured cost of the given AnimNode, state, conduit or transition, if any was measured. */
+	static void GetNodeCostPopups(const UEdGraphNode* Node, TArray<FGraphInformationPopupInfo>& Popups);
+
+	/* Obtain the color of a transition whose rule is expensive to evaluate, false if the rule isn't expensive. */
+	static bool GetExpensiveTransitionColor(const UEdGraphNode* TransitionNode, FLinearColor& OutColor);
+};
@@ -2,6 +2,7 @@
 
 #include "Graphs/Nodes/PaperZDAnimGraphNode_RandomPlayer.h"
 #include "AnimSequences/PaperZDAnimSequence.h"
+#include "Compilers/Access/PaperZDAnimBPGeneratedClassAccess.h"
 
 #define LOCTEXT_NAMESPACE "ZDNodes"
 
@@ -24,4 +25,15 @@ FText UPaperZDAnimGraphNode_RandomPlayer::GetNodeTitle(ENodeTitleType::Type Titl
 	return LOCTEXT("PlayRandomSequence_Title", "Play Random Sequence");
 }
 
+void UPaperZDAnimGraphNode_RandomPlayer::OnProcessDuringCompilation(FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData)
+{
+	//The entries never change at runtime, bake them once onto the class instead of letting every AnimInstance hold a copy
+	TArray<FPaperZDRandomPlayerData>& RandomPlayers = OutCompiledData.GetRandomPlayers();
+	AnimNode.RandomPlayerIndex = RandomPlayers.Num();
+	RandomPlayers.AddDefaulted_GetRef().Init(AnimNode.Entries, AnimNode.bShuffleMode);
+
+	//We're processing a copy of the editor node, so the class defaults (and the AnimInstances on the editor) don't need to keep them either
+	AnimNode.Entries.Empty();
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -30,5 +30,6 @@ public:
 
 	//~ Begin UPaperZDAnimGraphNode_Base Interface
 	virtual FString GetNodeCategory() const override;
+	virtual void OnProcessDuringCompilation(FPaperZDAnimBPCompilerAccess& InCompilationContext, FPaperZDAnimBPGeneratedClassAccess& OutCompiledData) override;
 	//~ End UPaperZDAnimGraphNode_Base Interface
 };
@@ -203,6 +203,14 @@ void UPaperZDAnimGraphNode_StateMachine::OnProcessDuringCompilation(FPaperZDAnim
 		StateMachine.MachineName = *GetStateMachineName();
 	}
 
+	//Debug data maps the editor nodes to their baked indices, keyed by guid as the nodes we're processing are clones of the ones on the editor
+	//Same as the state machine array, the debug data map can be modified by the internal state machines, so we always search for our entry
+	auto GetMachineDebugData = [&]() -> FPaperZDStateMachineDebugData&
+	{
+		return OutCompiledData.GetDebugData().StateMachines.FindOrAdd(NodeGuid);
+	};
+	GetMachineDebugData().StateMachineIndex = StateMachineIndex;
+
 	//Iterate over all the nodes
 	UPaperZDStateGraphNode_Root* RootNode = nullptr;
 	TArray<UPaperZDStateGraphNode_Transition*> Transitions;
@@ -242,6 +250,8 @@ void UPaperZDAnimGraphNode_StateMachine::OnProcessDuringCompilation(FPaperZDAnim
 			const int32 BakedNodeIndex = StateMachine.Nodes.AddDefaulted();
 			FPaperZDAnimStateMachineNode& BakedNode = StateMachine.Nodes[BakedNodeIndex];
 			GraphNodeToStateMachineNodeId.Add(Node, BakedNodeIndex);
+			GetMachineDebugData().NodeGuidToStateIndex.Add(Node->NodeGuid, BakedNodeIndex);
+			BakedNode.StateName = FName(*Node->GetNodeName());
 			check(Node->GetBoundGraph());
 
 			//Setup the node
@@ -273,7 +283,7 @@ void UPaperZDAnimGraphNode_StateMachine::OnProcessDuringCompilation(FPaperZDAnim
 					//Create a transition rule that will govern this transition
 					int32 RuleIdx = StateMachine.TransitionRules.AddDefaulted();
 					FPaperZDAnimStateMachineTransitionRule& TransitionRule = StateMachine.TransitionRules[RuleIdx];
-					Handle->ProcessTransitionGraph(ConduitNode->GetBoundGraph(), TransitionRule, InCompilationContext, OutCompiledData);
+					Handle->ProcessTransitionGraph(ConduitNode->GetBoundGraph(), TransitionRule, StateMachine.RuleProgram, InCompilationContext, OutCompiledData);
 
 					//Setup the conduit
 					BakedNode.bConduit = true;
@@ -311,13 +321,14 @@ void UPaperZDAnimGraphNode_StateMachine::OnProcessDuringCompilation(FPaperZDAnim
 			FPaperZDAnimStateMachine& StateMachine = OutCompiledData.GetStateMachines()[StateMachineIndex];
 			int32 RuleIdx = StateMachine.TransitionRules.AddDefaulted();
 			FPaperZDAnimStateMachineTransitionRule& TransitionRule = StateMachine.TransitionRules[RuleIdx];
-			Handle->ProcessTransitionGraph(GraphTransition->GetBoundGraph(), TransitionRule, InCompilationContext, OutCompiledData);
+			Handle->ProcessTransitionGraph(GraphTransition->GetBoundGraph(), TransitionRule, StateMachine.RuleProgram, InCompilationContext, OutCompiledData);
 
 			//Finally add the transition rule to the node
 			FPaperZDAnimStateMachineNode& BakedFromNode = StateMachine.Nodes[GraphNodeToStateMachineNodeId[FromNode]];
 			FPaperZDAnimStateMachineLink& Link = BakedFromNode.OutwardLinks.AddDefaulted_GetRef();
 			Link.TargetNodeIndex = GraphNodeToStateMachineNodeId[ToNode];
 			Link.TransitionRuleIndex = RuleIdx;
+			GetMachineDebugData().TransitionGuidToRuleIndex.Add(GraphTransition->NodeGuid, RuleIdx);
 
 			//~~~~ Transitional AnimGraphs ~~~~
 			if (GraphTransition->HasTransitionalAnimations())
@@ -0,0 +1,16 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "Graphs/Nodes/Slate/SPaperZDAnimGraphNode_Base.h"
+#include "Graphs/Nodes/PaperZDAnimGraphNode_Base.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
+
+void SPaperZDAnimGraphNode_Base::Construct(const FArguments& InArgs, UPaperZDAnimGraphNode_Base* InNode)
+{
+	SGraphNodeK2Default::Construct(SGraphNodeK2Default::FArguments(), InNode);
+}
+
+void SPaperZDAnimGraphNode_Base::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
+{
+	SGraphNodeK2Default::GetNodeInfoPopups(Context, Popups);
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
+}
@@ -0,0 +1,25 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/DeclarativeSyntaxSupport.h"
+#include "KismetNodes/SGraphNodeK2Default.h"
+
+class UPaperZDAnimGraphNode_Base;
+
+/**
+ * Visual representation for the AnimGraph nodes without a custom one, displays the cost measured for the node.
+ */
+class SPaperZDAnimGraphNode_Base : public SGraphNodeK2Default
+{
+public:
+	SLATE_BEGIN_ARGS(SPaperZDAnimGraphNode_Base) {}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs, UPaperZDAnimGraphNode_Base* InNode);
+
+	// SNodePanel::SNode interface
+	virtual void GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const override;
+	// End of SNodePanel::SNode interface
+};
@@ -5,6 +5,7 @@
 #include "Widgets/Images/SImage.h"
 #include "Graphs/Nodes/PaperZDAnimGraphNode_Base.h"
 #include "Editors/Util/PaperZDEditorStyle.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
 
 /////////////////////////////////////////////////////
 // SGraphNodeAnimationResult
@@ -16,6 +17,12 @@ void SPaperZDAnimGraphNode_Sink::Construct(const FArguments& InArgs, UPaperZDAni
 	UpdateGraphNode();
 }
 
+void SPaperZDAnimGraphNode_Sink::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
+{
+	SGraphNodeK2Base::GetNodeInfoPopups(Context, Popups);
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
+}
+
 TSharedRef<SWidget> SPaperZDAnimGraphNode_Sink::CreateNodeContentArea()
 {
 	return SNew(SBorder)
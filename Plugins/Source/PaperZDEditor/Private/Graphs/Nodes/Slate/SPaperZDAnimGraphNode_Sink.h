@@ -20,6 +20,10 @@ public:
 
 	void Construct(const FArguments& InArgs, class UPaperZDAnimGraphNode_Base* InNode);
 
+	// SNodePanel::SNode interface
+	virtual void GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const override;
+	// End of SNodePanel::SNode interface
+
 protected:
 	// SGraphNode interface
 	virtual TSharedRef<SWidget> CreateNodeContentArea() override;
@@ -3,6 +3,7 @@
 #include "Graphs/Nodes/Slate/SPaperZDAnimGraphNode_StateMachine.h"
 #include "Graphs/Nodes/PaperZDAnimGraphNode_StateMachine.h"
 #include "Graphs/PaperZDStateMachineGraph.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
 
 void SPaperZDAnimGraphNode_StateMachine::Construct(const FArguments& InArgs, UPaperZDAnimGraphNode_StateMachine* InNode)
 {
@@ -11,6 +12,12 @@ void SPaperZDAnimGraphNode_StateMachine::Construct(const FArguments& InArgs, UPa
 	UpdateGraphNode();
 }
 
+void SPaperZDAnimGraphNode_StateMachine::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
+{
+	SGraphNodeK2Composite::GetNodeInfoPopups(Context, Popups);
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
+}
+
 UEdGraph* SPaperZDAnimGraphNode_StateMachine::GetInnerGraph() const
 {
 	UPaperZDAnimGraphNode_StateMachine* StateMachine= CastChecked<UPaperZDAnimGraphNode_StateMachine>(GraphNode);
@@ -13,6 +13,11 @@ public:
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& InArgs, class UPaperZDAnimGraphNode_StateMachine* InNode);
+
+	// SNodePanel::SNode interface
+	virtual void GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const override;
+	// End of SNodePanel::SNode interface
+
 protected:
 	// SGraphNodeK2Composite interface
 	virtual UEdGraph* GetInnerGraph() const override;
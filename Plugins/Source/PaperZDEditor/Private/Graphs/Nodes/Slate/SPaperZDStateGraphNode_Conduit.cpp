@@ -6,6 +6,8 @@
 #include "Widgets/Images/SImage.h"
 #include "Widgets/SToolTip.h"
 #include "Kismet2/BlueprintEditorUtils.h"
+#include "Editors/Util/PaperZDAnimRecorderDebugger.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
 #include "Widgets/Text/SInlineEditableTextBlock.h"
 
 //#include "SGraphPreviewer.h"
@@ -74,12 +76,18 @@ void SPaperZDStateGraphNode_Conduit::Construct(const FArguments& InArgs, UPaperZ
 
 void SPaperZDStateGraphNode_Conduit::GetStateInfoPopup(UEdGraphNode* GraphNode, TArray<FGraphInformationPopupInfo>& Popups)
 {
-	//@TODO: Add state info when Debug data is added
+	FPaperZDAnimRecorderDebugger::FStateInfo StateInfo;
+	if (FPaperZDAnimRecorderDebugger::GetStateInfo(GraphNode, StateInfo) && StateInfo.bActive)
+	{
+		const FLinearColor PopupColor(1.f, 0.5f, 0.25f);
+		Popups.Emplace(nullptr, PopupColor, FString::Printf(TEXT("Active for %.2fs"), StateInfo.StateTime));
+	}
 }
 
 void SPaperZDStateGraphNode_Conduit::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
 {
 	GetStateInfoPopup(GraphNode, Popups);
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
 }
 
 FSlateColor SPaperZDStateGraphNode_Conduit::GetBorderBackgroundColor() const
@@ -88,7 +96,19 @@ FSlateColor SPaperZDStateGraphNode_Conduit::GetBorderBackgroundColor() const
 	FLinearColor ActiveStateColorDim(0.4f, 0.3f, 0.15f);
 	FLinearColor ActiveStateColorBright(1.f, 0.6f, 0.35f);
 
-	//@TODO: Use the other colors when Debug Data is available
+	//Recorded by the instance being debugged
+	FPaperZDAnimRecorderDebugger::FStateInfo StateInfo;
+	if (FPaperZDAnimRecorderDebugger::GetStateInfo(GraphNode, StateInfo))
+	{
+		if (StateInfo.bActive)
+		{
+			return ActiveStateColorBright;
+		}
+		else if (StateInfo.bVisited)
+		{
+			return ActiveStateColorDim;
+		}
+	}
 
 	return InactiveStateColor;
 }
@@ -7,6 +7,8 @@
 #include "Widgets/SToolTip.h"
 #include "SGraphPreviewer.h"
 #include "Kismet2/BlueprintEditorUtils.h"
+#include "Editors/Util/PaperZDAnimRecorderDebugger.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
 #include "IDocumentation.h"
 #include "Widgets/Text/SInlineEditableTextBlock.h"
 
@@ -77,12 +79,18 @@ void SPaperZDStateGraphNode_State::Construct(const FArguments& InArgs, UPaperZDS
 
 void SPaperZDStateGraphNode_State::GetStateInfoPopup(UEdGraphNode* GraphNode, TArray<FGraphInformationPopupInfo>& Popups)
 {
-	//@TODO: Add state info when Debug data is added
+	FPaperZDAnimRecorderDebugger::FStateInfo StateInfo;
+	if (FPaperZDAnimRecorderDebugger::GetStateInfo(GraphNode, StateInfo) && StateInfo.bActive)
+	{
+		const FLinearColor PopupColor(1.f, 0.5f, 0.25f);
+		Popups.Emplace(nullptr, PopupColor, FString::Printf(TEXT("Active for %.2fs"), StateInfo.StateTime));
+	}
 }
 
 void SPaperZDStateGraphNode_State::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
 {
 	GetStateInfoPopup(GraphNode, Popups);
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
 }
 
 FSlateColor SPaperZDStateGraphNode_State::GetBorderBackgroundColor() const
@@ -91,7 +99,19 @@ FSlateColor SPaperZDStateGraphNode_State::GetBorderBackgroundColor() const
 	FLinearColor ActiveStateColorDim(0.4f, 0.3f, 0.15f);
 	FLinearColor ActiveStateColorBright(1.f, 0.6f, 0.35f);
 
-	//@TODO: Use the other colors when Debug Data is available
+	//Recorded by the instance being debugged
+	FPaperZDAnimRecorderDebugger::FStateInfo StateInfo;
+	if (FPaperZDAnimRecorderDebugger::GetStateInfo(GraphNode, StateInfo))
+	{
+		if (StateInfo.bActive)
+		{
+			return ActiveStateColorBright;
+		}
+		else if (StateInfo.bVisited)
+		{
+			return ActiveStateColorDim;
+		}
+	}
 
 	return InactiveStateColor;
 }
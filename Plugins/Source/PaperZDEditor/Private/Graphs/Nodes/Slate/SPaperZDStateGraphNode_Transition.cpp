@@ -13,6 +13,8 @@
 #include "ConnectionDrawingPolicy.h"
 #include "IDocumentation.h"
 #include "Editors/Util/PaperZDEditorStyle.h"
+#include "Editors/Util/PaperZDAnimRecorderDebugger.h"
+#include "Editors/Util/PaperZDNodeCostOverlay.h"
 
 #define LOCTEXT_NAMESPACE "ZD_TransitionNodes"
 
@@ -26,6 +28,7 @@ void SPaperZDStateGraphNode_Transition::Construct(const FArguments& InArgs, UPap
 
 void SPaperZDStateGraphNode_Transition::GetNodeInfoPopups(FNodeInfoContext* Context, TArray<FGraphInformationPopupInfo>& Popups) const
 {
+	FPaperZDNodeCostOverlay::GetNodeCostPopups(GraphNode, Popups);
 }
 
 void SPaperZDStateGraphNode_Transition::MoveTo(const FVector2D& NewPosition, FNodeSet& NodeFilter, bool bMarkDirty /* = true*/)
@@ -211,7 +214,19 @@ FLinearColor SPaperZDStateGraphNode_Transition::StaticGetTransitionColor(UPaperZ
 	const FLinearColor HoverColor(0.724f, 0.256f, 0.0f, 1.0f);
 	//FLinearColor BaseColor(0.9f, 0.9f, 0.9f, 1.0f);
 
-	//@TODO: Add debug data colors and active / inactive status
+	//Transitions taken by the instance being debugged
+	if (FPaperZDAnimRecorderDebugger::IsTransitionActive(TransNode))
+	{
+		return ActiveColor;
+	}
+
+	//Rules measured as expensive on the last play session
+	FLinearColor CostColor;
+	if (!bIsHovered && FPaperZDNodeCostOverlay::GetExpensiveTransitionColor(TransNode, CostColor))
+	{
+		return CostColor;
+	}
+
 	return bIsHovered ? HoverColor : TransNode->Color;
 }
 
@@ -9,6 +9,7 @@
 #include "Graphs/Nodes/Slate/SPaperZDAnimGraphNode_Sink.h"
 #include "Graphs/Nodes/PaperZDAnimGraphNode_StateMachine.h"
 #include "Graphs/Nodes/Slate/SPaperZDAnimGraphNode_StateMachine.h"
+#include "Graphs/Nodes/Slate/SPaperZDAnimGraphNode_Base.h"
 
 //////////////////////////////////////////////////////////////////////////
 //// Graph Factory
@@ -23,6 +24,10 @@ TSharedPtr<SGraphNode> FPaperZDGraphNodeFactory::CreateNode(UEdGraphNode* InNode
 	{
 		return SNew(SPaperZDAnimGraphNode_StateMachine, StateMachineNode);
 	}
+	else if (UPaperZDAnimGraphNode_Base* AnimGraphNode = Cast<UPaperZDAnimGraphNode_Base>(InNode))
+	{
+		return SNew(SPaperZDAnimGraphNode_Base, AnimGraphNode);
+	}
 
 	return nullptr;
 }
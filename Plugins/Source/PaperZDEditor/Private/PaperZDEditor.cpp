@@ -39,6 +39,8 @@
 //For Sequencer support
 #include "ISequencerModule.h"
 #include "PaperZDAnimationTrackEditor.h"
+#include "PaperZDNodeCost.h"
+#include "Editor.h"
 
 #define LOCTEXT_NAMESPACE "FPaperZDEditorModule"
 void FPaperZDEditorModule::StartupModule()
@@ -68,6 +70,9 @@ void FPaperZDEditorModule::StartupModule()
 	//Register the custom graph factories
 	RegisterGraphFactories();
 
+	//Node costs only reflect the last play session
+	BeginPIEHandle = FEditorDelegates::BeginPIE.AddRaw(this, &FPaperZDEditorModule::OnBeginPIE);
+
 	//Finally register the EditorProxy, so the runtime part can configure editor-only functionalities when this module is up and running
 	FPaperZDRuntimeEditorProxy::Register();
 }
@@ -78,6 +83,14 @@ void FPaperZDEditorModule::ShutdownModule()
 	UnregisterGraphFactories();
 
 	FPaperZDAnimBPEditor::UnregisterDefaultEventNodes();
+	FEditorDelegates::BeginPIE.Remove(BeginPIEHandle);
+}
+
+void FPaperZDEditorModule::OnBeginPIE(const bool bIsSimulating)
+{
+#if PAPERZD_NODE_COST_ENABLED
+	FPaperZDNodeCostCapture::ResetAll();
+#endif
 }
 
 void FPaperZDEditorModule::RegisterCompiler()
@@ -0,0 +1,133 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Commandlets/PaperZDBenchmarkScenarios.h"
+#include "PaperZDAnimBP.h"
+#include "PaperZDAnimBPGeneratedClass.h"
+#include "PaperZDAnimInstance.h"
+#include "PaperZDAnimCounters.h"
+#include "AnimSequences/Players/PaperZDAnimationPlaybackData.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FPaperZDParallelUpdateTestHelpers
+{
+	/* Compares two playback results, describing the first difference found. */
+	bool IsSamePlayback(const FPaperZDAnimationPlaybackData& Serial, const FPaperZDAnimationPlaybackData& Parallel, FString& OutDifference)
+	{
+		if (Serial.WeightedAnimations.Num() != Parallel.WeightedAnimations.Num())
+		{
+			OutDifference = FString::Printf(TEXT("%d animations against %d"), Serial.WeightedAnimations.Num(), Parallel.WeightedAnimations.Num());
+			return false;
+		}
+		else if (!FMath::IsNearlyEqual(Serial.DirectionalAngle, Parallel.DirectionalAngle))
+		{
+			OutDifference = FString::Printf(TEXT("directional angle %f against %f"), Serial.DirectionalAngle, Parallel.DirectionalAngle);
+			return false;
+		}
+
+		for (int32 i = 0; i < Serial.WeightedAnimations.Num(); i++)
+		{
+			const FPaperZDWeightedAnimation& SerialAnimation = Serial.WeightedAnimations[i];
+			const FPaperZDWeightedAnimation& ParallelAnimation = Parallel.WeightedAnimations[i];
+			if (SerialAnimation.AnimSequencePtr != ParallelAnimation.AnimSequencePtr || SerialAnimation.Layer != ParallelAnimation.Layer
+				|| !FMath::IsNearlyEqual(SerialAnimation.PlaybackTime, ParallelAnimation.PlaybackTime)
+				|| !FMath::IsNearlyEqual(SerialAnimation.Weight, ParallelAnimation.Weight)
+				|| !FMath::IsNearlyEqual(SerialAnimation.LayerWeight, ParallelAnimation.LayerWeight))
+			{
+				OutDifference = FString::Printf(TEXT("animation %d differs, time %f against %f"), i, SerialAnimation.PlaybackTime, ParallelAnimation.PlaybackTime);
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPaperZDParallelUpdateTest, "PaperZD.AnimInstance.ParallelUpdate", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FPaperZDParallelUpdateTest::RunTest(const FString& Parameters)
+{
+	using namespace FPaperZDParallelUpdateTestHelpers;
+	const int32 NumFrames = 120;
+	const float DeltaTime = 1.0f / 30.0f;
+
+	//Nothing ticks the world, every instance is driven by hand through either path
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("PaperZDParallelUpdateTestWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	for (const FString& ScenarioName : FPaperZDBenchmarkScenarios::GetScenarioNames())
+	{
+		const UPaperZDAnimBP* AnimBP = FPaperZDBenchmarkScenarios::CreateScenario(ScenarioName);
+		if (!AnimBP)
+		{
+			AddError(FString::Printf(TEXT("Scenario '%s' failed to compile."), *ScenarioName));
+			continue;
+		}
+
+		//Graphs that need the game thread never take the parallel path, bound play rates are on the fast path and shouldn't prevent it
+		const UPaperZDAnimBPGeneratedClass* AnimClass = CastChecked<UPaperZDAnimBPGeneratedClass>(AnimBP->GeneratedClass);
+		if (ScenarioName == TEXT("ExposedValues"))
+		{
+			TestTrue(TEXT("Fast-path exposed values support the parallel update"), AnimClass->SupportsParallelUpdate());
+		}
+		if (!AnimClass->SupportsParallelUpdate())
+		{
+			continue;
+		}
+
+		UPaperZDAnimInstance* SerialInstance = FPaperZDBenchmarkScenarios::SpawnAnimInstance(World, AnimBP->GeneratedClass.Get());
+		UPaperZDAnimInstance* ParallelInstance = FPaperZDBenchmarkScenarios::SpawnAnimInstance(World, AnimBP->GeneratedClass.Get());
+		if (!TestTrue(FString::Printf(TEXT("%s: instances created"), *ScenarioName), SerialInstance && ParallelInstance && ParallelInstance->CanUpdateInParallel()))
+		{
+			continue;
+		}
+
+		FPaperZDAnimCounters::SetEnabled(true);
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			FPaperZDAnimCounters::Reset();
+			SerialInstance->Tick(DeltaTime);
+			const FPaperZDAnimCounters::FSnapshot SerialCounters = FPaperZDAnimCounters::GetSnapshot();
+
+			FPaperZDAnimCounters::Reset();
+			ParallelInstance->PreParallelUpdate(DeltaTime);
+			ParallelInstance->ParallelUpdateAnimations();
+			ParallelInstance->PostParallelUpdate();
+			const FPaperZDAnimCounters::FSnapshot ParallelCounters = FPaperZDAnimCounters::GetSnapshot();
+
+			FString Difference;
+			if (!IsSamePlayback(SerialInstance->GetEvaluatedPlaybackData(), ParallelInstance->GetEvaluatedPlaybackData(), Difference))
+			{
+				AddError(FString::Printf(TEXT("%s, frame %d: %s."), *ScenarioName, Frame, *Difference));
+				break;
+			}
+			else if (SerialCounters.NotifiesFired != ParallelCounters.NotifiesFired || SerialCounters.StateTransitions != ParallelCounters.StateTransitions)
+			{
+				AddError(FString::Printf(TEXT("%s, frame %d: %lld notifies and %lld transitions against %lld and %lld."), *ScenarioName, Frame,
+					SerialCounters.NotifiesFired, SerialCounters.StateTransitions, ParallelCounters.NotifiesFired, ParallelCounters.StateTransitions));
+				break;
+			}
+
+			//The bound play rate must have reached the node on both paths
+			const TArray<FPaperZDWeightedAnimation, TInlineAllocator<4>>& Animations = ParallelInstance->GetEvaluatedPlaybackData().WeightedAnimations;
+			if (Frame == 0 && ScenarioName == TEXT("ExposedValues") && Animations.Num())
+			{
+				TestEqual(TEXT("Bound play rate applied"), Animations[0].PlaybackTime, 1.5f * DeltaTime, KINDA_SMALL_NUMBER);
+			}
+		}
+		FPaperZDAnimCounters::SetEnabled(false);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,60 @@
+// Copyright 2017 ~ 2022 Critical Failure Studio Ltd. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Commandlets/PaperZDBenchmarkScenarios.h"
+#include "PaperZDAllocationCounter.h"
+#include "PaperZDAnimBP.h"
+#include "PaperZDAnimInstance.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPaperZDTickAllocationTest, "PaperZD.AnimInstance.TickAllocations", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FPaperZDTickAllocationTest::RunTest(const FString& Parameters)
+{
+	const int32 NumWarmupTicks = 120;
+	const int32 NumTicks = 1000;
+	const float DeltaTime = 1.0f / 30.0f;
+
+	//Nothing ticks the world, the instance is ticked by hand so nothing else gets counted
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("PaperZDTickAllocationTestWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	for (const FString& ScenarioName : FPaperZDBenchmarkScenarios::GetScenarioNames())
+	{
+		const UPaperZDAnimBP* AnimBP = FPaperZDBenchmarkScenarios::CreateScenario(ScenarioName);
+		UPaperZDAnimInstance* AnimInstance = AnimBP ? FPaperZDBenchmarkScenarios::SpawnAnimInstance(World, AnimBP->GeneratedClass.Get()) : nullptr;
+		if (!AnimInstance)
+		{
+			AddError(FString::Printf(TEXT("Scenario '%s' failed to compile or spawn."), *ScenarioName));
+			continue;
+		}
+
+		//The first ticks can still grow the reused buffers, the steady state shouldn't allocate at all
+		for (int32 TickIndex = 0; TickIndex < NumWarmupTicks; TickIndex++)
+		{
+			AnimInstance->Tick(DeltaTime);
+		}
+
+		FPaperZDScopedAllocationCounter Allocations(true);
+		for (int32 TickIndex = 0; TickIndex < NumTicks; TickIndex++)
+		{
+			AnimInstance->Tick(DeltaTime);
+		}
+		Allocations.Stop();
+
+		TestEqual(FString::Printf(TEXT("%s: heap allocations over %d ticks (%lld bytes)"), *ScenarioName, NumTicks, Allocations.GetAllocatedBytes()), Allocations.GetNumAllocations(), static_cast<int64>(0));
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
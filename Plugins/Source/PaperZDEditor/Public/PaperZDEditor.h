@@ -27,6 +27,9 @@ class FPaperZDEditorModule : public IModuleInterface
 	TSharedPtr<FPaperZDGraphPinFactory> GraphPinFactory;
 	TSharedPtr<FPaperZDGraphPinConnectionFactory> GraphPinConnectionFactory;
 
+	//Play session hook
+	FDelegateHandle BeginPIEHandle;
+
 public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
@@ -54,6 +57,9 @@ private:
 	void RegisterSettings();
 	void UnregisterSettings();
 
+	//Discards the node costs of the last play session
+	void OnBeginPIE(const bool bIsSimulating);
+
 	//For BlueprintCompilationManager
 	void RegisterCompiler();
 	static TSharedPtr<class FKismetCompilerContext> GetCompilerForAnimBP(class UBlueprint* BP, class FCompilerResultsLog& InMessageLog, const struct FKismetCompilerOptions& InCompileOptions);